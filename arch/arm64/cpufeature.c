@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/cpufeature.h>
+#include <bfdev/asm/cpufeature.h>
+#include <export.h>
+
+#if defined(__aarch64__) && defined(__linux__)
+# include <sys/auxv.h>
+# include <asm/hwcap.h>
+
+#define ARM64_FEATURE(hwcap, bit, feature) \
+    ((hwcap) & HWCAP_##bit ? BFDEV_CPU_FEATURE(BFDEV_CPU_##feature) : 0)
+
+hidden uint64_t
+bfdev_arch_cpu_probe(void)
+{
+    unsigned long hwcap;
+
+    hwcap = getauxval(AT_HWCAP);
+
+    return ARM64_FEATURE(hwcap, ASIMD, NEON) |
+           ARM64_FEATURE(hwcap, CRC32, CRC32) |
+           ARM64_FEATURE(hwcap, PMULL, PMULL) |
+           ARM64_FEATURE(hwcap, AES, AES) |
+           ARM64_FEATURE(hwcap, SHA1, SHA1) |
+           ARM64_FEATURE(hwcap, SHA2, SHA2);
+}
+
+#else /* !__aarch64__ || !__linux__ */
+
+/* without a way to ask the kernel, trust what the compiler targets */
+hidden uint64_t
+bfdev_arch_cpu_probe(void)
+{
+    uint64_t features;
+
+    features = BFDEV_CPU_FEATURE(BFDEV_CPU_NEON);
+
+#ifdef __ARM_FEATURE_CRC32
+    features |= BFDEV_CPU_FEATURE(BFDEV_CPU_CRC32);
+#endif
+
+#ifdef __ARM_FEATURE_CRYPTO
+    features |= BFDEV_CPU_FEATURE(BFDEV_CPU_PMULL) |
+                BFDEV_CPU_FEATURE(BFDEV_CPU_AES) |
+                BFDEV_CPU_FEATURE(BFDEV_CPU_SHA1) |
+                BFDEV_CPU_FEATURE(BFDEV_CPU_SHA2);
+#endif
+
+    return features;
+}
+
+#endif /* __aarch64__ && __linux__ */
@@ -0,0 +1,9 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+#
+
+set(BFDEV_ARCH_SOURCE
+    ${BFDEV_ARCH_SOURCE}
+    ${CMAKE_CURRENT_LIST_DIR}/cpufeature.c
+)
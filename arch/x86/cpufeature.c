@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/cpufeature.h>
+#include <bfdev/asm/cpufeature.h>
+#include <cpuid.h>
+#include <export.h>
+
+/* cpuid leaf 1 */
+#define X86_ECX_PCLMUL      BFDEV_BIT(1)
+#define X86_ECX_SSSE3       BFDEV_BIT(9)
+#define X86_ECX_SSE41       BFDEV_BIT(19)
+#define X86_ECX_SSE42       BFDEV_BIT(20)
+#define X86_ECX_POPCNT      BFDEV_BIT(23)
+#define X86_ECX_AESNI       BFDEV_BIT(25)
+#define X86_ECX_OSXSAVE     BFDEV_BIT(27)
+#define X86_ECX_AVX         BFDEV_BIT(28)
+#define X86_EDX_SSE2        BFDEV_BIT(26)
+
+/* cpuid leaf 7, subleaf 0 */
+#define X86_EBX_AVX2        BFDEV_BIT(5)
+#define X86_EBX_BMI2        BFDEV_BIT(8)
+#define X86_EBX_AVX512F     BFDEV_BIT(16)
+#define X86_EBX_SHANI       BFDEV_BIT(29)
+#define X86_EBX_AVX512BW    BFDEV_BIT(30)
+#define X86_EBX_AVX512VL    BFDEV_BIT(31)
+#define X86_ECX_VPCLMUL     BFDEV_BIT(10)
+
+/* register state enabled by the operating system in xcr0 */
+#define X86_XCR0_AVX        0x06
+#define X86_XCR0_AVX512     0xe6
+
+#define X86_FEATURE(reg, bit, feature) \
+    ((reg) & X86_##bit ? BFDEV_CPU_FEATURE(BFDEV_CPU_##feature) : 0)
+
+static uint64_t
+x86_xgetbv(void)
+{
+    uint32_t eax, edx;
+
+    /* the mnemonic needs -mxsave, which the whole file does not have */
+    asm volatile (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+
+    return ((uint64_t)edx << 32) | eax;
+}
+
+hidden uint64_t
+bfdev_arch_cpu_probe(void)
+{
+    unsigned int eax, ebx, ecx, edx, max;
+    uint64_t features, xcr0;
+
+    max = __get_cpuid_max(0, NULL);
+    if (max < 1)
+        return 0;
+
+    __cpuid(1, eax, ebx, ecx, edx);
+    features = X86_FEATURE(edx, EDX_SSE2, SSE2) |
+               X86_FEATURE(ecx, ECX_SSSE3, SSSE3) |
+               X86_FEATURE(ecx, ECX_SSE41, SSE41) |
+               X86_FEATURE(ecx, ECX_SSE42, SSE42) |
+               X86_FEATURE(ecx, ECX_POPCNT, POPCNT) |
+               X86_FEATURE(ecx, ECX_PCLMUL, PCLMUL) |
+               X86_FEATURE(ecx, ECX_AESNI, AESNI);
+
+    xcr0 = 0;
+    if (ecx & X86_ECX_OSXSAVE)
+        xcr0 = x86_xgetbv();
+
+    if ((ecx & X86_ECX_AVX) && (xcr0 & X86_XCR0_AVX) == X86_XCR0_AVX)
+        features |= BFDEV_CPU_FEATURE(BFDEV_CPU_AVX);
+
+    if (max < 7)
+        return features;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    features |= X86_FEATURE(ebx, EBX_BMI2, BMI2) |
+                X86_FEATURE(ebx, EBX_SHANI, SHANI);
+
+    if (features & BFDEV_CPU_FEATURE(BFDEV_CPU_AVX)) {
+        features |= X86_FEATURE(ebx, EBX_AVX2, AVX2) |
+                    X86_FEATURE(ecx, ECX_VPCLMUL, VPCLMUL);
+    }
+
+    if ((xcr0 & X86_XCR0_AVX512) == X86_XCR0_AVX512 &&
+        (ebx & X86_EBX_AVX512F)) {
+        features |= BFDEV_CPU_FEATURE(BFDEV_CPU_AVX512F) |
+                    X86_FEATURE(ebx, EBX_AVX512BW, AVX512BW) |
+                    X86_FEATURE(ebx, EBX_AVX512VL, AVX512VL);
+    }
+
+    return features;
+}
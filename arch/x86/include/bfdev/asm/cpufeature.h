@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_ASM_CPUFEATURE_H_
+#define _BFDEV_ASM_CPUFEATURE_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+
+BFDEV_BEGIN_DECLS
+
+#define bfdev_arch_cpu_probe bfdev_arch_cpu_probe
+extern uint64_t
+bfdev_arch_cpu_probe(void);
+
+BFDEV_END_DECLS
+
+#include <bfdev/asm-generic/cpufeature.h>
+
+#endif /* _BFDEV_ASM_CPUFEATURE_H_ */
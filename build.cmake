@@ -30,7 +30,7 @@ include(scripts/asm-generic.cmake)
 asm_generic(
     bfdev/asm-generic/
     ${BFDEV_GENERATED_PATH}/bfdev/asm
-    ${BFDEV_ARCH_HEADER_PATH}/bfdev/asm
+    "${BFDEV_ARCH_HEADER_PATH}/bfdev/asm;${BFDEV_GENERIC_HEADER_PATH}/bfdev/asm"
     ${BFDEV_HEADER_PATH}/bfdev/asm-generic
 )
 
@@ -54,12 +54,14 @@ file(GLOB_RECURSE BFDEV_GENERATED_HEADER
 
 file(GLOB_RECURSE BFDEV_ARCH_HEADER
     ${BFDEV_ARCH_HEADER_PATH}/*.h
+    ${BFDEV_GENERIC_HEADER_PATH}/*.h
 )
 
 set(BFDEV_INCLUDE_DIRS
     ${BFDEV_HEADER_PATH}
     ${BFDEV_GENERATED_PATH}
     ${BFDEV_ARCH_HEADER_PATH}
+    ${BFDEV_GENERIC_HEADER_PATH}
 )
 
 set_property(
@@ -0,0 +1,127 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "bloom-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <bfdev/bloom.h>
+#include <bfdev/blkbloom.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/dispatch.h>
+#include <bfdev/log.h>
+
+#define TEST_KEYS (1U << 22)
+#define TEST_BITS 12
+#define TEST_FUNCS 8
+#define TEST_BATCH 64
+
+static uint64_t
+blkbloom_hash(const void *key, void *pdata)
+{
+    return bfdev_xxh3(key, sizeof(uint64_t), 0);
+}
+
+static double
+time_usecs(struct timeval *start, struct timeval *stop)
+{
+    return (stop->tv_sec - start->tv_sec) * 1000000.0 +
+           (stop->tv_usec - start->tv_usec);
+}
+
+#define BENCHMARK(name, keys, statement) do {                   \
+    struct timeval start, stop;                                 \
+    unsigned int count, hits;                                   \
+                                                                \
+    gettimeofday(&start, NULL);                                 \
+    for (count = hits = 0; count < (keys); ) {                  \
+        statement;                                              \
+    }                                                           \
+    gettimeofday(&stop, NULL);                                  \
+                                                                \
+    bfdev_log_info("%-16s %8.2lf ns/key (%u hits)\n", name,     \
+                   time_usecs(&start, &stop) * 1000.0 / (keys), \
+                   hits);                                       \
+} while (0)
+
+int
+main(int argc, const char *argv[])
+{
+    bfdev_dispatch_t *dispatch;
+    bfdev_blkbloom_t *blkbloom;
+    bfdev_bloom_t *bloom;
+    unsigned int keys, batch;
+    uint64_t *hashes, key;
+
+    keys = TEST_KEYS;
+    if (argc > 1)
+        keys = strtoul(argv[1], NULL, 0);
+
+    hashes = malloc(sizeof(*hashes) * keys * 2);
+    if (!hashes)
+        return 1;
+
+    bloom = bfdev_bloom_create(NULL, keys * TEST_BITS, bfdev_xxh3_bloom,
+                               TEST_FUNCS, BFDEV_XXH3_KEY_LENGTH(sizeof(key)));
+    if (!bloom)
+        return 1;
+
+    blkbloom = bfdev_blkbloom_create(NULL, (unsigned long)keys * TEST_BITS,
+                                     blkbloom_hash, NULL);
+    if (!blkbloom)
+        return 1;
+
+    for (key = 0; key < keys * 2; ++key)
+        hashes[key] = blkbloom_hash(&key, NULL);
+
+    bfdev_log_info("%u keys, %u bits per key\n", keys, TEST_BITS);
+
+    dispatch = bfdev_dispatch_find("blkbloom");
+    if (dispatch)
+        bfdev_log_info("blkbloom implementation: %s\n",
+                       dispatch->selected->name);
+
+    BENCHMARK("bloom push", keys,
+        key = count++;
+        hits += bfdev_bloom_push(bloom, &key)
+    );
+
+    BENCHMARK("bloom peek", keys * 2,
+        key = count++;
+        hits += bfdev_bloom_peek(bloom, &key)
+    );
+
+    BENCHMARK("blkbloom push", keys,
+        key = count++;
+        hits += bfdev_blkbloom_push(blkbloom, &key)
+    );
+
+    BENCHMARK("blkbloom peek", keys * 2,
+        key = count++;
+        hits += bfdev_blkbloom_peek(blkbloom, &key)
+    );
+
+    bfdev_blkbloom_flush(blkbloom);
+
+    BENCHMARK("blkbloom batch+", keys,
+        batch = keys - count < TEST_BATCH ? keys - count : TEST_BATCH;
+        hits += bfdev_blkbloom_push_batch(blkbloom, hashes + count, batch);
+        count += batch
+    );
+
+    BENCHMARK("blkbloom batch?", keys * 2,
+        batch = keys * 2 - count < TEST_BATCH ? keys * 2 - count : TEST_BATCH;
+        hits += bfdev_blkbloom_peek_batch(blkbloom, hashes + count, NULL, batch);
+        count += batch
+    );
+
+    bfdev_blkbloom_destroy(blkbloom);
+    bfdev_bloom_destroy(bloom);
+    free(hashes);
+
+    return 0;
+}
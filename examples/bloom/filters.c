@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "bloom-filters"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <bfdev/blkbloom.h>
+#include <bfdev/cbloom.h>
+#include <bfdev/cuckoo.h>
+#include <bfdev/sbloom.h>
+#include <bfdev/xorfilter.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/log.h>
+
+#define TEST_KEYS (1U << 20)
+
+static uint64_t
+filter_hash(const void *key, void *pdata)
+{
+    return bfdev_xxh3(key, sizeof(uint64_t), 0);
+}
+
+static double
+time_usecs(struct timeval *start, struct timeval *stop)
+{
+    return (stop->tv_sec - start->tv_sec) * 1000000.0 +
+           (stop->tv_usec - start->tv_usec);
+}
+
+/* keys below @keys are members, the next @keys are not */
+#define REPORT(name, peek, filter, keys, bytes) do {                \
+    struct timeval start, stop;                                     \
+    unsigned int __hits;                                            \
+    uint64_t __key;                                                 \
+                                                                    \
+    gettimeofday(&start, NULL);                                     \
+    for (__key = __hits = 0; __key < (keys) * 2; ++__key)           \
+        __hits += peek(filter, &__key);                             \
+    gettimeofday(&stop, NULL);                                      \
+                                                                    \
+    bfdev_log_info("%-10s %6.2lf bits/key %8.5lf fpr %6.2lf ns/peek\n", \
+                   name, (bytes) * 8.0 / (keys),                    \
+                   (double)(__hits - (keys)) / (keys),              \
+                   time_usecs(&start, &stop) * 1000.0 / ((keys) * 2)); \
+} while (0)
+
+int
+main(int argc, const char *argv[])
+{
+    bfdev_blkbloom_t *blkbloom;
+    bfdev_xorfilter_t *xorfilter;
+    bfdev_cbloom_t *cbloom;
+    bfdev_cuckoo_t *cuckoo;
+    bfdev_sbloom_t *sbloom;
+    bfdev_sbloom_stage_t *stage;
+    unsigned long bytes;
+    unsigned int keys;
+    uint64_t *hashes, key;
+
+    keys = TEST_KEYS;
+    if (argc > 1)
+        keys = strtoul(argv[1], NULL, 0);
+
+    hashes = malloc(sizeof(*hashes) * keys);
+    if (!hashes)
+        return 1;
+
+    for (key = 0; key < keys; ++key)
+        hashes[key] = filter_hash(&key, NULL);
+
+    /* roughly the same budget of about 10 bits per key */
+    blkbloom = bfdev_blkbloom_create(NULL, (unsigned long)keys * 10,
+                                     filter_hash, NULL);
+    cbloom = bfdev_cbloom_create(NULL, (unsigned long)keys * 10, 7,
+                                 filter_hash, NULL);
+    cuckoo = bfdev_cuckoo_create(NULL, keys, filter_hash, NULL);
+    sbloom = bfdev_sbloom_create(NULL, keys / 16, 7, filter_hash, NULL);
+    xorfilter = bfdev_xorfilter_create(NULL, hashes, keys, filter_hash, NULL);
+    if (!blkbloom || !cbloom || !cuckoo || !sbloom || !xorfilter)
+        return 1;
+
+    bfdev_blkbloom_push_batch(blkbloom, hashes, keys);
+    for (key = 0; key < keys; ++key) {
+        bfdev_cbloom_push(cbloom, &key);
+        if (bfdev_cuckoo_push(cuckoo, &key) ||
+            bfdev_sbloom_push(sbloom, &key))
+            return 1;
+    }
+
+    REPORT("blkbloom", bfdev_blkbloom_peek, blkbloom, keys,
+           blkbloom->blocks * BFDEV_BLKBLOOM_BLOCK_SIZE);
+
+    REPORT("cbloom", bfdev_cbloom_peek, cbloom, keys,
+           (cbloom->capacity + 1) / 2);
+
+    REPORT("cuckoo", bfdev_cuckoo_peek, cuckoo, keys,
+           (cuckoo->mask + 1) * sizeof(*cuckoo->buckets));
+
+    bytes = 0;
+    bfdev_list_for_each_entry(stage, &sbloom->stages, list)
+        bytes += stage->bits / 8;
+    REPORT("sbloom", bfdev_sbloom_peek, sbloom, keys, bytes);
+
+    REPORT("xorfilter", bfdev_xorfilter_peek, xorfilter, keys,
+           xorfilter->length);
+
+    bfdev_xorfilter_destroy(xorfilter);
+    bfdev_sbloom_destroy(sbloom);
+    bfdev_cuckoo_destroy(cuckoo);
+    bfdev_cbloom_destroy(cbloom);
+    bfdev_blkbloom_destroy(blkbloom);
+    free(hashes);
+
+    return 0;
+}
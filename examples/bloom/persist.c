@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "bloom-persist"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <err.h>
+#include <sys/mman.h>
+#include <bfdev/bloom.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/log.h>
+
+#define TEST_KEYS 100000
+#define TEST_BITS (TEST_KEYS * 12)
+#define TEST_FUNCS 6
+#define TEST_HASHID 1
+#define TEST_FILE "bloom-persist.img"
+
+static unsigned int
+bloom_hash(unsigned int func, const void *key, void *pdata)
+{
+    return (unsigned int)bfdev_xxh3(key, sizeof(unsigned int), func);
+}
+
+static void
+bloom_save(const char *path)
+{
+    bfdev_bloom_t *bloom;
+    unsigned int key;
+    size_t size;
+    void *image;
+    FILE *file;
+
+    bloom = bfdev_bloom_create(NULL, TEST_BITS, bloom_hash, TEST_FUNCS, NULL);
+    if (!bloom)
+        err(ENOMEM, "bfdev_bloom_create");
+
+    for (key = 0; key < TEST_KEYS; ++key)
+        bfdev_bloom_push(bloom, &key);
+
+    size = bfdev_bloom_export_size(bloom);
+    image = malloc(size);
+    if (!image)
+        err(ENOMEM, "malloc");
+
+    if (bfdev_bloom_export(bloom, image, size, TEST_HASHID))
+        errx(1, "bfdev_bloom_export");
+
+    file = fopen(path, "wb");
+    if (!file)
+        err(errno, "fopen");
+
+    if (fwrite(image, size, 1, file) != 1)
+        err(errno, "fwrite");
+
+    fclose(file);
+    free(image);
+    bfdev_bloom_destroy(bloom);
+
+    bfdev_log_info("saved %zu bytes\n", size);
+}
+
+static int
+bloom_load(const char *path)
+{
+    bfdev_bloom_t bloom;
+    unsigned int key, hits;
+    void *image;
+    off_t size;
+    int fd, retval;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        err(errno, "open");
+
+    size = lseek(fd, 0, SEEK_END);
+    if (size < 0)
+        err(errno, "lseek");
+
+    /* private mapping, pages are only read in as lookups touch them */
+    image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (image == MAP_FAILED)
+        err(errno, "mmap");
+    close(fd);
+
+    retval = bfdev_bloom_attach(&bloom, image, size, bloom_hash,
+                                TEST_HASHID, NULL);
+    if (retval == -BFDEV_EOPNOTSUPP) {
+        bfdev_log_info("attach unsupported, skipped\n");
+        munmap(image, size);
+        return 0;
+    } else if (retval)
+        errx(1, "bfdev_bloom_attach: %d", retval);
+
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (!bfdev_bloom_peek(&bloom, &key))
+            errx(1, "key %u lost", key);
+    }
+
+    for (hits = 0; key < TEST_KEYS * 2; ++key)
+        hits += bfdev_bloom_peek(&bloom, &key);
+
+    bfdev_log_info("attached, false positive rate %.4lf\n",
+                   (double)hits / TEST_KEYS);
+    munmap(image, size);
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    const char *path;
+    int retval;
+
+    path = argc > 1 ? argv[1] : TEST_FILE;
+    bloom_save(path);
+    retval = bloom_load(path);
+    unlink(path);
+
+    return retval;
+}
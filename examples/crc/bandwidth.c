@@ -29,10 +29,30 @@ for (count = 0; count < TEST_LOOP; ++count) {   \
     );                                          \
 }
 
+#define ACCEL_CRC_BANDWIDTH(name, type)                 \
+for (accel = 0; accel < BFDEV_CRC_ACCEL_NR; ++accel) {  \
+    type (*func)(const void *, size_t, type);           \
+                                                        \
+    func = bfdev_##name##_kernel(accel);                \
+    if (!func)                                          \
+        continue;                                       \
+                                                        \
+    for (count = 0; count < TEST_LOOP; ++count) {       \
+        EXAMPLE_TIME_LOOP(&loop, 1000,                  \
+            func(buff, TEST_SIZE, 0);                   \
+            0;                                          \
+        );                                              \
+        bfdev_log_info(                                 \
+            #name " %s bandwidth %u: %uMiB/s\n",        \
+            bfdev_crc_accel_name(accel), count, loop    \
+        );                                              \
+    }                                                   \
+}
+
 int
 main(int argc, char const *argv[])
 {
-    unsigned int count, loop;
+    unsigned int count, loop, accel;
     uint8_t *buff;
     size_t index;
 
@@ -49,6 +69,7 @@ main(int argc, char const *argv[])
     GENERIC_CRC_BANDWIDTH(bfdev_crc8, "crc8", TEST_SIZE)
     GENERIC_CRC_BANDWIDTH(bfdev_crc16, "crc16", TEST_SIZE)
     GENERIC_CRC_BANDWIDTH(bfdev_crc32, "crc32", TEST_SIZE)
+    GENERIC_CRC_BANDWIDTH(bfdev_crc32c, "crc32c", TEST_SIZE)
     GENERIC_CRC_BANDWIDTH(bfdev_crc64, "crc64", TEST_SIZE)
 
     GENERIC_CRC_BANDWIDTH(bfdev_crc_ccitt, "crc-ccitt", TEST_SIZE)
@@ -56,6 +77,12 @@ main(int argc, char const *argv[])
     GENERIC_CRC_BANDWIDTH(bfdev_crc_t10dif, "crc-t10dif", TEST_SIZE)
     GENERIC_CRC_BANDWIDTH(bfdev_crc_rocksoft, "crc-rocksoft", TEST_SIZE)
 
+    ACCEL_CRC_BANDWIDTH(crc32, uint32_t)
+    ACCEL_CRC_BANDWIDTH(crc32c, uint32_t)
+    ACCEL_CRC_BANDWIDTH(crc64, uint64_t)
+    ACCEL_CRC_BANDWIDTH(crc_t10dif, uint16_t)
+    ACCEL_CRC_BANDWIDTH(crc_rocksoft, uint64_t)
+
     free(buff);
     return 0;
 }
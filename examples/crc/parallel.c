@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crc-parallel"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <bfdev/log.h>
+#include <bfdev/crc.h>
+#include <bfdev/wspool.h>
+
+#define TEST_SIZE (1UL << 26)
+#define TEST_LOOP 4
+#define TEST_THREADS 8
+#define TEST_DEPTH 64
+
+struct helper {
+    pthread_t tid;
+    bfdev_wspool_t *pool;
+    unsigned int index;
+};
+
+static uint8_t *buff;
+
+static uint32_t *
+futex_word(bfdev_atomic_t *event)
+{
+    /* the low half changes on every increment */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (uint32_t *)(event + 1) - 1;
+#else
+    return (uint32_t *)event;
+#endif
+}
+
+static void
+futex_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAIT_PRIVATE,
+            (uint32_t)value, NULL, NULL, 0);
+}
+
+static void
+futex_wake(bfdev_atomic_t *event, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAKE_PRIVATE,
+            INT_MAX, NULL, NULL, 0);
+}
+
+static const bfdev_wspool_ops_t
+futex_ops = {
+    .wait = futex_wait,
+    .wake = futex_wake,
+};
+
+static void *
+helper_run(void *pdata)
+{
+    struct helper *helper = pdata;
+
+    bfdev_wspool_run(helper->pool, helper->index);
+    return NULL;
+}
+
+static double
+time_mbps(struct timeval *start, struct timeval *stop)
+{
+    return TEST_LOOP * TEST_SIZE / ((stop->tv_sec - start->tv_sec) *
+           1000000.0 + (stop->tv_usec - start->tv_usec));
+}
+
+#define PARALLEL_CRC(name, type) do {                               \
+    struct timeval start, stop;                                     \
+    type expect, crc;                                               \
+    unsigned int loop;                                              \
+                                                                    \
+    gettimeofday(&start, NULL);                                     \
+    for (loop = 0; loop < TEST_LOOP; ++loop)                        \
+        expect = bfdev_##name(buff, TEST_SIZE, 0);                  \
+    gettimeofday(&stop, NULL);                                      \
+    bfdev_log_info(#name " serial    %u threads: %8.2lf MB/s\n",    \
+                   1, time_mbps(&start, &stop));                    \
+                                                                    \
+    gettimeofday(&start, NULL);                                     \
+    for (loop = 0; loop < TEST_LOOP; ++loop) {                      \
+        crc = 0;                                                    \
+        retval = bfdev_##name##_parallel(pool, 0, buff,             \
+                                         TEST_SIZE, 0, &crc);       \
+        if (retval)                                                 \
+            return retval;                                          \
+    }                                                               \
+    gettimeofday(&stop, NULL);                                      \
+    bfdev_log_info(#name " parallel  %u threads: %8.2lf MB/s\n",    \
+                   threads, time_mbps(&start, &stop));              \
+                                                                    \
+    if (crc != expect) {                                            \
+        bfdev_log_err(#name " mismatch\n");                         \
+        return -BFDEV_EFAULT;                                       \
+    }                                                               \
+} while (0)
+
+static int
+pool_bench(bfdev_wspool_t *pool, unsigned int threads)
+{
+    int retval;
+
+    PARALLEL_CRC(crc32, uint32_t);
+    PARALLEL_CRC(crc32c, uint32_t);
+    PARALLEL_CRC(crc64, uint64_t);
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+pool_run(unsigned int threads)
+{
+    struct helper helpers[TEST_THREADS];
+    bfdev_wspool_t pool;
+    unsigned int index;
+    int retval;
+
+    retval = bfdev_wspool_alloc(&pool, NULL, threads, TEST_DEPTH);
+    if (retval)
+        return retval;
+
+    bfdev_wspool_set_wait(&pool, &futex_ops, NULL);
+    for (index = 1; index < threads; ++index) {
+        helpers[index] = (struct helper) {
+            .pool = &pool,
+            .index = index,
+        };
+        pthread_create(&helpers[index].tid, NULL, helper_run, &helpers[index]);
+    }
+
+    retval = pool_bench(&pool, threads);
+
+    bfdev_wspool_stop(&pool);
+    for (index = 1; index < threads; ++index)
+        pthread_join(helpers[index].tid, NULL);
+    bfdev_wspool_free(&pool);
+
+    return retval;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int threads;
+    unsigned long index;
+    int retval;
+
+    buff = malloc(TEST_SIZE);
+    if (!buff)
+        return 1;
+
+    for (index = 0; index < TEST_SIZE; ++index)
+        buff[index] = (uint8_t)rand();
+
+    for (threads = 1; threads <= TEST_THREADS; threads <<= 1) {
+        retval = pool_run(threads);
+        if (retval)
+            break;
+    }
+
+    free(buff);
+    return !!retval;
+}
@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crypto-multibuf"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <bfdev/sha1.h>
+#include <bfdev/sha2.h>
+#include <bfdev/md5.h>
+#include <bfdev/log.h>
+#include <bfdev/size.h>
+#include <bfdev/macro.h>
+#include "../time.h"
+
+#define TEST_SIZE BFDEV_SZ_1MiB
+#define TEST_CHUNKS (TEST_SIZE / BFDEV_SZ_4KiB)
+
+#define MULTIBUF_BANDWIDTH(name, init, finish, ctxname, dsize) do {     \
+    bfdev_##ctxname##_ctx_t ctx[TEST_CHUNKS], *ctxs[TEST_CHUNKS];       \
+    uint8_t digest[TEST_CHUNKS][dsize], expect[dsize];                  \
+    unsigned int index, loop;                                           \
+                                                                        \
+    EXAMPLE_TIME_LOOP(&loop, 1000,                                      \
+        for (index = 0; index < chunks; ++index) {                      \
+            bfdev_##init##_init(&ctx[0]);                               \
+            bfdev_##name##_update(&ctx[0], datas[index], chunk);        \
+            bfdev_##finish##_finish(&ctx[0], digest[index]);            \
+        }                                                               \
+        0;                                                              \
+    );                                                                  \
+    bfdev_log_info(#finish " %3zuKiB serial:    %5uMiB/s\n",            \
+                   chunk / BFDEV_SZ_1KiB, loop);                        \
+                                                                        \
+    EXAMPLE_TIME_LOOP(&loop, 1000,                                      \
+        for (index = 0; index < chunks; ++index) {                      \
+            ctxs[index] = &ctx[index];                                  \
+            hashes[index] = digest[index];                              \
+            bfdev_##init##_init(&ctx[index]);                           \
+        }                                                               \
+        bfdev_##name##_update_mb(ctxs, datas, sizes, chunks);           \
+        bfdev_##finish##_finish_mb(ctxs, hashes, chunks);               \
+        0;                                                              \
+    );                                                                  \
+    bfdev_log_info(#finish " %3zuKiB multibuf:  %5uMiB/s\n",            \
+                   chunk / BFDEV_SZ_1KiB, loop);                        \
+                                                                        \
+    for (index = 0; index < chunks; ++index) {                          \
+        bfdev_##init##_init(&ctx[0]);                                   \
+        bfdev_##name##_update(&ctx[0], datas[index], chunk);            \
+        bfdev_##finish##_finish(&ctx[0], expect);                       \
+        if (memcmp(expect, digest[index], dsize))                       \
+            return 1;                                                   \
+    }                                                                   \
+} while (0)
+
+static const size_t
+chunk_sizes[] = {
+    BFDEV_SZ_4KiB, BFDEV_SZ_16KiB, BFDEV_SZ_64KiB,
+};
+
+static const char *datas[TEST_CHUNKS];
+static size_t sizes[TEST_CHUNKS];
+static void *hashes[TEST_CHUNKS];
+
+int
+main(int argc, char const *argv[])
+{
+    unsigned int count, index, chunks;
+    uint8_t *buff;
+    size_t chunk;
+
+    buff = malloc(TEST_SIZE);
+    if (!buff)
+        return 1;
+
+    srand(time(NULL));
+    for (index = 0; index < TEST_SIZE; ++index)
+        buff[index] = (uint8_t)rand();
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(chunk_sizes); ++count) {
+        chunk = chunk_sizes[count];
+        chunks = TEST_SIZE / chunk;
+
+        for (index = 0; index < chunks; ++index) {
+            datas[index] = (const char *)buff + index * chunk;
+            sizes[index] = chunk;
+        }
+
+        MULTIBUF_BANDWIDTH(sha1, sha1, sha1, sha1, BFDEV_SHA1_DIGEST_SIZE);
+        MULTIBUF_BANDWIDTH(sha2, sha256, sha256, sha2, BFDEV_SHA256_DIGEST_SIZE);
+        MULTIBUF_BANDWIDTH(md5, md5, md5, md5, BFDEV_MD5_DIGEST_SIZE);
+    }
+
+    free(buff);
+    return 0;
+}
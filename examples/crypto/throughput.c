@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crypto-throughput"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <bfdev/sha1.h>
+#include <bfdev/sha2.h>
+#include <bfdev/md5.h>
+#include <bfdev/log.h>
+#include <bfdev/size.h>
+#include <bfdev/macro.h>
+
+#define TEST_MIN 64
+#define TEST_MAX (1024 * BFDEV_SZ_1MiB)
+#define TEST_TIME 200000
+
+#define THROUGHPUT_DIGEST(name, init, finish, ctxname, dsize)       \
+static void                                                         \
+finish##_hash(const void *data, size_t size)                        \
+{                                                                   \
+    uint8_t digest[dsize];                                          \
+    bfdev_##ctxname##_ctx_t ctx;                                    \
+                                                                    \
+    bfdev_##init##_init(&ctx);                                      \
+    bfdev_##name##_update(&ctx, data, size);                        \
+    bfdev_##finish##_finish(&ctx, digest);                          \
+}
+
+struct digest {
+    const char *name;
+    void (*hash)(const void *data, size_t size);
+};
+
+THROUGHPUT_DIGEST(sha1, sha1, sha1, sha1, BFDEV_SHA1_DIGEST_SIZE)
+THROUGHPUT_DIGEST(sha2, sha224, sha224, sha2, BFDEV_SHA224_DIGEST_SIZE)
+THROUGHPUT_DIGEST(sha2, sha256, sha256, sha2, BFDEV_SHA256_DIGEST_SIZE)
+THROUGHPUT_DIGEST(md5, md5, md5, md5, BFDEV_MD5_DIGEST_SIZE)
+
+static const struct digest
+digests[] = {
+    {"sha1", sha1_hash},
+    {"sha224", sha224_hash},
+    {"sha256", sha256_hash},
+    {"md5", md5_hash},
+};
+
+static double
+time_usecs(struct timeval *start, struct timeval *stop)
+{
+    return (stop->tv_sec - start->tv_sec) * 1000000.0 +
+           (stop->tv_usec - start->tv_usec);
+}
+
+static void
+throughput(const struct digest *digest, const void *data, size_t size)
+{
+    struct timeval start, stop;
+    unsigned long loop;
+    double usecs;
+
+    gettimeofday(&start, NULL);
+    loop = 0;
+
+    do {
+        digest->hash(data, size);
+        gettimeofday(&stop, NULL);
+        usecs = time_usecs(&start, &stop);
+        loop++;
+    } while (usecs < TEST_TIME);
+
+    bfdev_log_info("%-6s %10zu bytes: %9.2lf MiB/s\n", digest->name, size,
+                   loop * size / usecs * 1000000.0 / BFDEV_SZ_1MiB);
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int count;
+    size_t size, limit;
+    uint8_t *buff;
+
+    /* the largest size hashed, in MiB */
+    limit = TEST_MAX;
+    if (argc > 1)
+        limit = strtoul(argv[1], NULL, 0) * BFDEV_SZ_1MiB;
+
+    if (limit < TEST_MIN)
+        limit = TEST_MIN;
+
+    buff = malloc(limit);
+    if (!buff)
+        return 1;
+
+    for (size = 0; size < limit; ++size)
+        buff[size] = (uint8_t)(size * 0x9e3779b9UL >> 24);
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(digests); ++count) {
+        for (size = TEST_MIN; size <= limit; size *= 4)
+            throughput(&digests[count], buff, size);
+    }
+
+    free(buff);
+    return 0;
+}
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "ebr-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <bfdev/ebr.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/prandom.h>
+
+#define TEST_SLOTS 256
+#define TEST_LOOP (1UL << 22)
+#define TEST_THREADS 8
+#define TEST_WRITES 16
+
+struct object {
+    unsigned long value;
+    bfdev_ebr_node_t ebr;
+};
+
+struct worker {
+    pthread_t tid;
+    unsigned int index;
+    unsigned long count;
+    unsigned long sum;
+};
+
+struct bench {
+    const char *name;
+    void *(*func)(void *pdata);
+};
+
+static BFDEV_DEFINE_EBR(ebr, NULL);
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static bfdev_atomic_t slots[TEST_SLOTS];
+
+static struct object *
+object_alloc(unsigned long value)
+{
+    struct object *object;
+
+    object = bfdev_malloc(NULL, sizeof(*object));
+    if (object)
+        object->value = value;
+
+    return object;
+}
+
+static void
+object_release(const bfdev_alloc_t *alloc, bfdev_ebr_node_t *node)
+{
+    bfdev_free(alloc, bfdev_ebr_entry(node, struct object, ebr));
+}
+
+static void *
+rwlock_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    struct object *object, *old;
+    bfdev_prandom_t rand;
+    unsigned long count;
+    unsigned int slot;
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < worker->count; ++count) {
+        slot = bfdev_prandom_value(&rand) % TEST_SLOTS;
+
+        if (count % TEST_WRITES) {
+            pthread_rwlock_rdlock(&rwlock);
+            object = (void *)bfdev_atomic_read(&slots[slot]);
+            worker->sum += object->value;
+            pthread_rwlock_unlock(&rwlock);
+            continue;
+        }
+
+        object = object_alloc(count);
+        if (!object)
+            continue;
+
+        pthread_rwlock_wrlock(&rwlock);
+        old = (void *)bfdev_xchg(&slots[slot], (bfdev_atomic_t)object);
+        pthread_rwlock_unlock(&rwlock);
+        bfdev_free(NULL, old);
+    }
+
+    return NULL;
+}
+
+static void *
+ebr_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    struct object *object, *old;
+    bfdev_ebr_thread_t *thread;
+    bfdev_prandom_t rand;
+    unsigned long count;
+    unsigned int slot;
+
+    thread = bfdev_ebr_attach(&ebr);
+    if (!thread)
+        return NULL;
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < worker->count; ++count) {
+        slot = bfdev_prandom_value(&rand) % TEST_SLOTS;
+
+        if (count % TEST_WRITES) {
+            bfdev_ebr_enter(&ebr, thread);
+            object = (void *)bfdev_atomic_read(&slots[slot]);
+            worker->sum += object->value;
+            bfdev_ebr_leave(&ebr, thread);
+            continue;
+        }
+
+        object = object_alloc(count);
+        if (!object)
+            continue;
+
+        old = (void *)bfdev_xchg(&slots[slot], (bfdev_atomic_t)object);
+        bfdev_ebr_retire(&ebr, thread, &old->ebr, object_release);
+    }
+
+    bfdev_ebr_detach(&ebr, thread);
+    return NULL;
+}
+
+static const struct bench
+benches[] = {
+    {"rwlock", rwlock_worker},
+    {"ebr", ebr_worker},
+};
+
+static void
+bench_run(const struct bench *bench, unsigned int threads)
+{
+    struct worker workers[TEST_THREADS];
+    struct timeval start, stop;
+    unsigned int thread;
+    double usecs;
+
+    gettimeofday(&start, NULL);
+    for (thread = 0; thread < threads; ++thread) {
+        workers[thread] = (struct worker) {
+            .index = thread,
+            .count = TEST_LOOP / threads,
+        };
+        pthread_create(&workers[thread].tid, NULL, bench->func,
+                       &workers[thread]);
+    }
+
+    for (thread = 0; thread < threads; ++thread)
+        pthread_join(workers[thread].tid, NULL);
+    gettimeofday(&stop, NULL);
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-6s %u threads: %8.3lf Mops/s\n", bench->name,
+                   threads, TEST_LOOP / usecs);
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int count, threads;
+
+    for (count = 0; count < TEST_SLOTS; ++count) {
+        slots[count] = (bfdev_atomic_t)object_alloc(count);
+        if (!slots[count])
+            return 1;
+    }
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(benches); ++count) {
+        for (threads = 1; threads <= TEST_THREADS; threads <<= 1)
+            bench_run(&benches[count], threads);
+    }
+
+    bfdev_ebr_destroy(&ebr);
+    for (count = 0; count < TEST_SLOTS; ++count)
+        bfdev_free(NULL, (void *)slots[count]);
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "fifo-spsc"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <bfdev/log.h>
+#include <bfdev/fifo.h>
+
+#define TEST_SIZE 1024
+#define TEST_LOOP (1UL << 22)
+#define TEST_BATCH 64
+
+struct bench {
+    const char *name;
+    void *(*producer)(void *pdata);
+    void *(*consumer)(void *pdata);
+};
+
+static BFDEV_DEFINE_FIFO(mutex_fifo, uint64_t, TEST_SIZE);
+static pthread_mutex_t mutex_lock = PTHREAD_MUTEX_INITIALIZER;
+static BFDEV_DEFINE_FIFO_SPSC(spsc_fifo, uint64_t, TEST_SIZE);
+
+static void *
+mutex_producer(void *pdata)
+{
+    uint64_t value;
+    bool retval;
+
+    for (value = 1; value <= TEST_LOOP;) {
+        pthread_mutex_lock(&mutex_lock);
+        retval = bfdev_fifo_put(&mutex_fifo, value);
+        pthread_mutex_unlock(&mutex_lock);
+
+        if (retval)
+            value++;
+        else
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+static void *
+mutex_consumer(void *pdata)
+{
+    uint64_t value, expect;
+    bool retval;
+
+    for (expect = 1; expect <= TEST_LOOP;) {
+        pthread_mutex_lock(&mutex_lock);
+        retval = bfdev_fifo_get(&mutex_fifo, &value);
+        pthread_mutex_unlock(&mutex_lock);
+
+        if (!retval) {
+            sched_yield();
+            continue;
+        }
+
+        if (value != expect++)
+            return (void *)1;
+    }
+
+    return NULL;
+}
+
+static void *
+spsc_producer(void *pdata)
+{
+    uint64_t value;
+
+    for (value = 1; value <= TEST_LOOP;) {
+        if (bfdev_fifo_spsc_put(&spsc_fifo, value))
+            value++;
+        else
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+static void *
+spsc_consumer(void *pdata)
+{
+    uint64_t value, expect;
+
+    for (expect = 1; expect <= TEST_LOOP;) {
+        if (!bfdev_fifo_spsc_get(&spsc_fifo, &value)) {
+            sched_yield();
+            continue;
+        }
+
+        if (value != expect++)
+            return (void *)1;
+    }
+
+    return NULL;
+}
+
+static void *
+batch_producer(void *pdata)
+{
+    uint64_t buff[TEST_BATCH], value;
+    unsigned long count, index;
+
+    for (value = 1; value <= TEST_LOOP;) {
+        for (index = 0; index < TEST_BATCH; ++index)
+            buff[index] = value + index;
+
+        count = bfdev_fifo_spsc_in(&spsc_fifo, buff, TEST_BATCH);
+        if (count)
+            value += count;
+        else
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+static void *
+batch_consumer(void *pdata)
+{
+    uint64_t buff[TEST_BATCH], expect;
+    unsigned long count, index;
+
+    for (expect = 1; expect <= TEST_LOOP;) {
+        count = bfdev_fifo_spsc_out(&spsc_fifo, buff, TEST_BATCH);
+        if (!count) {
+            sched_yield();
+            continue;
+        }
+
+        for (index = 0; index < count; ++index) {
+            if (buff[index] != expect++)
+                return (void *)1;
+        }
+    }
+
+    return NULL;
+}
+
+static const struct bench
+benches[] = {
+    {"mutex", mutex_producer, mutex_consumer},
+    {"spsc", spsc_producer, spsc_consumer},
+    {"spsc-batch", batch_producer, batch_consumer},
+};
+
+int
+main(int argc, const char *argv[])
+{
+    struct timeval start, stop;
+    pthread_t producer, consumer;
+    unsigned int count;
+    void *retval;
+    double usecs;
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(benches); ++count) {
+        gettimeofday(&start, NULL);
+        pthread_create(&consumer, NULL, benches[count].consumer, NULL);
+        pthread_create(&producer, NULL, benches[count].producer, NULL);
+        pthread_join(producer, NULL);
+        pthread_join(consumer, &retval);
+        gettimeofday(&stop, NULL);
+
+        if (retval) {
+            bfdev_log_err("%s: sequence mismatch\n", benches[count].name);
+            return 1;
+        }
+
+        usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+                (stop.tv_usec - start.tv_usec);
+        bfdev_log_info("%-10s %lu objects: %8.3lf Mops/s\n",
+                       benches[count].name, TEST_LOOP, TEST_LOOP / usecs);
+    }
+
+    return 0;
+}
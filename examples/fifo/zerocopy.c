@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "fifo-zerocopy"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <bfdev/log.h>
+#include <bfdev/fifo.h>
+#include <bfdev/minmax.h>
+
+#define TEST_SIZE (1UL << 16)
+#define TEST_CHUNK (1UL << 14)
+#define TEST_TOTAL (1UL << 26)
+
+static BFDEV_DEFINE_FIFO(fifo, uint8_t, TEST_SIZE);
+static uint8_t source[TEST_CHUNK];
+
+static void *
+writer(void *pdata)
+{
+    int fd = (int)(intptr_t)pdata;
+    unsigned long total;
+    ssize_t length;
+
+    for (total = 0; total < TEST_TOTAL; total += length) {
+        length = write(fd, source, bfdev_min(TEST_CHUNK, TEST_TOTAL - total));
+        if (length <= 0)
+            break;
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static unsigned long
+checksum(unsigned long sum, const uint8_t *data, unsigned long len)
+{
+    while (len--)
+        sum += *data++;
+    return sum;
+}
+
+static unsigned long
+zerocopy(int fd)
+{
+    bfdev_fifo_span_t spans[2];
+    struct iovec iov[2];
+    unsigned long sum, len;
+    ssize_t length;
+
+    for (sum = 0;;) {
+        /* read straight into the free space of fifo */
+        len = bfdev_fifo_reserve(&fifo, spans, TEST_CHUNK);
+        iov[0] = (struct iovec) {spans[0].data, spans[0].len};
+        iov[1] = (struct iovec) {spans[1].data, spans[1].len};
+
+        length = readv(fd, iov, spans[1].len ? 2 : 1);
+        if (length <= 0)
+            break;
+        bfdev_fifo_commit(&fifo, length);
+
+        /* and parse it where it lies */
+        len = bfdev_fifo_peek_spans(&fifo, spans, TEST_CHUNK);
+        sum = checksum(sum, spans[0].data, spans[0].len);
+        sum = checksum(sum, spans[1].data, spans[1].len);
+        bfdev_fifo_consume(&fifo, len);
+    }
+
+    return sum;
+}
+
+static unsigned long
+copying(int fd)
+{
+    uint8_t buff[TEST_CHUNK];
+    unsigned long sum, len;
+    ssize_t length;
+
+    for (sum = 0;;) {
+        length = read(fd, buff, TEST_CHUNK);
+        if (length <= 0)
+            break;
+        bfdev_fifo_in(&fifo, buff, length);
+
+        len = bfdev_fifo_out(&fifo, buff, TEST_CHUNK);
+        sum = checksum(sum, buff, len);
+    }
+
+    return sum;
+}
+
+static int
+bench(const char *name, unsigned long (*func)(int fd), unsigned long expect)
+{
+    struct timeval start, stop;
+    unsigned long sum;
+    pthread_t thread;
+    int fds[2];
+    double usecs;
+
+    if (pipe(fds))
+        return 1;
+
+    /* start at an odd offset so that spans wrap around */
+    fifo.fifo.in = fifo.fifo.out = TEST_SIZE - 7;
+
+    gettimeofday(&start, NULL);
+    pthread_create(&thread, NULL, writer, (void *)(intptr_t)fds[1]);
+    sum = func(fds[0]);
+    pthread_join(thread, NULL);
+    gettimeofday(&stop, NULL);
+    close(fds[0]);
+
+    if (sum != expect || !bfdev_fifo_check_empty(&fifo)) {
+        bfdev_log_err("%s: checksum mismatch\n", name);
+        return 1;
+    }
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-8s %lu MiB: %8.3lf MiB/s\n", name, TEST_TOTAL >> 20,
+                   (TEST_TOTAL >> 20) / (usecs / 1000000.0));
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned long count, expect;
+    int retval;
+
+    for (count = 0; count < TEST_CHUNK; ++count)
+        source[count] = count * 31;
+
+    expect = checksum(0, source, TEST_CHUNK) * (TEST_TOTAL / TEST_CHUNK);
+
+    retval = bench("copying", copying, expect);
+    if (retval)
+        return retval;
+
+    return bench("zerocopy", zerocopy, expect);
+}
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <bfdev/log.h>
 #include <bfdev/heap.h>
+#include <bfdev/dheap.h>
 #include "../time.h"
 
 #define HEAP_DEBUG 0
@@ -17,6 +18,7 @@
 
 struct bench_node {
     bfdev_heap_node_t node;
+    bfdev_dheap_node_t dnode;
     unsigned int num;
     unsigned int data;
 };
@@ -24,6 +26,9 @@ struct bench_node {
 #define bfdev_heap_to_bench(ptr) \
     bfdev_heap_entry_safe(ptr, struct bench_node, node)
 
+#define bfdev_dheap_to_bench(ptr) \
+    bfdev_dheap_entry_safe(ptr, struct bench_node, dnode)
+
 #if HEAP_DEBUG
 static void
 node_dump(struct bench_node *node)
@@ -68,6 +73,97 @@ bench_cmp(const bfdev_heap_node_t *hpa,
     return node1->data < node2->data ? -1 : 1;
 }
 
+static long
+bench_dcmp(const bfdev_dheap_node_t *hpa,
+           const bfdev_dheap_node_t *hpb, void *pdata)
+{
+    struct bench_node *node1, *node2;
+
+    node1 = bfdev_dheap_to_bench(hpa);
+    node2 = bfdev_dheap_to_bench(hpb);
+
+    if (node1->data == node2->data)
+        return 0;
+
+    return node1->data < node2->data ? -1 : 1;
+}
+
+static int
+bench_dheap(struct bench_node *bnode)
+{
+    bfdev_dheap_node_t **nodes, *dnode;
+    unsigned int count, prev;
+    int retval;
+
+    BFDEV_DEFINE_DHEAP(bench_dheap, NULL, 0, bench_dcmp, NULL);
+
+    nodes = malloc(sizeof(*nodes) * TEST_LEN);
+    if (!nodes) {
+        bfdev_log_err("Insufficient memory!\n");
+        return 1;
+    }
+
+    for (count = 0; count < TEST_LEN; ++count)
+        nodes[count] = &bnode[count].dnode;
+
+    bfdev_log_info("D-ary heap insert nodes:\n");
+    retval = EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            retval = bfdev_dheap_insert(&bench_dheap, nodes[count]);
+            if (retval)
+                break;
+        }
+        retval;
+    );
+    if (retval)
+        goto failed;
+
+    bfdev_log_info("D-ary heap pop all nodes:\n");
+    retval = EXAMPLE_TIME_STATISTICAL(
+        for (prev = 0; (dnode = bfdev_dheap_pop(&bench_dheap)); ) {
+            if (bfdev_dheap_to_bench(dnode)->data < prev) {
+                retval = 1;
+                break;
+            }
+            prev = bfdev_dheap_to_bench(dnode)->data;
+        }
+        retval;
+    );
+    if (retval) {
+        bfdev_log_err("D-ary heap order error!\n");
+        goto failed;
+    }
+
+    bfdev_log_info("D-ary heap heapify nodes:\n");
+    retval = EXAMPLE_TIME_STATISTICAL(
+        bfdev_dheap_heapify(&bench_dheap, nodes, TEST_LEN);
+    );
+    if (retval)
+        goto failed;
+
+    bfdev_log_info("D-ary heap decrease all keys:\n");
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            bnode[count].data >>= 1;
+            bfdev_dheap_update(&bench_dheap, nodes[count]);
+        }
+        0;
+    );
+
+    bfdev_log_info("D-ary heap delete all nodes:\n");
+    EXAMPLE_TIME_STATISTICAL(
+        while ((dnode = bfdev_dheap_peek(&bench_dheap)))
+            bfdev_dheap_delete(&bench_dheap, dnode);
+        0;
+    );
+
+failed:
+    bfdev_dheap_release(&bench_dheap);
+    free(nodes);
+
+    return retval;
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -75,6 +171,7 @@ main(int argc, const char *argv[])
     unsigned int count;
     unsigned long index;
     void *block;
+    int retval;
 
     BFDEV_HEAP_ROOT(bench_root);
 
@@ -114,15 +211,23 @@ main(int argc, const char *argv[])
     );
     bfdev_log_info("\ttotal num: %u\n", count);
 
-    bfdev_log_info("Deletion all nodes...\n");
-    while (bench_root.count) {
-        bnode = bfdev_heap_to_bench(bench_root.node);
-        node_dump(bnode);
-        bfdev_heap_delete(&bench_root, &bnode->node, bench_cmp, NULL);
-    }
+    bfdev_log_info("Deletion all nodes:\n");
+    EXAMPLE_TIME_STATISTICAL(
+        while (bench_root.count) {
+            bnode = bfdev_heap_to_bench(bench_root.node);
+            node_dump(bnode);
+            bfdev_heap_delete(&bench_root, &bnode->node, bench_cmp, NULL);
+        }
+        0;
+    );
+
+    retval = bench_dheap(block);
+    if (retval)
+        goto error;
 
     bfdev_log_info("Done.\n");
-    free(block);
 
-    return 0;
+error:
+    free(block);
+    return retval;
 }
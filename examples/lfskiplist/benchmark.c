@@ -0,0 +1,369 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "lfskiplist-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <bfdev/lfskiplist.h>
+#include <bfdev/fskiplist.h>
+
+#define TEST_DEPTH 32
+#define TEST_KEYS (1U << 16)
+#define TEST_OPS (1U << 20)
+#define TEST_THREADS 32
+
+/* one in TEST_UPDATE operations inserts, another one deletes */
+#define TEST_UPDATE 10
+
+struct bench_ops {
+    const char *name;
+    int (*insert)(void *ctx, void *thread, void *key);
+    int (*delete)(void *ctx, void *thread, const void *key);
+    void *(*find)(void *ctx, void *thread, const void *key);
+    void *(*attach)(void *ctx);
+    void (*detach)(void *ctx, void *thread);
+};
+
+struct bench_worker {
+    pthread_t tid;
+    const struct bench_ops *ops;
+    void *ctx;
+    unsigned int index;
+    unsigned int threads;
+    unsigned int errors;
+};
+
+/* every key is owned by one worker, only the owner inserts or deletes it */
+static bool present[TEST_KEYS + 1];
+static pthread_barrier_t barrier;
+
+static long
+test_cmp(const void *key1, const void *key2, void *pdata)
+{
+    uintptr_t valuea, valueb;
+
+    valuea = (uintptr_t)key1;
+    valueb = (uintptr_t)key2;
+
+    if (valuea == valueb)
+        return 0;
+
+    return valuea > valueb ? 1 : -1;
+}
+
+static int
+lf_insert(void *ctx, void *thread, void *key)
+{
+    return bfdev_lfskiplist_insert(ctx, thread, key);
+}
+
+static int
+lf_delete(void *ctx, void *thread, const void *key)
+{
+    return bfdev_lfskiplist_delete(ctx, thread, key);
+}
+
+static void *
+lf_find(void *ctx, void *thread, const void *key)
+{
+    return bfdev_lfskiplist_find(ctx, thread, key);
+}
+
+static void *
+lf_attach(void *ctx)
+{
+    return bfdev_lfskiplist_attach(ctx);
+}
+
+static void
+lf_detach(void *ctx, void *thread)
+{
+    bfdev_lfskiplist_detach(ctx, thread);
+}
+
+static const struct bench_ops
+lf_ops = {
+    .name = "lock-free",
+    .insert = lf_insert,
+    .delete = lf_delete,
+    .find = lf_find,
+    .attach = lf_attach,
+    .detach = lf_detach,
+};
+
+struct locked_skiplist {
+    pthread_mutex_t lock;
+    bfdev_fskip_head_t *head;
+};
+
+static const bfdev_fskip_ops_t
+locked_fskip_ops = {
+    .cmp = test_cmp,
+};
+
+static int
+locked_insert(void *ctx, void *thread, void *key)
+{
+    struct locked_skiplist *locked = ctx;
+    int retval;
+
+    pthread_mutex_lock(&locked->lock);
+    retval = bfdev_fskiplist_insert(locked->head, key);
+    pthread_mutex_unlock(&locked->lock);
+
+    return retval;
+}
+
+static int
+locked_delete(void *ctx, void *thread, const void *key)
+{
+    struct locked_skiplist *locked = ctx;
+    void *retval;
+
+    pthread_mutex_lock(&locked->lock);
+    retval = bfdev_fskiplist_delete(locked->head, key);
+    pthread_mutex_unlock(&locked->lock);
+
+    return retval ? -BFDEV_ENOERR : -BFDEV_ENOENT;
+}
+
+static void *
+locked_find(void *ctx, void *thread, const void *key)
+{
+    struct locked_skiplist *locked = ctx;
+    bfdev_fskip_node_t *node;
+
+    pthread_mutex_lock(&locked->lock);
+    node = bfdev_fskiplist_find(locked->head, key);
+    pthread_mutex_unlock(&locked->lock);
+
+    return node ? node->key : NULL;
+}
+
+static void *
+locked_attach(void *ctx)
+{
+    return ctx;
+}
+
+static void
+locked_detach(void *ctx, void *thread)
+{
+}
+
+static const struct bench_ops
+locked_ops = {
+    .name = "mutex",
+    .insert = locked_insert,
+    .delete = locked_delete,
+    .find = locked_find,
+    .attach = locked_attach,
+    .detach = locked_detach,
+};
+
+static void *
+bench_worker(void *pdata)
+{
+    struct bench_worker *worker = pdata;
+    const struct bench_ops *ops = worker->ops;
+    unsigned int count, loops, action;
+    bfdev_prandom_t rand;
+    void *thread, *found;
+    uintptr_t key;
+    bool owner;
+
+    thread = ops->attach(worker->ctx);
+    if (!thread) {
+        worker->errors++;
+        return NULL;
+    }
+
+    loops = TEST_OPS / worker->threads;
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    pthread_barrier_wait(&barrier);
+
+    for (count = 0; count < loops; ++count) {
+        key = bfdev_prandom_value(&rand) % TEST_KEYS + 1;
+        action = bfdev_prandom_value(&rand) % TEST_UPDATE;
+
+        owner = key % worker->threads == worker->index;
+
+        if (action > 1 || !owner) {
+            /* lookups of foreign keys race with their owners */
+            found = ops->find(worker->ctx, thread, (void *)key);
+            if (owner && !!found != present[key])
+                worker->errors++;
+            continue;
+        }
+
+        if (present[key]) {
+            if (ops->delete(worker->ctx, thread, (void *)key))
+                worker->errors++;
+            present[key] = false;
+        } else {
+            if (ops->insert(worker->ctx, thread, (void *)key))
+                worker->errors++;
+            present[key] = true;
+        }
+    }
+
+    ops->detach(worker->ctx, thread);
+
+    return NULL;
+}
+
+static int
+bench_run(const struct bench_ops *ops, void *ctx, unsigned int threads)
+{
+    struct bench_worker workers[TEST_THREADS];
+    struct timeval start, stop;
+    unsigned int count, errors;
+    double usecs;
+
+    pthread_barrier_init(&barrier, NULL, threads + 1);
+    for (count = 0; count < threads; ++count) {
+        workers[count].ops = ops;
+        workers[count].ctx = ctx;
+        workers[count].index = count;
+        workers[count].threads = threads;
+        workers[count].errors = 0;
+        pthread_create(&workers[count].tid, NULL, bench_worker, &workers[count]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    gettimeofday(&start, NULL);
+
+    errors = 0;
+    for (count = 0; count < threads; ++count) {
+        pthread_join(workers[count].tid, NULL);
+        errors += workers[count].errors;
+    }
+
+    gettimeofday(&stop, NULL);
+    pthread_barrier_destroy(&barrier);
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-9s threads %2u: %8.3lf Mops/s\n", ops->name,
+                   threads, TEST_OPS / usecs);
+
+    if (errors) {
+        bfdev_log_err("%u operations returned a wrong result\n", errors);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int
+bench_lockfree(void)
+{
+    bfdev_lfskip_head_t *head;
+    bfdev_lfskip_thread_t *thread;
+    bfdev_lfskip_node_t *node;
+    unsigned int count, threads;
+    uintptr_t key, prev;
+    int retval;
+
+    head = bfdev_lfskiplist_create(NULL, TEST_DEPTH, test_cmp, NULL, NULL);
+    if (!head)
+        return 1;
+
+    thread = bfdev_lfskiplist_attach(head);
+    if (!thread)
+        return 1;
+
+    memset(present, 0, sizeof(present));
+    for (count = 1; count <= TEST_KEYS; count += 2) {
+        if (bfdev_lfskiplist_insert(head, thread, (void *)(uintptr_t)count))
+            return 1;
+        present[count] = true;
+    }
+    bfdev_lfskiplist_detach(head, thread);
+
+    retval = 0;
+    for (threads = 1; !retval && threads <= TEST_THREADS; threads <<= 1)
+        retval = bench_run(&lf_ops, head, threads);
+
+    /* the surviving keys must be exactly the ones the owners left behind */
+    thread = bfdev_lfskiplist_attach(head);
+    bfdev_lfskiplist_enter(head, thread);
+
+    prev = count = 0;
+    bfdev_lfskiplist_for_each(node, head) {
+        key = (uintptr_t)node->key;
+        if (key <= prev || !present[key])
+            retval = 1;
+        prev = key;
+        count++;
+    }
+
+    bfdev_lfskiplist_leave(head, thread);
+    bfdev_lfskiplist_detach(head, thread);
+
+    for (key = 1; key <= TEST_KEYS; ++key)
+        count -= present[key];
+
+    if (retval || count) {
+        bfdev_log_err("skiplist content mismatch\n");
+        retval = 1;
+    }
+
+    bfdev_lfskiplist_destroy(head);
+
+    return retval;
+}
+
+static int
+bench_locked(void)
+{
+    struct locked_skiplist locked;
+    unsigned int count, threads;
+    int retval;
+
+    locked.head = bfdev_fskiplist_create(NULL, &locked_fskip_ops,
+                                         TEST_DEPTH, false, NULL);
+    if (!locked.head)
+        return 1;
+
+    pthread_mutex_init(&locked.lock, NULL);
+    memset(present, 0, sizeof(present));
+    for (count = 1; count <= TEST_KEYS; count += 2) {
+        if (bfdev_fskiplist_insert(locked.head, (void *)(uintptr_t)count))
+            return 1;
+        present[count] = true;
+    }
+
+    retval = 0;
+    for (threads = 1; !retval && threads <= TEST_THREADS; threads <<= 1)
+        retval = bench_run(&locked_ops, &locked, threads);
+
+    pthread_mutex_destroy(&locked.lock);
+    bfdev_fskiplist_destroy(locked.head, NULL, NULL);
+
+    return retval;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    int retval;
+
+    bfdev_log_info("%u keys, %u operations, %u%% updates\n",
+                   TEST_KEYS, TEST_OPS, 200 / TEST_UPDATE);
+
+    retval = bench_lockfree();
+    if (!retval)
+        retval = bench_locked();
+
+    return retval;
+}
@@ -0,0 +1,296 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "mpmc-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <bfdev/log.h>
+#include <bfdev/fifo.h>
+#include <bfdev/minmax.h>
+#include <bfdev/mpmc.h>
+
+#define TEST_SIZE 1024
+#define TEST_ITEMS (1UL << 20)
+#define TEST_THREADS 32
+#define TEST_BATCH 16
+
+struct bench {
+    const char *name;
+    unsigned long (*in)(const uint64_t *buff, unsigned long count);
+    unsigned long (*out)(uint64_t *buff, unsigned long count);
+    unsigned long batch;
+};
+
+struct worker {
+    pthread_t tid;
+    const struct bench *bench;
+    unsigned int index;
+    unsigned long items;
+    uint64_t sum;
+    bool error;
+};
+
+static bfdev_mpmc_t mpmc;
+static BFDEV_DEFINE_FIFO(fifo, uint64_t, TEST_SIZE);
+static pthread_mutex_t fifo_lock = PTHREAD_MUTEX_INITIALIZER;
+static bfdev_atomic_t remain;
+
+static uint32_t *
+futex_word(bfdev_atomic_t *event)
+{
+    /* the low half changes on every increment */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (uint32_t *)(event + 1) - 1;
+#else
+    return (uint32_t *)event;
+#endif
+}
+
+static void
+futex_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAIT_PRIVATE,
+            (uint32_t)value, NULL, NULL, 0);
+}
+
+static void
+futex_wake(bfdev_atomic_t *event, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAKE_PRIVATE,
+            INT32_MAX, NULL, NULL, 0);
+}
+
+static const bfdev_mpmc_ops_t
+futex_ops = {
+    .wait = futex_wait,
+    .wake = futex_wake,
+};
+
+static unsigned long
+mutex_in(const uint64_t *buff, unsigned long count)
+{
+    unsigned long done;
+
+    pthread_mutex_lock(&fifo_lock);
+    done = bfdev_fifo_in(&fifo, buff, count);
+    pthread_mutex_unlock(&fifo_lock);
+
+    return done;
+}
+
+static unsigned long
+mutex_out(uint64_t *buff, unsigned long count)
+{
+    unsigned long done;
+
+    pthread_mutex_lock(&fifo_lock);
+    done = bfdev_fifo_out(&fifo, buff, count);
+    pthread_mutex_unlock(&fifo_lock);
+
+    return done;
+}
+
+static unsigned long
+try_in(const uint64_t *buff, unsigned long count)
+{
+    return bfdev_mpmc_try_in(&mpmc, buff, count);
+}
+
+static unsigned long
+try_out(uint64_t *buff, unsigned long count)
+{
+    return bfdev_mpmc_try_out(&mpmc, buff, count);
+}
+
+static unsigned long
+wait_in(const uint64_t *buff, unsigned long count)
+{
+    bfdev_mpmc_in(&mpmc, buff, count);
+    return count;
+}
+
+static unsigned long
+wait_out(uint64_t *buff, unsigned long count)
+{
+    unsigned long done;
+
+    bfdev_mpmc_out(&mpmc, buff, count, &done);
+    return done;
+}
+
+static const struct bench
+benches[] = {
+    {"mutex-fifo", mutex_in, mutex_out, 1},
+    {"mpmc-try", try_in, try_out, 1},
+    {"mpmc-batch", try_in, try_out, TEST_BATCH},
+    {"mpmc-futex", wait_in, wait_out, 1},
+};
+
+static void *
+producer(void *pdata)
+{
+    struct worker *worker = pdata;
+    uint64_t buff[TEST_BATCH];
+    unsigned long value, count, index, done;
+
+    for (value = 0; value < worker->items; value += done) {
+        count = bfdev_min(worker->bench->batch, worker->items - value);
+        for (index = 0; index < count; ++index)
+            buff[index] = ((uint64_t)worker->index << 32) | (value + index);
+
+        done = worker->bench->in(buff, count);
+        if (!done)
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+static void *
+consumer(void *pdata)
+{
+    struct worker *worker = pdata;
+    uint64_t buff[TEST_BATCH], last[TEST_THREADS];
+    unsigned long count, index, owner;
+    bool blocking;
+
+    for (index = 0; index < TEST_THREADS; ++index)
+        last[index] = UINT64_MAX;
+
+    /* blocking consumers sleep until they get a stop marker */
+    blocking = worker->bench->in == wait_in;
+
+    for (;;) {
+        if (!blocking && bfdev_atomic_read(&remain) <= 0)
+            break;
+
+        count = worker->bench->out(buff, worker->bench->batch);
+        if (!count) {
+            sched_yield();
+            continue;
+        }
+
+        for (index = 0; index < count; ++index) {
+            if (buff[index] == UINT64_MAX)
+                return NULL;
+
+            /* items of one producer must come out in order */
+            owner = buff[index] >> 32;
+            if (last[owner] != UINT64_MAX &&
+                (uint32_t)buff[index] <= (uint32_t)last[owner])
+                worker->error = true;
+
+            last[owner] = buff[index];
+            worker->sum += (uint32_t)buff[index];
+        }
+
+        bfdev_atomic_sub(&remain, count);
+    }
+
+    return NULL;
+}
+
+static int
+bench_run(const struct bench *bench, unsigned int threads)
+{
+    struct worker producers[TEST_THREADS], consumers[TEST_THREADS];
+    struct timeval start, stop;
+    uint64_t sum, expect, stopper;
+    unsigned int count;
+    double usecs;
+
+    stopper = UINT64_MAX;
+    remain = TEST_ITEMS;
+    expect = 0;
+
+    gettimeofday(&start, NULL);
+    for (count = 0; count < threads; ++count) {
+        consumers[count] = (struct worker) {
+            .bench = bench, .index = count,
+        };
+        pthread_create(&consumers[count].tid, NULL, consumer,
+                       &consumers[count]);
+    }
+
+    for (count = 0; count < threads; ++count) {
+        producers[count] = (struct worker) {
+            .bench = bench, .index = count,
+            .items = TEST_ITEMS / threads,
+        };
+        expect += (uint64_t)producers[count].items *
+                  (producers[count].items - 1) / 2;
+        pthread_create(&producers[count].tid, NULL, producer,
+                       &producers[count]);
+    }
+
+    for (count = 0; count < threads; ++count)
+        pthread_join(producers[count].tid, NULL);
+
+    /* one stop marker for every sleeping consumer */
+    if (bench->in == wait_in) {
+        for (count = 0; count < threads; ++count)
+            bench->in(&stopper, 1);
+    }
+
+    sum = 0;
+    for (count = 0; count < threads; ++count) {
+        pthread_join(consumers[count].tid, NULL);
+        if (consumers[count].error) {
+            bfdev_log_err("%s: order violated\n", bench->name);
+            return 1;
+        }
+        sum += consumers[count].sum;
+    }
+    gettimeofday(&stop, NULL);
+
+    if (sum != expect) {
+        bfdev_log_err("%s: checksum mismatch\n", bench->name);
+        return 1;
+    }
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-10s %2u:%-2u %8.3lf Mops/s\n", bench->name,
+                   threads, threads, TEST_ITEMS / usecs);
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int count, threads;
+    int retval;
+
+    retval = bfdev_mpmc_alloc(&mpmc, NULL, sizeof(uint64_t), TEST_SIZE);
+    if (retval)
+        return retval;
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(benches); ++count) {
+        if (benches[count].in == wait_in)
+            bfdev_mpmc_set_wait(&mpmc, &futex_ops, NULL);
+
+        for (threads = 1; threads <= TEST_THREADS; threads <<= 1) {
+            retval = bench_run(&benches[count], threads);
+            if (retval)
+                break;
+        }
+
+        bfdev_mpmc_set_wait(&mpmc, NULL, NULL);
+        if (retval)
+            break;
+    }
+
+    bfdev_mpmc_free(&mpmc);
+    return retval;
+}
@@ -0,0 +1,286 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "mpsc-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/mpsc.h>
+#include <bfdev/container.h>
+
+#define TEST_ITEMS (1UL << 20)
+#define TEST_THREADS 32
+
+struct item {
+    bfdev_slist_head_t node;
+    unsigned int owner;
+    unsigned long seq;
+};
+
+struct bench {
+    const char *name;
+    void (*push)(struct item *item);
+    unsigned long (*drain)(unsigned long *last, bool *error);
+};
+
+struct worker {
+    pthread_t tid;
+    const struct bench *bench;
+    struct item *items;
+    unsigned long count;
+};
+
+static struct item *items;
+static bfdev_mpsc_t mpsc;
+
+static BFDEV_SLIST_HEAD(llist);
+static BFDEV_SLIST_HEAD(mutex_head);
+static bfdev_slist_head_t *mutex_tail = &mutex_head;
+static pthread_mutex_t mutex_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t *
+futex_word(bfdev_atomic_t *event)
+{
+    /* the low half changes on every increment */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (uint32_t *)(event + 1) - 1;
+#else
+    return (uint32_t *)event;
+#endif
+}
+
+static void
+futex_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAIT_PRIVATE,
+            (uint32_t)value, NULL, NULL, 0);
+}
+
+static void
+futex_wake(bfdev_atomic_t *event, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAKE_PRIVATE,
+            1, NULL, NULL, 0);
+}
+
+static const bfdev_mpsc_ops_t
+futex_ops = {
+    .wait = futex_wait,
+    .wake = futex_wake,
+};
+
+static bool
+check_order(struct item *item, unsigned long *last)
+{
+    bool error;
+
+    error = last[item->owner] != ULONG_MAX &&
+            item->seq != last[item->owner] + 1;
+    last[item->owner] = item->seq;
+
+    return error;
+}
+
+static void
+mutex_push(struct item *item)
+{
+    item->node.next = NULL;
+    pthread_mutex_lock(&mutex_lock);
+    mutex_tail->next = &item->node;
+    mutex_tail = &item->node;
+    pthread_mutex_unlock(&mutex_lock);
+}
+
+static unsigned long
+mutex_drain(unsigned long *last, bool *error)
+{
+    bfdev_slist_head_t *node;
+    struct item *item;
+
+    pthread_mutex_lock(&mutex_lock);
+    node = mutex_head.next;
+    if (node) {
+        mutex_head.next = node->next;
+        if (mutex_tail == node)
+            mutex_tail = &mutex_head;
+    }
+    pthread_mutex_unlock(&mutex_lock);
+
+    if (!node) {
+        sched_yield();
+        return 0;
+    }
+
+    item = bfdev_container_of(node, struct item, node);
+    *error |= check_order(item, last);
+
+    return 1;
+}
+
+static void
+llist_push(struct item *item)
+{
+    bfdev_llist_add(&llist, &item->node);
+}
+
+static unsigned long
+llist_drain(unsigned long *last, bool *error)
+{
+    /* lifo single pop, no order to check */
+    if (bfdev_llist_del(&llist))
+        return 1;
+
+    sched_yield();
+    return 0;
+}
+
+static void
+mpsc_push(struct item *item)
+{
+    bfdev_mpsc_push(&mpsc, &item->node);
+}
+
+static unsigned long
+pop_drain(unsigned long *last, bool *error)
+{
+    bfdev_slist_head_t *node;
+    struct item *item;
+
+    node = bfdev_mpsc_pop(&mpsc);
+    if (!node) {
+        sched_yield();
+        return 0;
+    }
+
+    item = bfdev_container_of(node, struct item, node);
+    *error |= check_order(item, last);
+
+    return 1;
+}
+
+static unsigned long
+wait_drain(unsigned long *last, bool *error)
+{
+    bfdev_slist_head_t *node, *tmp;
+    unsigned long count;
+    struct item *item;
+
+    bfdev_mpsc_wait(&mpsc);
+
+    count = 0;
+    bfdev_mpsc_for_each_chain(node, tmp, bfdev_mpsc_pop_all(&mpsc)) {
+        item = bfdev_container_of(node, struct item, node);
+        *error |= check_order(item, last);
+        count++;
+    }
+
+    return count;
+}
+
+static const struct bench
+benches[] = {
+    {"mutex-list", mutex_push, mutex_drain},
+    {"llist-del", llist_push, llist_drain},
+    {"mpsc-pop", mpsc_push, pop_drain},
+    {"mpsc-futex", mpsc_push, wait_drain},
+};
+
+static void *
+producer(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+
+    for (count = 0; count < worker->count; ++count)
+        worker->bench->push(&worker->items[count]);
+
+    return NULL;
+}
+
+static int
+bench_run(const struct bench *bench, unsigned int threads)
+{
+    struct worker workers[TEST_THREADS];
+    unsigned long last[TEST_THREADS], index, count, done;
+    struct timeval start, stop;
+    unsigned int thread;
+    double usecs;
+    bool error;
+
+    count = TEST_ITEMS / threads;
+    for (thread = 0; thread < threads; ++thread) {
+        last[thread] = ULONG_MAX;
+        workers[thread] = (struct worker) {
+            .bench = bench,
+            .items = items + thread * count,
+            .count = count,
+        };
+
+        for (index = 0; index < count; ++index) {
+            workers[thread].items[index].owner = thread;
+            workers[thread].items[index].seq = index;
+        }
+    }
+
+    gettimeofday(&start, NULL);
+    for (thread = 0; thread < threads; ++thread)
+        pthread_create(&workers[thread].tid, NULL, producer,
+                       &workers[thread]);
+
+    error = false;
+    for (done = 0; done < count * threads;)
+        done += bench->drain(last, &error);
+
+    for (thread = 0; thread < threads; ++thread)
+        pthread_join(workers[thread].tid, NULL);
+    gettimeofday(&stop, NULL);
+
+    if (error) {
+        bfdev_log_err("%s: order violated\n", bench->name);
+        return 1;
+    }
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-10s %2u:1 %8.3lf Mops/s\n", bench->name,
+                   threads, done / usecs);
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int count, threads;
+    int retval;
+
+    items = malloc(sizeof(*items) * TEST_ITEMS);
+    if (!items)
+        return 1;
+
+    bfdev_mpsc_init(&mpsc, &futex_ops, NULL);
+    for (count = 0; count < BFDEV_ARRAY_SIZE(benches); ++count) {
+        for (threads = 1; threads <= TEST_THREADS; threads <<= 1) {
+            retval = bench_run(&benches[count], threads);
+            if (retval)
+                goto finish;
+        }
+    }
+
+finish:
+    free(items);
+    return retval;
+}
@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "notifier-rcu"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/notifier-rcu.h>
+
+#define TEST_NODES 8
+#define TEST_EVENTS (1UL << 20)
+#define TEST_THREADS 4
+#define TEST_MAGIC 0x5a5a5a5aUL
+
+struct hits {
+    unsigned long base;
+    unsigned long churn;
+    bool corrupt;
+};
+
+struct reader {
+    pthread_t tid;
+    unsigned int cpu;
+    struct hits hits;
+};
+
+struct bench {
+    const char *name;
+    void (*call)(unsigned int cpu, struct hits *hits);
+    void (*churn)(bfdev_notifier_node_t *node);
+};
+
+static BFDEV_DEFINE_NOTIFIER(notifier);
+static bfdev_notifier_rcu_t notifier_rcu;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static bfdev_notifier_node_t nodes[TEST_NODES];
+static bfdev_notifier_node_t rcu_nodes[TEST_NODES];
+static const struct bench *current;
+static bfdev_atomic_t running;
+
+static bfdev_notifier_ret_t
+count_hits(void *args, void *pdata)
+{
+    struct hits *hits = args;
+    unsigned long *magic = pdata;
+
+    if (!magic)
+        hits->base++;
+    else if (*magic == TEST_MAGIC)
+        hits->churn++;
+    else
+        hits->corrupt = true;
+
+    return BFDEV_NOTIFI_RET_DONE;
+}
+
+static void
+mutex_call(unsigned int cpu, struct hits *hits)
+{
+    pthread_mutex_lock(&mutex);
+    bfdev_notifier_call(&notifier, hits, -1, NULL);
+    pthread_mutex_unlock(&mutex);
+}
+
+static void
+mutex_churn(bfdev_notifier_node_t *node)
+{
+    pthread_mutex_lock(&mutex);
+    bfdev_notifier_register(&notifier, node);
+    pthread_mutex_unlock(&mutex);
+
+    sched_yield();
+
+    pthread_mutex_lock(&mutex);
+    bfdev_notifier_unregister(&notifier, node);
+    pthread_mutex_unlock(&mutex);
+}
+
+static void
+rwlock_call(unsigned int cpu, struct hits *hits)
+{
+    pthread_rwlock_rdlock(&rwlock);
+    bfdev_notifier_call(&notifier, hits, -1, NULL);
+    pthread_rwlock_unlock(&rwlock);
+}
+
+static void
+rwlock_churn(bfdev_notifier_node_t *node)
+{
+    pthread_rwlock_wrlock(&rwlock);
+    bfdev_notifier_register(&notifier, node);
+    pthread_rwlock_unlock(&rwlock);
+
+    sched_yield();
+
+    pthread_rwlock_wrlock(&rwlock);
+    bfdev_notifier_unregister(&notifier, node);
+    pthread_rwlock_unlock(&rwlock);
+}
+
+static void
+rcu_call(unsigned int cpu, struct hits *hits)
+{
+    bfdev_notifier_rcu_call(&notifier_rcu, cpu, hits, -1, NULL);
+}
+
+static void
+rcu_churn(bfdev_notifier_node_t *node)
+{
+    bfdev_notifier_rcu_register(&notifier_rcu, node);
+    sched_yield();
+    bfdev_notifier_rcu_unregister(&notifier_rcu, node);
+}
+
+static const struct bench
+benches[] = {
+    {"mutex", mutex_call, mutex_churn},
+    {"rwlock", rwlock_call, rwlock_churn},
+    {"rcu", rcu_call, rcu_churn},
+};
+
+static void *
+reader(void *pdata)
+{
+    struct reader *reader = pdata;
+    unsigned long count;
+
+    for (count = 0; count < TEST_EVENTS; ++count)
+        current->call(reader->cpu, &reader->hits);
+
+    return NULL;
+}
+
+static void *
+writer(void *pdata)
+{
+    bfdev_notifier_node_t node;
+    unsigned long *magic;
+
+    while (bfdev_atomic_read(&running)) {
+        magic = malloc(sizeof(*magic));
+        if (!magic)
+            break;
+
+        /* poisoned and freed as soon as the chain lets go of it */
+        *magic = TEST_MAGIC;
+        node.priority = rand() % TEST_NODES;
+        node.entry = count_hits;
+        node.pdata = magic;
+        current->churn(&node);
+
+        if (current->churn == rcu_churn) {
+            while (!bfdev_notifier_rcu_reclaim(&notifier_rcu))
+                sched_yield();
+        }
+
+        *magic = 0;
+        free(magic);
+    }
+
+    return NULL;
+}
+
+static int
+bench_run(const struct bench *bench)
+{
+    struct reader readers[TEST_THREADS];
+    struct timeval start, stop;
+    unsigned long churn;
+    unsigned int thread;
+    pthread_t churner;
+    double usecs;
+
+    current = bench;
+    bfdev_atomic_write(&running, 1);
+    pthread_create(&churner, NULL, writer, NULL);
+
+    gettimeofday(&start, NULL);
+    for (thread = 0; thread < TEST_THREADS; ++thread) {
+        readers[thread] = (struct reader) {.cpu = thread};
+        pthread_create(&readers[thread].tid, NULL, reader, &readers[thread]);
+    }
+
+    for (thread = 0; thread < TEST_THREADS; ++thread)
+        pthread_join(readers[thread].tid, NULL);
+    gettimeofday(&stop, NULL);
+
+    bfdev_atomic_write(&running, 0);
+    pthread_join(churner, NULL);
+
+    for (thread = churn = 0; thread < TEST_THREADS; ++thread) {
+        if (readers[thread].hits.corrupt ||
+            readers[thread].hits.base != TEST_EVENTS * TEST_NODES) {
+            bfdev_log_err("%s: chain corrupted\n", bench->name);
+            return 1;
+        }
+        churn += readers[thread].hits.churn;
+    }
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-6s %u readers: %8.3lf Mevents/s, %lu churn calls\n",
+                   bench->name, TEST_THREADS,
+                   TEST_EVENTS * TEST_THREADS / usecs, churn);
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int count;
+    int retval;
+
+    retval = bfdev_notifier_rcu_alloc(&notifier_rcu, NULL, TEST_THREADS);
+    if (retval)
+        return retval;
+
+    for (count = 0; count < TEST_NODES; ++count) {
+        nodes[count].priority = count;
+        nodes[count].entry = count_hits;
+        nodes[count].pdata = NULL;
+        rcu_nodes[count] = nodes[count];
+
+        bfdev_notifier_register(&notifier, &nodes[count]);
+        retval = bfdev_notifier_rcu_register(&notifier_rcu, &rcu_nodes[count]);
+        if (retval)
+            goto finish;
+    }
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(benches); ++count) {
+        retval = bench_run(&benches[count]);
+        if (retval)
+            break;
+    }
+
+finish:
+    bfdev_notifier_rcu_free(&notifier_rcu);
+    return retval;
+}
@@ -0,0 +1,221 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "percpu-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <bfdev/log.h>
+#include <bfdev/percpu.h>
+#include <bfdev/refcount.h>
+
+#define TEST_LOOP (1UL << 22)
+#define TEST_THREADS 8
+
+struct worker {
+    pthread_t tid;
+    unsigned int cpu;
+    unsigned long count;
+    bfdev_atomic_t *released;
+};
+
+static bfdev_atomic_t shared;
+static BFDEV_DEFINE_REFCNT(refcnt);
+static bfdev_percpu_counter_t counter;
+static bfdev_percpu_refcnt_t percpu;
+
+static void *
+shared_counter(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+
+    for (count = 0; count < worker->count; ++count)
+        bfdev_atomic_add(&shared, 1);
+
+    return NULL;
+}
+
+static void *
+percpu_counter(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+
+    for (count = 0; count < worker->count; ++count)
+        bfdev_percpu_counter_inc(&counter, worker->cpu);
+
+    return NULL;
+}
+
+static void *
+shared_refcnt(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+
+    for (count = 0; count < worker->count; ++count) {
+        bfdev_refcnt_inc(&refcnt);
+        if (bfdev_refcnt_dec_test(&refcnt))
+            bfdev_atomic_add(worker->released, 1);
+    }
+
+    return NULL;
+}
+
+static void *
+percpu_refcnt(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+
+    for (count = 0; count < worker->count; ++count) {
+        if (!bfdev_percpu_refcnt_tryget_live(&percpu, worker->cpu))
+            break;
+        if (bfdev_percpu_refcnt_put(&percpu, worker->cpu))
+            bfdev_atomic_add(worker->released, 1);
+    }
+
+    return NULL;
+}
+
+static double
+bench_run(void *(*func)(void *), unsigned int threads,
+          unsigned long count, bfdev_atomic_t *released)
+{
+    struct worker workers[TEST_THREADS];
+    struct timeval start, stop;
+    unsigned int thread;
+
+    gettimeofday(&start, NULL);
+    for (thread = 0; thread < threads; ++thread) {
+        workers[thread] = (struct worker) {
+            .cpu = thread,
+            .count = count,
+            .released = released,
+        };
+        pthread_create(&workers[thread].tid, NULL, func, &workers[thread]);
+    }
+
+    for (thread = 0; thread < threads; ++thread)
+        pthread_join(workers[thread].tid, NULL);
+    gettimeofday(&stop, NULL);
+
+    return (stop.tv_sec - start.tv_sec) * 1000000.0 +
+           (stop.tv_usec - start.tv_usec);
+}
+
+static void *
+racing_kill(void *pdata)
+{
+    bfdev_atomic_t *released = pdata;
+
+    if (bfdev_percpu_refcnt_kill(&percpu))
+        bfdev_atomic_add(released, 1);
+
+    return NULL;
+}
+
+static int
+kill_check(unsigned int threads)
+{
+    struct worker workers[TEST_THREADS];
+    bfdev_atomic_t released;
+    unsigned int thread;
+    pthread_t killer;
+
+    /* kill while every thread keeps taking and dropping references */
+    released = 0;
+    bfdev_percpu_refcnt_reinit(&percpu);
+
+    for (thread = 0; thread < threads; ++thread) {
+        workers[thread] = (struct worker) {
+            .cpu = thread,
+            .count = ~0UL,
+            .released = &released,
+        };
+        pthread_create(&workers[thread].tid, NULL, percpu_refcnt,
+                       &workers[thread]);
+    }
+
+    pthread_create(&killer, NULL, racing_kill, &released);
+    pthread_join(killer, NULL);
+
+    for (thread = 0; thread < threads; ++thread)
+        pthread_join(workers[thread].tid, NULL);
+
+    if (released != 1 || bfdev_percpu_refcnt_tryget(&percpu, 0)) {
+        bfdev_log_err("kill with %u threads released %ld times\n",
+                      threads, (long)released);
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    bfdev_atomic_t released;
+    unsigned int threads;
+    double usecs;
+    int retval;
+
+    retval = bfdev_percpu_counter_alloc(&counter, NULL, TEST_THREADS);
+    if (retval)
+        return retval;
+
+    retval = bfdev_percpu_refcnt_alloc(&percpu, NULL, TEST_THREADS);
+    if (retval)
+        goto failed;
+
+    for (threads = 1; threads <= TEST_THREADS; threads <<= 1) {
+        bfdev_atomic_write(&shared, 0);
+        usecs = bench_run(shared_counter, threads, TEST_LOOP / threads, NULL);
+        bfdev_log_info("shared counter  %u threads: %8.3lf Mops/s\n",
+                       threads, TEST_LOOP / usecs);
+
+        bfdev_percpu_counter_reset(&counter);
+        usecs = bench_run(percpu_counter, threads, TEST_LOOP / threads, NULL);
+        bfdev_log_info("percpu counter  %u threads: %8.3lf Mops/s\n",
+                       threads, TEST_LOOP / usecs);
+
+        if (shared != bfdev_percpu_counter_sum(&counter)) {
+            bfdev_log_err("counter mismatch\n");
+            retval = 1;
+            goto finish;
+        }
+
+        released = 0;
+        usecs = bench_run(shared_refcnt, threads,
+                          TEST_LOOP / threads, &released);
+        bfdev_log_info("shared refcount %u threads: %8.3lf Mops/s\n",
+                       threads, TEST_LOOP / usecs);
+
+        bfdev_percpu_refcnt_reinit(&percpu);
+        usecs = bench_run(percpu_refcnt, threads,
+                          TEST_LOOP / threads, &released);
+        bfdev_log_info("percpu refcount %u threads: %8.3lf Mops/s\n",
+                       threads, TEST_LOOP / usecs);
+
+        if (released || !bfdev_percpu_refcnt_kill(&percpu)) {
+            bfdev_log_err("refcount released early\n");
+            retval = 1;
+            goto finish;
+        }
+
+        retval = kill_check(threads);
+        if (retval)
+            goto finish;
+    }
+
+finish:
+    bfdev_percpu_refcnt_free(&percpu);
+failed:
+    bfdev_percpu_counter_free(&counter);
+    return retval;
+}
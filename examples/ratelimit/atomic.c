@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "ratelimit-atomic"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <pthread.h>
+#include <bfdev/log.h>
+#include <bfdev/ratelimit.h>
+
+#define TEST_THREADS 8
+#define TEST_LOOP 100000
+#define TEST_INTERVAL 100
+#define TEST_BURST 300
+#define TEST_BASE 1700000000000LL
+
+struct worker {
+    pthread_t tid;
+    bfdev_time_t current;
+    unsigned long passed;
+};
+
+static BFDEV_DEFINE_RATELIMIT_ATOMIC(limit, TEST_INTERVAL, TEST_BURST);
+
+static void *
+test_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+    unsigned int batch;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        batch = count % 3 + 1;
+        if (bfdev_ratelimit_acquire(&limit, worker->current, batch))
+            worker->passed += batch;
+    }
+
+    return NULL;
+}
+
+static unsigned long
+test_period(bfdev_time_t current)
+{
+    struct worker workers[TEST_THREADS];
+    unsigned long passed;
+    unsigned int count;
+
+    for (count = 0; count < TEST_THREADS; ++count) {
+        workers[count] = (struct worker) {.current = current};
+        pthread_create(&workers[count].tid, NULL, test_worker, &workers[count]);
+    }
+
+    passed = 0;
+    for (count = 0; count < TEST_THREADS; ++count) {
+        pthread_join(workers[count].tid, NULL);
+        passed += workers[count].passed;
+    }
+
+    bfdev_log("ratelimit %lld: passed %lu\n", (long long)current, passed);
+    return passed;
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned int count;
+
+    for (count = 0; count < 4; ++count) {
+        if (test_period(TEST_BASE + count * TEST_INTERVAL) != TEST_BURST) {
+            bfdev_log_err("burst exceeded\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "ringbuf-mirror"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <string.h>
+#include <bfdev/log.h>
+#include <bfdev/ringbuf.h>
+#include "../time.h"
+
+#define TEST_SIZE (1UL << 16)
+#define TEST_RECORD 2
+#define TEST_LOOP (1UL << 18)
+#define TEST_PAYLOAD 1500
+
+static BFDEV_DEFINE_RINGBUF_DYNAMIC_RECORD(normal, uint8_t, TEST_RECORD);
+static BFDEV_DEFINE_RINGBUF_DYNAMIC_RECORD(mirror, uint8_t, TEST_RECORD);
+static uint8_t packet[TEST_PAYLOAD];
+
+static unsigned long
+checksum(unsigned long sum, const uint8_t *data, unsigned long len)
+{
+    while (len--)
+        sum += *data++;
+    return sum;
+}
+
+/* classic record path, every record is reassembled into a buffer */
+static unsigned long
+copying(void)
+{
+    uint8_t buff[TEST_PAYLOAD];
+    unsigned long count, len, sum;
+
+    for (count = sum = 0; count < TEST_LOOP; ++count) {
+        len = 64 + count % (TEST_PAYLOAD - 64);
+        bfdev_ringbuf_in(&normal, packet, len);
+        len = bfdev_ringbuf_out(&normal, buff, TEST_PAYLOAD);
+        sum = checksum(sum, buff, len);
+    }
+
+    return sum;
+}
+
+/* double-mapped path, every record is parsed where it lies */
+static unsigned long
+inplace(bool *split)
+{
+    bfdev_ringbuf_span_t spans[2];
+    unsigned long count, len, sum;
+
+    for (count = sum = 0; count < TEST_LOOP; ++count) {
+        len = 64 + count % (TEST_PAYLOAD - 64);
+        bfdev_ringbuf_in(&mirror, packet, len);
+        len = bfdev_ringbuf_peek_spans(&mirror, spans, TEST_PAYLOAD);
+        *split |= !!spans[1].len;
+        sum = checksum(sum, spans[0].data, spans[0].len);
+        bfdev_ringbuf_consume(&mirror, len);
+    }
+
+    return sum;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned long count, expect, sum;
+    bool split;
+    int retval;
+
+    for (count = 0; count < TEST_PAYLOAD; ++count)
+        packet[count] = count * 7;
+
+    retval = bfdev_ringbuf_alloc(&normal, NULL, TEST_SIZE);
+    if (retval)
+        return retval;
+
+    retval = bfdev_ringbuf_alloc_mirror(&mirror, TEST_SIZE);
+    if (retval == -BFDEV_EOPNOTSUPP) {
+        bfdev_log_warn("double mapping not supported\n");
+        bfdev_ringbuf_free(&normal);
+        return 0;
+    } else if (retval) {
+        bfdev_ringbuf_free(&normal);
+        return retval;
+    }
+
+    bfdev_log_info("Copy %lu records out:\n", TEST_LOOP);
+    EXAMPLE_TIME_STATISTICAL(
+        expect = copying();
+        0;
+    );
+
+    split = false;
+    bfdev_log_info("Parse %lu records in place:\n", TEST_LOOP);
+    EXAMPLE_TIME_STATISTICAL(
+        sum = inplace(&split);
+        0;
+    );
+
+    bfdev_ringbuf_free(&mirror);
+    bfdev_ringbuf_free(&normal);
+
+    if (split || sum != expect) {
+        bfdev_log_err("mirror mismatch\n");
+        return 1;
+    }
+
+    return 0;
+}
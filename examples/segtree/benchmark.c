@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "segtree-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <bfdev/log.h>
+#include <bfdev/sort.h>
+#include <bfdev/segtree.h>
+#include "../time.h"
+
+#define TEST_LEN 200000
+#define TEST_QUERY 200000
+#define TEST_RANGE (1UL << 32)
+#define TEST_SPAN (1UL << 16)
+
+struct test_node {
+    bfdev_segtree_node_t node;
+};
+
+static long
+node_cmp(const void *key1, const void *key2, void *pdata)
+{
+    const bfdev_segtree_node_t *node1, *node2;
+
+    node1 = *(bfdev_segtree_node_t *const *)key1;
+    node2 = *(bfdev_segtree_node_t *const *)key2;
+
+    if (node1->start == node2->start)
+        return 0;
+
+    return node1->start > node2->start ? 1 : -1;
+}
+
+static long
+point_cmp(const void *key1, const void *key2, void *pdata)
+{
+    unsigned long point1, point2;
+
+    point1 = *(const unsigned long *)key1;
+    point2 = *(const unsigned long *)key2;
+
+    if (point1 == point2)
+        return 0;
+
+    return point1 > point2 ? 1 : -1;
+}
+
+static int
+stab_count(bfdev_segtree_node_t *node, size_t index, void *pdata)
+{
+    unsigned long *hits = pdata;
+
+    (*hits)++;
+    return 0;
+}
+
+static unsigned long
+random_value(void)
+{
+    return (((unsigned long)rand() << 16) ^ rand()) % TEST_RANGE;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    bfdev_segtree_node_t **sorted, *snode;
+    unsigned long *points, hits, bhits;
+    struct test_node *nodes;
+    unsigned int count;
+    int retval;
+
+    BFDEV_RB_ROOT_CACHED(root);
+    BFDEV_RB_ROOT_CACHED(built);
+
+    nodes = malloc(sizeof(*nodes) * TEST_LEN);
+    sorted = malloc(sizeof(*sorted) * TEST_LEN);
+    points = malloc(sizeof(*points) * TEST_QUERY);
+    if (!nodes || !sorted || !points)
+        return 1;
+
+    srand(time(NULL));
+    for (count = 0; count < TEST_LEN; ++count) {
+        nodes[count].node.start = random_value();
+        nodes[count].node.end = nodes[count].node.start +
+                                (unsigned long)rand() % TEST_SPAN;
+        sorted[count] = &nodes[count].node;
+    }
+
+    for (count = 0; count < TEST_QUERY; ++count)
+        points[count] = random_value();
+
+    bfdev_sort(sorted, TEST_LEN, sizeof(*sorted), node_cmp, NULL);
+    bfdev_sort(points, TEST_QUERY, sizeof(*points), point_cmp, NULL);
+
+    bfdev_log_info("Insert %u nodes:\n", TEST_LEN);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count)
+            bfdev_segtree_insert(&root, &nodes[count].node);
+        0;
+    );
+
+    bfdev_log_info("Query %u sorted points one by one:\n", TEST_QUERY);
+    hits = 0;
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_QUERY; ++count) {
+            bfdev_segtree_for_each(snode, points[count], points[count], &root)
+                hits++;
+        }
+        0;
+    );
+
+    /* the bulk build relinks the same nodes into a second tree */
+    bfdev_log_info("Build %u sorted nodes:\n", TEST_LEN);
+    EXAMPLE_TIME_STATISTICAL(
+        bfdev_segtree_build(&built, sorted, TEST_LEN);
+        0;
+    );
+
+    bfdev_log_info("Query %u sorted points in batch:\n", TEST_QUERY);
+    bhits = 0;
+    EXAMPLE_TIME_STATISTICAL(
+        bfdev_segtree_stab(&built, points, TEST_QUERY, stab_count, &bhits);
+        0;
+    );
+
+    bfdev_log_info("%lu segments hit by %u points\n", hits, TEST_QUERY);
+    retval = hits != bhits;
+    if (retval)
+        bfdev_log_err("batch query mismatch: %lu\n", bhits);
+
+    free(points);
+    free(sorted);
+    free(nodes);
+
+    return retval;
+}
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <bfdev/log.h>
 #include <bfdev/skiplist.h>
+#include <bfdev/fskiplist.h>
 #include "../time.h"
 
 #define TEST_DEPTH 32
@@ -43,6 +44,77 @@ test_find(const void *node, void *pdata)
     return valuea > valueb ? 1 : -1;
 }
 
+static uintptr_t
+test_prefix(const void *key, void *pdata)
+{
+    return (uintptr_t)key;
+}
+
+static const bfdev_fskip_ops_t
+test_ops = {
+    .cmp = test_cmp,
+    .prefix = test_prefix,
+};
+
+static int
+bench_fskiplist(uintptr_t *record, bool finger)
+{
+    bfdev_fskip_head_t *head;
+    bfdev_fskip_node_t *node;
+    unsigned int count;
+    uintptr_t value;
+    int retval;
+
+    head = bfdev_fskiplist_create(NULL, &test_ops, TEST_DEPTH, finger, NULL);
+    if (!head)
+        return 1;
+
+    bfdev_log_info("Forward insert %u node (finger %d):\n", TEST_LEN, finger);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            retval = bfdev_fskiplist_insert(head, (void *)record[count]);
+            if (retval)
+                return 1;
+        }
+        0;
+    );
+
+    bfdev_log_info("Forward find %u node (finger %d):\n", TEST_LEN, finger);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            value = record[(unsigned long)rand() % TEST_LEN];
+            node = bfdev_fskiplist_find(head, (void *)value);
+            if (!node)
+                return 1;
+        }
+        0;
+    );
+
+    bfdev_log_info("Forward delete %u node (finger %d):\n", TEST_LEN, finger);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            if (!bfdev_fskiplist_delete(head, (void *)record[count]))
+                return 1;
+        }
+        0;
+    );
+
+    bfdev_fskiplist_reset(head, NULL, NULL);
+    bfdev_log_info("Forward sequential insert %u node (finger %d):\n", TEST_LEN, finger);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            retval = bfdev_fskiplist_insert(head, (void *)(uintptr_t)count);
+            if (retval)
+                return 1;
+        }
+        0;
+    );
+
+    bfdev_fskiplist_destroy(head, NULL, NULL);
+
+    return 0;
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -84,8 +156,24 @@ main(int argc, const char *argv[])
         0;
     );
 
+    bfdev_skiplist_reset(head, NULL, NULL);
+    bfdev_log_info("Sequential insert %u node:\n", TEST_LEN);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count) {
+            retval = bfdev_skiplist_insert(head, (void *)(uintptr_t)count, test_cmp, NULL);
+            if (retval)
+                return 1;
+        }
+        0;
+    );
+
     bfdev_skiplist_destroy(head, NULL, NULL);
+
+    retval = bench_fskiplist(record, false);
+    if (!retval)
+        retval = bench_fskiplist(record, true);
+
     free(record);
 
-    return 0;
+    return retval;
 }
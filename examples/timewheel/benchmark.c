@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "timewheel-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <bfdev/log.h>
+#include <bfdev/heap.h>
+#include <bfdev/timewheel.h>
+#include "../time.h"
+
+#define TEST_LEN 1000000
+#define TEST_RANGE (1U << 20)
+#define TEST_STEP 1000
+
+struct bench_node {
+    bfdev_timewheel_node_t timer;
+    bfdev_heap_node_t node;
+    bfdev_time_t expires;
+};
+
+#define timer_to_bench(ptr) \
+    bfdev_timewheel_entry(ptr, struct bench_node, timer)
+
+#define heap_to_bench(ptr) \
+    bfdev_heap_entry(ptr, struct bench_node, node)
+
+static long
+bench_cmp(const bfdev_heap_node_t *hpa,
+          const bfdev_heap_node_t *hpb, void *pdata)
+{
+    struct bench_node *node1, *node2;
+
+    node1 = heap_to_bench(hpa);
+    node2 = heap_to_bench(hpb);
+
+    return bfdev_time_compare(node1->expires, node2->expires);
+}
+
+static int
+bench_timewheel(struct bench_node *nodes)
+{
+    static bfdev_timewheel_t wheel;
+    bfdev_timewheel_node_t *timer;
+    unsigned long fired, errors;
+    bfdev_time_t now;
+    unsigned int count;
+    int retval;
+
+    BFDEV_LIST_HEAD(expired);
+
+    bfdev_timewheel_init(&wheel, 0);
+    for (count = 0; count < TEST_LEN; ++count)
+        bfdev_timewheel_node_init(&nodes[count].timer);
+
+    bfdev_log_info("Timewheel arm %u timers:\n", TEST_LEN);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count)
+            bfdev_timewheel_add(&wheel, &nodes[count].timer, nodes[count].expires);
+        0;
+    );
+
+    bfdev_log_info("Timewheel cancel %u timers:\n", TEST_LEN / 2);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; count += 2)
+            bfdev_timewheel_del(&wheel, &nodes[count].timer);
+        0;
+    );
+
+    fired = errors = 0;
+    bfdev_log_info("Timewheel expire all timers:\n");
+    EXAMPLE_TIME_STATISTICAL(
+        for (now = TEST_STEP; now <= TEST_RANGE + TEST_STEP; now += TEST_STEP) {
+            fired += bfdev_timewheel_expire(&wheel, now, &expired);
+            bfdev_list_for_each_entry(timer, &expired, list) {
+                if (bfdev_time_after(timer->expires, now) ||
+                    bfdev_time_before_equal(timer->expires, now - TEST_STEP))
+                    errors++;
+            }
+            bfdev_list_head_init(&expired);
+        }
+        0;
+    );
+
+    retval = errors || fired != TEST_LEN / 2 ||
+             bfdev_timewheel_count(&wheel);
+    if (retval) {
+        bfdev_log_err("Timewheel expiry error!\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int
+bench_heap(struct bench_node *nodes)
+{
+    struct bench_node *bnode;
+    unsigned long fired;
+    unsigned int count;
+    bfdev_time_t now;
+
+    BFDEV_HEAP_ROOT(root);
+
+    bfdev_log_info("Heap arm %u timers:\n", TEST_LEN);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; ++count)
+            bfdev_heap_insert(&root, &nodes[count].node, bench_cmp, NULL);
+        0;
+    );
+
+    bfdev_log_info("Heap cancel %u timers:\n", TEST_LEN / 2);
+    EXAMPLE_TIME_STATISTICAL(
+        for (count = 0; count < TEST_LEN; count += 2)
+            bfdev_heap_delete(&root, &nodes[count].node, bench_cmp, NULL);
+        0;
+    );
+
+    fired = 0;
+    bfdev_log_info("Heap expire all timers:\n");
+    EXAMPLE_TIME_STATISTICAL(
+        for (now = TEST_STEP; root.count; now += TEST_STEP) {
+            while (root.count) {
+                bnode = heap_to_bench(root.node);
+                if (bfdev_time_after(bnode->expires, now))
+                    break;
+                bfdev_heap_delete(&root, &bnode->node, bench_cmp, NULL);
+                fired++;
+            }
+        }
+        0;
+    );
+
+    if (fired != TEST_LEN / 2) {
+        bfdev_log_err("Heap expiry error!\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    struct bench_node *nodes;
+    unsigned int count;
+    int retval;
+
+    nodes = malloc(sizeof(*nodes) * TEST_LEN);
+    if (!nodes) {
+        bfdev_log_err("Insufficient memory!\n");
+        return 1;
+    }
+
+    srand(time(NULL));
+    for (count = 0; count < TEST_LEN; ++count)
+        nodes[count].expires = (rand() % TEST_RANGE) + 1;
+
+    retval = bench_timewheel(nodes);
+    if (!retval)
+        retval = bench_heap(nodes);
+
+    free(nodes);
+
+    return retval;
+}
@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "tokenbucket-atomic"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/tokenbucket.h>
+
+#define TEST_THREADS 8
+#define TEST_LOOP (1UL << 20)
+#define TEST_INTERVAL 10
+#define TEST_CAPACITY 1000
+#define TEST_KEYS 4096
+#define TEST_BASE 1700000000000LL
+
+struct worker {
+    pthread_t tid;
+    unsigned int index;
+    unsigned long passed;
+};
+
+struct bench {
+    const char *name;
+    void *(*func)(void *pdata);
+};
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static BFDEV_DEFINE_TOKENBUCKET(locked, TEST_INTERVAL, TEST_CAPACITY);
+static BFDEV_DEFINE_TOKENBUCKET_ATOMIC(shared, TEST_INTERVAL, TEST_CAPACITY);
+static const BFDEV_DEFINE_TOKENBUCKET(config, TEST_INTERVAL, TEST_CAPACITY);
+static bfdev_atomic_t keys[TEST_KEYS];
+static bfdev_atomic_t now;
+
+static inline bfdev_time_t
+now_read(void)
+{
+    return TEST_BASE + bfdev_atomic_read(&now);
+}
+
+static void *
+mutex_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+    bool accept;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        pthread_mutex_lock(&mutex);
+        accept = bfdev_tokenbucket(&locked, now_read());
+        pthread_mutex_unlock(&mutex);
+        worker->passed += accept;
+    }
+
+    return NULL;
+}
+
+static void *
+atomic_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        worker->passed += bfdev_tokenbucket_atomic(&shared, now_read());
+
+    return NULL;
+}
+
+static void *
+batch_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+    unsigned int batch;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        batch = count % 4 + 1;
+        if (bfdev_tokenbucket_acquire(&shared, now_read(), batch))
+            worker->passed += batch;
+    }
+
+    return NULL;
+}
+
+static void *
+gcra_worker(void *pdata)
+{
+    struct worker *worker = pdata;
+    unsigned long count;
+    unsigned int key;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        key = (count * 7 + worker->index) % TEST_KEYS;
+        worker->passed += bfdev_tokenbucket_gcra(&config, &keys[key],
+                                                 now_read(), 1);
+    }
+
+    return NULL;
+}
+
+static unsigned long
+bench_run(const struct bench *bench, unsigned long expect)
+{
+    struct worker workers[TEST_THREADS];
+    struct timeval start, stop;
+    unsigned long passed;
+    unsigned int thread;
+    double usecs;
+
+    gettimeofday(&start, NULL);
+    for (thread = 0; thread < TEST_THREADS; ++thread) {
+        workers[thread] = (struct worker) {.index = thread};
+        pthread_create(&workers[thread].tid, NULL, bench->func,
+                       &workers[thread]);
+    }
+
+    passed = 0;
+    for (thread = 0; thread < TEST_THREADS; ++thread) {
+        pthread_join(workers[thread].tid, NULL);
+        passed += workers[thread].passed;
+    }
+    gettimeofday(&stop, NULL);
+
+    usecs = (stop.tv_sec - start.tv_sec) * 1000000.0 +
+            (stop.tv_usec - start.tv_usec);
+    bfdev_log_info("%-6s %u threads: %8.3lf Mops/s passed %lu\n",
+                   bench->name, TEST_THREADS,
+                   TEST_THREADS * TEST_LOOP / usecs, passed);
+
+    return passed != expect;
+}
+
+static const struct bench
+benches[] = {
+    {"mutex", mutex_worker},
+    {"atomic", atomic_worker},
+    {"batch", batch_worker},
+    {"gcra", gcra_worker},
+};
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned long expect;
+    unsigned int count;
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(benches); ++count) {
+        bfdev_tokenbucket_reset(&locked);
+        bfdev_tokenbucket_atomic_reset(&shared);
+        for (expect = 0; expect < TEST_KEYS; ++expect)
+            bfdev_atomic_write(&keys[expect], 0);
+
+        /* time stands still, every bucket hands out its burst once */
+        bfdev_atomic_write(&now, 0);
+        expect = count == 3 ? TEST_KEYS * TEST_CAPACITY : TEST_CAPACITY;
+        if (bench_run(&benches[count], expect))
+            goto failed;
+    }
+
+    /* refill exactly one token per elapsed interval */
+    bfdev_tokenbucket_atomic_reset(&shared);
+    bfdev_atomic_write(&now, 0);
+    if (bench_run(&benches[1], TEST_CAPACITY))
+        goto failed;
+
+    bfdev_atomic_write(&now, TEST_INTERVAL * 10);
+    if (bench_run(&benches[1], 10))
+        goto failed;
+
+    return 0;
+
+failed:
+    bfdev_log_err("token count mismatch\n");
+    return 1;
+}
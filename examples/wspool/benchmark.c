@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "wspool-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <bfdev/log.h>
+#include <bfdev/wspool.h>
+
+#define TEST_SIZE (1UL << 22)
+#define TEST_LOOP 8
+#define TEST_THREADS 8
+#define TEST_DEPTH 64
+
+struct helper {
+    pthread_t tid;
+    bfdev_wspool_t *pool;
+    unsigned int index;
+};
+
+static uint32_t *array;
+
+static uint32_t *
+futex_word(bfdev_atomic_t *event)
+{
+    /* the low half changes on every increment */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (uint32_t *)(event + 1) - 1;
+#else
+    return (uint32_t *)event;
+#endif
+}
+
+static void
+futex_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAIT_PRIVATE,
+            (uint32_t)value, NULL, NULL, 0);
+}
+
+static void
+futex_wake(bfdev_atomic_t *event, void *pdata)
+{
+    syscall(SYS_futex, futex_word(event), FUTEX_WAKE_PRIVATE,
+            INT_MAX, NULL, NULL, 0);
+}
+
+static const bfdev_wspool_ops_t
+futex_ops = {
+    .wait = futex_wait,
+    .wake = futex_wake,
+};
+
+static void
+fill_range(unsigned long begin, unsigned long end, void *pdata)
+{
+    unsigned long seed = (unsigned long)pdata;
+
+    for (; begin < end; ++begin)
+        array[begin] = (uint32_t)((begin + seed) * 0x9e3779b9UL) >> 8;
+}
+
+static void
+sum_map(unsigned long begin, unsigned long end, void *result, void *pdata)
+{
+    uint64_t sum = 0;
+
+    for (; begin < end; ++begin)
+        sum += array[begin];
+
+    *(uint64_t *)result = sum;
+}
+
+static void
+sum_combine(void *result, const void *other, void *pdata)
+{
+    *(uint64_t *)result += *(const uint64_t *)other;
+}
+
+static void *
+helper_run(void *pdata)
+{
+    struct helper *helper = pdata;
+
+    bfdev_wspool_run(helper->pool, helper->index);
+    return NULL;
+}
+
+static double
+time_usecs(struct timeval *start, struct timeval *stop)
+{
+    return (stop->tv_sec - start->tv_sec) * 1000000.0 +
+           (stop->tv_usec - start->tv_usec);
+}
+
+static uint64_t
+serial_run(void)
+{
+    struct timeval start, stop;
+    unsigned long loop;
+    uint64_t sum;
+
+    gettimeofday(&start, NULL);
+    for (loop = 0; loop < TEST_LOOP; ++loop) {
+        fill_range(0, TEST_SIZE, (void *)loop);
+        sum_map(0, TEST_SIZE, &sum, NULL);
+    }
+    gettimeofday(&stop, NULL);
+
+    bfdev_log_info("serial   %u threads: %8.3lf Melems/s\n", 1,
+                   TEST_LOOP * TEST_SIZE / time_usecs(&start, &stop));
+
+    return sum;
+}
+
+static int
+pool_run(unsigned int threads, unsigned long grain, uint64_t expect)
+{
+    struct helper helpers[TEST_THREADS];
+    struct timeval start, stop;
+    bfdev_wspool_t pool;
+    unsigned long loop;
+    unsigned int index;
+    uint64_t sum;
+    int retval;
+
+    retval = bfdev_wspool_alloc(&pool, NULL, threads, TEST_DEPTH);
+    if (retval)
+        return retval;
+
+    bfdev_wspool_set_wait(&pool, &futex_ops, NULL);
+    for (index = 1; index < threads; ++index) {
+        helpers[index] = (struct helper) {
+            .pool = &pool,
+            .index = index,
+        };
+        pthread_create(&helpers[index].tid, NULL, helper_run, &helpers[index]);
+    }
+
+    gettimeofday(&start, NULL);
+    for (loop = 0; loop < TEST_LOOP; ++loop) {
+        retval = bfdev_wspool_parallel_for(&pool, 0, 0, TEST_SIZE, grain,
+                                           fill_range, (void *)loop);
+        if (retval)
+            break;
+
+        retval = bfdev_wspool_parallel_reduce(&pool, 0, 0, TEST_SIZE, grain,
+                                              sum_map, sum_combine,
+                                              &sum, sizeof(sum), NULL);
+        if (retval)
+            break;
+    }
+    gettimeofday(&stop, NULL);
+
+    bfdev_wspool_stop(&pool);
+    for (index = 1; index < threads; ++index)
+        pthread_join(helpers[index].tid, NULL);
+    bfdev_wspool_free(&pool);
+
+    if (retval)
+        return retval;
+
+    bfdev_log_info("wspool   %u threads grain %7lu: %8.3lf Melems/s\n",
+                   threads, grain,
+                   TEST_LOOP * TEST_SIZE / time_usecs(&start, &stop));
+
+    if (sum != expect) {
+        bfdev_log_err("sum mismatch: %llu != %llu\n",
+                      (unsigned long long)sum, (unsigned long long)expect);
+        return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    unsigned int threads;
+    uint64_t expect;
+    int retval;
+
+    array = malloc(TEST_SIZE * sizeof(*array));
+    if (!array)
+        return 1;
+
+    expect = serial_run();
+    for (threads = 1; threads <= TEST_THREADS; threads <<= 1) {
+        retval = pool_run(threads, 0, expect);
+        if (retval)
+            goto failed;
+    }
+
+    /* too fine a grain drowns the work in scheduling */
+    retval = pool_run(TEST_THREADS, 64, expect);
+    if (retval)
+        goto failed;
+
+    retval = pool_run(TEST_THREADS, TEST_SIZE / 4, expect);
+
+failed:
+    free(array);
+    return !!retval;
+}
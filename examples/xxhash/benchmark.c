@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "xxhash-benchmark"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/jhash.h>
+#include <bfdev/dispatch.h>
+#include <bfdev/log.h>
+#include <bfdev/size.h>
+#include <bfdev/macro.h>
+
+#define TEST_MIN 4
+#define TEST_MAX BFDEV_SZ_1MiB
+#define TEST_TIME 100000
+
+struct hasher {
+    const char *name;
+    uint64_t (*hash)(const void *data, size_t size);
+};
+
+static uint64_t
+xxh3_hash(const void *data, size_t size)
+{
+    return bfdev_xxh3(data, size, 0);
+}
+
+static uint64_t
+xxh128_hash(const void *data, size_t size)
+{
+    return bfdev_xxh128(data, size, 0).low;
+}
+
+static uint64_t
+jhash_hash(const void *data, size_t size)
+{
+    return bfdev_jhash(data, size, 0);
+}
+
+static const struct hasher
+hashers[] = {
+    {"xxh3", xxh3_hash},
+    {"xxh128", xxh128_hash},
+    {"jhash", jhash_hash},
+};
+
+static double
+time_usecs(struct timeval *start, struct timeval *stop)
+{
+    return (stop->tv_sec - start->tv_sec) * 1000000.0 +
+           (stop->tv_usec - start->tv_usec);
+}
+
+static void
+benchmark(const struct hasher *hasher, const void *data, size_t size)
+{
+    struct timeval start, stop;
+    unsigned long loop, count;
+    volatile uint64_t sink;
+    double usecs;
+
+    gettimeofday(&start, NULL);
+    loop = 0;
+
+    /* check the clock rarely, small keys take a few nanoseconds */
+    do {
+        for (count = 0; count < 256; ++count)
+            sink = hasher->hash(data, size);
+        gettimeofday(&stop, NULL);
+        usecs = time_usecs(&start, &stop);
+        loop += count;
+    } while (usecs < TEST_TIME);
+
+    (void)sink;
+    bfdev_log_info("%-6s %8zu bytes: %9.2lf MiB/s %8.2lf ns/hash\n",
+                   hasher->name, size,
+                   loop * size / usecs * 1000000.0 / BFDEV_SZ_1MiB,
+                   usecs * 1000.0 / loop);
+}
+
+int
+main(int argc, const char *argv[])
+{
+    bfdev_dispatch_t *dispatch;
+    unsigned int count;
+    size_t size;
+    uint8_t *buff;
+
+    buff = malloc(TEST_MAX);
+    if (!buff)
+        return 1;
+
+    for (size = 0; size < TEST_MAX; ++size)
+        buff[size] = (uint8_t)(size * 0x9e3779b9UL >> 24);
+
+    /* BFDEV_DISPATCH=xxh3=<impl> measures another one */
+    dispatch = bfdev_dispatch_find("xxh3");
+    if (dispatch)
+        bfdev_log_info("xxh3 implementation: %s\n", dispatch->selected->name);
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(hashers); ++count) {
+        for (size = TEST_MIN; size <= TEST_MAX; size *= 4)
+            benchmark(&hashers[count], buff, size);
+    }
+
+    free(buff);
+    return 0;
+}
@@ -13,6 +13,18 @@
 
 BFDEV_BEGIN_DECLS
 
+typedef struct bfdev_ascii85_ctx bfdev_ascii85_ctx_t;
+
+/**
+ * struct bfdev_ascii85_ctx - ascii85 streaming context.
+ * @pend: bytes or characters short of a whole group.
+ * @count: number of entries held in @pend.
+ */
+struct bfdev_ascii85_ctx {
+    uint8_t pend[5];
+    unsigned int count;
+};
+
 /**
  * bfdev_ascii85_encode_length() - ascii85 encode buffer length.
  * @size: length to encode.
@@ -59,6 +71,73 @@ bfdev_ascii85_encode(void *buff, const void *data, size_t *plen, size_t size);
 extern int
 bfdev_ascii85_decode(void *buff, const void *data, size_t *plen, size_t size);
 
+/**
+ * bfdev_ascii85_init() - prepare an ascii85 streaming context.
+ * @ctx: the context to initialize.
+ *
+ * One context serves either an encoder or a decoder.
+ */
+extern void
+bfdev_ascii85_init(bfdev_ascii85_ctx_t *ctx);
+
+/**
+ * bfdev_ascii85_encode_update() - encode the next piece of a stream.
+ * @ctx: the streaming context.
+ * @buff: encode output buffer.
+ * @data: data to encode.
+ * @size: length of @data.
+ *
+ * Bytes short of a whole group are held in @ctx, so @buff must have
+ * room for bfdev_ascii85_encode_length(@size) characters.
+ *
+ * Return the number of characters written to @buff.
+ */
+extern size_t
+bfdev_ascii85_encode_update(bfdev_ascii85_ctx_t *ctx, void *buff,
+                            const void *data, size_t size);
+
+/**
+ * bfdev_ascii85_encode_finish() - encode what is left of a stream.
+ * @ctx: the streaming context.
+ * @buff: encode output buffer.
+ *
+ * Return the number of characters written to @buff.
+ */
+extern size_t
+bfdev_ascii85_encode_finish(bfdev_ascii85_ctx_t *ctx, void *buff);
+
+/**
+ * bfdev_ascii85_decode_update() - decode the next piece of a stream.
+ * @ctx: the streaming context.
+ * @buff: decode output buffer.
+ * @data: data to decode.
+ * @plen: save output length.
+ * @size: length of @data.
+ *
+ * Characters short of a whole group are held in @ctx. Each 'z' expands
+ * to four bytes on its own, which bfdev_ascii85_decode_length() does
+ * not account for.
+ *
+ * On -BFDEV_EINVAL, @plen still holds the bytes decoded before the bad
+ * character.
+ */
+extern int
+bfdev_ascii85_decode_update(bfdev_ascii85_ctx_t *ctx, void *buff,
+                            const void *data, size_t *plen, size_t size);
+
+/**
+ * bfdev_ascii85_decode_finish() - decode what is left of a stream.
+ * @ctx: the streaming context.
+ * @buff: decode output buffer.
+ * @plen: save output length.
+ *
+ * Groups always come whole, leftover characters are reported as
+ * -BFDEV_EPROTO.
+ */
+extern int
+bfdev_ascii85_decode_finish(bfdev_ascii85_ctx_t *ctx, void *buff,
+                            size_t *plen);
+
 BFDEV_END_DECLS
 
 #endif /* _CRYPTO_ASCII85_H_ */
@@ -30,6 +30,33 @@ bfdev_arch_atomic_write(bfdev_atomic_t *atomic, bfdev_atomic_t value)
 }
 #endif
 
+#ifndef bfdev_arch_atomic_read_acquire
+# define bfdev_arch_atomic_read_acquire bfdev_arch_atomic_read_acquire
+static __bfdev_always_inline bfdev_atomic_t
+bfdev_arch_atomic_read_acquire(const bfdev_atomic_t *atomic)
+{
+    return __atomic_load_n(atomic, __ATOMIC_ACQUIRE);
+}
+#endif
+
+#ifndef bfdev_arch_atomic_write_release
+# define bfdev_arch_atomic_write_release bfdev_arch_atomic_write_release
+static __bfdev_always_inline void
+bfdev_arch_atomic_write_release(bfdev_atomic_t *atomic, bfdev_atomic_t value)
+{
+    __atomic_store_n(atomic, value, __ATOMIC_RELEASE);
+}
+#endif
+
+#ifndef bfdev_arch_atomic_fence
+# define bfdev_arch_atomic_fence bfdev_arch_atomic_fence
+static __bfdev_always_inline void
+bfdev_arch_atomic_fence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#endif
+
 #define BFDEV_GENERIC_ATOMIC(name, func)                                \
 static __bfdev_always_inline void                                       \
 bfdev_arch_atomic_##name(bfdev_atomic_t *atomic, bfdev_atomic_t value)  \
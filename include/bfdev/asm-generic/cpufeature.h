@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_ASM_GENERIC_CPUFEATURE_H_
+#define _BFDEV_ASM_GENERIC_CPUFEATURE_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+
+BFDEV_BEGIN_DECLS
+
+#ifndef bfdev_arch_cpu_probe
+# define bfdev_arch_cpu_probe bfdev_arch_cpu_probe
+static __bfdev_always_inline uint64_t
+bfdev_arch_cpu_probe(void)
+{
+    return 0;
+}
+#endif
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_ASM_GENERIC_CPUFEATURE_H_ */
@@ -36,6 +36,49 @@ bfdev_atomic_write(bfdev_atomic_t *atomic, bfdev_atomic_t value)
 }
 #endif
 
+/**
+ * bfdev_atomic_read_acquire - atomic read variable with acquire ordering.
+ * @atomic: pointer of type atomic_t.
+ *
+ * Later memory accesses can not be reordered before this read.
+ */
+#ifndef bfdev_atomic_read_acquire
+static __bfdev_always_inline bfdev_atomic_t
+bfdev_atomic_read_acquire(const bfdev_atomic_t *atomic)
+{
+    return bfdev_arch_atomic_read_acquire(atomic);
+}
+#endif
+
+/**
+ * bfdev_atomic_write_release - atomic write variable with release ordering.
+ * @atomic: pointer of type atomic_t.
+ * @value: required value.
+ *
+ * Earlier memory accesses can not be reordered after this write.
+ */
+#ifndef bfdev_atomic_write_release
+static __bfdev_always_inline void
+bfdev_atomic_write_release(bfdev_atomic_t *atomic, bfdev_atomic_t value)
+{
+    bfdev_arch_atomic_write_release(atomic, value);
+}
+#endif
+
+/**
+ * bfdev_atomic_fence - full memory barrier.
+ *
+ * No memory access can be reordered across this point, in
+ * particular a store followed by a load of another location.
+ */
+#ifndef bfdev_atomic_fence
+static __bfdev_always_inline void
+bfdev_atomic_fence(void)
+{
+    bfdev_arch_atomic_fence();
+}
+#endif
+
 /**
  * bfdev_atomic_add - atomic add variable.
  * @atomic: pointer of type atomic_t.
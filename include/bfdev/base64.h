@@ -8,11 +8,26 @@
 
 #include <bfdev/config.h>
 #include <bfdev/types.h>
+#include <bfdev/stddef.h>
 #include <bfdev/errno.h>
 #include <bfdev/math.h>
 
 BFDEV_BEGIN_DECLS
 
+typedef struct bfdev_base64_ctx bfdev_base64_ctx_t;
+
+/**
+ * struct bfdev_base64_ctx - base64 streaming context.
+ * @pend: bytes or digits short of a whole group.
+ * @count: number of entries held in @pend.
+ * @padding: decoding reached the end of the input.
+ */
+struct bfdev_base64_ctx {
+    uint8_t pend[4];
+    unsigned int count;
+    bool padding;
+};
+
 /**
  * bfdev_base64_encode_length() - base64 encode buffer length.
  * @size: length to encode.
@@ -51,6 +66,73 @@ bfdev_base64_encode(void *buff, const void *data, size_t size);
 extern int
 bfdev_base64_decode(void *buff, const void *data, size_t size);
 
+/**
+ * bfdev_base64_init() - prepare a base64 streaming context.
+ * @ctx: the context to initialize.
+ *
+ * One context serves either an encoder or a decoder.
+ */
+extern void
+bfdev_base64_init(bfdev_base64_ctx_t *ctx);
+
+/**
+ * bfdev_base64_encode_update() - encode the next piece of a stream.
+ * @ctx: the streaming context.
+ * @buff: encode output buffer.
+ * @data: data to encode.
+ * @size: length of @data.
+ *
+ * Bytes short of a whole group are held in @ctx, so @buff must have
+ * room for bfdev_base64_encode_length(@size) characters.
+ *
+ * Return the number of characters written to @buff.
+ */
+extern size_t
+bfdev_base64_encode_update(bfdev_base64_ctx_t *ctx, void *buff,
+                            const void *data, size_t size);
+
+/**
+ * bfdev_base64_encode_finish() - encode what is left of a stream.
+ * @ctx: the streaming context.
+ * @buff: encode output buffer.
+ *
+ * Return the number of characters written to @buff.
+ */
+extern size_t
+bfdev_base64_encode_finish(bfdev_base64_ctx_t *ctx, void *buff);
+
+/**
+ * bfdev_base64_decode_update() - decode the next piece of a stream.
+ * @ctx: the streaming context.
+ * @buff: decode output buffer.
+ * @data: data to decode.
+ * @plen: save output length.
+ * @size: length of @data.
+ *
+ * Digits short of a whole group are held in @ctx, so @buff must have
+ * room for bfdev_base64_decode_length(@size) bytes. Decoding stops at
+ * the first pad character, anything after it is ignored.
+ *
+ * On -BFDEV_EINVAL, @plen still holds the bytes decoded before the bad
+ * character.
+ */
+extern int
+bfdev_base64_decode_update(bfdev_base64_ctx_t *ctx, void *buff,
+                            const void *data, size_t *plen, size_t size);
+
+/**
+ * bfdev_base64_decode_finish() - decode what is left of a stream.
+ * @ctx: the streaming context.
+ * @buff: decode output buffer.
+ * @plen: save output length.
+ *
+ * Flush the digits held in @ctx, at most two bytes. Padding may be
+ * omitted, but a lone digit is reported as -BFDEV_EPROTO.
+ */
+extern int
+bfdev_base64_decode_finish(bfdev_base64_ctx_t *ctx, void *buff,
+                            size_t *plen);
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_BASE64_H_ */
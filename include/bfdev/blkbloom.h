@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_BLKBLOOM_H_
+#define _BFDEV_BLKBLOOM_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/errno.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+#define BFDEV_BLKBLOOM_WORDS 8
+#define BFDEV_BLKBLOOM_BLOCK_SIZE 64
+#define BFDEV_BLKBLOOM_BLOCK_BITS (BFDEV_BLKBLOOM_BLOCK_SIZE * 8)
+
+typedef struct bfdev_blkbloom bfdev_blkbloom_t;
+typedef struct bfdev_blkbloom_block bfdev_blkbloom_block_t;
+
+typedef uint64_t (*bfdev_blkbloom_hash_t)
+(const void *key, void *pdata);
+
+/**
+ * struct bfdev_blkbloom_block - one cache line of the filter.
+ * @word: every key sets exactly one bit in each word.
+ */
+struct bfdev_blkbloom_block {
+    uint64_t word[BFDEV_BLKBLOOM_WORDS];
+} __bfdev_aligned(BFDEV_BLKBLOOM_BLOCK_SIZE);
+
+/**
+ * struct bfdev_blkbloom - split block bloom filter.
+ * @alloc: allocator of the filter.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ * @blocks: number of blocks in @table.
+ * @table: the blocks, aligned to a cache line.
+ *
+ * The high half of the hash picks a block, the low half picks the
+ * eight bits inside it. A query therefore touches a single cache line,
+ * regardless of the size of the filter.
+ */
+struct bfdev_blkbloom {
+    const bfdev_alloc_t *alloc;
+    bfdev_blkbloom_hash_t hash;
+    void *pdata;
+
+    unsigned long blocks;
+    bfdev_blkbloom_block_t *table;
+    uint8_t memory[];
+};
+
+/**
+ * bfdev_blkbloom_peek_hash() - test a precomputed hash.
+ * @bloom: filter pointer.
+ * @hash: 64-bit hash of the key.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_blkbloom_peek_hash(const bfdev_blkbloom_t *bloom, uint64_t hash);
+
+/**
+ * bfdev_blkbloom_push_hash() - insert a precomputed hash.
+ * @bloom: filter pointer.
+ * @hash: 64-bit hash of the key.
+ *
+ * @return: true if the key may have been present before.
+ */
+extern bool
+bfdev_blkbloom_push_hash(bfdev_blkbloom_t *bloom, uint64_t hash);
+
+/**
+ * bfdev_blkbloom_peek() - test an object against the filter.
+ * @bloom: filter pointer.
+ * @key: object pointer.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_blkbloom_peek(const bfdev_blkbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_blkbloom_push() - insert an object into the filter.
+ * @bloom: filter pointer.
+ * @key: object pointer.
+ *
+ * @return: true if the key may have been present before.
+ */
+extern bool
+bfdev_blkbloom_push(bfdev_blkbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_blkbloom_peek_batch() - test many precomputed hashes.
+ * @bloom: filter pointer.
+ * @hashes: 64-bit hashes of the keys.
+ * @result: where to store the answer for every hash, may be NULL.
+ * @count: number of hashes.
+ *
+ * The blocks of later hashes are prefetched while earlier ones are
+ * probed, so the cache misses of a batch overlap.
+ *
+ * @return: number of hashes that may be present.
+ */
+extern unsigned int
+bfdev_blkbloom_peek_batch(const bfdev_blkbloom_t *bloom, const uint64_t *hashes,
+                          bool *result, unsigned int count);
+
+/**
+ * bfdev_blkbloom_push_batch() - insert many precomputed hashes.
+ * @bloom: filter pointer.
+ * @hashes: 64-bit hashes of the keys.
+ * @count: number of hashes.
+ *
+ * @return: number of hashes that may have been present before.
+ */
+extern unsigned int
+bfdev_blkbloom_push_batch(bfdev_blkbloom_t *bloom, const uint64_t *hashes,
+                          unsigned int count);
+
+/**
+ * bfdev_blkbloom_flush() - flush the entire filter.
+ * @bloom: filter pointer.
+ */
+extern void
+bfdev_blkbloom_flush(bfdev_blkbloom_t *bloom);
+
+/**
+ * bfdev_blkbloom_create() - create a split block bloom filter.
+ * @alloc: allocator of the filter.
+ * @capacity: size of the filter in bits, rounded up to whole blocks.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ *
+ * About 12 bits per key give a false positive rate near 0.5%.
+ */
+extern bfdev_blkbloom_t *
+bfdev_blkbloom_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                      bfdev_blkbloom_hash_t hash, void *pdata);
+
+/**
+ * bfdev_blkbloom_destroy() - destroy a split block bloom filter.
+ * @bloom: filter pointer.
+ */
+extern void
+bfdev_blkbloom_destroy(bfdev_blkbloom_t *bloom);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_BLKBLOOM_H_ */
@@ -14,11 +14,25 @@
 
 BFDEV_BEGIN_DECLS
 
+#define BFDEV_BLOOM_MAGIC "BFBL"
+#define BFDEV_BLOOM_VERSION 1
+
 typedef struct bfdev_bloom bfdev_bloom_t;
+typedef struct bfdev_bloom_header bfdev_bloom_header_t;
 
 typedef unsigned int (*bfdev_bloom_hash_t)
 (unsigned int func, const void *key, void *pdata);
 
+/**
+ * struct bfdev_bloom - bloom filter.
+ * @alloc: allocator of the filter, unused once attached.
+ * @hash: object hash callback function.
+ * @funcs: number of supported hash algorithms.
+ * @pdata: private data pointer of @hash.
+ * @capacity: size of @bitmap in bits.
+ * @bitmap: the bits, either @memory or an attached image.
+ * @memory: storage of @bitmap for allocated filters.
+ */
 struct bfdev_bloom {
     const bfdev_alloc_t *alloc;
     bfdev_bloom_hash_t hash;
@@ -26,7 +40,34 @@ struct bfdev_bloom {
     void *pdata;
 
     unsigned int capacity;
-    unsigned long bitmap[];
+    unsigned long *bitmap;
+    unsigned long memory[];
+};
+
+/**
+ * struct bfdev_bloom_header - head of a serialized bloom filter.
+ * @magic: BFDEV_BLOOM_MAGIC, not nul terminated.
+ * @version: BFDEV_BLOOM_VERSION.
+ * @wordbits: bits per long of the writer, bit indexes depend on it.
+ * @funcs: number of hash functions.
+ * @hashid: caller chosen identifier of the hash callback.
+ * @capacity: size of the bitmap in bits.
+ * @checksum: crc32c of the bitmap.
+ * @length: size of the bitmap in bytes, following the header.
+ *
+ * All fields are little endian. The bitmap is stored as little endian
+ * longs, which is the native layout on little endian machines, so an
+ * image can be used in place.
+ */
+struct bfdev_bloom_header {
+    uint8_t magic[4];
+    bfdev_le16 version;
+    bfdev_le16 wordbits;
+    bfdev_le32 funcs;
+    bfdev_le32 hashid;
+    bfdev_le32 capacity;
+    bfdev_le32 checksum;
+    bfdev_le64 length;
 };
 
 /**
@@ -56,6 +97,101 @@ bfdev_bloom_push(bfdev_bloom_t *bloom, void *key);
 extern void
 bfdev_bloom_flush(bfdev_bloom_t *bloom);
 
+/**
+ * bfdev_bloom_union() - merge another filter into a bloom filter.
+ * @dest: filter to merge into.
+ * @src: filter to merge from.
+ *
+ * Both filters must share capacity, functions and hash callback.
+ * The result holds every key of either filter.
+ *
+ * @return: -BFDEV_EINVAL if the filters are not compatible.
+ */
+extern int
+bfdev_bloom_union(bfdev_bloom_t *dest, const bfdev_bloom_t *src);
+
+/**
+ * bfdev_bloom_intersect() - intersect a bloom filter with another one.
+ * @dest: filter to intersect into.
+ * @src: filter to intersect with.
+ *
+ * The result holds every key present in both filters, and may have a
+ * higher false positive rate than a filter built from the keys alone.
+ *
+ * @return: -BFDEV_EINVAL if the filters are not compatible.
+ */
+extern int
+bfdev_bloom_intersect(bfdev_bloom_t *dest, const bfdev_bloom_t *src);
+
+/**
+ * bfdev_bloom_export_size() - size of the serialized bloom filter.
+ * @bloom: bloom filter pointer.
+ */
+extern size_t
+bfdev_bloom_export_size(const bfdev_bloom_t *bloom);
+
+/**
+ * bfdev_bloom_export() - serialize a bloom filter.
+ * @bloom: bloom filter pointer.
+ * @buff: buffer to write the image to.
+ * @size: size of @buff.
+ * @hashid: identifier of the hash callback, checked on load.
+ *
+ * @return: -BFDEV_ENOSPC if @buff is smaller than the image.
+ */
+extern int
+bfdev_bloom_export(const bfdev_bloom_t *bloom, void *buff,
+                   size_t size, uint32_t hashid);
+
+/**
+ * bfdev_bloom_check() - validate a serialized bloom filter.
+ * @buff: the image.
+ * @size: size of @buff.
+ * @hashid: identifier of the expected hash callback.
+ *
+ * Verifies the header and the checksum of the bitmap.
+ *
+ * @return: -BFDEV_EBADMSG for a damaged image, -BFDEV_EPROTO for one
+ * this build can not read, -BFDEV_EINVAL for another hash callback.
+ */
+extern int
+bfdev_bloom_check(const void *buff, size_t size, uint32_t hashid);
+
+/**
+ * bfdev_bloom_import() - load a copy of a serialized bloom filter.
+ * @alloc: allocator of the new filter.
+ * @buff: the image.
+ * @size: size of @buff.
+ * @hash: object hash callback function.
+ * @hashid: identifier of @hash.
+ * @pdata: private data pointer of @hash.
+ *
+ * The image is fully checked first, see bfdev_bloom_check().
+ */
+extern bfdev_bloom_t *
+bfdev_bloom_import(const bfdev_alloc_t *alloc, const void *buff, size_t size,
+                   bfdev_bloom_hash_t hash, uint32_t hashid, void *pdata);
+
+/**
+ * bfdev_bloom_attach() - use a serialized bloom filter in place.
+ * @bloom: filter to set up, not to be destroyed later.
+ * @buff: the image, usually a memory mapped file, long aligned.
+ * @size: size of @buff.
+ * @hash: object hash callback function.
+ * @hashid: identifier of @hash.
+ * @pdata: private data pointer of @hash.
+ *
+ * Lookups run straight on the bitmap inside @buff, which must outlive
+ * @bloom. Pushing writes to @buff as well. Only the header is checked,
+ * so pages are not touched before they are needed.
+ *
+ * @return: -BFDEV_EOPNOTSUPP on big endian machines, which can not use
+ * the little endian words in place; bfdev_bloom_import() works there.
+ */
+extern int
+bfdev_bloom_attach(bfdev_bloom_t *bloom, void *buff, size_t size,
+                   bfdev_bloom_hash_t hash, uint32_t hashid, void *pdata);
+
 /**
  * bfdev_bloom_create() - creat a bloom filter.
  * @capacity: capacity size of bloom filter.
@@ -12,6 +12,7 @@
 #include <bfdev/list.h>
 #include <bfdev/hlist.h>
 #include <bfdev/bitflags.h>
+#include <bfdev/percpu.h>
 
 BFDEV_BEGIN_DECLS
 
@@ -86,6 +87,11 @@ struct bfdev_cache_head {
     unsigned long starve;
     unsigned long hits;
     unsigned long misses;
+
+    /* shared counter */
+    bfdev_percpu_counter_t *stat_hits;
+    bfdev_percpu_counter_t *stat_misses;
+    unsigned int stat_cpu;
 };
 
 struct bfdev_cache_algo {
@@ -131,6 +137,26 @@ BFDEV_BITFLAGS_STRUCT(
     __BFDEV_CACHE_STARVING
 );
 
+/**
+ * bfdev_cache_stat - account hits and misses to shared counters.
+ * @head: the lru_cache header.
+ * @hits: counter of obtained elements found in the cache, or NULL.
+ * @misses: counter of obtained elements not in the cache, or NULL.
+ * @cpu: slot index used by this cache.
+ *
+ * Caches kept one per cpu or thread share a pair of counters, each
+ * bumping its own slot, so the totals are read without walking every
+ * cache. The counters stay owned by the caller and survive reset.
+ */
+static inline void
+bfdev_cache_stat(bfdev_cache_head_t *head, bfdev_percpu_counter_t *hits,
+                 bfdev_percpu_counter_t *misses, unsigned int cpu)
+{
+    head->stat_hits = hits;
+    head->stat_misses = misses;
+    head->stat_cpu = cpu;
+}
+
 /**
  * bfdev_cache_find - find element by tag, if present in the hash table.
  * @head: the lru_cache header.
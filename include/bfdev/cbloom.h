@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_CBLOOM_H_
+#define _BFDEV_CBLOOM_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/errno.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/* counters stop here and are never decremented again */
+#define BFDEV_CBLOOM_SATURATED 15
+
+typedef struct bfdev_cbloom bfdev_cbloom_t;
+
+typedef uint64_t (*bfdev_cbloom_hash_t)
+(const void *key, void *pdata);
+
+/**
+ * struct bfdev_cbloom - counting bloom filter.
+ * @alloc: allocator of the filter.
+ * @hash: 64-bit key hash callback.
+ * @funcs: number of counters touched per key.
+ * @pdata: private data pointer of @hash.
+ * @capacity: number of counters.
+ * @counters: 4-bit counters, two per byte, low nibble first.
+ *
+ * The counter indexes are derived from the two halves of one 64-bit
+ * hash by double hashing, so the callback runs once per operation.
+ */
+struct bfdev_cbloom {
+    const bfdev_alloc_t *alloc;
+    bfdev_cbloom_hash_t hash;
+    unsigned int funcs;
+    void *pdata;
+
+    unsigned long capacity;
+    uint8_t counters[];
+};
+
+/**
+ * bfdev_cbloom_peek() - peek an object from a counting bloom filter.
+ * @bloom: filter pointer.
+ * @key: object pointer.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_cbloom_peek(const bfdev_cbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_cbloom_push() - push an object into a counting bloom filter.
+ * @bloom: filter pointer.
+ * @key: object pointer to push.
+ *
+ * @return: true if the key may have been present before.
+ */
+extern bool
+bfdev_cbloom_push(bfdev_cbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_cbloom_pop() - remove an object from a counting bloom filter.
+ * @bloom: filter pointer.
+ * @key: object pointer to remove.
+ *
+ * Only keys that were pushed may be removed, anything else may take
+ * other keys with it. Saturated counters are left alone.
+ *
+ * @return: -BFDEV_ENOENT if the key is certainly absent.
+ */
+extern int
+bfdev_cbloom_pop(bfdev_cbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_cbloom_flush() - flush the entire counting bloom filter.
+ * @bloom: filter pointer.
+ */
+extern void
+bfdev_cbloom_flush(bfdev_cbloom_t *bloom);
+
+/**
+ * bfdev_cbloom_create() - create a counting bloom filter.
+ * @alloc: allocator of the filter.
+ * @capacity: number of counters, at most 2^32.
+ * @funcs: number of counters touched per key.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ */
+extern bfdev_cbloom_t *
+bfdev_cbloom_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                    unsigned int funcs, bfdev_cbloom_hash_t hash, void *pdata);
+
+/**
+ * bfdev_cbloom_destroy() - destroy a counting bloom filter.
+ * @bloom: filter pointer.
+ */
+extern void
+bfdev_cbloom_destroy(bfdev_cbloom_t *bloom);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_CBLOOM_H_ */
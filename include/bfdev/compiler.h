@@ -31,6 +31,18 @@ BFDEV_BEGIN_DECLS
 # define bfdev_barrier_data(ptr) __bfdev_barrier(:"r"(ptr))
 #endif
 
+/*
+ * Size of the cache line used to keep data written
+ * by different threads apart.
+ */
+#ifndef BFDEV_CACHELINE_BYTES
+# define BFDEV_CACHELINE_BYTES 64
+#endif
+
+#ifndef __bfdev_cacheline_aligned
+# define __bfdev_cacheline_aligned __bfdev_aligned(BFDEV_CACHELINE_BYTES)
+#endif
+
 /*
  * Whether 'type' is a signed type or an unsigned type.
  * Supports scalar types, bool and also pointer types.
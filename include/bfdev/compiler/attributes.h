@@ -288,6 +288,12 @@ BFDEV_BEGIN_DECLS
  */
 #define __bfdev_weak __attribute__((__weak__))
 
+/*
+ * gcc: https://gcc.gnu.org/onlinedocs/gcc/Common-Function-Attributes.html#index-target-function-attribute
+ * clang: https://clang.llvm.org/docs/AttributeReference.html#target
+ */
+#define __bfdev_target(options) __attribute__((__target__(options)))
+
 /*
  * gcc: https://gcc.gnu.org/onlinedocs/gcc/Common-Function-Attributes.html#index-visibility-function-attribute
  */
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_CPUFEATURE_H_
+#define _BFDEV_CPUFEATURE_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * enum bfdev_cpu_feature - instruction set extensions.
+ *
+ * Only features the library has kernels for are listed. A feature is
+ * reported when both the cpu and the operating system support it, the
+ * avx ones need the registers to be saved across context switches.
+ */
+enum bfdev_cpu_feature {
+    /* x86 */
+    BFDEV_CPU_SSE2 = 0,
+    BFDEV_CPU_SSSE3,
+    BFDEV_CPU_SSE41,
+    BFDEV_CPU_SSE42,
+    BFDEV_CPU_POPCNT,
+    BFDEV_CPU_PCLMUL,
+    BFDEV_CPU_AESNI,
+    BFDEV_CPU_SHANI,
+    BFDEV_CPU_AVX,
+    BFDEV_CPU_AVX2,
+    BFDEV_CPU_BMI2,
+    BFDEV_CPU_AVX512F,
+    BFDEV_CPU_AVX512BW,
+    BFDEV_CPU_AVX512VL,
+    BFDEV_CPU_VPCLMUL,
+
+    /* arm64 */
+    BFDEV_CPU_NEON = 32,
+    BFDEV_CPU_CRC32,
+    BFDEV_CPU_PMULL,
+    BFDEV_CPU_AES,
+    BFDEV_CPU_SHA1,
+    BFDEV_CPU_SHA2,
+
+    BFDEV_CPU_FEATURE_NR,
+};
+
+#define BFDEV_CPU_FEATURE(feature) \
+    (1ULL << (feature))
+
+/**
+ * bfdev_cpu_features() - get the features of the running cpu.
+ *
+ * The cpu is probed on the first call. The BFDEV_CPU_MASK environment
+ * variable, a comma separated list of feature names, hides features
+ * from the whole library.
+ *
+ * @return: mask of BFDEV_CPU_FEATURE() bits.
+ */
+extern uint64_t
+bfdev_cpu_features(void);
+
+/**
+ * bfdev_cpu_has() - test a feature of the running cpu.
+ * @feature: feature to test.
+ */
+static inline bool
+bfdev_cpu_has(enum bfdev_cpu_feature feature)
+{
+    return !!(bfdev_cpu_features() & BFDEV_CPU_FEATURE(feature));
+}
+
+/**
+ * bfdev_cpu_has_all() - test a set of features of the running cpu.
+ * @features: mask of BFDEV_CPU_FEATURE() bits.
+ */
+static inline bool
+bfdev_cpu_has_all(uint64_t features)
+{
+    return (bfdev_cpu_features() & features) == features;
+}
+
+/**
+ * bfdev_cpu_feature_name() - get the name of a feature.
+ * @feature: feature to name.
+ *
+ * @return: lowercase name as used by BFDEV_CPU_MASK, or NULL.
+ */
+extern const char *
+bfdev_cpu_feature_name(enum bfdev_cpu_feature feature);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_CPUFEATURE_H_ */
@@ -11,6 +11,41 @@
 
 BFDEV_BEGIN_DECLS
 
+struct bfdev_wspool;
+
+/**
+ * enum bfdev_crc_accel - implementations of crc functions.
+ * @BFDEV_CRC_GENERIC: table driven, always available.
+ * @BFDEV_CRC_SSE42: x86 crc32 instruction.
+ * @BFDEV_CRC_PCLMUL: x86 carry-less multiply folding.
+ * @BFDEV_CRC_ARMV8: arm64 crc32 instructions.
+ * @BFDEV_CRC_PMULL: arm64 polynomial multiply folding.
+ *
+ * Every dispatched crc function picks the fastest implementation the
+ * cpu supports once at startup. They are registered with bfdev_dispatch
+ * under the name of the function, such as "crc32c".
+ */
+enum bfdev_crc_accel {
+    BFDEV_CRC_GENERIC = 0,
+    BFDEV_CRC_SSE42,
+    BFDEV_CRC_PCLMUL,
+    BFDEV_CRC_ARMV8,
+    BFDEV_CRC_PMULL,
+    BFDEV_CRC_ACCEL_NR,
+};
+
+typedef uint16_t
+(*bfdev_crc16_func_t)(const void *data, size_t len, uint16_t crc);
+
+typedef uint32_t
+(*bfdev_crc32_func_t)(const void *data, size_t len, uint32_t crc);
+
+typedef uint64_t
+(*bfdev_crc64_func_t)(const void *data, size_t len, uint64_t crc);
+
+extern const char *
+bfdev_crc_accel_name(enum bfdev_crc_accel accel);
+
 extern uint8_t
 bfdev_crc4(const void *data, size_t bits, uint8_t crc);
 
@@ -26,6 +61,9 @@ bfdev_crc16(const void *data, size_t len, uint16_t crc);
 extern uint32_t
 bfdev_crc32(const void *data, size_t len, uint32_t crc);
 
+extern uint32_t
+bfdev_crc32c(const void *data, size_t len, uint32_t crc);
+
 extern uint64_t
 bfdev_crc64(const void *data, size_t len, uint64_t crc);
 
@@ -41,6 +79,133 @@ bfdev_crc_t10dif(const void *data, size_t len, uint16_t crc);
 extern uint64_t
 bfdev_crc_rocksoft(const void *data, size_t len, uint64_t crc);
 
+/*
+ * bfdev_crc*_combine() - crc of two buffers joined together.
+ * @crc1: crc of the first buffer, from any initial value.
+ * @crc2: crc of the second buffer, starting from zero.
+ * @len2: length of the second buffer, in bits for crc4.
+ *
+ * Returns the crc of both buffers, as if the second one had been
+ * processed right after the first. Runs in O(log @len2).
+ */
+
+extern uint8_t
+bfdev_crc4_combine(uint8_t crc1, uint8_t crc2, size_t len2);
+
+extern uint8_t
+bfdev_crc7_combine(uint8_t crc1, uint8_t crc2, size_t len2);
+
+extern uint8_t
+bfdev_crc8_combine(uint8_t crc1, uint8_t crc2, size_t len2);
+
+extern uint16_t
+bfdev_crc16_combine(uint16_t crc1, uint16_t crc2, size_t len2);
+
+extern uint32_t
+bfdev_crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+extern uint32_t
+bfdev_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+extern uint64_t
+bfdev_crc64_combine(uint64_t crc1, uint64_t crc2, size_t len2);
+
+extern uint16_t
+bfdev_crc_ccitt_combine(uint16_t crc1, uint16_t crc2, size_t len2);
+
+extern uint16_t
+bfdev_crc_itut_combine(uint16_t crc1, uint16_t crc2, size_t len2);
+
+extern uint16_t
+bfdev_crc_t10dif_combine(uint16_t crc1, uint16_t crc2, size_t len2);
+
+extern uint64_t
+bfdev_crc_rocksoft_combine(uint64_t crc1, uint64_t crc2, size_t len2);
+
+/*
+ * bfdev_crc*_parallel() - crc of a buffer on a work-stealing pool.
+ * @pool: the pool to run on.
+ * @index: worker index owned by calling thread.
+ * @data: the buffer to checksum.
+ * @len: length of @data.
+ * @grain: bytes handled by one task, zero picks a default.
+ * @crc: the initial crc, receives the final crc.
+ *
+ * The buffer is cut into chunks checksummed independently from zero,
+ * which are merged back through the combine functions.
+ */
+
+extern int
+bfdev_crc7_parallel(struct bfdev_wspool *pool, unsigned int index,
+                    const void *data, size_t len, size_t grain, uint8_t *crc);
+
+extern int
+bfdev_crc8_parallel(struct bfdev_wspool *pool, unsigned int index,
+                    const void *data, size_t len, size_t grain, uint8_t *crc);
+
+extern int
+bfdev_crc16_parallel(struct bfdev_wspool *pool, unsigned int index,
+                     const void *data, size_t len, size_t grain,
+                     uint16_t *crc);
+
+extern int
+bfdev_crc32_parallel(struct bfdev_wspool *pool, unsigned int index,
+                     const void *data, size_t len, size_t grain,
+                     uint32_t *crc);
+
+extern int
+bfdev_crc32c_parallel(struct bfdev_wspool *pool, unsigned int index,
+                      const void *data, size_t len, size_t grain,
+                      uint32_t *crc);
+
+extern int
+bfdev_crc64_parallel(struct bfdev_wspool *pool, unsigned int index,
+                     const void *data, size_t len, size_t grain,
+                     uint64_t *crc);
+
+extern int
+bfdev_crc_ccitt_parallel(struct bfdev_wspool *pool, unsigned int index,
+                         const void *data, size_t len, size_t grain,
+                         uint16_t *crc);
+
+extern int
+bfdev_crc_itut_parallel(struct bfdev_wspool *pool, unsigned int index,
+                        const void *data, size_t len, size_t grain,
+                        uint16_t *crc);
+
+extern int
+bfdev_crc_t10dif_parallel(struct bfdev_wspool *pool, unsigned int index,
+                          const void *data, size_t len, size_t grain,
+                          uint16_t *crc);
+
+extern int
+bfdev_crc_rocksoft_parallel(struct bfdev_wspool *pool, unsigned int index,
+                            const void *data, size_t len, size_t grain,
+                            uint64_t *crc);
+
+/*
+ * bfdev_crc*_kernel() - get one implementation of a crc function.
+ * @accel: the implementation wanted.
+ *
+ * Returns NULL if it does not exist for this crc, or the cpu lacks
+ * the instructions it needs.
+ */
+
+extern bfdev_crc32_func_t
+bfdev_crc32_kernel(enum bfdev_crc_accel accel);
+
+extern bfdev_crc32_func_t
+bfdev_crc32c_kernel(enum bfdev_crc_accel accel);
+
+extern bfdev_crc64_func_t
+bfdev_crc64_kernel(enum bfdev_crc_accel accel);
+
+extern bfdev_crc16_func_t
+bfdev_crc_t10dif_kernel(enum bfdev_crc_accel accel);
+
+extern bfdev_crc64_func_t
+bfdev_crc_rocksoft_kernel(enum bfdev_crc_accel accel);
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_CRC_H_ */
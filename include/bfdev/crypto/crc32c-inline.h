@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_CRYPTO_CRC32C_INLINE_H_
+#define _BFDEV_CRYPTO_CRC32C_INLINE_H_
+
+#include <bfdev/config.h>
+#include <bfdev/crypto/crc-inline.h>
+
+BFDEV_BEGIN_DECLS
+
+#include <bfdev/crypto/crc32c-table.h>
+
+BFDEV_CRC_INLINE(
+    bfdev_crc32c, uint32_t,
+    bfdev_crc32c_table, bfdev_cpu_to_le32
+)
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_CRYPTO_CRC32C_INLINE_H_ */
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_CUCKOO_H_
+#define _BFDEV_CUCKOO_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/errno.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+#define BFDEV_CUCKOO_SLOTS 4
+#define BFDEV_CUCKOO_KICKS 500
+
+typedef struct bfdev_cuckoo bfdev_cuckoo_t;
+typedef struct bfdev_cuckoo_bucket bfdev_cuckoo_bucket_t;
+
+typedef uint64_t (*bfdev_cuckoo_hash_t)
+(const void *key, void *pdata);
+
+/**
+ * struct bfdev_cuckoo_bucket - one bucket of fingerprints.
+ * @fp: 16-bit fingerprints, zero marks a free slot.
+ */
+struct bfdev_cuckoo_bucket {
+    uint16_t fp[BFDEV_CUCKOO_SLOTS];
+};
+
+/**
+ * struct bfdev_cuckoo - cuckoo filter.
+ * @alloc: allocator of the filter.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ * @mask: number of buckets minus one.
+ * @count: number of fingerprints stored.
+ * @random: state of the victim selection.
+ * @victim: a fingerprint that found no slot, zero if none.
+ * @vindex: bucket of @victim.
+ * @buckets: the buckets.
+ *
+ * Each key lives in one of two buckets, the second is derived from the
+ * first and the fingerprint alone, so entries can be moved and removed
+ * without the key. The false positive rate is about 8 / 65536.
+ */
+struct bfdev_cuckoo {
+    const bfdev_alloc_t *alloc;
+    bfdev_cuckoo_hash_t hash;
+    void *pdata;
+
+    unsigned long mask;
+    unsigned long count;
+    uint32_t random;
+
+    uint16_t victim;
+    unsigned long vindex;
+    bfdev_cuckoo_bucket_t buckets[];
+};
+
+/**
+ * bfdev_cuckoo_peek() - peek an object from a cuckoo filter.
+ * @cuckoo: filter pointer.
+ * @key: object pointer.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_cuckoo_peek(const bfdev_cuckoo_t *cuckoo, const void *key);
+
+/**
+ * bfdev_cuckoo_push() - push an object into a cuckoo filter.
+ * @cuckoo: filter pointer.
+ * @key: object pointer to push.
+ *
+ * Pushing a key twice stores it twice, and it has to be popped as
+ * many times to go away.
+ *
+ * @return: -BFDEV_ENOSPC once the filter is full.
+ */
+extern int
+bfdev_cuckoo_push(bfdev_cuckoo_t *cuckoo, const void *key);
+
+/**
+ * bfdev_cuckoo_pop() - remove an object from a cuckoo filter.
+ * @cuckoo: filter pointer.
+ * @key: object pointer to remove.
+ *
+ * Only keys that were pushed may be removed. The filter keeps no more
+ * than a fingerprint, so popping a key that was never pushed may remove
+ * the fingerprint of another key that shares it and a bucket, and that
+ * key then reads as absent: a false negative.
+ *
+ * @return: -BFDEV_ENOENT if the key is certainly absent.
+ */
+extern int
+bfdev_cuckoo_pop(bfdev_cuckoo_t *cuckoo, const void *key);
+
+/**
+ * bfdev_cuckoo_flush() - flush the entire cuckoo filter.
+ * @cuckoo: filter pointer.
+ */
+extern void
+bfdev_cuckoo_flush(bfdev_cuckoo_t *cuckoo);
+
+/**
+ * bfdev_cuckoo_create() - create a cuckoo filter.
+ * @alloc: allocator of the filter.
+ * @capacity: number of keys the filter should hold.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ *
+ * Buckets come in powers of two and fill up to about 95%.
+ */
+extern bfdev_cuckoo_t *
+bfdev_cuckoo_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                    bfdev_cuckoo_hash_t hash, void *pdata);
+
+/**
+ * bfdev_cuckoo_destroy() - destroy a cuckoo filter.
+ * @cuckoo: filter pointer.
+ */
+extern void
+bfdev_cuckoo_destroy(bfdev_cuckoo_t *cuckoo);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_CUCKOO_H_ */
@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_DHEAP_H_
+#define _BFDEV_DHEAP_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/array.h>
+#include <bfdev/container.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * D-ary Heap:
+ *
+ * The d-ary heap keeps the node pointers in a contiguous array
+ * instead of linking them through parent/left/right pointers.
+ * Every node only records its slot in the array, which is what
+ * makes delete and decrease-key possible without a search.
+ * A wider fanout makes the tree shallower and keeps the children
+ * of one node in the same cache line during sift down.
+ */
+
+#ifndef BFDEV_DHEAP_WAYS
+# define BFDEV_DHEAP_WAYS 4
+#endif
+
+typedef struct bfdev_dheap bfdev_dheap_t;
+typedef struct bfdev_dheap_node bfdev_dheap_node_t;
+
+struct bfdev_dheap_node {
+    unsigned long index;
+};
+
+BFDEV_CALLBACK_CMP(
+    bfdev_dheap_cmp_t,
+    const bfdev_dheap_node_t *
+);
+
+struct bfdev_dheap {
+    bfdev_array_t nodes;
+    bfdev_dheap_cmp_t cmp;
+    unsigned int ways;
+    void *pdata;
+};
+
+#define BFDEV_DHEAP_STATIC(ALLOC, WAYS, CMP, PDATA) { \
+    .nodes = BFDEV_ARRAY_STATIC(ALLOC, sizeof(bfdev_dheap_node_t *)), \
+    .cmp = (CMP), .ways = (WAYS), .pdata = (PDATA), \
+}
+
+#define BFDEV_DHEAP_INIT(alloc, ways, cmp, pdata) \
+    (bfdev_dheap_t) BFDEV_DHEAP_STATIC(alloc, ways, cmp, pdata)
+
+#define BFDEV_DEFINE_DHEAP(name, alloc, ways, cmp, pdata) \
+    bfdev_dheap_t name = BFDEV_DHEAP_INIT(alloc, ways, cmp, pdata)
+
+/**
+ * bfdev_dheap_entry - get the struct for this entry.
+ * @ptr: the &bfdev_dheap_node_t pointer.
+ * @type: the type of the struct this is embedded in.
+ * @member: the name of the bfdev_dheap_node within the struct.
+ */
+#define bfdev_dheap_entry(ptr, type, member) \
+    bfdev_container_of(ptr, type, member)
+
+/**
+ * bfdev_dheap_entry_safe - get the struct for this entry or null.
+ * @ptr: the &bfdev_dheap_node_t pointer.
+ * @type: the type of the struct this is embedded in.
+ * @member: the name of the bfdev_dheap_node within the struct.
+ */
+#define bfdev_dheap_entry_safe(ptr, type, member) \
+    bfdev_container_of_safe(ptr, type, member)
+
+/**
+ * bfdev_dheap_init() - initialize a d-ary heap.
+ * @heap: the heap to initialize.
+ * @alloc: allocator used to allocate the node array.
+ * @ways: fanout of each node, zero selects %BFDEV_DHEAP_WAYS.
+ * @cmp: operator defining the node order.
+ * @pdata: private data of @cmp.
+ */
+static inline void
+bfdev_dheap_init(bfdev_dheap_t *heap, const bfdev_alloc_t *alloc,
+                 unsigned int ways, bfdev_dheap_cmp_t cmp, void *pdata)
+{
+    *heap = BFDEV_DHEAP_INIT(alloc, ways, cmp, pdata);
+}
+
+/**
+ * bfdev_dheap_count() - get the number of nodes in heap.
+ * @heap: the heap to count.
+ */
+static inline unsigned long
+bfdev_dheap_count(const bfdev_dheap_t *heap)
+{
+    return bfdev_array_index(&heap->nodes);
+}
+
+/**
+ * bfdev_dheap_empty() - check whether a heap is empty.
+ * @heap: the heap to check.
+ */
+static inline bool
+bfdev_dheap_empty(const bfdev_dheap_t *heap)
+{
+    return !bfdev_dheap_count(heap);
+}
+
+/**
+ * bfdev_dheap_find() - get the node stored at @index.
+ * @heap: the heap to search.
+ * @index: array index of node.
+ */
+static inline bfdev_dheap_node_t *
+bfdev_dheap_find(const bfdev_dheap_t *heap, unsigned long index)
+{
+    bfdev_dheap_node_t **slot;
+
+    slot = bfdev_array_data(&heap->nodes, index);
+    if (bfdev_unlikely(!slot))
+        return NULL;
+
+    return *slot;
+}
+
+/**
+ * bfdev_dheap_peek() - get the minimum node without removing it.
+ * @heap: the heap to peek.
+ */
+static inline bfdev_dheap_node_t *
+bfdev_dheap_peek(const bfdev_dheap_t *heap)
+{
+    return bfdev_dheap_find(heap, 0);
+}
+
+/**
+ * bfdev_dheap_insert() - insert a node into heap.
+ * @heap: the heap to insert into.
+ * @node: new node to insert.
+ */
+extern int
+bfdev_dheap_insert(bfdev_dheap_t *heap, bfdev_dheap_node_t *node);
+
+/**
+ * bfdev_dheap_delete() - remove an arbitrary node from heap.
+ * @heap: the heap to delete from.
+ * @node: node to delete.
+ */
+extern void
+bfdev_dheap_delete(bfdev_dheap_t *heap, bfdev_dheap_node_t *node);
+
+/**
+ * bfdev_dheap_pop() - remove and return the minimum node.
+ * @heap: the heap to pop from.
+ */
+extern bfdev_dheap_node_t *
+bfdev_dheap_pop(bfdev_dheap_t *heap);
+
+/**
+ * bfdev_dheap_update() - restore order after the key of @node changed.
+ * @heap: the heap of node.
+ * @node: the node whose key was decreased or increased.
+ */
+extern void
+bfdev_dheap_update(bfdev_dheap_t *heap, bfdev_dheap_node_t *node);
+
+/**
+ * bfdev_dheap_heapify() - bulk insert nodes and rebuild the heap.
+ * @heap: the heap to insert into.
+ * @nodes: array of nodes to insert.
+ * @num: number of nodes in @nodes.
+ *
+ * Appends all nodes and restores the heap order bottom-up,
+ * which costs O(n) instead of O(n log n) individual inserts.
+ */
+extern int
+bfdev_dheap_heapify(bfdev_dheap_t *heap, bfdev_dheap_node_t **nodes,
+                    unsigned long num);
+
+/**
+ * bfdev_dheap_release() - release the node array of heap.
+ * @heap: the heap to release.
+ */
+extern void
+bfdev_dheap_release(bfdev_dheap_t *heap);
+
+/**
+ * bfdev_dheap_for_each - iterate over a heap in array order.
+ * @pos: the &bfdev_dheap_node_t to use as a loop cursor.
+ * @index: the index to use as a loop counter.
+ * @heap: the heap to iterate over.
+ */
+#define bfdev_dheap_for_each(pos, index, heap) \
+    for ((index) = 0; ((pos) = bfdev_dheap_find(heap, index)); ++(index))
+
+/**
+ * bfdev_dheap_for_each_entry - iterate over a heap of given type in array order.
+ * @pos: the type * to use as a loop cursor.
+ * @index: the index to use as a loop counter.
+ * @heap: the heap to iterate over.
+ * @member: the name of the bfdev_dheap_node within the struct.
+ */
+#define bfdev_dheap_for_each_entry(pos, index, heap, member) \
+    for ((index) = 0; ((pos) = bfdev_dheap_entry_safe( \
+         bfdev_dheap_find(heap, index), typeof(*(pos)), member)); ++(index))
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_DHEAP_H_ */
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_DISPATCH_H_
+#define _BFDEV_DISPATCH_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/errno.h>
+#include <bfdev/list.h>
+#include <bfdev/macro.h>
+#include <bfdev/cpufeature.h>
+
+BFDEV_BEGIN_DECLS
+
+typedef struct bfdev_dispatch bfdev_dispatch_t;
+typedef struct bfdev_dispatch_impl bfdev_dispatch_impl_t;
+
+/**
+ * struct bfdev_dispatch_impl - one implementation of a module.
+ * @name: name to select it by, such as "avx2".
+ * @features: mask of BFDEV_CPU_FEATURE() bits it needs.
+ * @ops: module specific table of functions, NULL if not built in.
+ */
+struct bfdev_dispatch_impl {
+    const char *name;
+    uint64_t features;
+    const void *ops;
+};
+
+/**
+ * struct bfdev_dispatch - a module with several implementations.
+ * @list: linked into the registered modules.
+ * @name: name of the module.
+ * @impls: the implementations, preferred first.
+ * @count: number of @impls.
+ * @ops: ops of the selected implementation, used by the hot path.
+ * @selected: the selected implementation, NULL until registered.
+ *
+ * @ops is statically set to the portable implementation, so calls made
+ * before the module registers are served as well.
+ */
+struct bfdev_dispatch {
+    bfdev_list_head_t list;
+    const char *name;
+    const bfdev_dispatch_impl_t *impls;
+    unsigned int count;
+
+    const void *ops;
+    const bfdev_dispatch_impl_t *selected;
+};
+
+#define BFDEV_DISPATCH_IMPL(NAME, FEATURES, OPS) { \
+    .name = (NAME), .features = (FEATURES), .ops = (OPS), \
+}
+
+#define BFDEV_DISPATCH_STATIC(NAME, IMPLS, DEFAULT) { \
+    .name = (NAME), .impls = (IMPLS), \
+    .count = BFDEV_ARRAY_SIZE(IMPLS), .ops = (DEFAULT), \
+}
+
+#define BFDEV_DISPATCH_INIT(NAME, IMPLS, DEFAULT) \
+    (bfdev_dispatch_t) BFDEV_DISPATCH_STATIC(NAME, IMPLS, DEFAULT)
+
+#define BFDEV_DEFINE_DISPATCH(name, NAME, IMPLS, DEFAULT) \
+    bfdev_dispatch_t name = BFDEV_DISPATCH_INIT(NAME, IMPLS, DEFAULT)
+
+/**
+ * bfdev_dispatch_ops() - get the ops of the selected implementation.
+ * @dispatch: the module.
+ * @type: type of the module ops.
+ */
+#define bfdev_dispatch_ops(dispatch, type) \
+    ((const type *)(dispatch)->ops)
+
+/**
+ * bfdev_dispatch_usable() - test if an implementation can run here.
+ * @impl: the implementation.
+ */
+extern bool
+bfdev_dispatch_usable(const bfdev_dispatch_impl_t *impl);
+
+/**
+ * bfdev_dispatch_select() - switch the implementation of a module.
+ * @dispatch: the module.
+ * @name: implementation to switch to, NULL for the default choice.
+ *
+ * The default choice is the one named for the module by the
+ * BFDEV_DISPATCH environment variable, falling back to the first
+ * usable one. The variable holds a comma separated list of either
+ * "module=impl" or a bare "impl", which applies to every module
+ * that has it, for instance "generic" or "xxh3=avx2,crc32c=sse4.2".
+ *
+ * Switching is not synchronized with callers on other threads.
+ *
+ * @return: -BFDEV_ENOENT if there is no such implementation,
+ * -BFDEV_EOPNOTSUPP if it can not run on this cpu.
+ */
+extern int
+bfdev_dispatch_select(bfdev_dispatch_t *dispatch, const char *name);
+
+/**
+ * bfdev_dispatch_find() - find a registered module.
+ * @name: name of the module.
+ */
+extern bfdev_dispatch_t *
+bfdev_dispatch_find(const char *name);
+
+/**
+ * bfdev_dispatch_register() - register a module and select its default.
+ * @dispatch: the module.
+ *
+ * @return: -BFDEV_EALREADY if the name is taken, -BFDEV_EINVAL if
+ * none of the implementations is usable.
+ */
+extern int
+bfdev_dispatch_register(bfdev_dispatch_t *dispatch);
+
+/**
+ * bfdev_dispatch_unregister() - unregister a module.
+ * @dispatch: the module.
+ */
+extern int
+bfdev_dispatch_unregister(bfdev_dispatch_t *dispatch);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_DISPATCH_H_ */
@@ -0,0 +1,244 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_EBR_H_
+#define _BFDEV_EBR_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/slist.h>
+#include <bfdev/atomic.h>
+#include <bfdev/cmpxchg.h>
+#include <bfdev/allocator.h>
+#include <bfdev/container.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Epoch Based Reclamation:
+ *
+ * Lets lock-free structures free what they unlink while other threads
+ * may still be reading it. Readers wrap their accesses in critical
+ * sections which announce the global epoch they started in. A pointer
+ * retired in epoch E is handed to its release function once the
+ * global epoch has reached E + 2, at which point every critical
+ * section that could have seen it has ended.
+ *
+ * Every thread works through its own record obtained with
+ * bfdev_ebr_attach(). Retired objects embed a bfdev_ebr_node, which
+ * is queued on per-thread lists, one per epoch, so retiring never
+ * allocates and never fails. They are released in batches whenever
+ * a thread notices that the epoch moved on. A thread stalled inside
+ * a critical section holds back reclamation for everybody.
+ */
+
+#ifndef BFDEV_EBR_RECLAIM
+# define BFDEV_EBR_RECLAIM 64
+#endif
+
+#define BFDEV_EBR_EPOCHS 3
+
+typedef struct bfdev_ebr bfdev_ebr_t;
+typedef struct bfdev_ebr_thread bfdev_ebr_thread_t;
+typedef struct bfdev_ebr_limbo bfdev_ebr_limbo_t;
+typedef struct bfdev_ebr_node bfdev_ebr_node_t;
+
+/**
+ * bfdev_ebr_release_t - release a retired object.
+ * @alloc: allocator of the domain.
+ * @node: the node embedded in the retired object.
+ */
+typedef void
+(*bfdev_ebr_release_t)(const bfdev_alloc_t *alloc, bfdev_ebr_node_t *node);
+
+/**
+ * struct bfdev_ebr_node - retire link embedded in a reclaimed object.
+ * @next: next node retired in the same epoch.
+ * @release: called once the grace period is over.
+ */
+struct bfdev_ebr_node {
+    bfdev_ebr_node_t *next;
+    bfdev_ebr_release_t release;
+};
+
+/**
+ * struct bfdev_ebr_limbo - objects retired in one epoch.
+ * @head: the most recently retired node.
+ * @count: number of retired nodes.
+ * @epoch: the epoch the nodes were retired in.
+ */
+struct bfdev_ebr_limbo {
+    bfdev_ebr_node_t *head;
+    unsigned long count;
+    bfdev_atomic_t epoch;
+};
+
+/**
+ * struct bfdev_ebr_thread - per-thread reclamation record.
+ * @list: link in the record list of domain.
+ * @active: announced epoch shifted left by one, bit zero set while inside.
+ * @used: whether the record is attached to a thread.
+ * @nest: nesting depth of critical sections.
+ * @epoch: global epoch seen by the last critical section.
+ * @retired: nodes retired since the last epoch advance attempt.
+ * @limbo: retired nodes waiting for a grace period, one list per epoch.
+ */
+struct bfdev_ebr_thread {
+    bfdev_slist_head_t list;
+    bfdev_atomic_t active;
+    bfdev_atomic_t used;
+
+    unsigned int nest;
+    bfdev_atomic_t epoch;
+    unsigned long retired;
+    bfdev_ebr_limbo_t limbo[BFDEV_EBR_EPOCHS];
+};
+
+/**
+ * struct bfdev_ebr - reclamation domain.
+ * @alloc: allocator of records, passed to release functions.
+ * @epoch: global epoch.
+ * @threads: lock-less list of thread records.
+ */
+struct bfdev_ebr {
+    const bfdev_alloc_t *alloc;
+    bfdev_atomic_t epoch;
+    bfdev_slist_head_t threads;
+};
+
+#define BFDEV_EBR_STATIC(ALLOC) { \
+    .alloc = (ALLOC), .epoch = 0, .threads = {NULL}, \
+}
+
+#define BFDEV_EBR_INIT(alloc) \
+    (bfdev_ebr_t) BFDEV_EBR_STATIC(alloc)
+
+#define BFDEV_DEFINE_EBR(name, alloc) \
+    bfdev_ebr_t name = BFDEV_EBR_INIT(alloc)
+
+static inline void
+bfdev_ebr_init(bfdev_ebr_t *ebr, const bfdev_alloc_t *alloc)
+{
+    *ebr = BFDEV_EBR_INIT(alloc);
+}
+
+/**
+ * bfdev_ebr_collect() - release limbo lists of a thread.
+ * @ebr: the reclamation domain.
+ * @thread: the record whose limbo lists are walked.
+ * @epoch: global epoch last read from @ebr.
+ *
+ * Records @epoch as seen by @thread and passes every object retired
+ * by @thread at least two epochs before @epoch to its release
+ * callback. Objects of other threads are never touched.
+ *
+ * Only the thread owning @thread may call it, with an epoch it has
+ * read from @ebr, either inside its own critical section as done by
+ * bfdev_ebr_enter() or outside of any section.
+ */
+extern void
+bfdev_ebr_collect(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread,
+                  bfdev_atomic_t epoch);
+
+/**
+ * bfdev_ebr_enter() - enter a critical section.
+ * @ebr: the reclamation domain.
+ * @thread: the record of calling thread.
+ *
+ * Objects observed inside the critical section are not released
+ * until it is left. Critical sections may nest.
+ */
+static inline void
+bfdev_ebr_enter(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread)
+{
+    bfdev_atomic_t epoch;
+
+    if (thread->nest++)
+        return;
+
+    /* announce the epoch with a full barrier before reading pointers */
+    epoch = bfdev_atomic_read(&ebr->epoch);
+    bfdev_xchg(&thread->active, (bfdev_atomic_t)((uintptr_t)epoch << 1) | 1);
+
+    if (bfdev_unlikely(thread->epoch != epoch))
+        bfdev_ebr_collect(ebr, thread, epoch);
+}
+
+/**
+ * bfdev_ebr_leave() - leave a critical section.
+ * @ebr: the reclamation domain.
+ * @thread: the record of calling thread.
+ */
+static inline void
+bfdev_ebr_leave(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread)
+{
+    if (--thread->nest)
+        return;
+
+    /* every read of the critical section completes before this */
+    bfdev_atomic_write_release(&thread->active, 0);
+}
+
+/**
+ * bfdev_ebr_entry - get the struct for this entry.
+ * @ptr: the &bfdev_ebr_node_t pointer.
+ * @type: the type of the struct this is embedded in.
+ * @member: the name of the bfdev_ebr_node within the struct.
+ */
+#define bfdev_ebr_entry(ptr, type, member) \
+    bfdev_container_of(ptr, type, member)
+
+/**
+ * bfdev_ebr_retire() - release an object after a grace period.
+ * @ebr: the reclamation domain.
+ * @thread: the record of calling thread.
+ * @node: node embedded in an object already unreachable for new readers.
+ * @release: called with @node once no reader can hold it anymore.
+ */
+extern void
+bfdev_ebr_retire(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread,
+                 bfdev_ebr_node_t *node, bfdev_ebr_release_t release);
+
+/**
+ * bfdev_ebr_reclaim() - try to release retired pointers now.
+ * @ebr: the reclamation domain.
+ * @thread: the record of calling thread, outside critical sections.
+ *
+ * Attempts to advance the global epoch and releases what became
+ * safe. Never blocks. Returns true once nothing of @thread is left
+ * in limbo.
+ */
+extern bool
+bfdev_ebr_reclaim(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread);
+
+/**
+ * bfdev_ebr_attach() - get a thread record of domain.
+ * @ebr: the reclamation domain.
+ *
+ * Records released by bfdev_ebr_detach() are reused first, together
+ * with the nodes they still have in limbo.
+ */
+extern bfdev_ebr_thread_t *
+bfdev_ebr_attach(bfdev_ebr_t *ebr);
+
+/**
+ * bfdev_ebr_detach() - release a thread record.
+ * @ebr: the reclamation domain.
+ * @thread: the record to release, must be outside critical sections.
+ */
+extern void
+bfdev_ebr_detach(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread);
+
+/**
+ * bfdev_ebr_destroy() - release every retired object and record.
+ * @ebr: the reclamation domain, with no thread left inside.
+ */
+extern void
+bfdev_ebr_destroy(bfdev_ebr_t *ebr);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_EBR_H_ */
@@ -9,11 +9,13 @@
 #include <bfdev/config.h>
 #include <bfdev/macro.h>
 #include <bfdev/errno.h>
+#include <bfdev/atomic.h>
 #include <bfdev/allocator.h>
 
 BFDEV_BEGIN_DECLS
 
 typedef struct bfdev_fifo bfdev_fifo_t;
+typedef struct bfdev_fifo_span bfdev_fifo_span_t;
 
 struct bfdev_fifo {
     const bfdev_alloc_t *alloc;
@@ -24,6 +26,16 @@ struct bfdev_fifo {
     void *data;
 };
 
+/**
+ * struct bfdev_fifo_span - contiguous region inside the fifo buffer.
+ * @data: start of the region.
+ * @len: number of objects in the region.
+ */
+struct bfdev_fifo_span {
+    void *data;
+    unsigned long len;
+};
+
 /**
  * BFDEV_GENERIC_FIFO() - define a generic fifo structure.
  * @datatype: fifo data type.
@@ -429,6 +441,55 @@ struct bfdev_fifo {
     bfdev_fifo_in_flat(__fifo, __tbuff, __tlen);                    \
 })
 
+/**
+ * bfdev_fifo_reserve() - get writable regions without copying.
+ * @pfifo: the fifo to write into.
+ * @spans: two spans, the second one covers the wraparound.
+ * @len: number of objects wanted.
+ *
+ * Returns the number of objects that may be written in place,
+ * they become visible after bfdev_fifo_commit(). Record fifos
+ * are not supported.
+ */
+#define bfdev_fifo_reserve(pfifo, spans, len) ({                    \
+    typeof((pfifo) + 1) __tmp = (pfifo);                            \
+    bfdev_fifo_reserve_flat(&__tmp->fifo, (spans), (len));          \
+})
+
+/**
+ * bfdev_fifo_commit() - publish objects written in reserved regions.
+ * @pfifo: the fifo written into.
+ * @len: number of objects, no more than reserved.
+ */
+#define bfdev_fifo_commit(pfifo, len) ({                            \
+    typeof((pfifo) + 1) __tmp = (pfifo);                            \
+    bfdev_fifo_commit_flat(&__tmp->fifo, (len));                    \
+})
+
+/**
+ * bfdev_fifo_peek_spans() - get readable regions without copying.
+ * @pfifo: the fifo to read from.
+ * @spans: two spans, the second one covers the wraparound.
+ * @len: number of objects wanted.
+ *
+ * Returns the number of objects that may be read in place,
+ * they stay in the fifo until bfdev_fifo_consume().
+ */
+#define bfdev_fifo_peek_spans(pfifo, spans, len) ({                 \
+    typeof((pfifo) + 1) __tmp = (pfifo);                            \
+    bfdev_fifo_peek_spans_flat(&__tmp->fifo, (spans), (len));       \
+})
+
+/**
+ * bfdev_fifo_consume() - release objects read in place.
+ * @pfifo: the fifo read from.
+ * @len: number of objects, no more than peeked.
+ */
+#define bfdev_fifo_consume(pfifo, len) ({                           \
+    typeof((pfifo) + 1) __tmp = (pfifo);                            \
+    bfdev_fifo_consume_flat(&__tmp->fifo, (len));                   \
+})
+
 extern unsigned long
 bfdev_fifo_peek_flat(bfdev_fifo_t *fifo, void *buff, unsigned long len);
 
@@ -450,6 +511,20 @@ extern unsigned long
 bfdev_fifo_in_record(bfdev_fifo_t *fifo, const void *buff, unsigned long len,
                      unsigned long record);
 
+extern unsigned long
+bfdev_fifo_reserve_flat(bfdev_fifo_t *fifo, bfdev_fifo_span_t *spans,
+                        unsigned long len);
+
+extern void
+bfdev_fifo_commit_flat(bfdev_fifo_t *fifo, unsigned long len);
+
+extern unsigned long
+bfdev_fifo_peek_spans_flat(bfdev_fifo_t *fifo, bfdev_fifo_span_t *spans,
+                           unsigned long len);
+
+extern void
+bfdev_fifo_consume_flat(bfdev_fifo_t *fifo, unsigned long len);
+
 extern int
 bfdev_fifo_dynamic_alloc(bfdev_fifo_t *fifo, const bfdev_alloc_t *alloc,
                          size_t esize, size_t size);
@@ -457,6 +532,410 @@ bfdev_fifo_dynamic_alloc(bfdev_fifo_t *fifo, const bfdev_alloc_t *alloc,
 extern void
 bfdev_fifo_dynamic_free(bfdev_fifo_t *fifo);
 
+/**
+ * SPSC Fifo:
+ *
+ * The single-producer single-consumer fifo keeps the layout of
+ * the normal fifo, but each index sits on its own cache line and
+ * is published with release ordering and observed with acquire
+ * ordering, so one producer thread and one consumer thread may use
+ * it concurrently without a lock. Each side also caches its last
+ * view of the other index and only rereads the shared cache line
+ * when the cached view says the fifo is full or empty.
+ */
+
+typedef struct bfdev_fifo_spsc bfdev_fifo_spsc_t;
+
+struct bfdev_fifo_spsc {
+    const bfdev_alloc_t *alloc;
+    unsigned long mask;
+    unsigned long esize;
+    void *data;
+
+    /* producer side */
+    unsigned long in __bfdev_cacheline_aligned;
+    unsigned long cout;
+
+    /* consumer side */
+    unsigned long out __bfdev_cacheline_aligned;
+    unsigned long cin;
+};
+
+/**
+ * BFDEV_GENERIC_FIFO_SPSC() - define a generic spsc fifo structure.
+ * @datatype: fifo data type.
+ * @ptrtype: fifo pointer containing data.
+ */
+#define BFDEV_GENERIC_FIFO_SPSC(datatype, ptrtype)      \
+    union {                                             \
+        bfdev_fifo_spsc_t fifo;                         \
+        datatype *data;                                 \
+        const datatype *cdata;                          \
+        ptrtype *ptr;                                   \
+        const ptrtype *cptr;                            \
+    }
+
+/**
+ * BFDEV_BODY_FIFO_SPSC() - generate the body of spsc fifo.
+ * @type: fifo contains the type of data.
+ * @ptype: fifo pointer containing data.
+ * @size: fifo buffer size.
+ */
+#define BFDEV_BODY_FIFO_SPSC(type, ptype, size) {       \
+    BFDEV_GENERIC_FIFO_SPSC(type, ptype);               \
+    type buff[((size < 2) ||                            \
+        (size & (size - 1))) ? -1 : size];              \
+}
+
+/**
+ * BFDEV_BODY_FIFO_SPSC_DYNAMIC() - generate the body of dynamic spsc fifo.
+ * @type: fifo contains the type of data.
+ * @ptype: fifo pointer containing data.
+ */
+#define BFDEV_BODY_FIFO_SPSC_DYNAMIC(type, ptype) {     \
+    BFDEV_GENERIC_FIFO_SPSC(type, ptype);               \
+    type buff[0];                                       \
+}
+
+/**
+ * BFDEV_FIFO_SPSC_INIT() - initialize spsc fifo in compound literals.
+ * @ptr: the pointer of fifo to init.
+ */
+#define BFDEV_FIFO_SPSC_INIT(ptr)                       \
+(typeof(*(ptr))) {                                      \
+    .fifo = {                                           \
+        .in = 0, .cout = 0, .out = 0, .cin = 0,         \
+        .esize = sizeof(*(ptr)->buff),                  \
+        .mask = BFDEV_ARRAY_SIZE((ptr)->buff) - 1,      \
+        .data = &(ptr)->buff,                           \
+    },                                                  \
+}
+
+/**
+ * BFDEV_FIFO_SPSC_DYNAMIC_INIT() - initialize dynamic spsc fifo in compound literals.
+ * @ptr: the pointer of fifo to init.
+ */
+#define BFDEV_FIFO_SPSC_DYNAMIC_INIT(ptr)               \
+(typeof(*(ptr))) {                                      \
+    .fifo = {                                           \
+        .in = 0, .cout = 0, .out = 0, .cin = 0,         \
+        .mask = 0, .data = NULL,                        \
+        .esize = sizeof(*(ptr)->buff),                  \
+    },                                                  \
+}
+
+/**
+ * BFDEV_STRUCT_FIFO_SPSC() - generate a spsc fifo structure.
+ * @type: fifo contains the type of data.
+ * @size: fifo buffer size.
+ */
+#define BFDEV_STRUCT_FIFO_SPSC(type, size) \
+    struct BFDEV_BODY_FIFO_SPSC(type, type, size)
+
+/**
+ * BFDEV_STRUCT_FIFO_SPSC_DYNAMIC() - generate a dynamic spsc fifo structure.
+ * @type: fifo contains the type of data.
+ */
+#define BFDEV_STRUCT_FIFO_SPSC_DYNAMIC(type) \
+    struct BFDEV_BODY_FIFO_SPSC_DYNAMIC(type, type)
+
+/**
+ * BFDEV_DECLARE_FIFO_SPSC() - declare a spsc fifo structure.
+ * @name: name of fifo structure to declare.
+ * @type: fifo contains the type of data.
+ * @size: fifo buffer size.
+ */
+#define BFDEV_DECLARE_FIFO_SPSC(name, type, size) \
+    BFDEV_STRUCT_FIFO_SPSC(type, size) name
+
+/**
+ * BFDEV_DECLARE_FIFO_SPSC_DYNAMIC() - declare a dynamic spsc fifo structure.
+ * @name: name of fifo structure to declare.
+ * @type: fifo contains the type of data.
+ */
+#define BFDEV_DECLARE_FIFO_SPSC_DYNAMIC(name, type) \
+    BFDEV_STRUCT_FIFO_SPSC_DYNAMIC(type) name
+
+/**
+ * BFDEV_DEFINE_FIFO_SPSC() - define a spsc fifo structure.
+ * @name: name of fifo structure to declare.
+ * @type: fifo contains the type of data.
+ * @size: fifo buffer size.
+ */
+#define BFDEV_DEFINE_FIFO_SPSC(name, type, size) \
+    BFDEV_DECLARE_FIFO_SPSC(name, type, size) = BFDEV_FIFO_SPSC_INIT(&name)
+
+/**
+ * BFDEV_DEFINE_FIFO_SPSC_DYNAMIC() - define a dynamic spsc fifo structure.
+ * @name: name of fifo structure to declare.
+ * @type: fifo contains the type of data.
+ */
+#define BFDEV_DEFINE_FIFO_SPSC_DYNAMIC(name, type) \
+    BFDEV_DECLARE_FIFO_SPSC_DYNAMIC(name, type) = BFDEV_FIFO_SPSC_DYNAMIC_INIT(&name)
+
+/**
+ * bfdev_fifo_spsc_unused() - get the free space seen by the producer.
+ * @fifo: the spsc fifo to check.
+ * @need: reread the consumer index if less than this is cached free.
+ *
+ * Must only be called by the producer.
+ */
+static inline unsigned long
+bfdev_fifo_spsc_unused(bfdev_fifo_spsc_t *fifo, unsigned long need)
+{
+    unsigned long size, unused;
+
+    size = fifo->mask + 1;
+    unused = size - (fifo->in - fifo->cout);
+
+    if (unused < need) {
+        fifo->cout = bfdev_atomic_read_acquire((bfdev_atomic_t *)&fifo->out);
+        unused = size - (fifo->in - fifo->cout);
+    }
+
+    return unused;
+}
+
+/**
+ * bfdev_fifo_spsc_valid() - get the data length seen by the consumer.
+ * @fifo: the spsc fifo to check.
+ * @need: reread the producer index if less than this is cached valid.
+ *
+ * Must only be called by the consumer.
+ */
+static inline unsigned long
+bfdev_fifo_spsc_valid(bfdev_fifo_spsc_t *fifo, unsigned long need)
+{
+    unsigned long valid;
+
+    valid = fifo->cin - fifo->out;
+
+    if (valid < need) {
+        fifo->cin = bfdev_atomic_read_acquire((bfdev_atomic_t *)&fifo->in);
+        valid = fifo->cin - fifo->out;
+    }
+
+    return valid;
+}
+
+/**
+ * bfdev_fifo_spsc_len() - get a snapshot of the valid data length.
+ * @ptr: the spsc fifo to get.
+ */
+#define bfdev_fifo_spsc_len(ptr) ({                                     \
+    typeof((ptr) + 1) __tlen = (ptr);                                   \
+    bfdev_atomic_read((bfdev_atomic_t *)&__tlen->fifo.in) -             \
+    bfdev_atomic_read((bfdev_atomic_t *)&__tlen->fifo.out);             \
+})
+
+/**
+ * bfdev_fifo_spsc_check_empty() - check whether spsc fifo is empty.
+ * @ptr: the spsc fifo to check, only valid for the consumer.
+ */
+#define bfdev_fifo_spsc_check_empty(ptr) ({                             \
+    typeof((ptr) + 1) __ttmp = (ptr);                                   \
+    !bfdev_fifo_spsc_valid(&__ttmp->fifo, 1);                           \
+})
+
+/**
+ * bfdev_fifo_spsc_check_full() - check whether spsc fifo is full.
+ * @ptr: the spsc fifo to check, only valid for the producer.
+ */
+#define bfdev_fifo_spsc_check_full(ptr) ({                              \
+    typeof((ptr) + 1) __ttmp = (ptr);                                   \
+    !bfdev_fifo_spsc_unused(&__ttmp->fifo, 1);                          \
+})
+
+/**
+ * bfdev_fifo_spsc_alloc() - dynamically allocate buffer to spsc fifo.
+ * @ptr: the spsc fifo to allocate buffer.
+ * @size: size of buffer.
+ */
+#define bfdev_fifo_spsc_alloc(ptr, alloc, size) ({                      \
+    typeof((ptr) + 1) __tmp = (ptr);                                    \
+    bfdev_fifo_check_dynamic(__tmp) ?                                   \
+    bfdev_fifo_spsc_dynamic_alloc(&__tmp->fifo,                         \
+    alloc, sizeof(*__tmp->data), size) :                                \
+    -BFDEV_EINVAL;                                                      \
+})
+
+/**
+ * bfdev_fifo_spsc_free() - dynamically free buffer to spsc fifo.
+ * @ptr: the spsc fifo to free buffer.
+ */
+#define bfdev_fifo_spsc_free(ptr) ({                                    \
+    typeof((ptr) + 1) __tmp = (ptr);                                    \
+    bfdev_fifo_check_dynamic(__tmp) ?                                   \
+    bfdev_fifo_spsc_dynamic_free(&__tmp->fifo) :                        \
+    -BFDEV_EINVAL;                                                      \
+})
+
+/**
+ * bfdev_fifo_spsc_get() - get an object from spsc fifo.
+ * @pfifo: the spsc fifo to get object out.
+ * @value: object to get.
+ */
+#define bfdev_fifo_spsc_get(pfifo, value) ({                            \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    typeof(__tmp->ptr) __tvalue = (value);                              \
+    bfdev_fifo_spsc_t *__fifo = &__tmp->fifo;                           \
+    unsigned long __retval;                                             \
+    __retval = !!bfdev_fifo_spsc_valid(__fifo, 1);                      \
+    if (__retval) {                                                     \
+        *(typeof(__tmp->data)) __tvalue =                               \
+        (bfdev_fifo_check_dynamic(__tmp) ?                              \
+        ((typeof(__tmp->data)) __fifo->data) :                          \
+        (__tmp->buff))                                                  \
+        [__fifo->out & __fifo->mask];                                   \
+        bfdev_atomic_write_release(                                     \
+            (bfdev_atomic_t *)&__fifo->out, __fifo->out + 1);           \
+    }                                                                   \
+    __retval;                                                           \
+})
+
+/**
+ * bfdev_fifo_spsc_put() - put an object into spsc fifo.
+ * @pfifo: the spsc fifo to put object in.
+ * @value: object to put.
+ */
+#define bfdev_fifo_spsc_put(pfifo, value) ({                            \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    typeof(*__tmp->cdata) __tvalue = (value);                           \
+    bfdev_fifo_spsc_t *__fifo = &__tmp->fifo;                           \
+    unsigned long __retval;                                             \
+    __retval = !!bfdev_fifo_spsc_unused(__fifo, 1);                     \
+    if (__retval) {                                                     \
+        (bfdev_fifo_check_dynamic(__tmp) ?                              \
+        ((typeof(__tmp->data)) __fifo->data) :                          \
+        (__tmp->buff))                                                  \
+        [__fifo->in & __fifo->mask] =                                   \
+        *(typeof(__tmp->data)) &__tvalue;                               \
+        bfdev_atomic_write_release(                                     \
+            (bfdev_atomic_t *)&__fifo->in, __fifo->in + 1);             \
+    }                                                                   \
+    __retval;                                                           \
+})
+
+/**
+ * bfdev_fifo_spsc_out_peek() - peek continuous data from spsc fifo.
+ * @pfifo: the spsc fifo to peek data out.
+ * @buff: the buffer to peek data in.
+ * @len: number of continuously peeked objects.
+ */
+#define bfdev_fifo_spsc_out_peek(pfifo, buff, len) ({                   \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    typeof(__tmp->ptr) __tbuff = (buff);                                \
+    bfdev_fifo_spsc_peek_flat(&__tmp->fifo, __tbuff, (len));            \
+})
+
+/**
+ * bfdev_fifo_spsc_out() - copy continuous data from spsc fifo.
+ * @pfifo: the spsc fifo to copy data out.
+ * @buff: the buffer to copy data in.
+ * @len: number of continuously copied objects.
+ */
+#define bfdev_fifo_spsc_out(pfifo, buff, len) ({                        \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    typeof(__tmp->ptr) __tbuff = (buff);                                \
+    bfdev_fifo_spsc_out_flat(&__tmp->fifo, __tbuff, (len));             \
+})
+
+/**
+ * bfdev_fifo_spsc_in() - copy continuous data into spsc fifo.
+ * @pfifo: the spsc fifo to copy data in.
+ * @buff: the buffer to copy data out.
+ * @len: number of continuously copied objects.
+ */
+#define bfdev_fifo_spsc_in(pfifo, buff, len) ({                         \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    typeof(__tmp->cptr) __tbuff = (buff);                               \
+    bfdev_fifo_spsc_in_flat(&__tmp->fifo, __tbuff, (len));              \
+})
+
+/**
+ * bfdev_fifo_spsc_reserve() - get writable regions without copying.
+ * @pfifo: the spsc fifo to write into.
+ * @spans: two spans, the second one covers the wraparound.
+ * @len: number of objects wanted.
+ *
+ * Must only be called by the producer.
+ */
+#define bfdev_fifo_spsc_reserve(pfifo, spans, len) ({                   \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    bfdev_fifo_spsc_reserve_flat(&__tmp->fifo, (spans), (len));         \
+})
+
+/**
+ * bfdev_fifo_spsc_commit() - publish objects written in reserved regions.
+ * @pfifo: the spsc fifo written into.
+ * @len: number of objects, no more than reserved.
+ *
+ * Must only be called by the producer.
+ */
+#define bfdev_fifo_spsc_commit(pfifo, len) ({                           \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    bfdev_fifo_spsc_commit_flat(&__tmp->fifo, (len));                   \
+})
+
+/**
+ * bfdev_fifo_spsc_peek_spans() - get readable regions without copying.
+ * @pfifo: the spsc fifo to read from.
+ * @spans: two spans, the second one covers the wraparound.
+ * @len: number of objects wanted.
+ *
+ * Must only be called by the consumer.
+ */
+#define bfdev_fifo_spsc_peek_spans(pfifo, spans, len) ({                \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    bfdev_fifo_spsc_peek_spans_flat(&__tmp->fifo, (spans), (len));      \
+})
+
+/**
+ * bfdev_fifo_spsc_consume() - release objects read in place.
+ * @pfifo: the spsc fifo read from.
+ * @len: number of objects, no more than peeked.
+ *
+ * Must only be called by the consumer.
+ */
+#define bfdev_fifo_spsc_consume(pfifo, len) ({                          \
+    typeof((pfifo) + 1) __tmp = (pfifo);                                \
+    bfdev_fifo_spsc_consume_flat(&__tmp->fifo, (len));                  \
+})
+
+extern unsigned long
+bfdev_fifo_spsc_peek_flat(bfdev_fifo_spsc_t *fifo, void *buff,
+                          unsigned long len);
+
+extern unsigned long
+bfdev_fifo_spsc_out_flat(bfdev_fifo_spsc_t *fifo, void *buff,
+                         unsigned long len);
+
+extern unsigned long
+bfdev_fifo_spsc_in_flat(bfdev_fifo_spsc_t *fifo, const void *buff,
+                        unsigned long len);
+
+extern unsigned long
+bfdev_fifo_spsc_reserve_flat(bfdev_fifo_spsc_t *fifo, bfdev_fifo_span_t *spans,
+                             unsigned long len);
+
+extern void
+bfdev_fifo_spsc_commit_flat(bfdev_fifo_spsc_t *fifo, unsigned long len);
+
+extern unsigned long
+bfdev_fifo_spsc_peek_spans_flat(bfdev_fifo_spsc_t *fifo,
+                                bfdev_fifo_span_t *spans, unsigned long len);
+
+extern void
+bfdev_fifo_spsc_consume_flat(bfdev_fifo_spsc_t *fifo, unsigned long len);
+
+extern int
+bfdev_fifo_spsc_dynamic_alloc(bfdev_fifo_spsc_t *fifo,
+                              const bfdev_alloc_t *alloc,
+                              size_t esize, size_t size);
+
+extern void
+bfdev_fifo_spsc_dynamic_free(bfdev_fifo_spsc_t *fifo);
+
 BFDEV_END_DECLS
 
 #endif  /* _BFDEV_FIFO_H_ */
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_FSKIPLIST_H_
+#define _BFDEV_FSKIPLIST_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Forward Skiplist:
+ *
+ * The forward skiplist keeps only a singly-linked tower of next
+ * links per node, carved out of large arena chunks instead of
+ * one allocation per node. Every link caches an order-preserving
+ * prefix of the key it points to, so most comparisons neither
+ * reach the callback nor touch the cache line of the next node.
+ * An optional finger remembers the last search path so that
+ * sequential inserts and lookups start close to their target.
+ */
+
+#ifndef BFDEV_FSKIPLIST_CHUNK
+# define BFDEV_FSKIPLIST_CHUNK 65536
+#endif
+
+typedef struct bfdev_fskip_head bfdev_fskip_head_t;
+typedef struct bfdev_fskip_node bfdev_fskip_node_t;
+typedef struct bfdev_fskip_link bfdev_fskip_link_t;
+typedef struct bfdev_fskip_ops bfdev_fskip_ops_t;
+
+/**
+ * struct bfdev_fskip_link - forward link of one tower level.
+ * @next: the next node on this level.
+ * @prefix: cached key prefix of @next, compared without touching @next.
+ */
+struct bfdev_fskip_link {
+    bfdev_fskip_node_t *next;
+    uintptr_t prefix;
+};
+
+struct bfdev_fskip_node {
+    void *key;
+    unsigned int level;
+    bfdev_fskip_link_t link[0];
+};
+
+/**
+ * struct bfdev_fskip_ops - forward skiplist operations.
+ * @cmp: total order of keys.
+ * @prefix: optional, must satisfy prefix(a) < prefix(b) => a < b.
+ */
+struct bfdev_fskip_ops {
+    long (*cmp)(const void *key1, const void *key2, void *pdata);
+    uintptr_t (*prefix)(const void *key, void *pdata);
+};
+
+struct bfdev_fskip_head {
+    const bfdev_alloc_t *alloc;
+    const bfdev_fskip_ops_t *ops;
+    void *pdata;
+
+    unsigned int curr;
+    unsigned int levels;
+    unsigned long count;
+
+    /* arena of node towers */
+    void *chunks;
+    uintptr_t brk;
+    uintptr_t end;
+    bfdev_fskip_node_t **freelist;
+
+    /* last search path */
+    bool finger;
+    uintptr_t fprefix;
+    bfdev_fskip_node_t **path;
+    bfdev_fskip_node_t sentinel;
+};
+
+/**
+ * bfdev_fskiplist_insert() - insert a key into skiplist.
+ * @head: the skiplist to insert into.
+ * @key: the key to insert.
+ */
+extern int
+bfdev_fskiplist_insert(bfdev_fskip_head_t *head, void *key);
+
+/**
+ * bfdev_fskiplist_delete() - delete a key from skiplist.
+ * @head: the skiplist to delete from.
+ * @key: the key to delete.
+ *
+ * Returns the stored key, or NULL if not found.
+ */
+extern void *
+bfdev_fskiplist_delete(bfdev_fskip_head_t *head, const void *key);
+
+/**
+ * bfdev_fskiplist_find() - find a key in skiplist.
+ * @head: the skiplist to search.
+ * @key: the key to find.
+ */
+extern bfdev_fskip_node_t *
+bfdev_fskiplist_find(bfdev_fskip_head_t *head, const void *key);
+
+/**
+ * bfdev_fskiplist_reset() - remove all keys and recycle the arena.
+ * @head: the skiplist to reset.
+ * @release: optional callback for every stored key.
+ * @pdata: private data of @release.
+ */
+extern void
+bfdev_fskiplist_reset(bfdev_fskip_head_t *head, bfdev_release_t release,
+                      void *pdata);
+
+/**
+ * bfdev_fskiplist_create() - create a forward skiplist.
+ * @alloc: allocator used for head and arena chunks.
+ * @ops: skiplist operations.
+ * @levels: maximum tower height.
+ * @finger: enable the last-search finger.
+ * @pdata: private data of @ops.
+ */
+extern bfdev_fskip_head_t *
+bfdev_fskiplist_create(const bfdev_alloc_t *alloc, const bfdev_fskip_ops_t *ops,
+                       unsigned int levels, bool finger, void *pdata);
+
+/**
+ * bfdev_fskiplist_destroy() - destroy a forward skiplist.
+ * @head: the skiplist to destroy.
+ * @release: optional callback for every stored key.
+ * @pdata: private data of @release.
+ */
+extern void
+bfdev_fskiplist_destroy(bfdev_fskip_head_t *head, bfdev_release_t release,
+                        void *pdata);
+
+/**
+ * bfdev_fskiplist_first() - get the smallest node.
+ * @head: the skiplist to take the node from.
+ */
+static inline bfdev_fskip_node_t *
+bfdev_fskiplist_first(const bfdev_fskip_head_t *head)
+{
+    return head->sentinel.link[0].next;
+}
+
+/**
+ * bfdev_fskiplist_next() - get the next node in key order.
+ * @node: the current node.
+ */
+static inline bfdev_fskip_node_t *
+bfdev_fskiplist_next(const bfdev_fskip_node_t *node)
+{
+    return node->link[0].next;
+}
+
+/**
+ * bfdev_fskiplist_for_each - iterate over skiplist in key order.
+ * @pos: the &bfdev_fskip_node_t to use as a loop cursor.
+ * @head: the head for your skiplist.
+ */
+#define bfdev_fskiplist_for_each(pos, head) \
+    for (pos = bfdev_fskiplist_first(head); pos; \
+         pos = bfdev_fskiplist_next(pos))
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_FSKIPLIST_H_ */
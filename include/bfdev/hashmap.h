@@ -9,6 +9,7 @@
 #include <bfdev/config.h>
 #include <bfdev/errno.h>
 #include <bfdev/hashtbl.h>
+#include <bfdev/percpu.h>
 #include <bfdev/allocator.h>
 
 BFDEV_BEGIN_DECLS
@@ -35,6 +36,11 @@ enum bfdev_hashmap_strategy {
     BFDEV_HASHMAP_APPEND,
 };
 
+/**
+ * struct bfdev_hashmap - hashmap head.
+ * @hits: optional counter of lookups that found their key.
+ * @misses: optional counter of lookups that did not.
+ */
 struct bfdev_hashmap {
     bfdev_hlist_head_t *buckets;
     unsigned int bits;
@@ -44,6 +50,9 @@ struct bfdev_hashmap {
     const bfdev_alloc_t *alloc;
     const bfdev_hashmap_ops_t *ops;
     void *pdata;
+
+    bfdev_percpu_counter_t *hits;
+    bfdev_percpu_counter_t *misses;
 };
 
 struct bfdev_hashmap_ops {
@@ -80,6 +89,23 @@ bfdev_hashmap_init(bfdev_hashmap_t *hashmap, const bfdev_alloc_t *alloc,
     *hashmap = BFDEV_HASHMAP_INIT(alloc, ops, pdata);
 }
 
+/**
+ * bfdev_hashmap_stat() - attach lookup counters to hashmap.
+ * @hashmap: hashmap structure to account.
+ * @hits: counter of found keys, or NULL.
+ * @misses: counter of missing keys, or NULL.
+ *
+ * The counters stay owned by the caller and may be shared by several
+ * hashmaps, bfdev_hashmap_release() leaves them alone.
+ */
+static inline void
+bfdev_hashmap_stat(bfdev_hashmap_t *hashmap, bfdev_percpu_counter_t *hits,
+                   bfdev_percpu_counter_t *misses)
+{
+    hashmap->hits = hits;
+    hashmap->misses = misses;
+}
+
 /**
  * bfdev_hashmap_insert() - insert a hashlist node to hashmap.
  * @hashmap: hashmap structure to be insert.
@@ -109,6 +135,20 @@ bfdev_hashmap_del(bfdev_hashmap_t *hashmap, const void *key,
 extern bfdev_hlist_node_t *
 bfdev_hashmap_find(bfdev_hashmap_t *hashmap, const void *key);
 
+/**
+ * bfdev_hashmap_find_cpu() - find a hashlist node and account it to a cpu.
+ * @hashmap: hashmap structure to be find.
+ * @key: key of the node to be find.
+ * @cpu: index of calling cpu or thread.
+ *
+ * Lookups leave the hashmap untouched, so readers sharing it under
+ * a read lock pass their own @cpu and bump separate counter slots.
+ * bfdev_hashmap_find() accounts everything to slot zero.
+ */
+extern bfdev_hlist_node_t *
+bfdev_hashmap_find_cpu(bfdev_hashmap_t *hashmap, const void *key,
+                       unsigned int cpu);
+
 /**
  * bfdev_hashmap_release() - release hash bucket in hashmap.
  * @hashmap: hashmap structure to be release.
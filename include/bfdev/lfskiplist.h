@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_LFSKIPLIST_H_
+#define _BFDEV_LFSKIPLIST_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/slist.h>
+#include <bfdev/atomic.h>
+#include <bfdev/prandom.h>
+#include <bfdev/ebr.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Lock-free Skiplist:
+ *
+ * A concurrent skiplist in the style of Fraser and Herlihy-Shavit.
+ * Keys are unique, every level is a lock-free linked list whose
+ * next pointers carry a deletion mark in the lowest bit: a delete
+ * first marks the tower from top to bottom, the mark on level zero
+ * is the linearization point, then any traversal snips the marked
+ * node out. Unlinked towers are handed to the epoch based
+ * reclamation of the skiplist, so readers never touch freed memory.
+ *
+ * Every thread works through its own record obtained with
+ * bfdev_lfskiplist_attach(). The allocator of the skiplist must
+ * be thread-safe. A key belongs to the skiplist once inserted:
+ * readers may still compare it after it is deleted, so it goes to
+ * the release callback together with its tower, after the grace
+ * period or at destroy.
+ */
+
+typedef struct bfdev_lfskip_head bfdev_lfskip_head_t;
+typedef struct bfdev_lfskip_node bfdev_lfskip_node_t;
+typedef struct bfdev_lfskip_thread bfdev_lfskip_thread_t;
+
+/**
+ * struct bfdev_lfskip_node - tower of a lock-free skiplist.
+ * @key: the key stored in this node.
+ * @head: the skiplist, used to release the key with the tower.
+ * @retire: reclamation link once the node is unlinked.
+ * @owners: parties that must finish before the node is retired.
+ * @level: height of the tower.
+ * @next: marked next pointers of every level.
+ */
+struct bfdev_lfskip_node {
+    void *key;
+    bfdev_lfskip_head_t *head;
+    bfdev_ebr_node_t retire;
+    bfdev_atomic_t owners;
+    unsigned int level;
+    bfdev_atomic_t next[0];
+};
+
+/**
+ * struct bfdev_lfskip_thread - per-thread skiplist record.
+ * @list: link in the record list of skiplist.
+ * @used: whether the record is attached to a thread.
+ * @ebr: reclamation record, kept for the lifetime of this record.
+ * @rand: private random state for tower heights.
+ * @path: predecessors and successors of the last search.
+ */
+struct bfdev_lfskip_thread {
+    bfdev_slist_head_t list;
+    bfdev_atomic_t used;
+    bfdev_ebr_thread_t *ebr;
+
+    bfdev_prandom_t rand;
+    bfdev_lfskip_node_t *path[0];
+};
+
+struct bfdev_lfskip_head {
+    const bfdev_alloc_t *alloc;
+    bfdev_cmp_t cmp;
+    bfdev_release_t release;
+    void *pdata;
+
+    unsigned int levels;
+    bfdev_atomic_t curr;
+    bfdev_ebr_t ebr;
+    bfdev_slist_head_t threads;
+    bfdev_lfskip_node_t sentinel;
+};
+
+/**
+ * bfdev_lfskiplist_attach() - get a thread record of skiplist.
+ * @head: the skiplist to work on.
+ *
+ * Records released by bfdev_lfskiplist_detach() are reused first,
+ * together with the nodes they still have in limbo.
+ */
+extern bfdev_lfskip_thread_t *
+bfdev_lfskiplist_attach(bfdev_lfskip_head_t *head);
+
+/**
+ * bfdev_lfskiplist_detach() - release a thread record.
+ * @head: the skiplist of record.
+ * @thread: the record to release, must be outside critical sections.
+ */
+extern void
+bfdev_lfskiplist_detach(bfdev_lfskip_head_t *head,
+                        bfdev_lfskip_thread_t *thread);
+
+/**
+ * bfdev_lfskiplist_enter() - enter a read-side critical section.
+ * @head: the skiplist to protect.
+ * @thread: the record of calling thread.
+ *
+ * Nodes observed inside the critical section are not reclaimed
+ * until it is left. Critical sections may nest.
+ */
+extern void
+bfdev_lfskiplist_enter(bfdev_lfskip_head_t *head,
+                       bfdev_lfskip_thread_t *thread);
+
+/**
+ * bfdev_lfskiplist_leave() - leave a read-side critical section.
+ * @head: the skiplist to protect.
+ * @thread: the record of calling thread.
+ */
+extern void
+bfdev_lfskiplist_leave(bfdev_lfskip_head_t *head,
+                       bfdev_lfskip_thread_t *thread);
+
+/**
+ * bfdev_lfskiplist_insert() - insert a key into skiplist.
+ * @head: the skiplist to insert into.
+ * @thread: the record of calling thread.
+ * @key: the key to insert.
+ *
+ * On success @key is owned by the skiplist until it is released.
+ * Returns -BFDEV_EEXIST if an equal key is already present, @key
+ * then stays with the caller.
+ */
+extern int
+bfdev_lfskiplist_insert(bfdev_lfskip_head_t *head,
+                        bfdev_lfskip_thread_t *thread, void *key);
+
+/**
+ * bfdev_lfskiplist_delete() - delete a key from skiplist.
+ * @head: the skiplist to delete from.
+ * @thread: the record of calling thread.
+ * @key: the key to delete.
+ *
+ * The stored key is handed to the release callback once no reader
+ * can reach it anymore, not before this returns.
+ *
+ * Returns -BFDEV_ENOENT if not found.
+ */
+extern int
+bfdev_lfskiplist_delete(bfdev_lfskip_head_t *head,
+                        bfdev_lfskip_thread_t *thread, const void *key);
+
+/**
+ * bfdev_lfskiplist_find() - find a key in skiplist.
+ * @head: the skiplist to search.
+ * @thread: the record of calling thread.
+ * @key: the key to find.
+ *
+ * The stored key may be released by a concurrent delete as soon as
+ * the critical section ends. To use it after the call, wrap the call
+ * and the use in bfdev_lfskiplist_enter() and bfdev_lfskiplist_leave().
+ *
+ * Returns the stored key, or NULL if not found.
+ */
+extern void *
+bfdev_lfskiplist_find(bfdev_lfskip_head_t *head,
+                      bfdev_lfskip_thread_t *thread, const void *key);
+
+/**
+ * bfdev_lfskiplist_first() - get the smallest live node.
+ * @head: the skiplist to take the node from.
+ *
+ * Must be called inside a critical section.
+ */
+extern bfdev_lfskip_node_t *
+bfdev_lfskiplist_first(bfdev_lfskip_head_t *head);
+
+/**
+ * bfdev_lfskiplist_next() - get the next live node in key order.
+ * @node: the current node.
+ *
+ * Must be called inside a critical section.
+ */
+extern bfdev_lfskip_node_t *
+bfdev_lfskiplist_next(bfdev_lfskip_node_t *node);
+
+/**
+ * bfdev_lfskiplist_create() - create a lock-free skiplist.
+ * @alloc: thread-safe allocator used for head, towers and records.
+ * @levels: maximum tower height.
+ * @cmp: total order of keys.
+ * @release: optional callback for every key leaving the skiplist.
+ * @pdata: private data of @cmp and @release.
+ */
+extern bfdev_lfskip_head_t *
+bfdev_lfskiplist_create(const bfdev_alloc_t *alloc, unsigned int levels,
+                        bfdev_cmp_t cmp, bfdev_release_t release,
+                        void *pdata);
+
+/**
+ * bfdev_lfskiplist_destroy() - destroy a lock-free skiplist.
+ * @head: the skiplist to destroy, no thread may still use it.
+ *
+ * Stored keys and keys still waiting for their grace period are
+ * handed to the release callback.
+ */
+extern void
+bfdev_lfskiplist_destroy(bfdev_lfskip_head_t *head);
+
+/**
+ * bfdev_lfskiplist_for_each - iterate over live nodes in key order.
+ * @pos: the &bfdev_lfskip_node_t to use as a loop cursor.
+ * @head: the head for your skiplist.
+ */
+#define bfdev_lfskiplist_for_each(pos, head) \
+    for (pos = bfdev_lfskiplist_first(head); pos; \
+         pos = bfdev_lfskiplist_next(pos))
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_LFSKIPLIST_H_ */
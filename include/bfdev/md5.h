@@ -38,6 +38,19 @@ bfdev_md5_finish(bfdev_md5_ctx_t *ctx, void *hash);
 extern void
 bfdev_md5_init(bfdev_md5_ctx_t *ctx);
 
+/*
+ * bfdev_md5_update_mb() - MD5 counterpart of bfdev_sha2_update_mb().
+ * bfdev_md5_finish_mb() - MD5 counterpart of bfdev_sha256_finish_mb().
+ */
+
+extern void
+bfdev_md5_update_mb(bfdev_md5_ctx_t *const *ctx, const char *const *data,
+                    const size_t *size, unsigned int nr);
+
+extern void
+bfdev_md5_finish_mb(bfdev_md5_ctx_t *const *ctx, void *const *hash,
+                    unsigned int nr);
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_MD5_H_ */
@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_MPMC_H_
+#define _BFDEV_MPMC_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/atomic.h>
+#include <bfdev/compiler.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * MPMC Queue:
+ *
+ * A bounded multi-producer multi-consumer queue after Dmitry Vyukov.
+ * Every cell carries a sequence number telling which lap of the ring
+ * may use it next, so producers and consumers only contend on their
+ * own index and a cell is handed over with one release store. Bulk
+ * operations claim a run of ready cells with a single cmpxchg.
+ *
+ * The try variants never block. The blocking variants sleep through
+ * the wait operations installed with bfdev_mpmc_set_wait(), which
+ * typically map onto futex(2) or a condition variable.
+ */
+
+typedef struct bfdev_mpmc bfdev_mpmc_t;
+typedef struct bfdev_mpmc_ops bfdev_mpmc_ops_t;
+
+/**
+ * struct bfdev_mpmc_ops - blocking operations of queue.
+ * @wait: sleep while @event still equals @value, spurious wakeups are fine.
+ * @wake: wake up every thread sleeping on @event.
+ */
+struct bfdev_mpmc_ops {
+    void (*wait)(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata);
+    void (*wake)(bfdev_atomic_t *event, void *pdata);
+};
+
+/**
+ * struct bfdev_mpmc - bounded mpmc queue.
+ * @alloc: allocator of cell array.
+ * @ops: optional blocking operations.
+ * @pdata: private data of blocking operations.
+ * @mask: number of cells minus one.
+ * @esize: size of each element.
+ * @csize: size of each cell, sequence included.
+ * @cells: the cell array.
+ * @in: next position to enqueue.
+ * @out: next position to dequeue.
+ * @readable: event bumped when a sleeping consumer may proceed.
+ * @writable: event bumped when a sleeping producer may proceed.
+ * @rwaiters: number of consumers going to sleep.
+ * @wwaiters: number of producers going to sleep.
+ */
+struct bfdev_mpmc {
+    const bfdev_alloc_t *alloc;
+    const bfdev_mpmc_ops_t *ops;
+    void *pdata;
+
+    unsigned long mask;
+    unsigned long esize;
+    unsigned long csize;
+    void *cells;
+
+    bfdev_atomic_t in __bfdev_cacheline_aligned;
+    bfdev_atomic_t out __bfdev_cacheline_aligned;
+
+    bfdev_atomic_t readable __bfdev_cacheline_aligned;
+    bfdev_atomic_t writable;
+    bfdev_atomic_t rwaiters;
+    bfdev_atomic_t wwaiters;
+};
+
+/**
+ * bfdev_mpmc_len() - approximate number of queued elements.
+ * @mpmc: the queue to be used.
+ */
+static inline unsigned long
+bfdev_mpmc_len(bfdev_mpmc_t *mpmc)
+{
+    bfdev_atomic_t in, out;
+
+    out = bfdev_atomic_read(&mpmc->out);
+    in = bfdev_atomic_read(&mpmc->in);
+
+    if (in - out < 0)
+        return 0;
+
+    return in - out;
+}
+
+/**
+ * bfdev_mpmc_size() - get the number of cells.
+ * @mpmc: the queue to be used.
+ */
+static inline unsigned long
+bfdev_mpmc_size(bfdev_mpmc_t *mpmc)
+{
+    return mpmc->mask + 1;
+}
+
+/**
+ * bfdev_mpmc_check_empty() - approximate check whether queue is empty.
+ * @mpmc: the queue to be used.
+ */
+static inline bool
+bfdev_mpmc_check_empty(bfdev_mpmc_t *mpmc)
+{
+    return !bfdev_mpmc_len(mpmc);
+}
+
+/**
+ * bfdev_mpmc_set_wait() - install blocking operations.
+ * @mpmc: the queue to be used.
+ * @ops: blocking operations, NULL disables the blocking variants.
+ * @pdata: private data of blocking operations.
+ *
+ * Must be called before the queue is shared between threads.
+ */
+static inline void
+bfdev_mpmc_set_wait(bfdev_mpmc_t *mpmc, const bfdev_mpmc_ops_t *ops,
+                    void *pdata)
+{
+    mpmc->ops = ops;
+    mpmc->pdata = pdata;
+}
+
+/**
+ * bfdev_mpmc_try_in() - enqueue elements without blocking.
+ * @mpmc: the queue to be used.
+ * @buff: elements to enqueue.
+ * @count: number of elements.
+ *
+ * Returns the number of elements enqueued, which may be less
+ * than @count when the queue fills up.
+ */
+extern unsigned long
+bfdev_mpmc_try_in(bfdev_mpmc_t *mpmc, const void *buff, unsigned long count);
+
+/**
+ * bfdev_mpmc_try_out() - dequeue elements without blocking.
+ * @mpmc: the queue to be used.
+ * @buff: where to store the elements.
+ * @count: maximum number of elements.
+ *
+ * Returns the number of elements dequeued.
+ */
+extern unsigned long
+bfdev_mpmc_try_out(bfdev_mpmc_t *mpmc, void *buff, unsigned long count);
+
+/**
+ * bfdev_mpmc_in() - enqueue elements, sleeping while full.
+ * @mpmc: the queue to be used.
+ * @buff: elements to enqueue.
+ * @count: number of elements.
+ *
+ * Returns only once all @count elements are enqueued.
+ * Returns -BFDEV_EOPNOTSUPP without blocking operations.
+ */
+extern int
+bfdev_mpmc_in(bfdev_mpmc_t *mpmc, const void *buff, unsigned long count);
+
+/**
+ * bfdev_mpmc_out() - dequeue elements, sleeping while empty.
+ * @mpmc: the queue to be used.
+ * @buff: where to store the elements.
+ * @count: maximum number of elements.
+ * @done: returns the number of elements dequeued, at least one.
+ *
+ * Returns -BFDEV_EOPNOTSUPP without blocking operations.
+ */
+extern int
+bfdev_mpmc_out(bfdev_mpmc_t *mpmc, void *buff, unsigned long count,
+               unsigned long *done);
+
+/**
+ * bfdev_mpmc_try_put() - enqueue one element without blocking.
+ * @mpmc: the queue to be used.
+ * @buff: the element to enqueue.
+ */
+static inline bool
+bfdev_mpmc_try_put(bfdev_mpmc_t *mpmc, const void *buff)
+{
+    return bfdev_mpmc_try_in(mpmc, buff, 1);
+}
+
+/**
+ * bfdev_mpmc_try_get() - dequeue one element without blocking.
+ * @mpmc: the queue to be used.
+ * @buff: where to store the element.
+ */
+static inline bool
+bfdev_mpmc_try_get(bfdev_mpmc_t *mpmc, void *buff)
+{
+    return bfdev_mpmc_try_out(mpmc, buff, 1);
+}
+
+/**
+ * bfdev_mpmc_put() - enqueue one element, sleeping while full.
+ * @mpmc: the queue to be used.
+ * @buff: the element to enqueue.
+ */
+static inline int
+bfdev_mpmc_put(bfdev_mpmc_t *mpmc, const void *buff)
+{
+    return bfdev_mpmc_in(mpmc, buff, 1);
+}
+
+/**
+ * bfdev_mpmc_get() - dequeue one element, sleeping while empty.
+ * @mpmc: the queue to be used.
+ * @buff: where to store the element.
+ */
+static inline int
+bfdev_mpmc_get(bfdev_mpmc_t *mpmc, void *buff)
+{
+    unsigned long done;
+
+    return bfdev_mpmc_out(mpmc, buff, 1, &done);
+}
+
+/**
+ * bfdev_mpmc_alloc() - allocate the cells of queue.
+ * @mpmc: the queue to initialize.
+ * @alloc: allocator of cell array.
+ * @esize: size of each element.
+ * @size: number of cells, rounded up to a power of two.
+ */
+extern int
+bfdev_mpmc_alloc(bfdev_mpmc_t *mpmc, const bfdev_alloc_t *alloc,
+                 size_t esize, size_t size);
+
+/**
+ * bfdev_mpmc_free() - release the cells of queue.
+ * @mpmc: the queue to release.
+ */
+extern void
+bfdev_mpmc_free(bfdev_mpmc_t *mpmc);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_MPMC_H_ */
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_MPSC_H_
+#define _BFDEV_MPSC_H_
+
+#include <bfdev/config.h>
+#include <bfdev/errno.h>
+#include <bfdev/slist.h>
+#include <bfdev/llist.h>
+#include <bfdev/atomic.h>
+#include <bfdev/compiler.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * MPSC Work Queue:
+ *
+ * An unbounded intrusive queue for many producers and one consumer.
+ * Producers push onto a lock-less list with one cmpxchg. The consumer
+ * never pops single entries from the shared list, it takes the whole
+ * list with one exchange and reverses it into a private batch, which
+ * restores FIFO order and leaves no room for ABA.
+ *
+ * An idle consumer may sleep through the wait operations installed
+ * with bfdev_mpsc_init(), only the push that turns the queue
+ * non-empty pays for the wakeup.
+ */
+
+typedef struct bfdev_mpsc bfdev_mpsc_t;
+typedef struct bfdev_mpsc_ops bfdev_mpsc_ops_t;
+
+/**
+ * struct bfdev_mpsc_ops - blocking operations of queue.
+ * @wait: sleep while @event still equals @value, spurious wakeups are fine.
+ * @wake: wake up the thread sleeping on @event.
+ */
+struct bfdev_mpsc_ops {
+    void (*wait)(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata);
+    void (*wake)(bfdev_atomic_t *event, void *pdata);
+};
+
+/**
+ * struct bfdev_mpsc - mpsc work queue.
+ * @head: lock-less list producers push onto, newest first.
+ * @batch: entries taken by the consumer, oldest first.
+ * @ops: optional blocking operations.
+ * @pdata: private data of blocking operations.
+ * @event: event bumped when the sleeping consumer may proceed.
+ * @sleeping: set while the consumer is going to sleep.
+ */
+struct bfdev_mpsc {
+    bfdev_slist_head_t head __bfdev_cacheline_aligned;
+
+    bfdev_slist_head_t *batch __bfdev_cacheline_aligned;
+    const bfdev_mpsc_ops_t *ops;
+    void *pdata;
+
+    bfdev_atomic_t event __bfdev_cacheline_aligned;
+    bfdev_atomic_t sleeping;
+};
+
+#define BFDEV_MPSC_STATIC(OPS, PDATA) { \
+    .head = {NULL}, .batch = NULL, \
+    .ops = (OPS), .pdata = (PDATA), \
+    .event = 0, .sleeping = 0, \
+}
+
+#define BFDEV_MPSC_INIT(ops, pdata) \
+    (bfdev_mpsc_t) BFDEV_MPSC_STATIC(ops, pdata)
+
+#define BFDEV_DEFINE_MPSC(name, ops, pdata) \
+    bfdev_mpsc_t name = BFDEV_MPSC_INIT(ops, pdata)
+
+/**
+ * bfdev_mpsc_init() - initialize a mpsc work queue.
+ * @mpsc: the queue to initialize.
+ * @ops: blocking operations, NULL disables bfdev_mpsc_wait().
+ * @pdata: private data of blocking operations.
+ */
+static inline void
+bfdev_mpsc_init(bfdev_mpsc_t *mpsc, const bfdev_mpsc_ops_t *ops,
+                void *pdata)
+{
+    *mpsc = BFDEV_MPSC_INIT(ops, pdata);
+}
+
+/**
+ * bfdev_mpsc_check_empty() - check whether queue is empty.
+ * @mpsc: the queue to check.
+ *
+ * Must only be called by the consumer.
+ */
+static inline bool
+bfdev_mpsc_check_empty(bfdev_mpsc_t *mpsc)
+{
+    return !mpsc->batch && !BFDEV_READ_ONCE(mpsc->head.next);
+}
+
+/**
+ * bfdev_mpsc_push_batch() - push a chain of entries.
+ * @mpsc: the queue to push onto.
+ * @node: first entry of chain, dequeued last.
+ * @end: last entry of chain, dequeued first.
+ *
+ * The chain must be linked from @node to @end, which keeps entries
+ * of the chain in reverse order, like bfdev_llist_split().
+ * Returns whether the queue was empty before pushing.
+ */
+extern bool
+bfdev_mpsc_push_batch(bfdev_mpsc_t *mpsc, bfdev_slist_head_t *node,
+                      bfdev_slist_head_t *end);
+
+/**
+ * bfdev_mpsc_push() - push an entry.
+ * @mpsc: the queue to push onto.
+ * @node: the entry to push.
+ *
+ * Returns whether the queue was empty before pushing.
+ */
+static inline bool
+bfdev_mpsc_push(bfdev_mpsc_t *mpsc, bfdev_slist_head_t *node)
+{
+    return bfdev_mpsc_push_batch(mpsc, node, node);
+}
+
+/**
+ * bfdev_mpsc_pop() - pop the oldest entry.
+ * @mpsc: the queue to pop from.
+ *
+ * Must only be called by the consumer.
+ * Returns NULL if the queue is empty.
+ */
+extern bfdev_slist_head_t *
+bfdev_mpsc_pop(bfdev_mpsc_t *mpsc);
+
+/**
+ * bfdev_mpsc_pop_all() - pop every queued entry.
+ * @mpsc: the queue to pop from.
+ *
+ * Returns a NULL terminated chain in FIFO order. Must only be
+ * called by the consumer.
+ */
+extern bfdev_slist_head_t *
+bfdev_mpsc_pop_all(bfdev_mpsc_t *mpsc);
+
+/**
+ * bfdev_mpsc_wait() - sleep until the queue is not empty.
+ * @mpsc: the queue to wait for.
+ *
+ * Must only be called by the consumer.
+ * Returns -BFDEV_EOPNOTSUPP without blocking operations.
+ */
+extern int
+bfdev_mpsc_wait(bfdev_mpsc_t *mpsc);
+
+/**
+ * bfdev_mpsc_for_each_chain - iterate over a chain from bfdev_mpsc_pop_all().
+ * @pos: the &bfdev_slist_head_t to use as a loop cursor.
+ * @tmp: another &bfdev_slist_head_t to use as temporary storage.
+ * @chain: the chain to iterate.
+ *
+ * The current entry may be released inside the loop.
+ */
+#define bfdev_mpsc_for_each_chain(pos, tmp, chain) \
+    for ((pos) = (chain); (pos) && ({(tmp) = (pos)->next; 1;}); (pos) = (tmp))
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_MPSC_H_ */
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_NOTIFIER_RCU_H_
+#define _BFDEV_NOTIFIER_RCU_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/atomic.h>
+#include <bfdev/percpu.h>
+#include <bfdev/notifier.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Read-mostly Notifier Chain:
+ *
+ * A notifier chain for events dispatched far more often than nodes
+ * come and go. Every (un)registration publishes an immutable array of
+ * callbacks sorted by priority through one pointer exchange, callers
+ * walk that array without taking any lock and without writing to
+ * shared cache lines, only their own per-cpu reader slot.
+ *
+ * Replaced arrays are reclaimed after a grace period in the style of
+ * SRCU: readers count themselves in one of two per-cpu counters, an
+ * array is freed once both counters have drained since it was
+ * replaced. (Un)registration must be serialized by the caller.
+ */
+
+typedef struct bfdev_notifier_rcu bfdev_notifier_rcu_t;
+typedef struct bfdev_notifier_snap bfdev_notifier_snap_t;
+typedef struct bfdev_notifier_call bfdev_notifier_call_t;
+
+struct bfdev_notifier_call {
+    bfdev_notifier_entry_t entry;
+    void *pdata;
+};
+
+/**
+ * struct bfdev_notifier_snap - published array of callbacks.
+ * @retire: link in the retired list once replaced.
+ * @phase: reader phase at the time of replacement.
+ * @count: number of callbacks.
+ * @calls: callbacks in priority order.
+ */
+struct bfdev_notifier_snap {
+    bfdev_notifier_snap_t *retire;
+    unsigned long phase;
+    unsigned int count;
+    bfdev_notifier_call_t calls[];
+};
+
+/**
+ * struct bfdev_notifier_rcu - read-mostly notification chain header.
+ * @snap: currently published array.
+ * @phase: selects the reader counter new readers use.
+ * @readers: per-cpu reader counters of both phases.
+ * @alloc: allocator of arrays.
+ * @chain: sorted node list, only touched by writers.
+ * @retired: replaced arrays waiting for a grace period.
+ */
+struct bfdev_notifier_rcu {
+    bfdev_atomic_t snap;
+    bfdev_atomic_t phase;
+    bfdev_percpu_counter_t readers[2];
+
+    const bfdev_alloc_t *alloc;
+    bfdev_notifier_t chain;
+    bfdev_notifier_snap_t *retired;
+};
+
+/**
+ * bfdev_notifier_rcu_call() - call every callback on the chain.
+ * @head: chain header to be notified.
+ * @cpu: index of calling cpu or thread.
+ * @args: parameters to be passed to the callbacks.
+ * @call_num: number of callbacks to be notified.
+ * @called_num: number of callbacks actually notified.
+ *
+ * Safe against concurrent (un)registration. Callbacks cannot remove
+ * themselves, BFDEV_NOTIFI_RET_REMOVE is ignored.
+ */
+extern bfdev_notifier_ret_t
+bfdev_notifier_rcu_call(bfdev_notifier_rcu_t *head, unsigned int cpu,
+                        void *args, unsigned int call_num,
+                        unsigned int *called_num);
+
+/**
+ * bfdev_notifier_rcu_register() - register a node to the chain.
+ * @head: header to be registered.
+ * @node: notification chain node to register.
+ */
+extern int
+bfdev_notifier_rcu_register(bfdev_notifier_rcu_t *head,
+                            bfdev_notifier_node_t *node);
+
+/**
+ * bfdev_notifier_rcu_unregister() - unregister a node from the chain.
+ * @head: header to be unregistered.
+ * @node: notification chain node to unregister.
+ *
+ * The node itself may be reused at once, but callers already walking
+ * the chain may still invoke its callback with its private data until
+ * bfdev_notifier_rcu_reclaim() reports that no array is pending.
+ */
+extern int
+bfdev_notifier_rcu_unregister(bfdev_notifier_rcu_t *head,
+                              bfdev_notifier_node_t *node);
+
+/**
+ * bfdev_notifier_rcu_reclaim() - free arrays nobody can see anymore.
+ * @head: chain header to reclaim.
+ *
+ * Never blocks, (un)registration calls it on its own. Returns true
+ * once every replaced array has been freed.
+ */
+extern bool
+bfdev_notifier_rcu_reclaim(bfdev_notifier_rcu_t *head);
+
+/**
+ * bfdev_notifier_rcu_alloc() - initialize a read-mostly notifier chain.
+ * @head: chain header to initialize.
+ * @alloc: allocator of arrays and reader counters.
+ * @nr: number of reader slots, see bfdev_percpu_counter_alloc().
+ */
+extern int
+bfdev_notifier_rcu_alloc(bfdev_notifier_rcu_t *head,
+                         const bfdev_alloc_t *alloc, unsigned int nr);
+
+/**
+ * bfdev_notifier_rcu_free() - release a read-mostly notifier chain.
+ * @head: chain header to release, with no callers left.
+ */
+extern void
+bfdev_notifier_rcu_free(bfdev_notifier_rcu_t *head);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_NOTIFIER_RCU_H_ */
@@ -94,6 +94,6 @@ bfdev_notifier_register(bfdev_notifier_t *head, bfdev_notifier_node_t *node);
 extern void
 bfdev_notifier_unregister(bfdev_notifier_t *head, bfdev_notifier_node_t *node);
 
-BFDEV_BEGIN_DECLS
+BFDEV_END_DECLS
 
 #endif /* _BFDEV_NOTIFIER_H_ */
@@ -0,0 +1,275 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_PERCPU_H_
+#define _BFDEV_PERCPU_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/limits.h>
+#include <bfdev/atomic.h>
+#include <bfdev/cmpxchg.h>
+#include <bfdev/compiler.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Per-CPU Counters:
+ *
+ * A counter split into cache line sized slots, every cpu or thread
+ * updates its own slot and readers add all slots together. Updates
+ * never bounce a shared cache line, reads become proportionally
+ * more expensive, which suits statistics that are bumped on every
+ * operation and read rarely.
+ *
+ * The library knows nothing about cpus or threads, callers pass a
+ * stable index of their own, such as sched_getcpu() or a thread
+ * number, which is folded onto the slots. Threads sharing a slot
+ * stay correct, they only lose the scalability.
+ *
+ * The per-cpu refcount is built on the same slots, in the spirit of
+ * percpu_ref of Linux. Gets and puts go to the slots until the owner
+ * kills the reference, which moves the sum of slots into a single
+ * atomic counter, from then on the last put is detected as usual.
+ */
+
+#define BFDEV_PERCPU_REFCNT_BIAS (BFDEV_INTPTR_MAX >> 1)
+#define BFDEV_PERCPU_REFCNT_DEAD (BFDEV_INTPTR_MIN >> 1)
+
+typedef struct bfdev_percpu_slot bfdev_percpu_slot_t;
+typedef struct bfdev_percpu_counter bfdev_percpu_counter_t;
+typedef struct bfdev_percpu_refcnt bfdev_percpu_refcnt_t;
+
+struct bfdev_percpu_slot {
+    bfdev_atomic_t value;
+} __bfdev_cacheline_aligned;
+
+/**
+ * struct bfdev_percpu_counter - sharded counter.
+ * @alloc: allocator of slots.
+ * @block: allocated memory, @slots aligned inside.
+ * @slots: cache line aligned slots.
+ * @mask: number of slots minus one.
+ */
+struct bfdev_percpu_counter {
+    const bfdev_alloc_t *alloc;
+    void *block;
+    bfdev_percpu_slot_t *slots;
+    unsigned long mask;
+};
+
+/**
+ * struct bfdev_percpu_refcnt - per-cpu reference counter.
+ * @counter: slots used before the reference is killed.
+ * @count: atomic counter, biased until the reference is killed.
+ */
+struct bfdev_percpu_refcnt {
+    bfdev_percpu_counter_t counter;
+    bfdev_atomic_t count __bfdev_cacheline_aligned;
+};
+
+static __bfdev_always_inline bfdev_percpu_slot_t *
+bfdev_percpu_slot(bfdev_percpu_counter_t *counter, unsigned int cpu)
+{
+    return &counter->slots[cpu & counter->mask];
+}
+
+/**
+ * bfdev_percpu_counter_add() - add a value to counter.
+ * @counter: the counter to update.
+ * @cpu: index of calling cpu or thread.
+ * @value: the value to add.
+ */
+static inline void
+bfdev_percpu_counter_add(bfdev_percpu_counter_t *counter, unsigned int cpu,
+                         bfdev_atomic_t value)
+{
+    bfdev_atomic_add(&bfdev_percpu_slot(counter, cpu)->value, value);
+}
+
+static inline void
+bfdev_percpu_counter_sub(bfdev_percpu_counter_t *counter, unsigned int cpu,
+                         bfdev_atomic_t value)
+{
+    bfdev_atomic_sub(&bfdev_percpu_slot(counter, cpu)->value, value);
+}
+
+static inline void
+bfdev_percpu_counter_inc(bfdev_percpu_counter_t *counter, unsigned int cpu)
+{
+    bfdev_percpu_counter_add(counter, cpu, 1);
+}
+
+static inline void
+bfdev_percpu_counter_dec(bfdev_percpu_counter_t *counter, unsigned int cpu)
+{
+    bfdev_percpu_counter_sub(counter, cpu, 1);
+}
+
+/**
+ * bfdev_percpu_counter_sum() - read the sum of all slots.
+ * @counter: the counter to read.
+ *
+ * Updates running concurrently may or may not be included.
+ */
+extern bfdev_atomic_t
+bfdev_percpu_counter_sum(bfdev_percpu_counter_t *counter);
+
+/**
+ * bfdev_percpu_counter_reset() - read the sum and clear all slots.
+ * @counter: the counter to reset.
+ *
+ * Every update is either returned or left in the counter.
+ */
+extern bfdev_atomic_t
+bfdev_percpu_counter_reset(bfdev_percpu_counter_t *counter);
+
+/**
+ * bfdev_percpu_counter_alloc() - allocate slots of counter.
+ * @counter: the counter to initialize.
+ * @alloc: allocator of slots.
+ * @nr: number of slots, rounded up to a power of two.
+ */
+extern int
+bfdev_percpu_counter_alloc(bfdev_percpu_counter_t *counter,
+                           const bfdev_alloc_t *alloc, unsigned int nr);
+
+extern void
+bfdev_percpu_counter_free(bfdev_percpu_counter_t *counter);
+
+static __bfdev_always_inline bool
+bfdev_percpu_refcnt_dead(bfdev_atomic_t value)
+{
+    /* killed slots stay far below zero, whatever lands on them */
+    return bfdev_unlikely(value < (BFDEV_PERCPU_REFCNT_DEAD >> 1));
+}
+
+/**
+ * bfdev_percpu_refcnt_get() - acquire a reference.
+ * @ref: the reference counter.
+ * @cpu: index of calling cpu or thread.
+ *
+ * After the reference is killed the caller must already hold one.
+ */
+static inline void
+bfdev_percpu_refcnt_get(bfdev_percpu_refcnt_t *ref, unsigned int cpu)
+{
+    bfdev_percpu_slot_t *slot;
+
+    slot = bfdev_percpu_slot(&ref->counter, cpu);
+    if (bfdev_percpu_refcnt_dead(bfdev_atomic_fetch_add(&slot->value, 1)))
+        bfdev_atomic_add(&ref->count, 1);
+}
+
+/**
+ * bfdev_percpu_refcnt_tryget_live() - acquire a reference unless killed.
+ * @ref: the reference counter.
+ * @cpu: index of calling cpu or thread.
+ *
+ * Returns false once the slot of @cpu has been killed.
+ */
+static inline bool
+bfdev_percpu_refcnt_tryget_live(bfdev_percpu_refcnt_t *ref, unsigned int cpu)
+{
+    bfdev_percpu_slot_t *slot;
+
+    slot = bfdev_percpu_slot(&ref->counter, cpu);
+    return !bfdev_percpu_refcnt_dead(bfdev_atomic_fetch_add(&slot->value, 1));
+}
+
+/**
+ * bfdev_percpu_refcnt_tryget() - acquire a reference unless released.
+ * @ref: the reference counter.
+ * @cpu: index of calling cpu or thread.
+ *
+ * Returns false once the last reference has been dropped.
+ */
+static inline bool
+bfdev_percpu_refcnt_tryget(bfdev_percpu_refcnt_t *ref, unsigned int cpu)
+{
+    bfdev_atomic_t prev;
+
+    if (bfdev_percpu_refcnt_tryget_live(ref, cpu))
+        return true;
+
+    prev = bfdev_atomic_read(&ref->count);
+    do {
+        if (!prev)
+            return false;
+    } while (!bfdev_try_cmpxchg(&ref->count, &prev, prev + 1));
+
+    return true;
+}
+
+/**
+ * bfdev_percpu_refcnt_put() - drop a reference.
+ * @ref: the reference counter.
+ * @cpu: index of calling cpu or thread.
+ *
+ * Returns true if this was the last reference.
+ */
+static inline bool
+bfdev_percpu_refcnt_put(bfdev_percpu_refcnt_t *ref, unsigned int cpu)
+{
+    bfdev_percpu_slot_t *slot;
+
+    slot = bfdev_percpu_slot(&ref->counter, cpu);
+    if (!bfdev_percpu_refcnt_dead(bfdev_atomic_fetch_sub(&slot->value, 1)))
+        return false;
+
+    return bfdev_atomic_fetch_sub(&ref->count, 1) == 1;
+}
+
+/**
+ * bfdev_percpu_refcnt_kill() - drop the initial reference.
+ * @ref: the reference counter.
+ *
+ * Switches the counter into atomic mode and drops the reference it
+ * was created with. Must be called exactly once.
+ * Returns true if this was the last reference.
+ */
+extern bool
+bfdev_percpu_refcnt_kill(bfdev_percpu_refcnt_t *ref);
+
+/**
+ * bfdev_percpu_refcnt_check_dead() - check whether reference is killed.
+ * @ref: the reference counter.
+ */
+static inline bool
+bfdev_percpu_refcnt_check_dead(bfdev_percpu_refcnt_t *ref)
+{
+    return bfdev_percpu_refcnt_dead(
+        bfdev_atomic_read(&ref->counter.slots[0].value));
+}
+
+/**
+ * bfdev_percpu_refcnt_reinit() - bring a released counter back.
+ * @ref: the reference counter, with no references left.
+ *
+ * Restores per-cpu mode with the initial reference held.
+ */
+extern void
+bfdev_percpu_refcnt_reinit(bfdev_percpu_refcnt_t *ref);
+
+/**
+ * bfdev_percpu_refcnt_alloc() - allocate a per-cpu reference counter.
+ * @ref: the reference counter to initialize.
+ * @alloc: allocator of slots.
+ * @nr: number of slots, rounded up to a power of two.
+ *
+ * The counter starts in per-cpu mode holding the initial reference.
+ */
+extern int
+bfdev_percpu_refcnt_alloc(bfdev_percpu_refcnt_t *ref,
+                          const bfdev_alloc_t *alloc, unsigned int nr);
+
+extern void
+bfdev_percpu_refcnt_free(bfdev_percpu_refcnt_t *ref);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_PERCPU_H_ */
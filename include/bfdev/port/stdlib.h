@@ -61,6 +61,15 @@ bfport_free(void *ptr)
 }
 #endif
 
+#ifndef bfport_getenv
+# define bfport_getenv bfport_getenv
+static __bfdev_always_inline char *
+bfport_getenv(const char *name)
+{
+    return getenv(name);
+}
+#endif
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_PORT_STDLIB_H_ */
@@ -9,10 +9,12 @@
 #include <bfdev/config.h>
 #include <bfdev/types.h>
 #include <bfdev/stddef.h>
+#include <bfdev/atomic.h>
 
 BFDEV_BEGIN_DECLS
 
 typedef struct bfdev_ratelimit bfdev_ratelimit_t;
+typedef struct bfdev_ratelimit_atomic bfdev_ratelimit_atomic_t;
 
 /**
  * struct bfdev_ratelimit - describe ratelimit status.
@@ -68,6 +70,67 @@ bfdev_ratelimit_reset(bfdev_ratelimit_t *limit)
 extern bool
 bfdev_ratelimit(bfdev_ratelimit_t *limit, bfdev_time_t current);
 
+/**
+ * struct bfdev_ratelimit_atomic - ratelimit safe for concurrent callers.
+ * @interval: manage time granularity of the maximum number of transfers.
+ * @burst: maximum number of transfers allowed in @interval period.
+ * @state: current period in units of @interval above the passed count.
+ *
+ * Periods are aligned to multiples of @interval instead of starting
+ * with the first transfer, so that a single cmpxchg on @state can
+ * both open a new period and count the transfer.
+ */
+struct bfdev_ratelimit_atomic {
+    bfdev_time_t interval;
+    unsigned int burst;
+    bfdev_atomic_t state;
+};
+
+#define BFDEV_RATELIMIT_ATOMIC_STATIC(INTERVAL, BURST) { \
+    .interval = (INTERVAL), .burst = (BURST), .state = 0, \
+}
+
+#define BFDEV_RATELIMIT_ATOMIC_INIT(interval, burst) \
+    (bfdev_ratelimit_atomic_t) BFDEV_RATELIMIT_ATOMIC_STATIC(interval, burst)
+
+#define BFDEV_DEFINE_RATELIMIT_ATOMIC(name, interval, burst) \
+    bfdev_ratelimit_atomic_t name = BFDEV_RATELIMIT_ATOMIC_INIT(interval, burst)
+
+static inline void
+bfdev_ratelimit_atomic_init(bfdev_ratelimit_atomic_t *limit,
+                            bfdev_time_t interval, unsigned int burst)
+{
+    *limit = BFDEV_RATELIMIT_ATOMIC_INIT(interval, burst);
+}
+
+static inline void
+bfdev_ratelimit_atomic_reset(bfdev_ratelimit_atomic_t *limit)
+{
+    bfdev_atomic_write(&limit->state, 0);
+}
+
+/**
+ * bfdev_ratelimit_acquire() - count transfers against a shared limit.
+ * @limit: ratelimit state data.
+ * @current: current time.
+ * @count: number of transfers to pass at once.
+ *
+ * Either all @count transfers pass or none.
+ *
+ * RETURNS:
+ * 0 means function will be suppressed.
+ * 1 means go ahead and do it.
+ */
+extern bool
+bfdev_ratelimit_acquire(bfdev_ratelimit_atomic_t *limit,
+                        bfdev_time_t current, unsigned int count);
+
+static inline bool
+bfdev_ratelimit_atomic(bfdev_ratelimit_atomic_t *limit, bfdev_time_t current)
+{
+    return bfdev_ratelimit_acquire(limit, current, 1);
+}
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_RATELIMIT_H_ */
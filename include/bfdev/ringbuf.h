@@ -14,6 +14,7 @@
 BFDEV_BEGIN_DECLS
 
 typedef struct bfdev_ringbuf bfdev_ringbuf_t;
+typedef struct bfdev_ringbuf_span bfdev_ringbuf_span_t;
 
 struct bfdev_ringbuf {
     const bfdev_alloc_t *alloc;
@@ -22,6 +23,17 @@ struct bfdev_ringbuf {
     unsigned long mask;
     unsigned long esize;
     void *data;
+    bool mirror;
+};
+
+/**
+ * struct bfdev_ringbuf_span - contiguous region inside the ringbuf buffer.
+ * @data: start of the region.
+ * @len: number of objects in the region.
+ */
+struct bfdev_ringbuf_span {
+    void *data;
+    unsigned long len;
 };
 
 /**
@@ -284,6 +296,31 @@ struct bfdev_ringbuf {
     -BFDEV_EINVAL;                                      \
 })
 
+/**
+ * bfdev_ringbuf_alloc_mirror() - allocate a double-mapped buffer to ringbuf.
+ * @ptr: the ringbuf to allocate buffer.
+ * @size: size of buffer, rounded up to whole pages.
+ *
+ * The buffer is mapped twice back to back, so every readable or
+ * writable region is virtually contiguous and spans or records
+ * never wrap. Released by bfdev_ringbuf_free() as usual.
+ */
+#define bfdev_ringbuf_alloc_mirror(ptr, size) ({        \
+    typeof((ptr) + 1) __tmp = (ptr);                    \
+    bfdev_ringbuf_check_dynamic(__tmp) ?                \
+    bfdev_ringbuf_mirror_alloc(&__tmp->ringbuf,         \
+    sizeof(*__tmp->data), size) :                       \
+    -BFDEV_EINVAL;                                      \
+})
+
+/**
+ * bfdev_ringbuf_check_mirror() - check whether ringbuf is double-mapped.
+ * @ptr: the ringbuf to check.
+ */
+#define bfdev_ringbuf_check_mirror(ptr) (               \
+    (ptr)->ringbuf.mirror                               \
+)
+
 /**
  * bfdev_ringbuf_free() - dynamically free buffer to ringbuf.
  * @ptr: the ringbuf to free buffer.
@@ -429,6 +466,71 @@ struct bfdev_ringbuf {
     bfdev_ringbuf_in_flat(__ringbuf, __tbuff, __tlen);                  \
 })
 
+/**
+ * bfdev_ringbuf_reserve() - get writable regions without copying.
+ * @pringbuf: the ringbuf to write into.
+ * @spans: two spans, the second one covers the wraparound.
+ * @len: number of objects wanted.
+ *
+ * Returns the number of objects that may be written in place,
+ * they become visible after bfdev_ringbuf_commit(). Like the
+ * copying variants, the commit overwrites the oldest objects
+ * when the ringbuf runs full. Record ringbufs are not supported.
+ */
+#define bfdev_ringbuf_reserve(pringbuf, spans, len) ({                  \
+    typeof((pringbuf) + 1) __tmp = (pringbuf);                          \
+    bfdev_ringbuf_reserve_flat(&__tmp->ringbuf, (spans), (len));        \
+})
+
+/**
+ * bfdev_ringbuf_commit() - publish objects written in reserved regions.
+ * @pringbuf: the ringbuf written into.
+ * @len: number of objects, no more than reserved.
+ */
+#define bfdev_ringbuf_commit(pringbuf, len) ({                          \
+    typeof((pringbuf) + 1) __tmp = (pringbuf);                          \
+    bfdev_ringbuf_commit_flat(&__tmp->ringbuf, (len));                  \
+})
+
+/**
+ * bfdev_ringbuf_peek_spans() - get readable regions without copying.
+ * @pringbuf: the ringbuf to read from.
+ * @spans: two spans, the second one covers the wraparound.
+ * @len: number of objects wanted.
+ *
+ * Returns the number of objects that may be read in place,
+ * they stay in the ringbuf until bfdev_ringbuf_consume(). For
+ * record ringbufs the spans cover the payload of the next record,
+ * which is a single span on a double-mapped ringbuf.
+ */
+#define bfdev_ringbuf_peek_spans(pringbuf, spans, len) ({               \
+    typeof((pringbuf) + 1) __tmp = (pringbuf);                          \
+    bfdev_ringbuf_t *__ringbuf = &__tmp->ringbuf;                       \
+    unsigned long __tlen = (len);                                       \
+    unsigned long __recsize = sizeof(*__tmp->rectype);                  \
+    (__recsize) ?                                                       \
+    bfdev_ringbuf_peek_spans_record(__ringbuf, spans, __tlen,           \
+                                    __recsize) :                        \
+    bfdev_ringbuf_peek_spans_flat(__ringbuf, spans, __tlen);            \
+})
+
+/**
+ * bfdev_ringbuf_consume() - release objects read in place.
+ * @pringbuf: the ringbuf read from.
+ * @len: number of objects, no more than peeked.
+ *
+ * Record ringbufs release the whole next record and ignore @len.
+ */
+#define bfdev_ringbuf_consume(pringbuf, len) ({                         \
+    typeof((pringbuf) + 1) __tmp = (pringbuf);                          \
+    bfdev_ringbuf_t *__ringbuf = &__tmp->ringbuf;                       \
+    unsigned long __tlen = (len);                                       \
+    unsigned long __recsize = sizeof(*__tmp->rectype);                  \
+    (__recsize) ?                                                       \
+    bfdev_ringbuf_consume_record(__ringbuf, __recsize) :                \
+    bfdev_ringbuf_consume_flat(__ringbuf, __tlen);                      \
+})
+
 extern unsigned long
 bfdev_ringbuf_peek_flat(bfdev_ringbuf_t *ringbuf, void *buff, unsigned long len);
 
@@ -450,10 +552,35 @@ extern unsigned long
 bfdev_ringbuf_in_record(bfdev_ringbuf_t *ringbuf, const void *buff, unsigned long len,
                         unsigned long record);
 
+extern unsigned long
+bfdev_ringbuf_reserve_flat(bfdev_ringbuf_t *ringbuf,
+                           bfdev_ringbuf_span_t *spans, unsigned long len);
+
+extern void
+bfdev_ringbuf_commit_flat(bfdev_ringbuf_t *ringbuf, unsigned long len);
+
+extern unsigned long
+bfdev_ringbuf_peek_spans_flat(bfdev_ringbuf_t *ringbuf,
+                              bfdev_ringbuf_span_t *spans, unsigned long len);
+
+extern void
+bfdev_ringbuf_consume_flat(bfdev_ringbuf_t *ringbuf, unsigned long len);
+
+extern unsigned long
+bfdev_ringbuf_peek_spans_record(bfdev_ringbuf_t *ringbuf,
+                                bfdev_ringbuf_span_t *spans, unsigned long len,
+                                unsigned long record);
+
+extern void
+bfdev_ringbuf_consume_record(bfdev_ringbuf_t *ringbuf, unsigned long record);
+
 extern int
 bfdev_ringbuf_dynamic_alloc(bfdev_ringbuf_t *ringbuf, const bfdev_alloc_t *alloc,
                             size_t esize, size_t size);
 
+extern int
+bfdev_ringbuf_mirror_alloc(bfdev_ringbuf_t *ringbuf, size_t esize, size_t size);
+
 extern void
 bfdev_ringbuf_dynamic_free(bfdev_ringbuf_t *ringbuf);
 
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_SBLOOM_H_
+#define _BFDEV_SBLOOM_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/errno.h>
+#include <bfdev/list.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+typedef struct bfdev_sbloom bfdev_sbloom_t;
+typedef struct bfdev_sbloom_stage bfdev_sbloom_stage_t;
+
+typedef uint64_t (*bfdev_sbloom_hash_t)
+(const void *key, void *pdata);
+
+/**
+ * struct bfdev_sbloom_stage - one bloom filter of the chain.
+ * @list: linked into bfdev_sbloom.stages, newest first.
+ * @capacity: number of keys this stage is sized for.
+ * @count: number of keys pushed into this stage.
+ * @bits: size of @bitmap in bits.
+ * @funcs: number of bits set per key.
+ * @salt: mixed into the hash, so stages are independent.
+ * @bitmap: the bits.
+ */
+struct bfdev_sbloom_stage {
+    bfdev_list_head_t list;
+    unsigned long capacity;
+    unsigned long count;
+    unsigned long bits;
+    unsigned int funcs;
+    unsigned int salt;
+    unsigned long bitmap[];
+};
+
+/**
+ * struct bfdev_sbloom - scalable bloom filter.
+ * @alloc: allocator of the filter.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ * @stages: chain of filters, only the newest one takes keys.
+ * @capacity: number of keys of the first stage.
+ * @error: the first stage has a false positive rate of 2^-(@error + 1).
+ * @count: number of keys pushed.
+ *
+ * A full stage is followed by one of twice the capacity and half the
+ * false positive rate, so the sum over all stages stays near
+ * 2^-@error however large the set grows.
+ */
+struct bfdev_sbloom {
+    const bfdev_alloc_t *alloc;
+    bfdev_sbloom_hash_t hash;
+    void *pdata;
+
+    bfdev_list_head_t stages;
+    unsigned long capacity;
+    unsigned int error;
+    unsigned long count;
+};
+
+/**
+ * bfdev_sbloom_peek() - peek an object from a scalable bloom filter.
+ * @bloom: filter pointer.
+ * @key: object pointer.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_sbloom_peek(const bfdev_sbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_sbloom_push() - push an object into a scalable bloom filter.
+ * @bloom: filter pointer.
+ * @key: object pointer to push.
+ *
+ * Keys that may already be present are not counted again.
+ *
+ * @return: -BFDEV_ENOMEM if a new stage could not be allocated.
+ */
+extern int
+bfdev_sbloom_push(bfdev_sbloom_t *bloom, const void *key);
+
+/**
+ * bfdev_sbloom_flush() - drop every key and all but the first stage.
+ * @bloom: filter pointer.
+ */
+extern void
+bfdev_sbloom_flush(bfdev_sbloom_t *bloom);
+
+/**
+ * bfdev_sbloom_create() - create a scalable bloom filter.
+ * @alloc: allocator of the filter.
+ * @capacity: number of keys of the first stage.
+ * @error: bound of the false positive rate as 2^-@error.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ */
+extern bfdev_sbloom_t *
+bfdev_sbloom_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                    unsigned int error, bfdev_sbloom_hash_t hash, void *pdata);
+
+/**
+ * bfdev_sbloom_destroy() - destroy a scalable bloom filter.
+ * @bloom: filter pointer.
+ */
+extern void
+bfdev_sbloom_destroy(bfdev_sbloom_t *bloom);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_SBLOOM_H_ */
@@ -13,6 +13,9 @@ BFDEV_BEGIN_DECLS
 
 typedef struct bfdev_segtree_node bfdev_segtree_node_t;
 
+typedef int (*bfdev_segtree_stab_t)
+(bfdev_segtree_node_t *node, size_t index, void *pdata);
+
 struct bfdev_segtree_node {
     bfdev_rb_node_t node;
     unsigned long start, end;
@@ -55,6 +58,35 @@ extern bfdev_segtree_node_t *
 bfdev_segtree_next(bfdev_segtree_node_t *node,
                    unsigned long start, unsigned long end);
 
+/**
+ * bfdev_segtree_stab() - report every segment containing any of the points.
+ * @root: the segtree to query.
+ * @points: points to query, sorted in ascending order.
+ * @count: number of points.
+ * @func: called once for each pair of segment and index of point it contains.
+ * @pdata: private data of @func.
+ *
+ * The whole batch is answered in a single walk of the tree, subtrees
+ * are only entered for the points that may still hit them. Returns
+ * the first non-zero value of @func, which also stops the walk.
+ */
+extern int
+bfdev_segtree_stab(bfdev_rb_root_cached_t *root, const unsigned long *points,
+                   size_t count, bfdev_segtree_stab_t func, void *pdata);
+
+/**
+ * bfdev_segtree_build() - build a segtree from sorted segments.
+ * @root: the segtree to build, must be empty.
+ * @nodes: segments sorted by start in ascending order.
+ * @count: number of segments.
+ *
+ * Links a balanced tree in O(n) instead of @count rebalancing inserts,
+ * the result can be modified with the regular insert and delete.
+ */
+extern void
+bfdev_segtree_build(bfdev_rb_root_cached_t *root,
+                    bfdev_segtree_node_t **nodes, size_t count);
+
 /**
  * bfdev_segtree_first_entry - get the first element from a segtree.
  * @ptr: the rbtree root to take the element from.
@@ -173,11 +205,11 @@ STNAME##_insert(bfdev_rb_root_cached_t *cached, STSTRUCT *node)             \
         }                                                                   \
     }                                                                       \
                                                                             \
+    node->STSUBTREE = end;                                                  \
     bfdev_rb_cached_insert_node_augmented(                                  \
         cached, parent ? &parent->STRB : NULL,                              \
         link, &node->STRB, leftmost, &STNAME##_callbacks                    \
     );                                                                      \
-    node->STSUBTREE = end;                                                  \
 }                                                                           \
                                                                             \
 STSTATIC void                                                               \
@@ -259,6 +291,138 @@ STNAME##_next(STSTRUCT *node, STTYPE start, STTYPE end)                     \
         else if (start <= STEND(node))                                      \
             return node;                                                    \
     }                                                                       \
+}                                                                           \
+                                                                            \
+/* gallop from the low end, answers stay close to it on a tree walk */   \
+static size_t                                                               \
+STNAME##_bound(const STTYPE *points, size_t low, size_t high,               \
+               STTYPE value, bool upper)                                    \
+{                                                                           \
+    size_t step, mid;                                                       \
+                                                                            \
+    for (step = 1; low + step < high; step <<= 1) {                         \
+        mid = low + step;                                                   \
+        if (points[mid] > value || (!upper && points[mid] == value)) {      \
+            high = mid;                                                     \
+            break;                                                          \
+        }                                                                   \
+        low = mid;                                                          \
+    }                                                                       \
+                                                                            \
+    while (low < high) {                                                    \
+        mid = low + (high - low) / 2;                                       \
+        if (points[mid] < value || (upper && points[mid] == value))         \
+            low = mid + 1;                                                  \
+        else                                                                \
+            high = mid;                                                     \
+    }                                                                       \
+                                                                            \
+    return low;                                                             \
+}                                                                           \
+                                                                            \
+static int                                                                  \
+STNAME##_stab_subtree(bfdev_rb_node_t *rb, const STTYPE *points,            \
+                      size_t low, size_t high,                              \
+                      int (*func)(STSTRUCT *, size_t, void *), void *pdata) \
+{                                                                           \
+    STSTRUCT *node;                                                         \
+    size_t index, limit;                                                    \
+    int retval;                                                             \
+                                                                            \
+    while (rb && low < high) {                                              \
+        node = bfdev_rb_entry(rb, STSTRUCT, STRB);                          \
+                                                                            \
+        /* points beyond the largest end can not hit this subtree */        \
+        high = STNAME##_bound(points, low, high, node->STSUBTREE, true);    \
+        if (low == high)                                                    \
+            break;                                                          \
+                                                                            \
+        retval = STNAME##_stab_subtree(                                     \
+            node->STRB.left, points, low, high, func, pdata                 \
+        );                                                                  \
+        if (retval)                                                         \
+            return retval;                                                  \
+                                                                            \
+        /* the node and the right subtree start at STSTART(node) */         \
+        low = STNAME##_bound(points, low, high, STSTART(node), false);      \
+        limit = STNAME##_bound(points, low, high, STEND(node), true);       \
+        for (index = low; index < limit; ++index) {                         \
+            retval = func(node, index, pdata);                              \
+            if (retval)                                                     \
+                return retval;                                              \
+        }                                                                   \
+                                                                            \
+        rb = node->STRB.right;                                              \
+    }                                                                       \
+                                                                            \
+    return 0;                                                               \
+}                                                                           \
+                                                                            \
+STSTATIC int                                                                \
+STNAME##_stab(bfdev_rb_root_cached_t *cached, const STTYPE *points,         \
+              size_t count, int (*func)(STSTRUCT *, size_t, void *),        \
+              void *pdata)                                                  \
+{                                                                           \
+    return STNAME##_stab_subtree(                                           \
+        cached->root.node, points, 0, count, func, pdata                    \
+    );                                                                      \
+}                                                                           \
+                                                                            \
+static bfdev_rb_node_t *                                                    \
+STNAME##_build_subtree(STSTRUCT **nodes, size_t count,                      \
+                       bfdev_rb_node_t *parent, unsigned int depth,         \
+                       unsigned int black)                                  \
+{                                                                           \
+    STSTRUCT *node, *child;                                                 \
+    size_t mid;                                                             \
+                                                                            \
+    if (!count)                                                             \
+        return NULL;                                                        \
+                                                                            \
+    mid = count / 2;                                                        \
+    node = nodes[mid];                                                      \
+    node->STRB.parent = parent;                                             \
+    node->STRB.color = depth < black ? BFDEV_RB_BLACK : BFDEV_RB_RED;       \
+    node->STRB.left = STNAME##_build_subtree(                               \
+        nodes, mid, &node->STRB, depth + 1, black                           \
+    );                                                                      \
+    node->STRB.right = STNAME##_build_subtree(                              \
+        nodes + mid + 1, count - mid - 1, &node->STRB, depth + 1, black     \
+    );                                                                      \
+                                                                            \
+    node->STSUBTREE = STEND(node);                                          \
+    if (node->STRB.left) {                                                  \
+        child = bfdev_rb_entry(node->STRB.left, STSTRUCT, STRB);            \
+        if (node->STSUBTREE < child->STSUBTREE)                             \
+            node->STSUBTREE = child->STSUBTREE;                             \
+    }                                                                       \
+    if (node->STRB.right) {                                                 \
+        child = bfdev_rb_entry(node->STRB.right, STSTRUCT, STRB);           \
+        if (node->STSUBTREE < child->STSUBTREE)                             \
+            node->STSUBTREE = child->STSUBTREE;                             \
+    }                                                                       \
+                                                                            \
+    return &node->STRB;                                                     \
+}                                                                           \
+                                                                            \
+STSTATIC void                                                               \
+STNAME##_build(bfdev_rb_root_cached_t *cached, STSTRUCT **nodes,            \
+               size_t count)                                                \
+{                                                                           \
+    unsigned int black;                                                     \
+                                                                            \
+    /*                                                                      \
+     * Midpoint splitting fills the first black levels completely,          \
+     * only the nodes of the last partial level are coloured red.           \
+     */                                                                     \
+    black = 0;                                                              \
+    while (((size_t)2 << black) - 1 <= count)                               \
+        black++;                                                            \
+                                                                            \
+    cached->root.node = STNAME##_build_subtree(                             \
+        nodes, count, NULL, 0, black                                        \
+    );                                                                      \
+    cached->leftmost = count ? &nodes[0]->STRB : NULL;                      \
 }
 
 BFDEV_END_DECLS
@@ -40,6 +40,19 @@ bfdev_sha1_finish(bfdev_sha1_ctx_t *ctx, void *hash);
 extern void
 bfdev_sha1_init(bfdev_sha1_ctx_t *ctx);
 
+/*
+ * bfdev_sha1_update_mb() - SHA1 counterpart of bfdev_sha2_update_mb().
+ * bfdev_sha1_finish_mb() - SHA1 counterpart of bfdev_sha256_finish_mb().
+ */
+
+extern void
+bfdev_sha1_update_mb(bfdev_sha1_ctx_t *const *ctx, const char *const *data,
+                     const size_t *size, unsigned int nr);
+
+extern void
+bfdev_sha1_finish_mb(bfdev_sha1_ctx_t *const *ctx, void *const *hash,
+                     unsigned int nr);
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_SHA1_H_ */
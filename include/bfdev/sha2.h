@@ -61,6 +61,31 @@ bfdev_sha224_init(bfdev_sha2_ctx_t *ctx);
 extern void
 bfdev_sha256_init(bfdev_sha2_ctx_t *ctx);
 
+/*
+ * bfdev_sha2_update_mb() - feed many independent streams at once.
+ * bfdev_sha2*_finish_mb() - finish many independent streams at once.
+ * @ctx: array of @nr distinct contexts.
+ * @data: array of data pointers, one for each context.
+ * @size: array of data lengths, one for each context.
+ * @hash: array of digest buffers, one for each context.
+ * @nr: number of streams.
+ *
+ * Same results as feeding every stream on its own, but the streams
+ * are hashed side by side in vector lanes when the cpu has them.
+ */
+
+extern void
+bfdev_sha2_update_mb(bfdev_sha2_ctx_t *const *ctx, const char *const *data,
+                     const size_t *size, unsigned int nr);
+
+extern void
+bfdev_sha224_finish_mb(bfdev_sha2_ctx_t *const *ctx, void *const *hash,
+                       unsigned int nr);
+
+extern void
+bfdev_sha256_finish_mb(bfdev_sha2_ctx_t *const *ctx, void *const *hash,
+                       unsigned int nr);
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_SHA2_H_ */
@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_TIMEWHEEL_H_
+#define _BFDEV_TIMEWHEEL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/list.h>
+#include <bfdev/bitmap.h>
+#include <bfdev/time.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Timing Wheel:
+ *
+ * A hierarchical timing wheel keeps timers in per-slot lists,
+ * each level covering BFDEV_TIMEWHEEL_SLOTS times the range of
+ * the level below. Arm and cancel are O(1), timers in the upper
+ * levels are cascaded down as the clock reaches their slot, and
+ * an occupancy bitmap per level lets the clock skip empty slots.
+ * Time is counted in ticks of whatever unit the caller chooses.
+ */
+
+#ifndef BFDEV_TIMEWHEEL_BITS
+# define BFDEV_TIMEWHEEL_BITS 6
+#endif
+
+#ifndef BFDEV_TIMEWHEEL_LEVELS
+# define BFDEV_TIMEWHEEL_LEVELS 8
+#endif
+
+#define BFDEV_TIMEWHEEL_SLOTS (1U << BFDEV_TIMEWHEEL_BITS)
+#define BFDEV_TIMEWHEEL_MASK (BFDEV_TIMEWHEEL_SLOTS - 1)
+
+/* slot index of a timer that is not armed in any wheel */
+#define BFDEV_TIMEWHEEL_IDLE (~0U)
+
+typedef struct bfdev_timewheel bfdev_timewheel_t;
+typedef struct bfdev_timewheel_node bfdev_timewheel_node_t;
+
+typedef void (*bfdev_timewheel_func_t)
+(bfdev_timewheel_node_t *node, void *pdata);
+
+struct bfdev_timewheel_node {
+    bfdev_list_head_t list;
+    bfdev_time_t expires;
+    unsigned int index;
+};
+
+struct bfdev_timewheel {
+    bfdev_time_t clock;
+    unsigned long count;
+    BFDEV_DEFINE_BITMAP(pending[BFDEV_TIMEWHEEL_LEVELS], BFDEV_TIMEWHEEL_SLOTS)
+    bfdev_list_head_t slots[BFDEV_TIMEWHEEL_LEVELS][BFDEV_TIMEWHEEL_SLOTS];
+};
+
+/**
+ * bfdev_timewheel_entry - get the struct for this entry.
+ * @ptr: the &bfdev_timewheel_node_t pointer.
+ * @type: the type of the struct this is embedded in.
+ * @member: the name of the bfdev_timewheel_node within the struct.
+ */
+#define bfdev_timewheel_entry(ptr, type, member) \
+    bfdev_container_of(ptr, type, member)
+
+/**
+ * bfdev_timewheel_node_init() - initialize a timer node.
+ * @node: the timer node to initialize.
+ */
+static inline void
+bfdev_timewheel_node_init(bfdev_timewheel_node_t *node)
+{
+    bfdev_list_head_init(&node->list);
+    node->index = BFDEV_TIMEWHEEL_IDLE;
+}
+
+/**
+ * bfdev_timewheel_pending() - check whether a timer is armed.
+ * @node: the timer node to check.
+ */
+static inline bool
+bfdev_timewheel_pending(const bfdev_timewheel_node_t *node)
+{
+    return node->index != BFDEV_TIMEWHEEL_IDLE;
+}
+
+/**
+ * bfdev_timewheel_count() - get the number of armed timers.
+ * @wheel: the timing wheel to count.
+ */
+static inline unsigned long
+bfdev_timewheel_count(const bfdev_timewheel_t *wheel)
+{
+    return wheel->count;
+}
+
+/**
+ * bfdev_timewheel_init() - initialize a timing wheel.
+ * @wheel: the timing wheel to initialize.
+ * @clock: current time of the wheel.
+ */
+extern void
+bfdev_timewheel_init(bfdev_timewheel_t *wheel, bfdev_time_t clock);
+
+/**
+ * bfdev_timewheel_add() - arm a timer.
+ * @wheel: the timing wheel to arm into.
+ * @node: the timer node, must not be pending.
+ * @expires: absolute expiry time of the timer.
+ *
+ * Timers that are already due fire on the next advance.
+ */
+extern void
+bfdev_timewheel_add(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node,
+                    bfdev_time_t expires);
+
+/**
+ * bfdev_timewheel_del() - cancel a pending timer.
+ * @wheel: the timing wheel of timer.
+ * @node: the timer node to cancel.
+ *
+ * Returns true if the timer was pending.
+ */
+extern bool
+bfdev_timewheel_del(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node);
+
+/**
+ * bfdev_timewheel_mod() - modify the expiry time of a timer.
+ * @wheel: the timing wheel of timer.
+ * @node: the timer node, may or may not be pending.
+ * @expires: new absolute expiry time of the timer.
+ *
+ * A timer still sitting on the list filled by bfdev_timewheel_expire()
+ * is taken off that list first.
+ */
+extern void
+bfdev_timewheel_mod(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node,
+                    bfdev_time_t expires);
+
+/**
+ * bfdev_timewheel_next() - get the next time the wheel has work to do.
+ * @wheel: the timing wheel to query.
+ * @timep: pointer used to return the next time.
+ *
+ * The returned time is either the expiry of the earliest timer or
+ * an earlier cascade point, it is safe to sleep until then.
+ * Returns false if no timer is pending.
+ */
+extern bool
+bfdev_timewheel_next(const bfdev_timewheel_t *wheel, bfdev_time_t *timep);
+
+/**
+ * bfdev_timewheel_expire() - advance the clock and collect due timers.
+ * @wheel: the timing wheel to advance.
+ * @now: the new current time.
+ * @expired: list that receives all expired timers in expiry order.
+ *
+ * Timers moved onto @expired are no longer owned by the wheel and
+ * no longer pending, bfdev_timewheel_del() leaves them alone. Detach
+ * them with bfdev_list_del_init() before arming them with
+ * bfdev_timewheel_add() again.
+ * Returns the number of timers moved onto @expired.
+ */
+extern unsigned long
+bfdev_timewheel_expire(bfdev_timewheel_t *wheel, bfdev_time_t now,
+                       bfdev_list_head_t *expired);
+
+/**
+ * bfdev_timewheel_run() - advance the clock and run due timers.
+ * @wheel: the timing wheel to advance.
+ * @now: the new current time.
+ * @func: callback invoked once for each expired timer.
+ * @pdata: private data of @func.
+ *
+ * Expired timers are collected as one batch before the first
+ * callback, so a callback may safely re-arm its own timer.
+ * Returns the number of timers that fired.
+ */
+extern unsigned long
+bfdev_timewheel_run(bfdev_timewheel_t *wheel, bfdev_time_t now,
+                    bfdev_timewheel_func_t func, void *pdata);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_TIMEWHEEL_H_ */
@@ -9,10 +9,12 @@
 #include <bfdev/config.h>
 #include <bfdev/types.h>
 #include <bfdev/stddef.h>
+#include <bfdev/atomic.h>
 
 BFDEV_BEGIN_DECLS
 
 typedef struct bfdev_tokenbucket bfdev_tokenbucket_t;
+typedef struct bfdev_tokenbucket_atomic bfdev_tokenbucket_atomic_t;
 
 struct bfdev_tokenbucket {
     bfdev_time_t interval;
@@ -68,6 +70,94 @@ bfdev_tokenbucket_reset(bfdev_tokenbucket_t *limit)
 extern bool
 bfdev_tokenbucket(bfdev_tokenbucket_t *limit, bfdev_time_t current);
 
+/**
+ * struct bfdev_tokenbucket_atomic - token bucket safe for concurrent callers.
+ * @interval: time to generate one token.
+ * @capacity: maximum number of tokens held.
+ * @state: refill time in units of @interval above the used token count.
+ *
+ * Refill and consume happen with a single cmpxchg on @state. Counting
+ * used rather than remaining tokens makes the zero state a full
+ * bucket, so a drained bucket is never mistaken for a fresh one. Tokens
+ * are generated at multiples of @interval, and a bucket left idle for
+ * more than 2^(BITS_PER_LONG - fls(@capacity)) intervals may come
+ * back less than full. No pass or miss statistics are kept, counting
+ * them would put every caller on one more shared cache line.
+ */
+struct bfdev_tokenbucket_atomic {
+    bfdev_time_t interval;
+    unsigned int capacity;
+    bfdev_atomic_t state;
+};
+
+#define BFDEV_TOKENBUCKET_ATOMIC_STATIC(INTERVAL, CAPACITY) { \
+    .interval = (INTERVAL), .capacity = (CAPACITY), .state = 0, \
+}
+
+#define BFDEV_TOKENBUCKET_ATOMIC_INIT(interval, capacity) \
+    (bfdev_tokenbucket_atomic_t) BFDEV_TOKENBUCKET_ATOMIC_STATIC(interval, capacity)
+
+#define BFDEV_DEFINE_TOKENBUCKET_ATOMIC(name, interval, capacity) \
+    bfdev_tokenbucket_atomic_t name = BFDEV_TOKENBUCKET_ATOMIC_INIT(interval, capacity)
+
+static inline void
+bfdev_tokenbucket_atomic_init(bfdev_tokenbucket_atomic_t *limit,
+                              bfdev_time_t interval, unsigned int capacity)
+{
+    *limit = BFDEV_TOKENBUCKET_ATOMIC_INIT(interval, capacity);
+}
+
+static inline void
+bfdev_tokenbucket_atomic_reset(bfdev_tokenbucket_atomic_t *limit)
+{
+    bfdev_atomic_write(&limit->state, 0);
+}
+
+/**
+ * bfdev_tokenbucket_acquire() - take tokens from a shared bucket.
+ * @limit: tokenbucket state data.
+ * @current: current time.
+ * @count: number of tokens to take at once.
+ *
+ * Either all @count tokens are taken or none.
+ *
+ * RETURNS:
+ * 0 means function will be suppressed.
+ * 1 means go ahead and do it.
+ */
+extern bool
+bfdev_tokenbucket_acquire(bfdev_tokenbucket_atomic_t *limit,
+                          bfdev_time_t current, unsigned int count);
+
+static inline bool
+bfdev_tokenbucket_atomic(bfdev_tokenbucket_atomic_t *limit,
+                         bfdev_time_t current)
+{
+    return bfdev_tokenbucket_acquire(limit, current, 1);
+}
+
+/**
+ * bfdev_tokenbucket_gcra() - generic cell rate algorithm limiting.
+ * @limit: shared configuration, only @interval and @capacity are used.
+ * @tat: theoretical arrival time, the whole state of one key.
+ * @current: current time.
+ * @count: number of tokens to take at once.
+ *
+ * Behaves like a token bucket of @limit, but keeps the state in a
+ * single word that starts out as zero. This suits limiting millions
+ * of keys, each holding a @tat, against one configuration. A live
+ * @tat never runs further ahead of the clock than the burst, anything
+ * else counts as idle, which keeps times truncated to a narrow
+ * bfdev_atomic_t working.
+ *
+ * RETURNS:
+ * 0 means function will be suppressed.
+ * 1 means go ahead and do it.
+ */
+extern bool
+bfdev_tokenbucket_gcra(const bfdev_tokenbucket_t *limit, bfdev_atomic_t *tat,
+                       bfdev_time_t current, unsigned int count);
+
 BFDEV_END_DECLS
 
 #endif /* _BFDEV_TOKENBUCKET_H_ */
@@ -0,0 +1,244 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_WSPOOL_H_
+#define _BFDEV_WSPOOL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/errno.h>
+#include <bfdev/atomic.h>
+#include <bfdev/compiler.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/**
+ * Work-stealing Pool:
+ *
+ * A fork-join scheduler in the style of Cilk. Every worker owns a
+ * Chase-Lev deque, it pushes and pops forked tasks at the bottom
+ * without any atomic read-modify-write, idle workers steal from the
+ * top of a random victim. A task that does not fit into a full deque
+ * simply runs in place.
+ *
+ * The pool does not create threads. Every thread using it owns one
+ * worker index: helper threads call bfdev_wspool_run() and keep
+ * stealing until bfdev_wspool_stop(), the thread that starts
+ * parallel work passes its own index to the parallel helpers.
+ * Idle helpers sleep through the wait operations installed with
+ * bfdev_wspool_set_wait(), without them they spin.
+ */
+
+#ifndef BFDEV_WSPOOL_RESULT
+# define BFDEV_WSPOOL_RESULT 64
+#endif
+
+typedef struct bfdev_wspool bfdev_wspool_t;
+typedef struct bfdev_wspool_ops bfdev_wspool_ops_t;
+typedef struct bfdev_wspool_task bfdev_wspool_task_t;
+typedef struct bfdev_wspool_worker bfdev_wspool_worker_t;
+
+typedef void
+(*bfdev_wspool_entry_t)(bfdev_wspool_worker_t *worker,
+                        bfdev_wspool_task_t *task);
+
+typedef void
+(*bfdev_wspool_for_t)(unsigned long begin, unsigned long end, void *pdata);
+
+typedef void
+(*bfdev_wspool_map_t)(unsigned long begin, unsigned long end,
+                      void *result, void *pdata);
+
+typedef void
+(*bfdev_wspool_combine_t)(void *result, const void *other, void *pdata);
+
+/**
+ * struct bfdev_wspool_ops - blocking operations of pool.
+ * @wait: sleep while @event still equals @value, spurious wakeups are fine.
+ * @wake: wake up every thread sleeping on @event.
+ */
+struct bfdev_wspool_ops {
+    void (*wait)(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata);
+    void (*wake)(bfdev_atomic_t *event, void *pdata);
+};
+
+/**
+ * struct bfdev_wspool_task - a forked piece of work.
+ * @entry: runs the task on the worker that picked it up.
+ * @done: set once @entry has returned.
+ */
+struct bfdev_wspool_task {
+    bfdev_wspool_entry_t entry;
+    bfdev_atomic_t done;
+};
+
+/**
+ * struct bfdev_wspool_worker - per-worker state.
+ * @top: stealing end of deque, shared with thieves.
+ * @bottom: owner end of deque.
+ * @pool: the pool of worker.
+ * @tasks: ring of deque.
+ * @seed: state for picking victims.
+ */
+struct bfdev_wspool_worker {
+    bfdev_atomic_t top;
+
+    bfdev_atomic_t bottom __bfdev_cacheline_aligned;
+    bfdev_wspool_t *pool;
+    bfdev_atomic_t *tasks;
+    uint32_t seed;
+} __bfdev_cacheline_aligned;
+
+/**
+ * struct bfdev_wspool - work-stealing pool.
+ * @alloc: allocator of workers and deques.
+ * @ops: optional blocking operations.
+ * @pdata: private data of blocking operations.
+ * @workers: cache line aligned workers.
+ * @block: allocated memory, @workers aligned inside.
+ * @nr: number of workers.
+ * @mask: capacity of each deque minus one.
+ * @stop: set once helpers should return.
+ * @event: event bumped when sleeping helpers may find work.
+ * @sleepers: number of helpers going to sleep.
+ */
+struct bfdev_wspool {
+    const bfdev_alloc_t *alloc;
+    const bfdev_wspool_ops_t *ops;
+    void *pdata;
+
+    bfdev_wspool_worker_t *workers;
+    void *block;
+    unsigned int nr;
+    unsigned long mask;
+    bfdev_atomic_t stop;
+
+    bfdev_atomic_t event __bfdev_cacheline_aligned;
+    bfdev_atomic_t sleepers;
+};
+
+static inline bfdev_wspool_worker_t *
+bfdev_wspool_worker(bfdev_wspool_t *pool, unsigned int index)
+{
+    return &pool->workers[index];
+}
+
+static inline void
+bfdev_wspool_set_wait(bfdev_wspool_t *pool, const bfdev_wspool_ops_t *ops,
+                      void *pdata)
+{
+    pool->ops = ops;
+    pool->pdata = pdata;
+}
+
+/**
+ * bfdev_wspool_fork() - make a task available to other workers.
+ * @worker: the worker of calling thread.
+ * @task: the task to fork, must stay valid until joined.
+ *
+ * If the deque of @worker is full the task runs before returning.
+ */
+extern void
+bfdev_wspool_fork(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task);
+
+/**
+ * bfdev_wspool_join() - wait for a forked task.
+ * @worker: the worker of calling thread.
+ * @task: the task to wait for.
+ *
+ * Runs the task itself if nobody stole it, otherwise helps with
+ * other tasks while waiting.
+ */
+extern void
+bfdev_wspool_join(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task);
+
+/**
+ * bfdev_wspool_parallel_for() - run a function over a range in parallel.
+ * @pool: the pool to run on.
+ * @index: worker index owned by calling thread.
+ * @begin: first index of range.
+ * @end: index after the range.
+ * @grain: largest piece handed to @func, 0 picks one.
+ * @func: called for disjoint pieces covering the range.
+ * @pdata: private data of @func.
+ */
+extern int
+bfdev_wspool_parallel_for(bfdev_wspool_t *pool, unsigned int index,
+                          unsigned long begin, unsigned long end,
+                          unsigned long grain, bfdev_wspool_for_t func,
+                          void *pdata);
+
+/**
+ * bfdev_wspool_parallel_reduce() - reduce a range in parallel.
+ * @pool: the pool to run on.
+ * @index: worker index owned by calling thread.
+ * @begin: first index of range.
+ * @end: index after the range, larger than @begin.
+ * @grain: largest piece handed to @map, 0 picks one.
+ * @map: stores the partial result of a piece into its result.
+ * @combine: folds the result of the following piece into a result.
+ * @result: receives the result of the whole range.
+ * @rsize: size of result, at most BFDEV_WSPOOL_RESULT.
+ * @pdata: private data of @map and @combine.
+ *
+ * Pieces are combined in range order, @combine needs to be
+ * associative but not commutative.
+ */
+extern int
+bfdev_wspool_parallel_reduce(bfdev_wspool_t *pool, unsigned int index,
+                             unsigned long begin, unsigned long end,
+                             unsigned long grain, bfdev_wspool_map_t map,
+                             bfdev_wspool_combine_t combine,
+                             void *result, size_t rsize, void *pdata);
+
+/**
+ * bfdev_wspool_run() - help the pool until it is stopped.
+ * @pool: the pool to help.
+ * @index: worker index owned by calling thread.
+ *
+ * Returns -BFDEV_EINVAL if @index is out of range, otherwise once
+ * bfdev_wspool_stop() has been called.
+ */
+extern int
+bfdev_wspool_run(bfdev_wspool_t *pool, unsigned int index);
+
+/**
+ * bfdev_wspool_stop() - make every bfdev_wspool_run() return.
+ * @pool: the pool to stop.
+ *
+ * The pool stays stopped, helpers entering bfdev_wspool_run()
+ * afterwards return at once until bfdev_wspool_reset().
+ */
+extern void
+bfdev_wspool_stop(bfdev_wspool_t *pool);
+
+/**
+ * bfdev_wspool_reset() - make a stopped pool usable by helpers again.
+ * @pool: the pool to reset.
+ *
+ * Must only be called once every bfdev_wspool_run() of the previous
+ * round has returned.
+ */
+extern void
+bfdev_wspool_reset(bfdev_wspool_t *pool);
+
+/**
+ * bfdev_wspool_alloc() - allocate a work-stealing pool.
+ * @pool: the pool to initialize.
+ * @alloc: allocator of workers and deques.
+ * @nr: number of workers.
+ * @depth: capacity of each deque, rounded up to a power of two.
+ */
+extern int
+bfdev_wspool_alloc(bfdev_wspool_t *pool, const bfdev_alloc_t *alloc,
+                   unsigned int nr, unsigned long depth);
+
+extern void
+bfdev_wspool_free(bfdev_wspool_t *pool);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_WSPOOL_H_ */
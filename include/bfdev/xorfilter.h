@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_XORFILTER_H_
+#define _BFDEV_XORFILTER_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+#include <bfdev/errno.h>
+#include <bfdev/allocator.h>
+
+BFDEV_BEGIN_DECLS
+
+/* give up on construction after this many seeds */
+#define BFDEV_XORFILTER_ATTEMPTS 100
+
+typedef struct bfdev_xorfilter bfdev_xorfilter_t;
+
+typedef uint64_t (*bfdev_xorfilter_hash_t)
+(const void *key, void *pdata);
+
+/**
+ * struct bfdev_xorfilter - static binary fuse filter.
+ * @alloc: allocator of the filter.
+ * @hash: 64-bit key hash callback.
+ * @pdata: private data pointer of @hash.
+ * @seed: seed the construction succeeded with.
+ * @segment_length: number of fingerprints per segment.
+ * @segment_mask: @segment_length minus one.
+ * @segment_span: fingerprints covered by the first slot of a key.
+ * @length: number of fingerprints.
+ * @fingerprints: 8-bit fingerprints.
+ *
+ * Every key maps to three slots in consecutive segments, and the xor
+ * of them is its fingerprint. Built once from a complete set, it takes
+ * about 9 bits per key for a false positive rate of 1/256.
+ */
+struct bfdev_xorfilter {
+    const bfdev_alloc_t *alloc;
+    bfdev_xorfilter_hash_t hash;
+    void *pdata;
+
+    uint64_t seed;
+    uint32_t segment_length;
+    uint32_t segment_mask;
+    uint32_t segment_span;
+    uint32_t length;
+    uint8_t fingerprints[];
+};
+
+/**
+ * bfdev_xorfilter_peek_hash() - test a precomputed hash.
+ * @filter: filter pointer.
+ * @hash: 64-bit hash of the key.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_xorfilter_peek_hash(const bfdev_xorfilter_t *filter, uint64_t hash);
+
+/**
+ * bfdev_xorfilter_peek() - test an object against the filter.
+ * @filter: filter pointer.
+ * @key: object pointer.
+ *
+ * @return: true if the key may be present.
+ */
+extern bool
+bfdev_xorfilter_peek(const bfdev_xorfilter_t *filter, const void *key);
+
+/**
+ * bfdev_xorfilter_create() - build a binary fuse filter.
+ * @alloc: allocator of the filter.
+ * @hashes: 64-bit hashes of every key, duplicates are allowed.
+ * @count: number of hashes, below 2^32.
+ * @hash: 64-bit key hash callback, used by bfdev_xorfilter_peek().
+ * @pdata: private data pointer of @hash.
+ *
+ * The filter can not be changed afterwards. Construction needs about
+ * 24 bytes of temporary memory per key.
+ */
+extern bfdev_xorfilter_t *
+bfdev_xorfilter_create(const bfdev_alloc_t *alloc, const uint64_t *hashes,
+                       size_t count, bfdev_xorfilter_hash_t hash, void *pdata);
+
+/**
+ * bfdev_xorfilter_destroy() - destroy a binary fuse filter.
+ * @filter: filter pointer.
+ */
+extern void
+bfdev_xorfilter_destroy(bfdev_xorfilter_t *filter);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_XORFILTER_H_ */
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _BFDEV_XXHASH_H_
+#define _BFDEV_XXHASH_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/stddef.h>
+
+BFDEV_BEGIN_DECLS
+
+#define BFDEV_XXH3_STRIPE_SIZE 64
+#define BFDEV_XXH3_SECRET_SIZE 192
+#define BFDEV_XXH3_BUFFER_SIZE 256
+#define BFDEV_XXH3_ACC_WORDS 8
+
+/**
+ * BFDEV_XXH3_KEY_LENGTH() - pass a fixed key length as private data.
+ * @length: size of every key.
+ *
+ * Keys are nul terminated strings when the private data is NULL.
+ */
+#define BFDEV_XXH3_KEY_LENGTH(length) \
+    ((void *)(uintptr_t)(length))
+
+typedef struct bfdev_xxh128 bfdev_xxh128_t;
+typedef struct bfdev_xxh3_ctx bfdev_xxh3_ctx_t;
+
+struct bfdev_xxh128 {
+    uint64_t low;
+    uint64_t high;
+};
+
+/**
+ * struct bfdev_xxh3_ctx - xxh3 streaming context.
+ * @acc: the eight accumulators of the long input loop.
+ * @secret: the secret, derived from the seed.
+ * @buffer: input held back, ends with the last stripe consumed.
+ * @seed: seed given on init.
+ * @total: number of bytes hashed so far.
+ * @buffered: number of bytes held in @buffer.
+ * @stripes: stripes consumed in the current block.
+ */
+struct bfdev_xxh3_ctx {
+    uint64_t acc[BFDEV_XXH3_ACC_WORDS];
+    uint8_t secret[BFDEV_XXH3_SECRET_SIZE];
+    uint8_t buffer[BFDEV_XXH3_BUFFER_SIZE];
+    uint64_t seed;
+    uint64_t total;
+    unsigned int buffered;
+    unsigned int stripes;
+};
+
+/**
+ * bfdev_xxh3() - 64-bit xxh3 of a buffer.
+ * @data: data to hash.
+ * @length: length of @data.
+ * @seed: seed value, zero gives the unseeded hash.
+ */
+extern uint64_t
+bfdev_xxh3(const void *data, size_t length, uint64_t seed);
+
+/**
+ * bfdev_xxh128() - 128-bit xxh3 of a buffer.
+ * @data: data to hash.
+ * @length: length of @data.
+ * @seed: seed value, zero gives the unseeded hash.
+ */
+extern bfdev_xxh128_t
+bfdev_xxh128(const void *data, size_t length, uint64_t seed);
+
+/**
+ * bfdev_xxh3_init() - prepare a streaming context.
+ * @ctx: the context to initialize.
+ * @seed: seed value.
+ *
+ * The same context finishes into either width.
+ */
+extern void
+bfdev_xxh3_init(bfdev_xxh3_ctx_t *ctx, uint64_t seed);
+
+/**
+ * bfdev_xxh3_update() - feed the next piece of a stream.
+ * @ctx: the streaming context.
+ * @data: data to hash.
+ * @length: length of @data.
+ */
+extern void
+bfdev_xxh3_update(bfdev_xxh3_ctx_t *ctx, const void *data, size_t length);
+
+/**
+ * bfdev_xxh3_finish() - 64-bit hash of a stream.
+ * @ctx: the streaming context.
+ *
+ * The context is left untouched, more data may follow.
+ */
+extern uint64_t
+bfdev_xxh3_finish(const bfdev_xxh3_ctx_t *ctx);
+
+/**
+ * bfdev_xxh128_finish() - 128-bit hash of a stream.
+ * @ctx: the streaming context.
+ *
+ * The context is left untouched, more data may follow.
+ */
+extern bfdev_xxh128_t
+bfdev_xxh128_finish(const bfdev_xxh3_ctx_t *ctx);
+
+/**
+ * bfdev_xxh3_key() - hash a key for bfdev_hashmap_ops.hash_key.
+ * @key: the key to hash.
+ * @pdata: key length from BFDEV_XXH3_KEY_LENGTH() or NULL.
+ */
+extern unsigned long
+bfdev_xxh3_key(const void *key, void *pdata);
+
+/**
+ * bfdev_xxh3_bloom() - hash a key for bfdev_bloom_hash_t.
+ * @func: index of the hash function, used as seed.
+ * @key: the key to hash.
+ * @pdata: key length from BFDEV_XXH3_KEY_LENGTH() or NULL.
+ */
+extern unsigned int
+bfdev_xxh3_bloom(unsigned int func, const void *key, void *pdata);
+
+BFDEV_END_DECLS
+
+#endif /* _BFDEV_XXHASH_H_ */
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_PORT_RINGBUF_H_
+#define _LOCAL_PORT_RINGBUF_H_
+
+#include <base.h>
+#include <bfdev/ringbuf.h>
+
+#ifndef __INSIDE_RINGBUF__
+# error "please don't include this file directly"
+#endif
+
+#if defined(__linux__) && !defined(_KERNEL)
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <linux/memfd.h>
+# define GENERIC_RINGBUF_MIRROR
+#endif
+
+#ifdef GENERIC_RINGBUF_MIRROR
+
+static inline size_t
+generic_ringbuf_mirror_align(void)
+{
+    long pagesize;
+
+    pagesize = sysconf(_SC_PAGESIZE);
+    if (pagesize <= 0)
+        return 0;
+
+    return pagesize;
+}
+
+/*
+ * Reserve twice the size of address space and map the same memfd
+ * into both halves, so any window of up to @size bytes starting in
+ * the first half is virtually contiguous.
+ */
+static inline void *
+generic_ringbuf_mirror_map(size_t size)
+{
+    void *area, *half;
+    int fd;
+
+    fd = syscall(SYS_memfd_create, "bfdev-ringbuf", MFD_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    if (ftruncate(fd, size))
+        goto failed;
+
+    area = mmap(NULL, size * 2, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED)
+        goto failed;
+
+    half = mmap(area, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0);
+    if (half == MAP_FAILED)
+        goto unmap;
+
+    half = mmap(area + size, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0);
+    if (half == MAP_FAILED)
+        goto unmap;
+
+    close(fd);
+    return area;
+
+unmap:
+    munmap(area, size * 2);
+failed:
+    close(fd);
+    return NULL;
+}
+
+static inline void
+generic_ringbuf_mirror_unmap(void *area, size_t size)
+{
+    munmap(area, size * 2);
+}
+
+#else /* !GENERIC_RINGBUF_MIRROR */
+
+static inline size_t
+generic_ringbuf_mirror_align(void)
+{
+    return 0;
+}
+
+static inline void *
+generic_ringbuf_mirror_map(size_t size)
+{
+    return NULL;
+}
+
+static inline void
+generic_ringbuf_mirror_unmap(void *area, size_t size)
+{
+    /* Nothing */
+}
+
+#endif /* GENERIC_RINGBUF_MIRROR */
+
+#endif /* _LOCAL_PORT_RINGBUF_H_ */
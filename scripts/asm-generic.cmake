@@ -5,11 +5,17 @@
 
 function(asm_generic prefix generated compare source)
     file(GLOB srclist ${source}/*.h)
-    file(GLOB cmplist ${compare}/*.h)
+
+    # headers found in any of the compare dirs are not generated
+    set(cmplist)
+    foreach(cmpdir ${compare})
+        file(GLOB cmpfiles RELATIVE ${cmpdir} ${cmpdir}/*.h)
+        list(APPEND cmplist ${cmpfiles})
+    endforeach()
 
     foreach(srcpath ${srclist})
         string(REGEX REPLACE ".+/(.+)" "\\1" filename ${srcpath})
-        list(FIND cmplist ${compare}/${filename} retval)
+        list(FIND cmplist ${filename} retval)
         set(genfile ${generated}/${filename})
 
         file(REMOVE ${genfile})
@@ -7,6 +7,10 @@
 #include <bfdev/bloom.h>
 #include <bfdev/hashtbl.h>
 #include <bfdev/bitops.h>
+#include <bfdev/bitmap.h>
+#include <bfdev/byteorder.h>
+#include <bfdev/align.h>
+#include <bfdev/crc.h>
 #include <export.h>
 
 static unsigned int
@@ -20,6 +24,82 @@ bloom_index(bfdev_bloom_t *bloom, unsigned int func, void *key)
     return index;
 }
 
+static inline size_t
+bloom_bitmap_size(unsigned int capacity)
+{
+    return BFDEV_BITS_TO_LONG((size_t)capacity) * BFDEV_BYTES_PER_LONG;
+}
+
+static inline bool
+bloom_compatible(const bfdev_bloom_t *dest, const bfdev_bloom_t *src)
+{
+    return dest->capacity == src->capacity && dest->funcs == src->funcs &&
+           dest->hash == src->hash && dest->pdata == src->pdata;
+}
+
+#ifdef __BFDEV_BIG_ENDIAN__
+# if BFDEV_BITS_PER_LONG == 64
+#  define bloom_cpu_to_le(value) ((__bfdev_force unsigned long)bfdev_cpu_to_le64(value))
+#  define bloom_le_to_cpu(value) bfdev_le64_to_cpu((__bfdev_force bfdev_le64)(value))
+# else
+#  define bloom_cpu_to_le(value) ((__bfdev_force unsigned long)bfdev_cpu_to_le32(value))
+#  define bloom_le_to_cpu(value) bfdev_le32_to_cpu((__bfdev_force bfdev_le32)(value))
+# endif
+
+static void
+bloom_bitmap_export(unsigned long *dest, const unsigned long *src,
+                    unsigned int capacity)
+{
+    unsigned int index, words;
+
+    words = BFDEV_BITS_TO_LONG(capacity);
+    for (index = 0; index < words; ++index)
+        dest[index] = bloom_cpu_to_le(src[index]);
+}
+
+static void
+bloom_bitmap_import(unsigned long *dest, const unsigned long *src,
+                    unsigned int capacity)
+{
+    unsigned int index, words;
+
+    words = BFDEV_BITS_TO_LONG(capacity);
+    for (index = 0; index < words; ++index)
+        dest[index] = bloom_le_to_cpu(src[index]);
+}
+#endif
+
+static int
+bloom_header_check(const bfdev_bloom_header_t *header, size_t size,
+                   uint32_t hashid)
+{
+    unsigned int capacity;
+
+    if (size < sizeof(*header))
+        return -BFDEV_EBADMSG;
+
+    if (bfport_memcmp(header->magic, BFDEV_BLOOM_MAGIC, sizeof(header->magic)))
+        return -BFDEV_EBADMSG;
+
+    /* the bit index of a key depends on the width of a long */
+    if (bfdev_le16_to_cpu(header->version) != BFDEV_BLOOM_VERSION ||
+        bfdev_le16_to_cpu(header->wordbits) != BFDEV_BITS_PER_LONG)
+        return -BFDEV_EPROTO;
+
+    if (bfdev_le32_to_cpu(header->hashid) != hashid)
+        return -BFDEV_EINVAL;
+
+    /* created filters are whole words, anything else is forged */
+    capacity = bfdev_le32_to_cpu(header->capacity);
+    if (!capacity || capacity % BFDEV_BITS_PER_LONG ||
+        !bfdev_le32_to_cpu(header->funcs) ||
+        bfdev_le64_to_cpu(header->length) != bloom_bitmap_size(capacity) ||
+        size - sizeof(*header) < bloom_bitmap_size(capacity))
+        return -BFDEV_EBADMSG;
+
+    return -BFDEV_ENOERR;
+}
+
 export bool
 bfdev_bloom_peek(bfdev_bloom_t *bloom, void *key)
 {
@@ -57,10 +137,145 @@ bfdev_bloom_flush(bfdev_bloom_t *bloom)
 {
     size_t size;
 
-    size = BFDEV_BITS_WORD(bloom->capacity);
+    size = bloom_bitmap_size(bloom->capacity);
     bfport_memset(bloom->bitmap, 0, size);
 }
 
+export int
+bfdev_bloom_union(bfdev_bloom_t *dest, const bfdev_bloom_t *src)
+{
+    if (!bloom_compatible(dest, src))
+        return -BFDEV_EINVAL;
+
+    bfdev_bitmap_or(dest->bitmap, dest->bitmap, src->bitmap, dest->capacity);
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_bloom_intersect(bfdev_bloom_t *dest, const bfdev_bloom_t *src)
+{
+    if (!bloom_compatible(dest, src))
+        return -BFDEV_EINVAL;
+
+    bfdev_bitmap_and(dest->bitmap, dest->bitmap, src->bitmap, dest->capacity);
+    return -BFDEV_ENOERR;
+}
+
+export size_t
+bfdev_bloom_export_size(const bfdev_bloom_t *bloom)
+{
+    return sizeof(bfdev_bloom_header_t) + bloom_bitmap_size(bloom->capacity);
+}
+
+export int
+bfdev_bloom_export(const bfdev_bloom_t *bloom, void *buff,
+                   size_t size, uint32_t hashid)
+{
+    bfdev_bloom_header_t *header;
+    unsigned long *bitmap;
+    size_t length;
+
+    if (size < bfdev_bloom_export_size(bloom))
+        return -BFDEV_ENOSPC;
+
+    header = buff;
+    bitmap = (void *)(header + 1);
+    length = bloom_bitmap_size(bloom->capacity);
+
+#ifdef __BFDEV_LITTLE_ENDIAN__
+    bfport_memcpy(bitmap, bloom->bitmap, length);
+#else
+    bloom_bitmap_export(bitmap, bloom->bitmap, bloom->capacity);
+#endif
+
+    bfport_memcpy(header->magic, BFDEV_BLOOM_MAGIC, sizeof(header->magic));
+    header->version = bfdev_cpu_to_le16(BFDEV_BLOOM_VERSION);
+    header->wordbits = bfdev_cpu_to_le16(BFDEV_BITS_PER_LONG);
+    header->funcs = bfdev_cpu_to_le32(bloom->funcs);
+    header->hashid = bfdev_cpu_to_le32(hashid);
+    header->capacity = bfdev_cpu_to_le32(bloom->capacity);
+    header->checksum = bfdev_cpu_to_le32(bfdev_crc32c(bitmap, length, 0));
+    header->length = bfdev_cpu_to_le64(length);
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_bloom_check(const void *buff, size_t size, uint32_t hashid)
+{
+    const bfdev_bloom_header_t *header;
+    uint32_t checksum;
+    int retval;
+
+    header = buff;
+    retval = bloom_header_check(header, size, hashid);
+    if (retval)
+        return retval;
+
+    checksum = bfdev_crc32c(header + 1, bfdev_le64_to_cpu(header->length), 0);
+    if (checksum != bfdev_le32_to_cpu(header->checksum))
+        return -BFDEV_EBADMSG;
+
+    return -BFDEV_ENOERR;
+}
+
+export bfdev_bloom_t *
+bfdev_bloom_import(const bfdev_alloc_t *alloc, const void *buff, size_t size,
+                   bfdev_bloom_hash_t hash, uint32_t hashid, void *pdata)
+{
+    const bfdev_bloom_header_t *header;
+    bfdev_bloom_t *bloom;
+
+    if (bfdev_bloom_check(buff, size, hashid))
+        return NULL;
+
+    header = buff;
+    bloom = bfdev_bloom_create(alloc, bfdev_le32_to_cpu(header->capacity),
+                               hash, bfdev_le32_to_cpu(header->funcs), pdata);
+    if (bfdev_unlikely(!bloom))
+        return NULL;
+
+#ifdef __BFDEV_LITTLE_ENDIAN__
+    bfport_memcpy(bloom->bitmap, header + 1,
+                  bloom_bitmap_size(bloom->capacity));
+#else
+    bloom_bitmap_import(bloom->bitmap, (const void *)(header + 1),
+                        bloom->capacity);
+#endif
+
+    return bloom;
+}
+
+export int
+bfdev_bloom_attach(bfdev_bloom_t *bloom, void *buff, size_t size,
+                   bfdev_bloom_hash_t hash, uint32_t hashid, void *pdata)
+{
+#ifdef __BFDEV_BIG_ENDIAN__
+    /* the bitmap is used in place, so its words must be native */
+    return -BFDEV_EOPNOTSUPP;
+#else
+    bfdev_bloom_header_t *header;
+    int retval;
+
+    header = buff;
+    retval = bloom_header_check(header, size, hashid);
+    if (retval)
+        return retval;
+
+    if (!bfdev_align_ptr_check(header + 1, BFDEV_BYTES_PER_LONG))
+        return -BFDEV_EINVAL;
+
+    bloom->alloc = NULL;
+    bloom->hash = hash;
+    bloom->funcs = bfdev_le32_to_cpu(header->funcs);
+    bloom->pdata = pdata;
+    bloom->capacity = bfdev_le32_to_cpu(header->capacity);
+    bloom->bitmap = (void *)(header + 1);
+
+    return -BFDEV_ENOERR;
+#endif
+}
+
 export bfdev_bloom_t *
 bfdev_bloom_create(const bfdev_alloc_t *alloc, unsigned int capacity,
                    bfdev_bloom_hash_t hash, unsigned int funcs, void *pdata)
@@ -68,14 +283,19 @@ bfdev_bloom_create(const bfdev_alloc_t *alloc, unsigned int capacity,
     bfdev_bloom_t *bloom;
     size_t size;
 
+    /* rounding up to whole words must not wrap to zero */
+    if (bfdev_unlikely(capacity > BFDEV_UINT_MAX - (BFDEV_BITS_PER_LONG - 1)))
+        return NULL;
+
     bfdev_align_high_adj(capacity, BFDEV_BITS_PER_LONG);
     size = BFDEV_BITS_DIV_LONG(capacity);
 
-    bloom = bfdev_zalloc(alloc, sizeof(*bloom) + sizeof(*bloom->bitmap) * size);
+    bloom = bfdev_zalloc(alloc, sizeof(*bloom) + sizeof(*bloom->memory) * size);
     if (bfdev_unlikely(!bloom))
         return NULL;
 
     bloom->capacity = capacity;
+    bloom->bitmap = bloom->memory;
     bloom->alloc = alloc;
     bloom->hash = hash;
     bloom->funcs = funcs;
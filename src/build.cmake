@@ -18,21 +18,31 @@ set(BFDEV_SOURCE
     ${CMAKE_CURRENT_LIST_DIR}/btree.c
     ${CMAKE_CURRENT_LIST_DIR}/btree-utils.c
     ${CMAKE_CURRENT_LIST_DIR}/dword.c
+    ${CMAKE_CURRENT_LIST_DIR}/ebr.c
     ${CMAKE_CURRENT_LIST_DIR}/callback.c
+    ${CMAKE_CURRENT_LIST_DIR}/cpufeature.c
+    ${CMAKE_CURRENT_LIST_DIR}/dheap.c
+    ${CMAKE_CURRENT_LIST_DIR}/dispatch.c
     ${CMAKE_CURRENT_LIST_DIR}/errname.c
     ${CMAKE_CURRENT_LIST_DIR}/fifo.c
     ${CMAKE_CURRENT_LIST_DIR}/fsm.c
+    ${CMAKE_CURRENT_LIST_DIR}/fskiplist.c
     ${CMAKE_CURRENT_LIST_DIR}/hashmap.c
     ${CMAKE_CURRENT_LIST_DIR}/heap.c
     ${CMAKE_CURRENT_LIST_DIR}/ilist.c
     ${CMAKE_CURRENT_LIST_DIR}/jhash.c
     ${CMAKE_CURRENT_LIST_DIR}/levenshtein.c
+    ${CMAKE_CURRENT_LIST_DIR}/lfskiplist.c
     ${CMAKE_CURRENT_LIST_DIR}/list-sort.c
     ${CMAKE_CURRENT_LIST_DIR}/llist.c
     ${CMAKE_CURRENT_LIST_DIR}/matrix.c
     ${CMAKE_CURRENT_LIST_DIR}/memalloc.c
     ${CMAKE_CURRENT_LIST_DIR}/mpi.c
+    ${CMAKE_CURRENT_LIST_DIR}/mpmc.c
+    ${CMAKE_CURRENT_LIST_DIR}/mpsc.c
+    ${CMAKE_CURRENT_LIST_DIR}/notifier-rcu.c
     ${CMAKE_CURRENT_LIST_DIR}/notifier.c
+    ${CMAKE_CURRENT_LIST_DIR}/percpu.c
     ${CMAKE_CURRENT_LIST_DIR}/popcount.c
     ${CMAKE_CURRENT_LIST_DIR}/prandom.c
     ${CMAKE_CURRENT_LIST_DIR}/radix.c
@@ -46,7 +56,9 @@ set(BFDEV_SOURCE
     ${CMAKE_CURRENT_LIST_DIR}/skiplist.c
     ${CMAKE_CURRENT_LIST_DIR}/sort.c
     ${CMAKE_CURRENT_LIST_DIR}/stringhash.c
+    ${CMAKE_CURRENT_LIST_DIR}/timewheel.c
     ${CMAKE_CURRENT_LIST_DIR}/tokenbucket.c
+    ${CMAKE_CURRENT_LIST_DIR}/wspool.c
 )
 
 if(BFDEV_DEBUG_LIST)
@@ -86,6 +98,8 @@ endif()
 
 include(${CMAKE_CURRENT_LIST_DIR}/cache/build.cmake)
 include(${CMAKE_CURRENT_LIST_DIR}/crypto/build.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/filter/build.cmake)
 include(${CMAKE_CURRENT_LIST_DIR}/libc/build.cmake)
 include(${CMAKE_CURRENT_LIST_DIR}/log/build.cmake)
 include(${CMAKE_CURRENT_LIST_DIR}/textsearch/build.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/xxhash/build.cmake)
@@ -152,6 +152,8 @@ bfdev_cache_obtain(bfdev_cache_head_t *head, const void *tag, unsigned long flag
     node = cache_lookup(head, tag, true);
     if (bfdev_likely(node)) {
         head->hits++;
+        if (head->stat_hits)
+            bfdev_percpu_counter_inc(head->stat_hits, head->stat_cpu);
 
         if (node->status == BFDEV_CACHE_PENDING) {
             if (!bfdev_cache_uncommitted_test(&flags))
@@ -178,6 +180,9 @@ bfdev_cache_obtain(bfdev_cache_head_t *head, const void *tag, unsigned long flag
     }
 
     head->misses++;
+    if (head->stat_misses)
+        bfdev_percpu_counter_inc(head->stat_misses, head->stat_cpu);
+
     if (!bfdev_cache_change_test(&flags))
         return NULL;
 
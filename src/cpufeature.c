@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/cpufeature.h>
+#include <bfdev/asm/cpufeature.h>
+#include <bfdev/atomic.h>
+#include <export.h>
+
+/* set once probed, so a cpu without any feature is not probed again */
+#define CPU_FEATURE_PROBED BFDEV_CPU_FEATURE(63)
+
+static const char *
+cpu_feature_names[BFDEV_CPU_FEATURE_NR] = {
+    [BFDEV_CPU_SSE2] = "sse2",
+    [BFDEV_CPU_SSSE3] = "ssse3",
+    [BFDEV_CPU_SSE41] = "sse4.1",
+    [BFDEV_CPU_SSE42] = "sse4.2",
+    [BFDEV_CPU_POPCNT] = "popcnt",
+    [BFDEV_CPU_PCLMUL] = "pclmul",
+    [BFDEV_CPU_AESNI] = "aesni",
+    [BFDEV_CPU_SHANI] = "shani",
+    [BFDEV_CPU_AVX] = "avx",
+    [BFDEV_CPU_AVX2] = "avx2",
+    [BFDEV_CPU_BMI2] = "bmi2",
+    [BFDEV_CPU_AVX512F] = "avx512f",
+    [BFDEV_CPU_AVX512BW] = "avx512bw",
+    [BFDEV_CPU_AVX512VL] = "avx512vl",
+    [BFDEV_CPU_VPCLMUL] = "vpclmul",
+    [BFDEV_CPU_NEON] = "neon",
+    [BFDEV_CPU_CRC32] = "crc32",
+    [BFDEV_CPU_PMULL] = "pmull",
+    [BFDEV_CPU_AES] = "aes",
+    [BFDEV_CPU_SHA1] = "sha1",
+    [BFDEV_CPU_SHA2] = "sha2",
+};
+
+static uint64_t
+cpu_features;
+
+static uint64_t
+cpu_feature_find(const char *name, size_t length)
+{
+    unsigned int feature;
+    const char *walk;
+
+    for (feature = 0; feature < BFDEV_CPU_FEATURE_NR; ++feature) {
+        walk = cpu_feature_names[feature];
+        if (walk && bfport_strlen(walk) == length &&
+            !bfport_memcmp(walk, name, length))
+            return BFDEV_CPU_FEATURE(feature);
+    }
+
+    return 0;
+}
+
+static uint64_t
+cpu_feature_mask(const char *list)
+{
+    uint64_t mask;
+    size_t length;
+
+    for (mask = 0; *list; list += length) {
+        list += bfport_strspn(list, ", ");
+        length = bfport_strcspn(list, ", ");
+        mask |= cpu_feature_find(list, length);
+    }
+
+    return mask;
+}
+
+export uint64_t
+bfdev_cpu_features(void)
+{
+    uint64_t features;
+    const char *mask;
+
+    features = BFDEV_READ_ONCE(cpu_features);
+    if (bfdev_likely(features))
+        return features & ~CPU_FEATURE_PROBED;
+
+    /* racing callers all come to the same result */
+    features = bfdev_arch_cpu_probe();
+
+    mask = bfport_getenv("BFDEV_CPU_MASK");
+    if (mask)
+        features &= ~cpu_feature_mask(mask);
+
+    BFDEV_WRITE_ONCE(cpu_features, features | CPU_FEATURE_PROBED);
+
+    return features;
+}
+
+export const char *
+bfdev_cpu_feature_name(enum bfdev_cpu_feature feature)
+{
+    if ((unsigned int)feature >= BFDEV_CPU_FEATURE_NR)
+        return NULL;
+
+    return cpu_feature_names[feature];
+}
@@ -6,103 +6,243 @@
 #include <base.h>
 #include <bfdev/ascii85.h>
 #include <bfdev/math.h>
-#include <bfdev/bits.h>
 #include <bfdev/unaligned.h>
 #include <export.h>
 
-static __bfdev_always_inline void
-ascii85_encode(uint8_t *buff, const void *data, size_t *plen, size_t size)
+static __bfdev_always_inline size_t
+ascii85_encode_group(uint8_t *buff, uint32_t value)
 {
-    uint32_t value;
-    size_t index;
+    if (!value) {
+        *buff = 'z';
+        return 1;
+    }
 
-    for (index = 0; size >= 4; size -= 4) {
-        value = bfdev_unaligned_get_be32(data);
-        data += 4;
+    buff[4] = '!' + value % 85; value /= 85;
+    buff[3] = '!' + value % 85; value /= 85;
+    buff[2] = '!' + value % 85; value /= 85;
+    buff[1] = '!' + value % 85; value /= 85;
+    buff[0] = '!' + value % 85;
 
-        if (!value)
-            buff[index] = 'z';
-        else {
-            buff[index + 4] = '!' + value % 85; value /= 85;
-            buff[index + 3] = '!' + value % 85; value /= 85;
-            buff[index + 2] = '!' + value % 85; value /= 85;
-            buff[index + 1] = '!' + value % 85; value /= 85;
-            buff[index] = '!' + value % 85;
-            index += 4;
-        }
+    return 5;
+}
 
-        index++;
-    }
+static __bfdev_always_inline bool
+ascii85_digit_valid(uint8_t digit)
+{
+    return '!' <= digit && digit <= 'u';
+}
 
-    if (size) {
-        value = bfdev_unaligned_get_be32(data);
-        value &= BFDEV_BIT_HIGH_MASK((BFDEV_BYTES_PER_U32 - size) * BFDEV_BITS_PER_BYTE);
-
-        if (!value)
-            buff[index] = 'z';
-        else {
-            buff[index + 4] = '!' + value % 85; value /= 85;
-            buff[index + 3] = '!' + value % 85; value /= 85;
-            buff[index + 2] = '!' + value % 85; value /= 85;
-            buff[index + 1] = '!' + value % 85; value /= 85;
-            buff[index] = '!' + value % 85;
-            index += 4;
-        }
+static size_t
+ascii85_encode_blocks(uint8_t *buff, const uint8_t *data,
+                      size_t *plen, size_t size)
+{
+    const uint8_t *start;
+    size_t index;
 
-        index++;
+    for (start = data, index = 0; size >= 4; size -= 4) {
+        index += ascii85_encode_group(buff + index,
+                                      bfdev_unaligned_get_be32(data));
+        data += 4;
     }
 
     *plen = index;
+
+    return data - start;
 }
 
-static __bfdev_always_inline int
-ascii85_decode(void *buff, const uint8_t *data, size_t *plen, size_t size)
+static size_t
+ascii85_decode_blocks(uint8_t *buff, const uint8_t *data,
+                      size_t *plen, size_t size)
 {
+    const uint8_t *start;
     unsigned int count;
     uint32_t value;
     size_t index;
 
-    for (index = 0; size; index += 4) {
+    for (start = data, index = 0; size; index += 4) {
         if (*data == 'z') {
             bfport_memset(buff + index, 0, 4);
             data++;
             size--;
+            continue;
         }
 
-        if (size >= 5) {
-            for (count = 0; count < 5; ++count) {
-                if (data[count] < '!' || 'u' < data[count])
-                    return -BFDEV_EINVAL;
-            }
-
-            value = data[0] - '!'; value *= 85;
-            value += data[1] - '!'; value *= 85;
-            value += data[2] - '!'; value *= 85;
-            value += data[3] - '!'; value *= 85;
-            value += data[4] - '!';
-            bfdev_unaligned_set_be32(buff + index, value);
-
-            data += 5;
-            size -= 5;
-            continue;
+        if (size < 5)
+            break;
+
+        for (count = 0; count < 5; ++count) {
+            if (!ascii85_digit_valid(data[count]))
+                goto finish;
         }
 
-        return -BFDEV_EPROTO;
+        value = data[0] - '!'; value *= 85;
+        value += data[1] - '!'; value *= 85;
+        value += data[2] - '!'; value *= 85;
+        value += data[3] - '!'; value *= 85;
+        value += data[4] - '!';
+        bfdev_unaligned_set_be32(buff + index, value);
+
+        data += 5;
+        size -= 5;
     }
 
+finish:
     *plen = index;
 
+    return data - start;
+}
+
+export void
+bfdev_ascii85_init(bfdev_ascii85_ctx_t *ctx)
+{
+    ctx->count = 0;
+}
+
+export size_t
+bfdev_ascii85_encode_update(bfdev_ascii85_ctx_t *ctx, void *buff,
+                            const void *data, size_t size)
+{
+    const uint8_t *src;
+    uint8_t *dest;
+    size_t done, length;
+
+    src = data;
+    dest = buff;
+
+    if (ctx->count) {
+        while (size && ctx->count < 4) {
+            ctx->pend[ctx->count++] = *src++;
+            size--;
+        }
+
+        if (ctx->count < 4)
+            return 0;
+
+        dest += ascii85_encode_group(dest,
+                                     bfdev_unaligned_get_be32(ctx->pend));
+        ctx->count = 0;
+    }
+
+    done = ascii85_encode_blocks(dest, src, &length, size);
+    dest += length;
+    src += done;
+    size -= done;
+
+    bfport_memcpy(ctx->pend, src, size);
+    ctx->count = size;
+
+    return dest - (uint8_t *)buff;
+}
+
+export size_t
+bfdev_ascii85_encode_finish(bfdev_ascii85_ctx_t *ctx, void *buff)
+{
+    unsigned int count;
+
+    count = ctx->count;
+    if (!count)
+        return 0;
+
+    /* a short group is encoded whole, zero filled */
+    bfport_memset(ctx->pend + count, 0, 4 - count);
+    ctx->count = 0;
+
+    return ascii85_encode_group(buff, bfdev_unaligned_get_be32(ctx->pend));
+}
+
+export int
+bfdev_ascii85_decode_update(bfdev_ascii85_ctx_t *ctx, void *buff,
+                            const void *data, size_t *plen, size_t size)
+{
+    const uint8_t *src;
+    uint8_t *dest;
+    size_t done, length;
+    uint32_t value;
+    unsigned int count;
+    int retval;
+
+    retval = -BFDEV_ENOERR;
+    src = data;
+    dest = buff;
+
+    while (size) {
+        if (!ctx->count) {
+            done = ascii85_decode_blocks(dest, src, &length, size);
+            dest += length;
+            src += done;
+            size -= done;
+            if (!size)
+                break;
+        }
+
+        /* a group split by the caller or garbage */
+        if (bfdev_unlikely(!ascii85_digit_valid(*src))) {
+            retval = -BFDEV_EINVAL;
+            break;
+        }
+
+        ctx->pend[ctx->count++] = *src++;
+        size--;
+
+        if (ctx->count == 5) {
+            for (value = count = 0; count < 5; ++count)
+                value = value * 85 + ctx->pend[count] - '!';
+            bfdev_unaligned_set_be32(dest, value);
+            ctx->count = 0;
+            dest += 4;
+        }
+    }
+
+    *plen = dest - (uint8_t *)buff;
+
+    return retval;
+}
+
+export int
+bfdev_ascii85_decode_finish(bfdev_ascii85_ctx_t *ctx, void *buff,
+                            size_t *plen)
+{
+    unsigned int count;
+
+    count = ctx->count;
+    ctx->count = 0;
+
+    if (count)
+        return -BFDEV_EPROTO;
+
+    *plen = 0;
+
     return -BFDEV_ENOERR;
 }
 
 export void
 bfdev_ascii85_encode(void *buff, const void *data, size_t *plen, size_t size)
 {
-    ascii85_encode(buff, data, plen, size);
+    bfdev_ascii85_ctx_t ctx;
+    size_t length;
+
+    bfdev_ascii85_init(&ctx);
+    length = bfdev_ascii85_encode_update(&ctx, buff, data, size);
+    *plen = length + bfdev_ascii85_encode_finish(&ctx, buff + length);
 }
 
 export int
 bfdev_ascii85_decode(void *buff, const void *data, size_t *plen, size_t size)
 {
-    return ascii85_decode(buff, data, plen, size);
+    bfdev_ascii85_ctx_t ctx;
+    size_t length, tail;
+    int retval;
+
+    bfdev_ascii85_init(&ctx);
+    retval = bfdev_ascii85_decode_update(&ctx, buff, data, &length, size);
+    if (retval)
+        return retval;
+
+    retval = bfdev_ascii85_decode_finish(&ctx, buff + length, &tail);
+    if (retval)
+        return retval;
+
+    *plen = length + tail;
+
+    return -BFDEV_ENOERR;
 }
@@ -28,157 +28,235 @@ base32_decode_table[256] = {
     ['4'] = 0x1c, ['5'] = 0x1d, ['6'] = 0x1e, ['7'] = 0x1f,
 };
 
-static __bfdev_always_inline void
-base32_encode(uint8_t *buff, const uint8_t *data, size_t size)
+/* characters carrying data for each length of a short group */
+static const uint8_t
+base32_tail_digits[5] = {
+    0, 2, 4, 5, 7,
+};
+
+static size_t
+base32_encode_blocks(uint8_t *buff, const uint8_t *data, size_t size)
 {
-    const uint8_t *prev;
-    unsigned int bstate;
-
-    prev = data;
-    for (; size >= 5; size -= 5) {
-        *buff++ = base32_encode_table[*data++ >> 3];
-        *buff++ = base32_encode_table[((*prev++ & 0x7) << 2) | (*data++ >> 6)];
-        *buff++ = base32_encode_table[(*prev >> 1) & 0x1f];
-        *buff++ = base32_encode_table[((*prev++ & 0x1) << 4) | (*data++ >> 4)];
-        *buff++ = base32_encode_table[((*prev++ & 0xf) << 1) | (*data++ >> 7)];
-        *buff++ = base32_encode_table[(*prev >> 2) & 0x1f];
-        *buff++ = base32_encode_table[((*prev++ & 0x3) << 3) | (*data++ >> 5)];
-        *buff++ = base32_encode_table[*prev++ & 0x1f];
+    const uint8_t *start;
+    uint64_t value;
+
+    for (start = data; size >= 5; size -= 5) {
+        value = (uint64_t)data[0] << 32 | (uint32_t)data[1] << 24 |
+                data[2] << 16 | data[3] << 8 | data[4];
+
+        buff[0] = base32_encode_table[(value >> 35) & 0x1f];
+        buff[1] = base32_encode_table[(value >> 30) & 0x1f];
+        buff[2] = base32_encode_table[(value >> 25) & 0x1f];
+        buff[3] = base32_encode_table[(value >> 20) & 0x1f];
+        buff[4] = base32_encode_table[(value >> 15) & 0x1f];
+        buff[5] = base32_encode_table[(value >> 10) & 0x1f];
+        buff[6] = base32_encode_table[(value >> 5) & 0x1f];
+        buff[7] = base32_encode_table[value & 0x1f];
+        buff += 8;
+        data += 5;
     }
 
-    bstate = 0;
-    while (size--) switch (bstate) {
-        case 0:
-            *buff++ = base32_encode_table[*data++ >> 3];
-            bstate = 1;
-            break;
+    return data - start;
+}
 
-        case 1:
-            *buff++ = base32_encode_table[((*prev++ & 0x7) << 2) | (*data++ >> 6)];
-            *buff++ = base32_encode_table[(*prev >> 1) & 0x1f];
-            bstate = 2;
-            break;
+static size_t
+base32_decode_blocks(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    unsigned int count;
+    uint64_t value;
+    uint8_t check;
 
-        case 2:
-            *buff++ = base32_encode_table[((*prev++ & 0x1) << 4) | (*data++ >> 4)];
-            bstate = 3;
-            break;
+    for (start = data; size >= 8; size -= 8) {
+        value = check = 0;
+        for (count = 0; count < 8; ++count) {
+            check |= base32_decode_table[data[count]];
+            value = value << 5 | (base32_decode_table[data[count]] & 0x1f);
+        }
 
-        case 3:
-            *buff++ = base32_encode_table[((*prev++ & 0xf) << 1) | (*data++ >> 7)];
-            *buff++ = base32_encode_table[(*prev >> 2) & 0x1f];
-            bstate = 4;
+        /* invalid digits are the only ones with the top bit set */
+        if (bfdev_unlikely(check & 0x80))
             break;
 
-        default:
-            *buff++ = base32_encode_table[((*prev++ & 0x3) << 3) | (*data++ >> 5)];
-            *buff++ = base32_encode_table[*prev++ & 0x1f];
-            bstate = 0;
-            break;
+        buff[0] = value >> 32;
+        buff[1] = value >> 24;
+        buff[2] = value >> 16;
+        buff[3] = value >> 8;
+        buff[4] = value;
+        buff += 5;
+        data += 8;
     }
 
-    switch (bstate) {
-        case 1:
-            *buff++ = base32_encode_table[(*prev & 0x7) << 2];
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff = '=';
-            break;
+    return data - start;
+}
 
-        case 2:
-            *buff++ = base32_encode_table[(*prev & 0x1) << 4];
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff = '=';
-            break;
+static size_t
+base32_encode_tail(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    uint8_t group[5] = {};
+    unsigned int count;
 
-        case 3:
-            *buff++ = base32_encode_table[(*prev & 0xf) << 1];
-            *buff++ = '=';
-            *buff++ = '=';
-            *buff = '=';
-            break;
+    if (!size)
+        return 0;
 
-        case 4:
-            *buff++ = base32_encode_table[(*prev & 0x3) << 3];
-            *buff = '=';
-            break;
+    bfport_memcpy(group, data, size);
+    base32_encode_blocks(buff, group, 5);
 
-        default:
-            break;
-    }
+    for (count = base32_tail_digits[size]; count < 8; ++count)
+        buff[count] = '=';
+
+    return 8;
 }
 
-static __bfdev_always_inline int
-base32_decode(uint8_t *buff, const uint8_t *data, size_t size)
+export void
+bfdev_base32_init(bfdev_base32_ctx_t *ctx)
 {
-    unsigned int bstate;
-    uint8_t decode;
-
-    bstate = 0;
-    while (size--) {
-        decode = base32_decode_table[*data];
-        if (decode == 0xff) {
-            if (bfdev_likely(*data == '='))
-                break;
-            return -BFDEV_EINVAL;
+    ctx->count = 0;
+    ctx->padding = false;
+}
+
+export size_t
+bfdev_base32_encode_update(bfdev_base32_ctx_t *ctx, void *buff,
+                           const void *data, size_t size)
+{
+    const uint8_t *src;
+    uint8_t *dest;
+    size_t done;
+
+    src = data;
+    dest = buff;
+
+    if (ctx->count) {
+        while (size && ctx->count < 5) {
+            ctx->pend[ctx->count++] = *src++;
+            size--;
         }
 
-        data++;
-        switch (bstate++ & 0x7) {
-            case 0:
-                *buff = decode << 3;
-                break;
+        if (ctx->count < 5)
+            return 0;
 
-            case 1:
-                *buff++ |= (decode >> 2) & 0x7;
-                *buff = decode << 6;
-                break;
+        base32_encode_blocks(dest, ctx->pend, 5);
+        ctx->count = 0;
+        dest += 8;
+    }
 
-            case 2:
-                *buff |= (decode & 0x1f) << 1;
-                break;
+    done = base32_encode_blocks(dest, src, size);
+    dest += done / 5 * 8;
+    src += done;
+    size -= done;
 
-            case 3:
-                *buff++ |= (decode >> 4) & 0x1;
-                *buff = decode << 4;
-                break;
+    bfport_memcpy(ctx->pend, src, size);
+    ctx->count = size;
 
-            case 4:
-                *buff++ |= (decode >> 1) & 0xf;
-                *buff = decode << 7;
-                break;
+    return dest - (uint8_t *)buff;
+}
 
-            case 5:
-                *buff |= (decode & 0x1f) << 2;
-                break;
+export size_t
+bfdev_base32_encode_finish(bfdev_base32_ctx_t *ctx, void *buff)
+{
+    size_t length;
+
+    length = base32_encode_tail(buff, ctx->pend, ctx->count);
+    ctx->count = 0;
+
+    return length;
+}
 
-            case 6:
-                *buff++ |= (decode >> 3) & 0x3;
-                *buff = decode << 5;
+export int
+bfdev_base32_decode_update(bfdev_base32_ctx_t *ctx, void *buff,
+                           const void *data, size_t *plen, size_t size)
+{
+    const uint8_t *src;
+    uint8_t *dest;
+    size_t done;
+    int retval;
+
+    retval = -BFDEV_ENOERR;
+    src = data;
+    dest = buff;
+
+    while (size && !ctx->padding) {
+        if (!ctx->count) {
+            done = base32_decode_blocks(dest, src, size);
+            dest += done / 8 * 5;
+            src += done;
+            size -= done;
+            if (!size)
                 break;
+        }
 
-            default:
-                *buff++ |= decode & 0x1f;
+        /* a group split by the caller, a pad or garbage */
+        if (base32_decode_table[*src] == 0xff) {
+            if (bfdev_unlikely(*src != '=')) {
+                retval = -BFDEV_EINVAL;
                 break;
+            }
+            ctx->padding = true;
+            break;
+        }
+
+        ctx->pend[ctx->count++] = *src++;
+        size--;
+
+        if (ctx->count == 8) {
+            base32_decode_blocks(dest, ctx->pend, 8);
+            ctx->count = 0;
+            dest += 5;
         }
     }
 
+    *plen = dest - (uint8_t *)buff;
+
+    return retval;
+}
+
+export int
+bfdev_base32_decode_finish(bfdev_base32_ctx_t *ctx, void *buff,
+                           size_t *plen)
+{
+    uint8_t group[5];
+    unsigned int count, length;
+
+    count = ctx->count;
+    bfdev_base32_init(ctx);
+
+    for (length = 0; length < 5; ++length) {
+        if (base32_tail_digits[length] == count)
+            break;
+    }
+
+    if (length == 5)
+        return -BFDEV_EPROTO;
+
+    /* fill up with zero digits */
+    bfport_memset(ctx->pend + count, 'A', 8 - count);
+    base32_decode_blocks(group, ctx->pend, 8);
+    bfport_memcpy(buff, group, length);
+    *plen = length;
+
     return -BFDEV_ENOERR;
 }
 
 export void
 bfdev_base32_encode(void *buff, const void *data, size_t size)
 {
-    base32_encode(buff, data, size);
+    size_t done;
+
+    done = base32_encode_blocks(buff, data, size);
+    base32_encode_tail(buff + done / 5 * 8, data + done, size - done);
 }
 
 export int
 bfdev_base32_decode(void *buff, const void *data, size_t size)
 {
-    return base32_decode(buff, data, size);
+    bfdev_base32_ctx_t ctx;
+    size_t length, tail;
+    int retval;
+
+    bfdev_base32_init(&ctx);
+    retval = bfdev_base32_decode_update(&ctx, buff, data, &length, size);
+    if (retval)
+        return retval;
+
+    return bfdev_base32_decode_finish(&ctx, buff + length, &tail);
 }
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_BASE64_ACCEL_H_
+#define _LOCAL_BASE64_ACCEL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+#if defined(__x86_64__) && defined(__GNUC__)
+# define BASE64_ACCEL_X86
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+# define BASE64_ACCEL_ARM64
+#endif
+
+/*
+ * base64_encode_*() - encode whole groups of three bytes.
+ * @buff: receives four characters per group.
+ * @data: data to encode.
+ * @size: length of @data, a trailing partial group is left alone.
+ *
+ * Return the number of bytes consumed, a multiple of three.
+ */
+
+typedef size_t
+(*base64_encode_t)(uint8_t *buff, const uint8_t *data, size_t size);
+
+/*
+ * base64_decode_*() - decode whole groups of four valid digits.
+ * @buff: receives three bytes per group.
+ * @data: characters to decode.
+ * @size: length of @data.
+ *
+ * Decoding stops in front of the first group holding anything but a
+ * digit, that group is left to the caller. Vector stores may write
+ * ahead, but never past the bytes all whole groups of @data decode to.
+ *
+ * Return the number of characters consumed, a multiple of four.
+ */
+
+typedef size_t
+(*base64_decode_t)(uint8_t *buff, const uint8_t *data, size_t size);
+
+struct base64_ops {
+    base64_encode_t encode;
+    base64_decode_t decode;
+};
+
+extern hidden size_t
+base64_encode_generic(uint8_t *buff, const uint8_t *data, size_t size);
+
+extern hidden size_t
+base64_decode_generic(uint8_t *buff, const uint8_t *data, size_t size);
+
+#ifdef BASE64_ACCEL_X86
+extern hidden size_t
+base64_encode_ssse3(uint8_t *buff, const uint8_t *data, size_t size);
+
+extern hidden size_t
+base64_decode_ssse3(uint8_t *buff, const uint8_t *data, size_t size);
+
+extern hidden size_t
+base64_encode_avx2(uint8_t *buff, const uint8_t *data, size_t size);
+
+extern hidden size_t
+base64_decode_avx2(uint8_t *buff, const uint8_t *data, size_t size);
+#endif
+
+#ifdef BASE64_ACCEL_ARM64
+extern hidden size_t
+base64_encode_neon(uint8_t *buff, const uint8_t *data, size_t size);
+
+extern hidden size_t
+base64_decode_neon(uint8_t *buff, const uint8_t *data, size_t size);
+#endif
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_BASE64_ACCEL_H_ */
@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include "base64-accel.h"
+#include <export.h>
+
+#ifdef BASE64_ACCEL_ARM64
+#include <arm_neon.h>
+
+static const uint8_t
+neon_encode_table[64] = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
+    'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
+    'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
+    'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3',
+    '4', '5', '6', '7', '8', '9', '+', '/',
+};
+
+/* only the ascii half, the rest is caught by its top bit */
+static const uint8_t
+neon_decode_table[128] = {
+    [0 ... 127] = 0xff,
+    ['A'] = 0x00, ['B'] = 0x01, ['C'] = 0x02, ['D'] = 0x03,
+    ['E'] = 0x04, ['F'] = 0x05, ['G'] = 0x06, ['H'] = 0x07,
+    ['I'] = 0x08, ['J'] = 0x09, ['K'] = 0x0a, ['L'] = 0x0b,
+    ['M'] = 0x0c, ['N'] = 0x0d, ['O'] = 0x0e, ['P'] = 0x0f,
+    ['Q'] = 0x10, ['R'] = 0x11, ['S'] = 0x12, ['T'] = 0x13,
+    ['U'] = 0x14, ['V'] = 0x15, ['W'] = 0x16, ['X'] = 0x17,
+    ['Y'] = 0x18, ['Z'] = 0x19, ['a'] = 0x1a, ['b'] = 0x1b,
+    ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+    ['g'] = 0x20, ['h'] = 0x21, ['i'] = 0x22, ['j'] = 0x23,
+    ['k'] = 0x24, ['l'] = 0x25, ['m'] = 0x26, ['n'] = 0x27,
+    ['o'] = 0x28, ['p'] = 0x29, ['q'] = 0x2a, ['r'] = 0x2b,
+    ['s'] = 0x2c, ['t'] = 0x2d, ['u'] = 0x2e, ['v'] = 0x2f,
+    ['w'] = 0x30, ['x'] = 0x31, ['y'] = 0x32, ['z'] = 0x33,
+    ['0'] = 0x34, ['1'] = 0x35, ['2'] = 0x36, ['3'] = 0x37,
+    ['4'] = 0x38, ['5'] = 0x39, ['6'] = 0x3a, ['7'] = 0x3b,
+    ['8'] = 0x3c, ['9'] = 0x3d, ['+'] = 0x3e, ['/'] = 0x3f,
+};
+
+static inline uint8x16x4_t
+neon_table_load(const uint8_t *table)
+{
+    uint8x16x4_t value;
+
+    value.val[0] = vld1q_u8(table);
+    value.val[1] = vld1q_u8(table + 16);
+    value.val[2] = vld1q_u8(table + 32);
+    value.val[3] = vld1q_u8(table + 48);
+
+    return value;
+}
+
+/*
+ * The structured loads and stores deinterleave 16 groups at once, so
+ * every field sits in a register of its own and the whole alphabet
+ * fits into a four register table lookup.
+ */
+hidden size_t
+base64_encode_neon(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    uint8x16x4_t table, out;
+    uint8x16x3_t in;
+
+    table = neon_table_load(neon_encode_table);
+    for (start = data; size >= 48; size -= 48) {
+        in = vld3q_u8(data);
+
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vorrq_u8(vshrq_n_u8(in.val[1], 4),
+                              vandq_u8(vshlq_n_u8(in.val[0], 4),
+                                       vdupq_n_u8(0x30)));
+        out.val[2] = vorrq_u8(vshrq_n_u8(in.val[2], 6),
+                              vandq_u8(vshlq_n_u8(in.val[1], 2),
+                                       vdupq_n_u8(0x3c)));
+        out.val[3] = vandq_u8(in.val[2], vdupq_n_u8(0x3f));
+
+        out.val[0] = vqtbl4q_u8(table, out.val[0]);
+        out.val[1] = vqtbl4q_u8(table, out.val[1]);
+        out.val[2] = vqtbl4q_u8(table, out.val[2]);
+        out.val[3] = vqtbl4q_u8(table, out.val[3]);
+
+        vst4q_u8(buff, out);
+        buff += 64;
+        data += 48;
+    }
+
+    return data - start + base64_encode_generic(buff, data, size);
+}
+
+static inline uint8x16_t
+neon_decode_lookup(uint8x16x4_t low, uint8x16x4_t high, uint8x16_t in)
+{
+    uint8x16_t value, sign;
+
+    /* out of range indexes read zero or keep the previous result */
+    value = vqtbl4q_u8(low, in);
+    value = vqtbx4q_u8(value, high, vsubq_u8(in, vdupq_n_u8(64)));
+    sign = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(in), 7));
+
+    return vorrq_u8(value, sign);
+}
+
+hidden size_t
+base64_decode_neon(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    uint8x16x4_t low, high, in;
+    const uint8_t *start;
+    uint8x16x3_t out;
+    uint8x16_t check;
+
+    low = neon_table_load(neon_decode_table);
+    high = neon_table_load(neon_decode_table + 64);
+
+    for (start = data; size >= 64; size -= 64) {
+        in = vld4q_u8(data);
+
+        in.val[0] = neon_decode_lookup(low, high, in.val[0]);
+        in.val[1] = neon_decode_lookup(low, high, in.val[1]);
+        in.val[2] = neon_decode_lookup(low, high, in.val[2]);
+        in.val[3] = neon_decode_lookup(low, high, in.val[3]);
+
+        check = vorrq_u8(vorrq_u8(in.val[0], in.val[1]),
+                         vorrq_u8(in.val[2], in.val[3]));
+        if (vmaxvq_u8(check) & 0x80)
+            break;
+
+        out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2),
+                              vshrq_n_u8(in.val[1], 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4),
+                              vshrq_n_u8(in.val[2], 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+
+        vst3q_u8(buff, out);
+        buff += 48;
+        data += 64;
+    }
+
+    return data - start + base64_decode_generic(buff, data, size);
+}
+
+#endif /* BASE64_ACCEL_ARM64 */
@@ -0,0 +1,285 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include "base64-accel.h"
+#include <export.h>
+
+#ifdef BASE64_ACCEL_X86
+#include <immintrin.h>
+
+#define SSSE3_TARGET __bfdev_target("ssse3")
+#define AVX2_TARGET __bfdev_target("avx2")
+
+/*
+ * Encoding follows Wojciech Muła: every 32-bit lane gathers three
+ * bytes, two multiplies move the four 6-bit fields into separate
+ * bytes, and a saturated subtract plus one compare turn each field
+ * into an index of a 16-entry table of offsets to its character.
+ */
+
+static SSSE3_TARGET __m128i
+ssse3_encode_split(__m128i in)
+{
+    __m128i t0, t1, t2, t3;
+
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+    ));
+
+    t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+    return _mm_or_si128(t1, t3);
+}
+
+static SSSE3_TARGET __m128i
+ssse3_encode_map(__m128i index)
+{
+    __m128i result, less;
+
+    result = _mm_subs_epu8(index, _mm_set1_epi8(51));
+    less = _mm_cmpgt_epi8(_mm_set1_epi8(26), index);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    result = _mm_shuffle_epi8(_mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0
+    ), result);
+
+    return _mm_add_epi8(result, index);
+}
+
+/*
+ * Decoding follows Muła and Lemire: the two nibbles of a character
+ * each select a class bit mask, a digit is valid when the masks do
+ * not overlap. The high nibble also picks the offset back to the
+ * digit value, only '/' shares its nibble with '+' and needs fixing.
+ * Two multiply-adds then pack four digits into three bytes.
+ */
+
+static SSSE3_TARGET bool
+ssse3_decode_digits(__m128i *value)
+{
+    __m128i in, hi, lo, eq2f, roll;
+
+    in = *value;
+    hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    lo = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+
+    lo = _mm_shuffle_epi8(_mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a
+    ), lo);
+
+    eq2f = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    roll = _mm_shuffle_epi8(_mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0
+    ), _mm_add_epi8(eq2f, hi));
+
+    hi = _mm_shuffle_epi8(_mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+    ), hi);
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi),
+                                         _mm_setzero_si128())) != 0xffff)
+        return false;
+
+    *value = _mm_add_epi8(in, roll);
+    return true;
+}
+
+static SSSE3_TARGET __m128i
+ssse3_decode_pack(__m128i digits)
+{
+    digits = _mm_maddubs_epi16(digits, _mm_set1_epi32(0x01400140));
+    digits = _mm_madd_epi16(digits, _mm_set1_epi32(0x00011000));
+
+    return _mm_shuffle_epi8(digits, _mm_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+    ));
+}
+
+hidden SSSE3_TARGET size_t
+base64_encode_ssse3(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    __m128i value;
+
+    /* each load takes 16 bytes to use 12 */
+    for (start = data; size >= 16; size -= 12) {
+        value = _mm_loadu_si128((const void *)data);
+        value = ssse3_encode_map(ssse3_encode_split(value));
+        _mm_storeu_si128((void *)buff, value);
+        buff += 16;
+        data += 12;
+    }
+
+    return data - start + base64_encode_generic(buff, data, size);
+}
+
+hidden SSSE3_TARGET size_t
+base64_decode_ssse3(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    __m128i value;
+
+    /* each store writes 16 bytes to fill 12 */
+    for (start = data; size >= 24; size -= 16) {
+        value = _mm_loadu_si128((const void *)data);
+        if (!ssse3_decode_digits(&value))
+            break;
+
+        _mm_storeu_si128((void *)buff, ssse3_decode_pack(value));
+        buff += 12;
+        data += 16;
+    }
+
+    return data - start + base64_decode_generic(buff, data, size);
+}
+
+static AVX2_TARGET __m256i
+avx2_encode_split(__m256i in)
+{
+    __m256i t0, t1, t2, t3;
+
+    in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+    ));
+
+    t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+
+    return _mm256_or_si256(t1, t3);
+}
+
+static AVX2_TARGET __m256i
+avx2_encode_map(__m256i index)
+{
+    __m256i result, less;
+
+    result = _mm256_subs_epu8(index, _mm256_set1_epi8(51));
+    less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), index);
+    result = _mm256_or_si256(result,
+                             _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+    result = _mm256_shuffle_epi8(_mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0
+    ), result);
+
+    return _mm256_add_epi8(result, index);
+}
+
+static AVX2_TARGET bool
+avx2_decode_digits(__m256i *value)
+{
+    __m256i in, hi, lo, eq2f, roll;
+
+    in = *value;
+    hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+    lo = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+
+    lo = _mm256_shuffle_epi8(_mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a
+    ), lo);
+
+    eq2f = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+    roll = _mm256_shuffle_epi8(_mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0
+    ), _mm256_add_epi8(eq2f, hi));
+
+    hi = _mm256_shuffle_epi8(_mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+    ), hi);
+
+    if (!_mm256_testz_si256(lo, hi))
+        return false;
+
+    *value = _mm256_add_epi8(in, roll);
+    return true;
+}
+
+static AVX2_TARGET __m256i
+avx2_decode_pack(__m256i digits)
+{
+    digits = _mm256_maddubs_epi16(digits, _mm256_set1_epi32(0x01400140));
+    digits = _mm256_madd_epi16(digits, _mm256_set1_epi32(0x00011000));
+
+    digits = _mm256_shuffle_epi8(digits, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+    ));
+
+    /* close the gap between the 12 bytes of each half */
+    return _mm256_permutevar8x32_epi32(digits,
+        _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+}
+
+hidden AVX2_TARGET size_t
+base64_encode_avx2(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    __m256i value;
+
+    /* the upper half loads from 12 bytes in, up to 28 are read */
+    for (start = data; size >= 28; size -= 24) {
+        value = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const void *)data)),
+            _mm_loadu_si128((const void *)(data + 12)), 1);
+        value = avx2_encode_map(avx2_encode_split(value));
+        _mm256_storeu_si256((void *)buff, value);
+        buff += 32;
+        data += 24;
+    }
+
+    return data - start + base64_encode_ssse3(buff, data, size);
+}
+
+hidden AVX2_TARGET size_t
+base64_decode_avx2(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    __m256i value;
+
+    /* each store writes 32 bytes to fill 24 */
+    for (start = data; size >= 44; size -= 32) {
+        value = _mm256_loadu_si256((const void *)data);
+        if (!avx2_decode_digits(&value))
+            break;
+
+        _mm256_storeu_si256((void *)buff, avx2_decode_pack(value));
+        buff += 24;
+        data += 32;
+    }
+
+    return data - start + base64_decode_ssse3(buff, data, size);
+}
+
+#endif /* BASE64_ACCEL_X86 */
@@ -5,6 +5,8 @@
 
 #include <base.h>
 #include <bfdev/base64.h>
+#include <bfdev/dispatch.h>
+#include "base64-accel.h"
 #include <export.h>
 
 static const uint8_t
@@ -40,104 +42,290 @@ base64_decode_table[256] = {
     ['8'] = 0x3c, ['9'] = 0x3d, ['+'] = 0x3e, ['/'] = 0x3f,
 };
 
-static __bfdev_always_inline void
-base64_encode(uint8_t *buff, const uint8_t *data, size_t size)
+hidden size_t
+base64_encode_generic(uint8_t *buff, const uint8_t *data, size_t size)
 {
-    const uint8_t *prev;
-    unsigned int bstate;
-
-    prev = data;
-    for (; size >= 3; size -= 3) {
-        *buff++ = base64_encode_table[*data++ >> 2];
-        *buff++ = base64_encode_table[((*prev++ & 0x3) << 4) | (*data++ >> 4)];
-        *buff++ = base64_encode_table[((*prev++ & 0xf) << 2) | (*data++ >> 6)];
-        *buff++ = base64_encode_table[*prev++ & 0x3f];
+    const uint8_t *start;
+    uint32_t value;
+
+    for (start = data; size >= 3; size -= 3) {
+        value = data[0] << 16 | data[1] << 8 | data[2];
+        buff[0] = base64_encode_table[value >> 18];
+        buff[1] = base64_encode_table[(value >> 12) & 0x3f];
+        buff[2] = base64_encode_table[(value >> 6) & 0x3f];
+        buff[3] = base64_encode_table[value & 0x3f];
+        buff += 4;
+        data += 3;
     }
 
-    bstate = 0;
-    while (size--) switch (bstate) {
-        case 0:
-            *buff++ = base64_encode_table[*data++ >> 2];
-            bstate = 1;
-            break;
+    return data - start;
+}
 
-        case 1:
-            *buff++ = base64_encode_table[((*prev++ & 0x3) << 4) | (*data++ >> 4)];
-            bstate = 2;
-            break;
+hidden size_t
+base64_decode_generic(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    const uint8_t *start;
+    uint8_t d0, d1, d2, d3;
 
-        default:
-            *buff++ = base64_encode_table[((*prev++ & 0xf) << 2) | (*data++ >> 6)];
-            *buff++ = base64_encode_table[*prev++ & 0x3f];
-            bstate = 0;
+    for (start = data; size >= 4; size -= 4) {
+        d0 = base64_decode_table[data[0]];
+        d1 = base64_decode_table[data[1]];
+        d2 = base64_decode_table[data[2]];
+        d3 = base64_decode_table[data[3]];
+
+        /* invalid digits are the only ones with the top bit set */
+        if (bfdev_unlikely((d0 | d1 | d2 | d3) & 0x80))
             break;
+
+        buff[0] = d0 << 2 | d1 >> 4;
+        buff[1] = d1 << 4 | d2 >> 2;
+        buff[2] = d2 << 6 | d3;
+        buff += 3;
+        data += 4;
     }
 
-    switch (bstate) {
+    return data - start;
+}
+
+static const struct base64_ops
+base64_generic_ops = {
+    .encode = base64_encode_generic,
+    .decode = base64_decode_generic,
+};
+
+#ifdef BASE64_ACCEL_X86
+static const struct base64_ops
+base64_ssse3_ops = {
+    .encode = base64_encode_ssse3,
+    .decode = base64_decode_ssse3,
+};
+
+static const struct base64_ops
+base64_avx2_ops = {
+    .encode = base64_encode_avx2,
+    .decode = base64_decode_avx2,
+};
+#endif
+
+#ifdef BASE64_ACCEL_ARM64
+static const struct base64_ops
+base64_neon_ops = {
+    .encode = base64_encode_neon,
+    .decode = base64_decode_neon,
+};
+#endif
+
+static const bfdev_dispatch_impl_t
+base64_impls[] = {
+#ifdef BASE64_ACCEL_X86
+    BFDEV_DISPATCH_IMPL("avx2", BFDEV_CPU_FEATURE(BFDEV_CPU_AVX2),
+                        &base64_avx2_ops),
+    BFDEV_DISPATCH_IMPL("ssse3", BFDEV_CPU_FEATURE(BFDEV_CPU_SSSE3),
+                        &base64_ssse3_ops),
+#endif
+#ifdef BASE64_ACCEL_ARM64
+    BFDEV_DISPATCH_IMPL("neon", BFDEV_CPU_FEATURE(BFDEV_CPU_NEON),
+                        &base64_neon_ops),
+#endif
+    BFDEV_DISPATCH_IMPL("generic", 0, &base64_generic_ops),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(base64_dispatch, "base64", base64_impls,
+                      &base64_generic_ops);
+
+static __bfdev_always_inline const struct base64_ops *
+base64_ops(void)
+{
+    return bfdev_dispatch_ops(&base64_dispatch, struct base64_ops);
+}
+
+static size_t
+base64_encode_tail(uint8_t *buff, const uint8_t *data, size_t size)
+{
+    uint32_t value;
+
+    switch (size) {
         case 1:
-            *buff++ = base64_encode_table[(*prev & 0x3) << 4];
-            *buff++ = '=';
-            *buff = '=';
+            value = data[0] << 16;
+            buff[2] = '=';
             break;
 
         case 2:
-            *buff++ = base64_encode_table[(*prev & 0xf) << 2];
-            *buff = '=';
+            value = data[0] << 16 | data[1] << 8;
+            buff[2] = base64_encode_table[(value >> 6) & 0x3f];
             break;
 
         default:
-            break;
+            return 0;
     }
+
+    buff[0] = base64_encode_table[value >> 18];
+    buff[1] = base64_encode_table[(value >> 12) & 0x3f];
+    buff[3] = '=';
+
+    return 4;
 }
 
-static __bfdev_always_inline int
-base64_decode(uint8_t *buff, const uint8_t *data, size_t size)
+export void
+bfdev_base64_init(bfdev_base64_ctx_t *ctx)
 {
-    unsigned int bstate;
-    uint8_t decode;
-
-    bstate = 0;
-    while (size--) {
-        decode = base64_decode_table[*data];
-        if (decode == 0xff) {
-            if (bfdev_likely(*data == '='))
-                break;
-            return -BFDEV_EINVAL;
+    ctx->count = 0;
+    ctx->padding = false;
+}
+
+export size_t
+bfdev_base64_encode_update(bfdev_base64_ctx_t *ctx, void *buff,
+                           const void *data, size_t size)
+{
+    const uint8_t *src;
+    uint8_t *dest;
+    size_t done;
+
+    src = data;
+    dest = buff;
+
+    if (ctx->count) {
+        while (size && ctx->count < 3) {
+            ctx->pend[ctx->count++] = *src++;
+            size--;
         }
 
-        data++;
-        switch (bstate++ & 0x3) {
-            case 0:
-                *buff = decode << 2;
-                break;
+        if (ctx->count < 3)
+            return 0;
 
-            case 1:
-                *buff++ |= (decode >> 4) & 0x3;
-                *buff = decode << 4;
-                break;
+        base64_encode_generic(dest, ctx->pend, 3);
+        ctx->count = 0;
+        dest += 4;
+    }
+
+    done = base64_ops()->encode(dest, src, size);
+    dest += done / 3 * 4;
+    src += done;
+    size -= done;
+
+    bfport_memcpy(ctx->pend, src, size);
+    ctx->count = size;
+
+    return dest - (uint8_t *)buff;
+}
+
+export size_t
+bfdev_base64_encode_finish(bfdev_base64_ctx_t *ctx, void *buff)
+{
+    size_t length;
 
-            case 2:
-                *buff++ |= (decode >> 2) & 0xf;
-                *buff = decode << 6;
+    length = base64_encode_tail(buff, ctx->pend, ctx->count);
+    ctx->count = 0;
+
+    return length;
+}
+
+export int
+bfdev_base64_decode_update(bfdev_base64_ctx_t *ctx, void *buff,
+                           const void *data, size_t *plen, size_t size)
+{
+    const uint8_t *src;
+    uint8_t *dest;
+    size_t done;
+    int retval;
+
+    retval = -BFDEV_ENOERR;
+    src = data;
+    dest = buff;
+
+    while (size && !ctx->padding) {
+        if (!ctx->count) {
+            done = base64_ops()->decode(dest, src, size);
+            dest += done / 4 * 3;
+            src += done;
+            size -= done;
+            if (!size)
                 break;
+        }
 
-            default:
-                *buff++ |= decode;
+        /* a group split by the caller, a pad or garbage */
+        if (base64_decode_table[*src] == 0xff) {
+            if (bfdev_unlikely(*src != '=')) {
+                retval = -BFDEV_EINVAL;
                 break;
+            }
+            ctx->padding = true;
+            break;
+        }
+
+        ctx->pend[ctx->count++] = *src++;
+        size--;
+
+        if (ctx->count == 4) {
+            base64_decode_generic(dest, ctx->pend, 4);
+            ctx->count = 0;
+            dest += 3;
         }
     }
 
+    *plen = dest - (uint8_t *)buff;
+
+    return retval;
+}
+
+export int
+bfdev_base64_decode_finish(bfdev_base64_ctx_t *ctx, void *buff,
+                           size_t *plen)
+{
+    uint8_t *dest;
+    unsigned int count;
+    uint32_t value;
+
+    dest = buff;
+    count = ctx->count;
+    bfdev_base64_init(ctx);
+
+    if (count == 1)
+        return -BFDEV_EPROTO;
+
+    if (count) {
+        value = base64_decode_table[ctx->pend[0]] << 18 |
+                base64_decode_table[ctx->pend[1]] << 12;
+        if (count == 3)
+            value |= base64_decode_table[ctx->pend[2]] << 6;
+
+        dest[0] = value >> 16;
+        if (count == 3)
+            dest[1] = value >> 8;
+    }
+
+    *plen = count ? count - 1 : 0;
+
     return -BFDEV_ENOERR;
 }
 
 export void
 bfdev_base64_encode(void *buff, const void *data, size_t size)
 {
-    base64_encode(buff, data, size);
+    size_t done;
+
+    done = base64_ops()->encode(buff, data, size);
+    base64_encode_tail(buff + done / 3 * 4, data + done, size - done);
 }
 
 export int
 bfdev_base64_decode(void *buff, const void *data, size_t size)
 {
-    return base64_decode(buff, data, size);
+    bfdev_base64_ctx_t ctx;
+    size_t length, tail;
+    int retval;
+
+    bfdev_base64_init(&ctx);
+    retval = bfdev_base64_decode_update(&ctx, buff, data, &length, size);
+    if (retval)
+        return retval;
+
+    return bfdev_base64_decode_finish(&ctx, buff + length, &tail);
+}
+
+static __bfdev_ctor int
+base64_accel_init(void)
+{
+    return bfdev_dispatch_register(&base64_dispatch);
 }
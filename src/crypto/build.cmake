@@ -9,17 +9,27 @@ set(BFDEV_SOURCE
     ${CMAKE_CURRENT_LIST_DIR}/ascii85.c
     ${CMAKE_CURRENT_LIST_DIR}/base32.c
     ${CMAKE_CURRENT_LIST_DIR}/base64.c
+    ${CMAKE_CURRENT_LIST_DIR}/base64-arm64.c
+    ${CMAKE_CURRENT_LIST_DIR}/base64-x86.c
     ${CMAKE_CURRENT_LIST_DIR}/crc4.c
     ${CMAKE_CURRENT_LIST_DIR}/crc7.c
     ${CMAKE_CURRENT_LIST_DIR}/crc8.c
     ${CMAKE_CURRENT_LIST_DIR}/crc16.c
     ${CMAKE_CURRENT_LIST_DIR}/crc32.c
+    ${CMAKE_CURRENT_LIST_DIR}/crc32c.c
     ${CMAKE_CURRENT_LIST_DIR}/crc64.c
+    ${CMAKE_CURRENT_LIST_DIR}/crc-accel.c
+    ${CMAKE_CURRENT_LIST_DIR}/crc-arm64.c
     ${CMAKE_CURRENT_LIST_DIR}/crc-ccitt.c
+    ${CMAKE_CURRENT_LIST_DIR}/crc-combine.c
     ${CMAKE_CURRENT_LIST_DIR}/crc-itut.c
     ${CMAKE_CURRENT_LIST_DIR}/crc-rocksoft.c
     ${CMAKE_CURRENT_LIST_DIR}/crc-t10dif.c
+    ${CMAKE_CURRENT_LIST_DIR}/crc-x86.c
+    ${CMAKE_CURRENT_LIST_DIR}/hash-mb.c
     ${CMAKE_CURRENT_LIST_DIR}/md5.c
+    ${CMAKE_CURRENT_LIST_DIR}/sha-arm64.c
+    ${CMAKE_CURRENT_LIST_DIR}/sha-x86.c
     ${CMAKE_CURRENT_LIST_DIR}/sha1.c
     ${CMAKE_CURRENT_LIST_DIR}/sha2.c
 )
@@ -0,0 +1,124 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/crc.h>
+#include <bfdev/bitrev.h>
+#include "crc-accel.h"
+#include <export.h>
+
+static const char *
+crc_accel_names[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = "generic",
+    [BFDEV_CRC_SSE42] = "sse4.2",
+    [BFDEV_CRC_PCLMUL] = "pclmul",
+    [BFDEV_CRC_ARMV8] = "armv8",
+    [BFDEV_CRC_PMULL] = "pmull",
+};
+
+static const uint64_t
+crc_accel_features[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = 0,
+    [BFDEV_CRC_SSE42] = BFDEV_CPU_FEATURE(BFDEV_CPU_SSE42),
+    [BFDEV_CRC_PCLMUL] = BFDEV_CPU_FEATURE(BFDEV_CPU_PCLMUL) |
+                         BFDEV_CPU_FEATURE(BFDEV_CPU_SSSE3),
+    [BFDEV_CRC_ARMV8] = BFDEV_CPU_FEATURE(BFDEV_CPU_CRC32),
+    [BFDEV_CRC_PMULL] = BFDEV_CPU_FEATURE(BFDEV_CPU_PMULL),
+};
+
+/* preferred first, generic always comes last */
+static const enum bfdev_crc_accel
+crc_accel_order[] = {
+    BFDEV_CRC_PMULL,
+    BFDEV_CRC_ARMV8,
+    BFDEV_CRC_PCLMUL,
+    BFDEV_CRC_SSE42,
+    BFDEV_CRC_GENERIC,
+};
+
+export const char *
+bfdev_crc_accel_name(enum bfdev_crc_accel accel)
+{
+    if ((unsigned int)accel >= BFDEV_CRC_ACCEL_NR)
+        return NULL;
+
+    return crc_accel_names[accel];
+}
+
+hidden bool
+crc_accel_supported(enum bfdev_crc_accel accel)
+{
+    return bfdev_cpu_has_all(crc_accel_features[accel]);
+}
+
+hidden unsigned int
+crc_accel_impls(bfdev_dispatch_impl_t *impls, const void *const *ops)
+{
+    enum bfdev_crc_accel accel;
+    unsigned int index, count;
+
+    count = 0;
+    for (index = 0; index < BFDEV_ARRAY_SIZE(crc_accel_order); ++index) {
+        accel = crc_accel_order[index];
+        if (!ops[accel])
+            continue;
+
+        impls[count].name = crc_accel_names[accel];
+        impls[count].features = crc_accel_features[accel];
+        impls[count].ops = ops[accel];
+        count++;
+    }
+
+    return count;
+}
+
+/* x^exp mod x^bits + poly, with the highest bit first */
+static uint64_t
+crc_xpow_mod(unsigned int exp, uint64_t poly, unsigned int bits)
+{
+    uint64_t value, mask, carry;
+
+    mask = bits < 64 ? (1ULL << bits) - 1 : ~0ULL;
+    for (value = 1; exp--;) {
+        carry = (value >> (bits - 1)) & 1;
+        value = (value << 1) & mask;
+        if (carry)
+            value ^= poly;
+    }
+
+    return value;
+}
+
+/*
+ * With the lowest bit first, a 128-bit block holds the coefficient of
+ * x^127 in its lowest bit, the low half carries the high powers. A
+ * carry-less product of two such halves comes out one bit short, the
+ * multipliers make up for that.
+ */
+hidden void
+crc_fold_lsb(struct crc_fold *fold, uint64_t poly, unsigned int bits)
+{
+    poly = bfdev_bitrev64(poly) >> (64 - bits);
+
+    fold->fold512[0] = bfdev_bitrev64(crc_xpow_mod(512 + 63, poly, bits));
+    fold->fold512[1] = bfdev_bitrev64(crc_xpow_mod(512 - 1, poly, bits));
+    fold->fold128[0] = bfdev_bitrev64(crc_xpow_mod(128 + 63, poly, bits));
+    fold->fold128[1] = bfdev_bitrev64(crc_xpow_mod(128 - 1, poly, bits));
+    fold->bits = bits;
+}
+
+/*
+ * With the highest bit first, the byte reversed block is a plain
+ * polynomial, the high half carries the high powers.
+ */
+hidden void
+crc_fold_msb(struct crc_fold *fold, uint64_t poly, unsigned int bits)
+{
+    fold->fold512[0] = crc_xpow_mod(512, poly, bits);
+    fold->fold512[1] = crc_xpow_mod(512 + 64, poly, bits);
+    fold->fold128[0] = crc_xpow_mod(128, poly, bits);
+    fold->fold128[1] = crc_xpow_mod(128 + 64, poly, bits);
+    fold->bits = bits;
+}
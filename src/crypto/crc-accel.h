@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_CRC_ACCEL_H_
+#define _LOCAL_CRC_ACCEL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/crc.h>
+#include <bfdev/dispatch.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+#if defined(__x86_64__) && defined(__GNUC__)
+# define CRC_ACCEL_X86
+#endif
+
+#if defined(__aarch64__) && defined(__AARCH64EL__) && defined(__GNUC__)
+# define CRC_ACCEL_ARM64
+#endif
+
+/* folding only pays off for a few blocks */
+#define CRC_FOLD_MIN 64
+
+/**
+ * struct crc_fold - folding constants of a polynomial.
+ * @fold512: multipliers of the low and high half to skip 512 bits.
+ * @fold128: multipliers of the low and high half to skip 128 bits.
+ * @bits: width of the crc.
+ */
+struct crc_fold {
+    uint64_t fold512[2];
+    uint64_t fold128[2];
+    unsigned int bits;
+};
+
+extern hidden bool
+crc_accel_supported(enum bfdev_crc_accel accel);
+
+/*
+ * crc_accel_impls() - describe the built kernels of a crc function.
+ * @impls: filled preferred first, BFDEV_CRC_ACCEL_NR entries at most.
+ * @ops: pointer to each kernel, NULL if it is not built.
+ *
+ * Return the number of @impls filled.
+ */
+extern hidden unsigned int
+crc_accel_impls(bfdev_dispatch_impl_t *impls, const void *const *ops);
+
+/*
+ * crc_fold_lsb() - constants of a crc processing the lowest bit first.
+ * crc_fold_msb() - constants of a crc processing the highest bit first.
+ * @fold: the constants to fill.
+ * @poly: polynomial without the top term, in the bit order of the crc.
+ * @bits: width of the crc.
+ */
+
+extern hidden void
+crc_fold_lsb(struct crc_fold *fold, uint64_t poly, unsigned int bits);
+
+extern hidden void
+crc_fold_msb(struct crc_fold *fold, uint64_t poly, unsigned int bits);
+
+/*
+ * crc_fold_*() - fold a buffer down to 16 bytes of equal crc.
+ * @fold: constants of the polynomial.
+ * @src: data to fold, at least CRC_FOLD_MIN bytes.
+ * @len: length of @src.
+ * @crc: the initial crc.
+ * @block: receives 16 bytes whose crc from zero equals that of the
+ *         folded data from @crc.
+ *
+ * Returns the number of bytes folded, a multiple of 16.
+ */
+
+#ifdef CRC_ACCEL_X86
+extern hidden size_t
+crc_fold_pclmul_lsb(const struct crc_fold *fold, const uint8_t *src,
+                    size_t len, uint64_t crc, uint8_t *block);
+
+extern hidden size_t
+crc_fold_pclmul_msb(const struct crc_fold *fold, const uint8_t *src,
+                    size_t len, uint64_t crc, uint8_t *block);
+
+extern hidden uint32_t
+crc32c_sse42(const void *data, size_t len, uint32_t crc);
+#endif
+
+#ifdef CRC_ACCEL_ARM64
+extern hidden size_t
+crc_fold_pmull_lsb(const struct crc_fold *fold, const uint8_t *src,
+                   size_t len, uint64_t crc, uint8_t *block);
+
+extern hidden size_t
+crc_fold_pmull_msb(const struct crc_fold *fold, const uint8_t *src,
+                   size_t len, uint64_t crc, uint8_t *block);
+
+extern hidden uint32_t
+crc32_armv8(const void *data, size_t len, uint32_t crc);
+
+extern hidden uint32_t
+crc32c_armv8(const void *data, size_t len, uint32_t crc);
+#endif
+
+/*
+ * Wrap a folding engine around the table driven crc, which takes over
+ * for the folded residue and the tail shorter than a block.
+ */
+#define CRC_ACCEL_FOLD(name, type, engine, order)               \
+static type                                                     \
+name##_##engine(const void *data, size_t len, type crc)         \
+{                                                               \
+    uint8_t block[16];                                          \
+    size_t done;                                                \
+                                                                \
+    if (len < CRC_FOLD_MIN)                                     \
+        return bfdev_##name##_inline(data, len, crc);           \
+                                                                \
+    done = crc_fold_##engine##_##order(&name##_fold,            \
+                                       data, len, crc, block);  \
+    crc = bfdev_##name##_inline(block, sizeof(block), 0);       \
+                                                                \
+    return bfdev_##name##_inline(                               \
+        (const uint8_t *)data + done, len - done, crc);         \
+}
+
+/*
+ * Dispatch a crc function through the fastest kernel, which is
+ * registered by its constructor before main() runs. Calls made
+ * earlier go through the generic kernel.
+ */
+#define CRC_ACCEL_DISPATCH(func, type, ftype)                   \
+static bfdev_dispatch_impl_t func##_impls[BFDEV_CRC_ACCEL_NR];  \
+                                                                \
+static bfdev_dispatch_t func##_dispatch = {                     \
+    .name = __bfdev_stringify(func),                            \
+    .impls = func##_impls,                                      \
+    .ops = &func##_kernels[BFDEV_CRC_GENERIC],                  \
+};                                                              \
+                                                                \
+export ftype                                                    \
+bfdev_##func##_kernel(enum bfdev_crc_accel accel)               \
+{                                                               \
+    if ((unsigned int)accel >= BFDEV_CRC_ACCEL_NR)              \
+        return NULL;                                            \
+                                                                \
+    if (!func##_kernels[accel] || !crc_accel_supported(accel))  \
+        return NULL;                                            \
+                                                                \
+    return func##_kernels[accel];                               \
+}                                                               \
+                                                                \
+export type                                                     \
+bfdev_##func(const void *data, size_t len, type crc)            \
+{                                                               \
+    return (*bfdev_dispatch_ops(&func##_dispatch, ftype))(      \
+        data, len, crc);                                        \
+}                                                               \
+                                                                \
+static int                                                      \
+func##_select(void)                                             \
+{                                                               \
+    const void *ops[BFDEV_CRC_ACCEL_NR];                        \
+    unsigned int count;                                         \
+                                                                \
+    for (count = 0; count < BFDEV_CRC_ACCEL_NR; ++count) {      \
+        ops[count] = func##_kernels[count] ?                    \
+            &func##_kernels[count] : NULL;                      \
+    }                                                           \
+                                                                \
+    func##_dispatch.count = crc_accel_impls(func##_impls, ops); \
+    return bfdev_dispatch_register(&func##_dispatch);           \
+}
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_CRC_ACCEL_H_ */
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/unaligned.h>
+#include "crc-accel.h"
+#include <export.h>
+
+#ifdef CRC_ACCEL_ARM64
+#include <arm_neon.h>
+#include <arm_acle.h>
+
+#ifdef __clang__
+# define CRC_TARGET __bfdev_target("crc")
+# define PMULL_TARGET __bfdev_target("aes")
+#else
+# define CRC_TARGET __bfdev_target("+crc")
+# define PMULL_TARGET __bfdev_target("+crypto")
+#endif
+
+static PMULL_TARGET __bfdev_always_inline uint64x2_t
+pmull_fold(uint64x2_t value, uint64x2_t fold)
+{
+    poly128_t low, high;
+
+    low = vmull_p64(
+        (poly64_t)vgetq_lane_u64(value, 0),
+        (poly64_t)vgetq_lane_u64(fold, 0)
+    );
+
+    high = vmull_p64(
+        (poly64_t)vgetq_lane_u64(value, 1),
+        (poly64_t)vgetq_lane_u64(fold, 1)
+    );
+
+    return veorq_u64(vreinterpretq_u64_p128(low), vreinterpretq_u64_p128(high));
+}
+
+static PMULL_TARGET __bfdev_always_inline uint64x2_t
+pmull_swap(uint64x2_t value)
+{
+    uint8x16_t bytes;
+
+    bytes = vrev64q_u8(vreinterpretq_u8_u64(value));
+    return vreinterpretq_u64_u8(vextq_u8(bytes, bytes, 8));
+}
+
+static PMULL_TARGET __bfdev_always_inline uint64x2_t
+pmull_load(const uint8_t *src, bool msb)
+{
+    uint64x2_t value;
+
+    value = vreinterpretq_u64_u8(vld1q_u8(src));
+    if (msb)
+        value = pmull_swap(value);
+
+    return value;
+}
+
+/* same scheme as the pclmul engine */
+static PMULL_TARGET __bfdev_always_inline size_t
+pmull_engine(const struct crc_fold *fold, const uint8_t *src,
+             size_t len, uint64_t crc, uint8_t *block, bool msb)
+{
+    uint64x2_t x0, x1, x2, x3, k512, k128;
+    size_t done;
+
+    k512 = vcombine_u64(vcreate_u64(fold->fold512[0]),
+                        vcreate_u64(fold->fold512[1]));
+    k128 = vcombine_u64(vcreate_u64(fold->fold128[0]),
+                        vcreate_u64(fold->fold128[1]));
+
+    x0 = pmull_load(src + 0x00, msb);
+    x1 = pmull_load(src + 0x10, msb);
+    x2 = pmull_load(src + 0x20, msb);
+    x3 = pmull_load(src + 0x30, msb);
+
+    if (msb)
+        x0 = veorq_u64(x0, vcombine_u64(vcreate_u64(0),
+                       vcreate_u64(crc << (64 - fold->bits))));
+    else
+        x0 = veorq_u64(x0, vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+
+    for (done = 64; len - done >= 64; done += 64) {
+        x0 = veorq_u64(pmull_fold(x0, k512), pmull_load(src + done + 0x00, msb));
+        x1 = veorq_u64(pmull_fold(x1, k512), pmull_load(src + done + 0x10, msb));
+        x2 = veorq_u64(pmull_fold(x2, k512), pmull_load(src + done + 0x20, msb));
+        x3 = veorq_u64(pmull_fold(x3, k512), pmull_load(src + done + 0x30, msb));
+    }
+
+    x0 = veorq_u64(pmull_fold(x0, k128), x1);
+    x0 = veorq_u64(pmull_fold(x0, k128), x2);
+    x0 = veorq_u64(pmull_fold(x0, k128), x3);
+
+    for (; len - done >= 16; done += 16)
+        x0 = veorq_u64(pmull_fold(x0, k128), pmull_load(src + done, msb));
+
+    if (msb)
+        x0 = pmull_swap(x0);
+    vst1q_u8(block, vreinterpretq_u8_u64(x0));
+
+    return done;
+}
+
+hidden PMULL_TARGET size_t
+crc_fold_pmull_lsb(const struct crc_fold *fold, const uint8_t *src,
+                   size_t len, uint64_t crc, uint8_t *block)
+{
+    return pmull_engine(fold, src, len, crc, block, false);
+}
+
+hidden PMULL_TARGET size_t
+crc_fold_pmull_msb(const struct crc_fold *fold, const uint8_t *src,
+                   size_t len, uint64_t crc, uint8_t *block)
+{
+    return pmull_engine(fold, src, len, crc, block, true);
+}
+
+#define ARMV8_CRC32(name, word, byte)                               \
+hidden CRC_TARGET uint32_t                                          \
+name##_armv8(const void *data, size_t len, uint32_t crc)            \
+{                                                                   \
+    const uint8_t *src = data;                                      \
+                                                                    \
+    for (; len && !bfdev_align_ptr_check(src, 8); --len)            \
+        crc = byte(crc, *src++);                                    \
+                                                                    \
+    for (; len >= 8; len -= 8) {                                    \
+        crc = word(crc, bfdev_unaligned_get_le64(src));             \
+        src += 8;                                                   \
+    }                                                               \
+                                                                    \
+    for (; len; --len)                                              \
+        crc = byte(crc, *src++);                                    \
+                                                                    \
+    return crc;                                                     \
+}
+
+ARMV8_CRC32(crc32, __crc32d, __crc32b)
+ARMV8_CRC32(crc32c, __crc32cd, __crc32cb)
+
+#endif /* CRC_ACCEL_ARM64 */
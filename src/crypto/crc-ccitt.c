@@ -5,6 +5,7 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc-ccitt-inline.h>
+#include "crc-combine.h"
 #include <export.h>
 
 export uint16_t
@@ -12,3 +13,6 @@ bfdev_crc_ccitt(const void *data, size_t len, uint16_t crc)
 {
     return bfdev_crc_ccitt_inline(data, len, crc);
 }
+
+CRC_COMBINE(crc_ccitt, uint16_t, 0x8408, 16, true)
+CRC_PARALLEL(crc_ccitt, uint16_t)
@@ -0,0 +1,147 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/crc.h>
+#include <bfdev/minmax.h>
+#include <bfdev/wspool.h>
+#include "crc-combine.h"
+#include <export.h>
+
+struct crc_chunk {
+    uint64_t crc;
+    uint64_t len;
+};
+
+struct crc_work {
+    const struct crc_poly *poly;
+    crc_update_t update;
+    const uint8_t *data;
+};
+
+/* the register multiplied by x */
+static inline uint64_t
+crc_mulx(const struct crc_poly *poly, uint64_t value)
+{
+    uint64_t carry;
+
+    if (poly->lsb) {
+        carry = value & 1;
+        value >>= 1;
+    } else {
+        carry = (value >> (poly->bits - 1)) & 1;
+        value <<= 1;
+        if (poly->bits < 64)
+            value &= (1ULL << poly->bits) - 1;
+    }
+
+    return carry ? value ^ poly->poly : value;
+}
+
+/* a * b mod P, one term of @va at a time */
+static uint64_t
+crc_multiply(const struct crc_poly *poly, uint64_t va, uint64_t vb)
+{
+    uint64_t product, term;
+    unsigned int count;
+
+    for (product = 0, count = 0; count < poly->bits; ++count) {
+        if (poly->lsb)
+            term = (va >> (poly->bits - count - 1)) & 1;
+        else
+            term = (va >> count) & 1;
+
+        if (term)
+            product ^= vb;
+        vb = crc_mulx(poly, vb);
+    }
+
+    return product;
+}
+
+/*
+ * Appending n zero bits multiplies the register by x^n mod P, which
+ * is raised here by repeated squaring of x^(2^k). A raw crc has no
+ * final xor, so the crc of the second buffer from zero adds up
+ * linearly on top.
+ */
+hidden uint64_t
+crc_combine(const struct crc_poly *poly, uint64_t crc1,
+            uint64_t crc2, uint64_t shift)
+{
+    uint64_t square;
+
+    square = crc_mulx(poly, poly->lsb ? 1ULL << (poly->bits - 1) : 1);
+    while (shift) {
+        if (shift & 1)
+            crc1 = crc_multiply(poly, crc1, square);
+        if (shift >>= 1)
+            square = crc_multiply(poly, square, square);
+    }
+
+    return crc1 ^ crc2;
+}
+
+static void
+crc_parallel_map(unsigned long begin, unsigned long end,
+                 void *result, void *pdata)
+{
+    struct crc_chunk *chunk = result;
+    struct crc_work *work = pdata;
+
+    chunk->crc = work->update(work->data + begin, end - begin, 0);
+    chunk->len = end - begin;
+}
+
+static void
+crc_parallel_combine(void *result, const void *other, void *pdata)
+{
+    const struct crc_chunk *next = other;
+    struct crc_chunk *chunk = result;
+    struct crc_work *work = pdata;
+
+    chunk->crc = crc_combine(work->poly, chunk->crc, next->crc,
+                             next->len * BFDEV_BITS_PER_BYTE);
+    chunk->len += next->len;
+}
+
+hidden int
+crc_parallel(const struct crc_poly *poly, crc_update_t update,
+             struct bfdev_wspool *pool, unsigned int index,
+             const void *data, size_t len, size_t grain, uint64_t *crc)
+{
+    struct crc_chunk chunk;
+    struct crc_work work;
+    int retval;
+
+    if (index >= pool->nr)
+        return -BFDEV_EINVAL;
+
+    if (!grain) {
+        grain = len / (pool->nr * 8);
+        grain = bfdev_max(grain, (size_t)CRC_PARALLEL_GRAIN);
+    }
+
+    if (len <= grain) {
+        *crc = update(data, len, *crc);
+        return -BFDEV_ENOERR;
+    }
+
+    work.poly = poly;
+    work.update = update;
+    work.data = data;
+
+    retval = bfdev_wspool_parallel_reduce(pool, index, 0, len, grain,
+                                          crc_parallel_map,
+                                          crc_parallel_combine,
+                                          &chunk, sizeof(chunk), &work);
+    if (retval)
+        return retval;
+
+    *crc = crc_combine(poly, *crc, chunk.crc,
+                       (uint64_t)len * BFDEV_BITS_PER_BYTE);
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_CRC_COMBINE_H_
+#define _LOCAL_CRC_COMBINE_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/bits.h>
+#include <bfdev/errno.h>
+#include <bfdev/crc.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+/* chunks below this spend more time merging than checksumming */
+#define CRC_PARALLEL_GRAIN 0x10000
+
+typedef uint64_t
+(*crc_update_t)(const void *data, size_t len, uint64_t crc);
+
+/**
+ * struct crc_poly - polynomial of a crc register.
+ * @poly: polynomial without the top term, in the bit order of the crc.
+ * @bits: width of the register.
+ * @lsb: the register processes the lowest bit first.
+ */
+struct crc_poly {
+    uint64_t poly;
+    unsigned int bits;
+    bool lsb;
+};
+
+/*
+ * crc_combine() - shift @crc1 over @shift zero bits and merge @crc2.
+ * crc_parallel() - checksum @len bytes of @data on @pool from @crc.
+ */
+
+extern hidden uint64_t
+crc_combine(const struct crc_poly *poly, uint64_t crc1,
+            uint64_t crc2, uint64_t shift);
+
+extern hidden int
+crc_parallel(const struct crc_poly *poly, crc_update_t update,
+             struct bfdev_wspool *pool, unsigned int index,
+             const void *data, size_t len, size_t grain, uint64_t *crc);
+
+#define CRC_COMBINE(name, type, ...)                            \
+static const struct crc_poly                                    \
+name##_poly = {__VA_ARGS__};                                    \
+                                                                \
+export type                                                     \
+bfdev_##name##_combine(type crc1, type crc2, size_t len2)       \
+{                                                               \
+    return crc_combine(&name##_poly, crc1, crc2,                \
+                       (uint64_t)len2 * BFDEV_BITS_PER_BYTE);   \
+}
+
+#define CRC_PARALLEL(name, type)                                \
+static uint64_t                                                 \
+name##_update(const void *data, size_t len, uint64_t crc)       \
+{                                                               \
+    return bfdev_##name(data, len, (type)crc);                  \
+}                                                               \
+                                                                \
+export int                                                      \
+bfdev_##name##_parallel(struct bfdev_wspool *pool,              \
+                        unsigned int index, const void *data,   \
+                        size_t len, size_t grain, type *crc)    \
+{                                                               \
+    uint64_t value;                                             \
+    int retval;                                                 \
+                                                                \
+    value = *crc;                                               \
+    retval = crc_parallel(&name##_poly, name##_update, pool,    \
+                          index, data, len, grain, &value);     \
+    if (retval)                                                 \
+        return retval;                                          \
+                                                                \
+    *crc = (type)value;                                         \
+    return -BFDEV_ENOERR;                                       \
+}
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_CRC_COMBINE_H_ */
@@ -5,6 +5,7 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc-itut-inline.h>
+#include "crc-combine.h"
 #include <export.h>
 
 export uint16_t
@@ -12,3 +13,6 @@ bfdev_crc_itut(const void *data, size_t len, uint16_t crc)
 {
     return bfdev_crc_itut_inline(data, len, crc);
 }
+
+CRC_COMBINE(crc_itut, uint16_t, 0x1021, 16, false)
+CRC_PARALLEL(crc_itut, uint16_t)
@@ -5,10 +5,45 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc-rocksoft-inline.h>
+#include "crc-accel.h"
+#include "crc-combine.h"
 #include <export.h>
 
-export uint64_t
-bfdev_crc_rocksoft(const void *data, size_t len, uint64_t crc)
+static struct crc_fold crc_rocksoft_fold;
+
+static uint64_t
+crc_rocksoft_generic(const void *data, size_t len, uint64_t crc)
 {
     return bfdev_crc_rocksoft_inline(data, len, crc);
 }
+
+#ifdef CRC_ACCEL_X86
+CRC_ACCEL_FOLD(crc_rocksoft, uint64_t, pclmul, lsb)
+#endif
+
+#ifdef CRC_ACCEL_ARM64
+CRC_ACCEL_FOLD(crc_rocksoft, uint64_t, pmull, lsb)
+#endif
+
+static const bfdev_crc64_func_t
+crc_rocksoft_kernels[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = crc_rocksoft_generic,
+#ifdef CRC_ACCEL_X86
+    [BFDEV_CRC_PCLMUL] = crc_rocksoft_pclmul,
+#endif
+#ifdef CRC_ACCEL_ARM64
+    [BFDEV_CRC_PMULL] = crc_rocksoft_pmull,
+#endif
+};
+
+CRC_ACCEL_DISPATCH(crc_rocksoft, uint64_t, bfdev_crc64_func_t)
+
+static __bfdev_ctor void
+crc_rocksoft_init(void)
+{
+    crc_fold_lsb(&crc_rocksoft_fold, 0x9a6c9329ac4bc9b5ULL, 64);
+    crc_rocksoft_select();
+}
+
+CRC_COMBINE(crc_rocksoft, uint64_t, 0x9a6c9329ac4bc9b5ULL, 64, true)
+CRC_PARALLEL(crc_rocksoft, uint64_t)
@@ -5,10 +5,45 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc-t10dif-inline.h>
+#include "crc-accel.h"
+#include "crc-combine.h"
 #include <export.h>
 
-export uint16_t
-bfdev_crc_t10dif(const void *data, size_t len, uint16_t crc)
+static struct crc_fold crc_t10dif_fold;
+
+static uint16_t
+crc_t10dif_generic(const void *data, size_t len, uint16_t crc)
 {
     return bfdev_crc_t10dif_inline(data, len, crc);
 }
+
+#ifdef CRC_ACCEL_X86
+CRC_ACCEL_FOLD(crc_t10dif, uint16_t, pclmul, msb)
+#endif
+
+#ifdef CRC_ACCEL_ARM64
+CRC_ACCEL_FOLD(crc_t10dif, uint16_t, pmull, msb)
+#endif
+
+static const bfdev_crc16_func_t
+crc_t10dif_kernels[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = crc_t10dif_generic,
+#ifdef CRC_ACCEL_X86
+    [BFDEV_CRC_PCLMUL] = crc_t10dif_pclmul,
+#endif
+#ifdef CRC_ACCEL_ARM64
+    [BFDEV_CRC_PMULL] = crc_t10dif_pmull,
+#endif
+};
+
+CRC_ACCEL_DISPATCH(crc_t10dif, uint16_t, bfdev_crc16_func_t)
+
+static __bfdev_ctor void
+crc_t10dif_init(void)
+{
+    crc_fold_msb(&crc_t10dif_fold, 0x8bb7, 16);
+    crc_t10dif_select();
+}
+
+CRC_COMBINE(crc_t10dif, uint16_t, 0x8bb7, 16, false)
+CRC_PARALLEL(crc_t10dif, uint16_t)
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/unaligned.h>
+#include "crc-accel.h"
+#include <export.h>
+
+#ifdef CRC_ACCEL_X86
+#include <immintrin.h>
+
+#define PCLMUL_TARGET __bfdev_target("pclmul,ssse3")
+#define SSE42_TARGET __bfdev_target("sse4.2")
+
+static PCLMUL_TARGET __bfdev_always_inline __m128i
+pclmul_fold(__m128i value, __m128i fold)
+{
+    return _mm_xor_si128(
+        _mm_clmulepi64_si128(value, fold, 0x00),
+        _mm_clmulepi64_si128(value, fold, 0x11)
+    );
+}
+
+static PCLMUL_TARGET __bfdev_always_inline __m128i
+pclmul_load(const uint8_t *src, __m128i swap, bool msb)
+{
+    __m128i value;
+
+    value = _mm_loadu_si128((const __m128i *)src);
+    if (msb)
+        value = _mm_shuffle_epi8(value, swap);
+
+    return value;
+}
+
+/*
+ * Four independent accumulators hide the latency of pclmulqdq, they
+ * are folded into one before going on block by block.
+ */
+static PCLMUL_TARGET __bfdev_always_inline size_t
+pclmul_engine(const struct crc_fold *fold, const uint8_t *src,
+              size_t len, uint64_t crc, uint8_t *block, bool msb)
+{
+    __m128i x0, x1, x2, x3, k512, k128, swap;
+    size_t done;
+
+    swap = _mm_set_epi8(
+        0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15
+    );
+
+    k512 = _mm_set_epi64x(fold->fold512[1], fold->fold512[0]);
+    k128 = _mm_set_epi64x(fold->fold128[1], fold->fold128[0]);
+
+    x0 = pclmul_load(src + 0x00, swap, msb);
+    x1 = pclmul_load(src + 0x10, swap, msb);
+    x2 = pclmul_load(src + 0x20, swap, msb);
+    x3 = pclmul_load(src + 0x30, swap, msb);
+
+    /* the initial crc goes into the leading bytes */
+    if (msb)
+        x0 = _mm_xor_si128(x0, _mm_set_epi64x(crc << (64 - fold->bits), 0));
+    else
+        x0 = _mm_xor_si128(x0, _mm_set_epi64x(0, crc));
+
+    for (done = 64; len - done >= 64; done += 64) {
+        x0 = _mm_xor_si128(pclmul_fold(x0, k512),
+                           pclmul_load(src + done + 0x00, swap, msb));
+        x1 = _mm_xor_si128(pclmul_fold(x1, k512),
+                           pclmul_load(src + done + 0x10, swap, msb));
+        x2 = _mm_xor_si128(pclmul_fold(x2, k512),
+                           pclmul_load(src + done + 0x20, swap, msb));
+        x3 = _mm_xor_si128(pclmul_fold(x3, k512),
+                           pclmul_load(src + done + 0x30, swap, msb));
+    }
+
+    x0 = _mm_xor_si128(pclmul_fold(x0, k128), x1);
+    x0 = _mm_xor_si128(pclmul_fold(x0, k128), x2);
+    x0 = _mm_xor_si128(pclmul_fold(x0, k128), x3);
+
+    for (; len - done >= 16; done += 16) {
+        x0 = _mm_xor_si128(pclmul_fold(x0, k128),
+                           pclmul_load(src + done, swap, msb));
+    }
+
+    if (msb)
+        x0 = _mm_shuffle_epi8(x0, swap);
+    _mm_storeu_si128((__m128i *)block, x0);
+
+    return done;
+}
+
+hidden PCLMUL_TARGET size_t
+crc_fold_pclmul_lsb(const struct crc_fold *fold, const uint8_t *src,
+                    size_t len, uint64_t crc, uint8_t *block)
+{
+    return pclmul_engine(fold, src, len, crc, block, false);
+}
+
+hidden PCLMUL_TARGET size_t
+crc_fold_pclmul_msb(const struct crc_fold *fold, const uint8_t *src,
+                    size_t len, uint64_t crc, uint8_t *block)
+{
+    return pclmul_engine(fold, src, len, crc, block, true);
+}
+
+hidden SSE42_TARGET uint32_t
+crc32c_sse42(const void *data, size_t len, uint32_t crc)
+{
+    const uint8_t *src = data;
+    uint64_t value;
+
+    for (; len && !bfdev_align_ptr_check(src, sizeof(value)); --len)
+        crc = _mm_crc32_u8(crc, *src++);
+
+    for (value = crc; len >= sizeof(value); len -= sizeof(value)) {
+        value = _mm_crc32_u64(value, bfdev_unaligned_get_u64(src));
+        src += sizeof(value);
+    }
+
+    for (crc = value; len; --len)
+        crc = _mm_crc32_u8(crc, *src++);
+
+    return crc;
+}
+
+#endif /* CRC_ACCEL_X86 */
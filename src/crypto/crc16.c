@@ -5,6 +5,7 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc16-inline.h>
+#include "crc-combine.h"
 #include <export.h>
 
 export uint16_t
@@ -12,3 +13,6 @@ bfdev_crc16(const void *data, size_t len, uint16_t crc)
 {
     return bfdev_crc16_inline(data, len, crc);
 }
+
+CRC_COMBINE(crc16, uint16_t, 0xa001, 16, true)
+CRC_PARALLEL(crc16, uint16_t)
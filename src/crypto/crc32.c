@@ -5,10 +5,46 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc32-inline.h>
+#include "crc-accel.h"
+#include "crc-combine.h"
 #include <export.h>
 
-export uint32_t
-bfdev_crc32(const void *data, size_t len, uint32_t crc)
+static struct crc_fold crc32_fold;
+
+static uint32_t
+crc32_generic(const void *data, size_t len, uint32_t crc)
 {
     return bfdev_crc32_inline(data, len, crc);
 }
+
+#ifdef CRC_ACCEL_X86
+CRC_ACCEL_FOLD(crc32, uint32_t, pclmul, lsb)
+#endif
+
+#ifdef CRC_ACCEL_ARM64
+CRC_ACCEL_FOLD(crc32, uint32_t, pmull, lsb)
+#endif
+
+static const bfdev_crc32_func_t
+crc32_kernels[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = crc32_generic,
+#ifdef CRC_ACCEL_X86
+    [BFDEV_CRC_PCLMUL] = crc32_pclmul,
+#endif
+#ifdef CRC_ACCEL_ARM64
+    [BFDEV_CRC_ARMV8] = crc32_armv8,
+    [BFDEV_CRC_PMULL] = crc32_pmull,
+#endif
+};
+
+CRC_ACCEL_DISPATCH(crc32, uint32_t, bfdev_crc32_func_t)
+
+static __bfdev_ctor void
+crc32_init(void)
+{
+    crc_fold_lsb(&crc32_fold, 0xedb88320, 32);
+    crc32_select();
+}
+
+CRC_COMBINE(crc32, uint32_t, 0xedb88320, 32, true)
+CRC_PARALLEL(crc32, uint32_t)
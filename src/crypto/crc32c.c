@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <bfdev/crc.h>
+#include <bfdev/crypto/crc32c-inline.h>
+#include "crc-accel.h"
+#include "crc-combine.h"
+#include <export.h>
+
+static struct crc_fold crc32c_fold;
+
+static uint32_t
+crc32c_generic(const void *data, size_t len, uint32_t crc)
+{
+    return bfdev_crc32c_inline(data, len, crc);
+}
+
+#ifdef CRC_ACCEL_X86
+CRC_ACCEL_FOLD(crc32c, uint32_t, pclmul, lsb)
+#endif
+
+#ifdef CRC_ACCEL_ARM64
+CRC_ACCEL_FOLD(crc32c, uint32_t, pmull, lsb)
+#endif
+
+static const bfdev_crc32_func_t
+crc32c_kernels[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = crc32c_generic,
+#ifdef CRC_ACCEL_X86
+    [BFDEV_CRC_SSE42] = crc32c_sse42,
+    [BFDEV_CRC_PCLMUL] = crc32c_pclmul,
+#endif
+#ifdef CRC_ACCEL_ARM64
+    [BFDEV_CRC_ARMV8] = crc32c_armv8,
+    [BFDEV_CRC_PMULL] = crc32c_pmull,
+#endif
+};
+
+CRC_ACCEL_DISPATCH(crc32c, uint32_t, bfdev_crc32_func_t)
+
+static __bfdev_ctor void
+crc32c_init(void)
+{
+    crc_fold_lsb(&crc32c_fold, 0x82f63b78, 32);
+    crc32c_select();
+}
+
+CRC_COMBINE(crc32c, uint32_t, 0x82f63b78, 32, true)
+CRC_PARALLEL(crc32c, uint32_t)
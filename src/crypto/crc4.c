@@ -5,6 +5,8 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc4-inline.h>
+#include <bfdev/math.h>
+#include "crc-combine.h"
 #include <export.h>
 
 export uint8_t
@@ -12,3 +14,15 @@ bfdev_crc4(const void *data, size_t len, uint8_t crc)
 {
     return bfdev_crc4_inline(data, len, crc);
 }
+
+static const struct crc_poly
+crc4_poly = {0x07, 4, false};
+
+/* every started byte of the input is fed in whole */
+export uint8_t
+bfdev_crc4_combine(uint8_t crc1, uint8_t crc2, size_t len2)
+{
+    len2 = BFDEV_DIV_ROUND_UP(len2, BFDEV_BITS_PER_BYTE);
+    return crc_combine(&crc4_poly, crc1, crc2,
+                       (uint64_t)len2 * BFDEV_BITS_PER_BYTE);
+}
@@ -5,10 +5,45 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc64-inline.h>
+#include "crc-accel.h"
+#include "crc-combine.h"
 #include <export.h>
 
-export uint64_t
-bfdev_crc64(const void *data, size_t len, uint64_t crc)
+static struct crc_fold crc64_fold;
+
+static uint64_t
+crc64_generic(const void *data, size_t len, uint64_t crc)
 {
     return bfdev_crc64_inline(data, len, crc);
 }
+
+#ifdef CRC_ACCEL_X86
+CRC_ACCEL_FOLD(crc64, uint64_t, pclmul, msb)
+#endif
+
+#ifdef CRC_ACCEL_ARM64
+CRC_ACCEL_FOLD(crc64, uint64_t, pmull, msb)
+#endif
+
+static const bfdev_crc64_func_t
+crc64_kernels[BFDEV_CRC_ACCEL_NR] = {
+    [BFDEV_CRC_GENERIC] = crc64_generic,
+#ifdef CRC_ACCEL_X86
+    [BFDEV_CRC_PCLMUL] = crc64_pclmul,
+#endif
+#ifdef CRC_ACCEL_ARM64
+    [BFDEV_CRC_PMULL] = crc64_pmull,
+#endif
+};
+
+CRC_ACCEL_DISPATCH(crc64, uint64_t, bfdev_crc64_func_t)
+
+static __bfdev_ctor void
+crc64_init(void)
+{
+    crc_fold_msb(&crc64_fold, 0x42f0e1eba9ea3693ULL, 64);
+    crc64_select();
+}
+
+CRC_COMBINE(crc64, uint64_t, 0x42f0e1eba9ea3693ULL, 64, false)
+CRC_PARALLEL(crc64, uint64_t)
@@ -5,6 +5,7 @@
 
 #include <bfdev/crc.h>
 #include <bfdev/crypto/crc7-inline.h>
+#include "crc-combine.h"
 #include <export.h>
 
 export uint8_t
@@ -12,3 +13,6 @@ bfdev_crc7(const void *data, size_t len, uint8_t crc)
 {
     return bfdev_crc7_inline(data, len, crc);
 }
+
+CRC_COMBINE(crc7, uint8_t, 0x12, 8, false)
+CRC_PARALLEL(crc7, uint8_t)
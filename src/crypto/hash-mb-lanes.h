@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+/*
+ * Hash transforms over MB_LANES streams at once, one stream per
+ * vector lane. Included once per vector width with MB_LANES, MB_ATTR
+ * and MB_NAME() defined, no include guard on purpose.
+ */
+
+#if !defined(MB_LANES) || !defined(MB_ATTR) || !defined(MB_NAME)
+# error "Lane parameters not defined"
+#endif
+
+typedef uint32_t
+MB_NAME(vec) __attribute__((__vector_size__(MB_LANES * 4)));
+
+#define MB_VEC MB_NAME(vec)
+#define MB_ROL(x, n) ((x) << (n) | (x) >> (32 - (n)))
+#define MB_ROR(x, n) ((x) >> (n) | (x) << (32 - (n)))
+
+#define MB_LOAD_STATE(vec, state, words) do {           \
+    unsigned int __word, __lane;                        \
+    for (__word = 0; __word < (words); ++__word)        \
+        for (__lane = 0; __lane < MB_LANES; ++__lane)   \
+            vec[__word][__lane] = state[__lane][__word];\
+} while (0)
+
+#define MB_STORE_STATE(vec, state, words) do {          \
+    unsigned int __word, __lane;                        \
+    for (__word = 0; __word < (words); ++__word)        \
+        for (__lane = 0; __lane < MB_LANES; ++__lane)   \
+            state[__lane][__word] = vec[__word][__lane];\
+} while (0)
+
+#define MB_LOAD_BLOCK(vec, data, offset, get) do {      \
+    unsigned int __word, __lane;                        \
+    for (__word = 0; __word < 16; ++__word)             \
+        for (__lane = 0; __lane < MB_LANES; ++__lane)   \
+            vec[__word][__lane] = get(data[__lane] +    \
+                (offset) + __word * 4);                 \
+} while (0)
+
+static const uint8_t
+MB_NAME(md5_index)[64] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    1, 6, 11, 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12,
+    5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2,
+    0, 7, 14, 5, 12, 3, 10, 1, 8, 15, 6, 13, 4, 11, 2, 9,
+};
+
+static const uint8_t
+MB_NAME(md5_shift)[16] = {
+    7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21,
+};
+
+static const uint32_t
+MB_NAME(md5_k)[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+#define MB_MD5_STEP(func, count) do {                               \
+    MB_VEC __tmp = a + (func) + block[MB_NAME(md5_index)[count]] +  \
+                   MB_NAME(md5_k)[count];                           \
+    unsigned int __shift;                                           \
+    __shift = MB_NAME(md5_shift)[(count) / 16 * 4 + (count) % 4];   \
+    a = d; d = c; c = b;                                            \
+    b += MB_ROL(__tmp, __shift);                                    \
+} while (0)
+
+static MB_ATTR void
+MB_NAME(md5)(uint32_t *const *state, const uint8_t *const *data,
+             size_t blocks)
+{
+    MB_VEC digest[4], block[16];
+    MB_VEC a, b, c, d;
+    unsigned int count;
+    size_t offset;
+
+    MB_LOAD_STATE(digest, state, 4);
+    for (offset = 0; blocks--; offset += MB_HASH_BLOCK) {
+        MB_LOAD_BLOCK(block, data, offset, bfdev_unaligned_get_le32);
+        a = digest[0];
+        b = digest[1];
+        c = digest[2];
+        d = digest[3];
+
+        for (count = 0; count < 16; ++count)
+            MB_MD5_STEP(d ^ (b & (c ^ d)), count);
+        for (; count < 32; ++count)
+            MB_MD5_STEP(c ^ (d & (b ^ c)), count);
+        for (; count < 48; ++count)
+            MB_MD5_STEP(b ^ c ^ d, count);
+        for (; count < 64; ++count)
+            MB_MD5_STEP(c ^ (b | ~d), count);
+
+        digest[0] += a;
+        digest[1] += b;
+        digest[2] += c;
+        digest[3] += d;
+    }
+    MB_STORE_STATE(digest, state, 4);
+}
+
+#define MB_SHA1_STEP(func, k, count) do {                           \
+    MB_VEC __tmp;                                                   \
+    if ((count) >= 16)                                              \
+        block[(count) & 15] = MB_ROL(block[((count) - 3) & 15] ^    \
+            block[((count) - 8) & 15] ^ block[((count) - 14) & 15] ^ \
+            block[(count) & 15], 1);                                \
+    __tmp = MB_ROL(a, 5) + (func) + e + (k) + block[(count) & 15];  \
+    e = d; d = c; c = MB_ROL(b, 30); b = a; a = __tmp;              \
+} while (0)
+
+static MB_ATTR void
+MB_NAME(sha1)(uint32_t *const *state, const uint8_t *const *data,
+              size_t blocks)
+{
+    MB_VEC digest[5], block[16];
+    MB_VEC a, b, c, d, e;
+    unsigned int count;
+    size_t offset;
+
+    MB_LOAD_STATE(digest, state, 5);
+    for (offset = 0; blocks--; offset += MB_HASH_BLOCK) {
+        MB_LOAD_BLOCK(block, data, offset, bfdev_unaligned_get_be32);
+        a = digest[0];
+        b = digest[1];
+        c = digest[2];
+        d = digest[3];
+        e = digest[4];
+
+        for (count = 0; count < 20; ++count)
+            MB_SHA1_STEP(d ^ (b & (c ^ d)), 0x5a827999, count);
+        for (; count < 40; ++count)
+            MB_SHA1_STEP(b ^ c ^ d, 0x6ed9eba1, count);
+        for (; count < 60; ++count)
+            MB_SHA1_STEP((b & c) | (d & (b | c)), 0x8f1bbcdc, count);
+        for (; count < 80; ++count)
+            MB_SHA1_STEP(b ^ c ^ d, 0xca62c1d6, count);
+
+        digest[0] += a;
+        digest[1] += b;
+        digest[2] += c;
+        digest[3] += d;
+        digest[4] += e;
+    }
+    MB_STORE_STATE(digest, state, 5);
+}
+
+static MB_ATTR void
+MB_NAME(sha2)(uint32_t *const *state, const uint8_t *const *data,
+              size_t blocks)
+{
+    MB_VEC digest[8], block[16];
+    MB_VEC a, b, c, d, e, f, g, h;
+    MB_VEC tmp1, tmp2, *slot;
+    unsigned int count;
+    size_t offset;
+
+    MB_LOAD_STATE(digest, state, 8);
+    for (offset = 0; blocks--; offset += MB_HASH_BLOCK) {
+        MB_LOAD_BLOCK(block, data, offset, bfdev_unaligned_get_be32);
+        a = digest[0];
+        b = digest[1];
+        c = digest[2];
+        d = digest[3];
+        e = digest[4];
+        f = digest[5];
+        g = digest[6];
+        h = digest[7];
+
+        for (count = 0; count < 64; ++count) {
+            slot = &block[count & 15];
+            if (count >= 16) {
+                tmp1 = block[(count - 2) & 15];
+                tmp2 = block[(count - 15) & 15];
+                *slot += (MB_ROR(tmp1, 17) ^ MB_ROR(tmp1, 19) ^ tmp1 >> 10) +
+                         (MB_ROR(tmp2, 7) ^ MB_ROR(tmp2, 18) ^ tmp2 >> 3) +
+                         block[(count - 7) & 15];
+            }
+
+            tmp1 = h + (MB_ROR(e, 6) ^ MB_ROR(e, 11) ^ MB_ROR(e, 25)) +
+                   (g ^ (e & (f ^ g))) + bfdev_sha2_k[count] + *slot;
+            tmp2 = (MB_ROR(a, 2) ^ MB_ROR(a, 13) ^ MB_ROR(a, 22)) +
+                   ((a & b) | (c & (a | b)));
+
+            h = g; g = f; f = e; e = d + tmp1;
+            d = c; c = b; b = a; a = tmp1 + tmp2;
+        }
+
+        digest[0] += a;
+        digest[1] += b;
+        digest[2] += c;
+        digest[3] += d;
+        digest[4] += e;
+        digest[5] += f;
+        digest[6] += g;
+        digest[7] += h;
+    }
+    MB_STORE_STATE(digest, state, 8);
+}
+
+#undef MB_VEC
+#undef MB_ROL
+#undef MB_ROR
+#undef MB_LOAD_STATE
+#undef MB_STORE_STATE
+#undef MB_LOAD_BLOCK
+#undef MB_MD5_STEP
+#undef MB_SHA1_STEP
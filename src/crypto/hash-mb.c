@@ -0,0 +1,319 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/minmax.h>
+#include <bfdev/unaligned.h>
+#include <bfdev/md5.h>
+#include <bfdev/sha1.h>
+#include <bfdev/sha2.h>
+#include <bfdev/crypto/md5.h>
+#include <bfdev/crypto/sha1.h>
+#include <bfdev/crypto/sha2.h>
+#include <bfdev/dispatch.h>
+#include "hash-mb.h"
+#include "sha-accel.h"
+#include <export.h>
+
+/**
+ * struct mb_engine - a set of transforms of one vector width.
+ * @lanes: number of streams hashed side by side.
+ * @transform: transform of each digest.
+ */
+struct mb_engine {
+    unsigned int lanes;
+    mb_transform_t transform[MB_HASH_NR];
+};
+
+#ifdef MB_HASH_SIMD
+# define MB_LANES 4
+# define MB_ATTR
+# define MB_NAME(name) __BFDEV_PASTE(mb_simd4_, name)
+# include "hash-mb-lanes.h"
+# undef MB_LANES
+# undef MB_ATTR
+# undef MB_NAME
+#endif
+
+#ifdef MB_HASH_X86
+# define MB_LANES 8
+# define MB_ATTR __bfdev_target("avx2")
+# define MB_NAME(name) __BFDEV_PASTE(mb_avx2_, name)
+# include "hash-mb-lanes.h"
+# undef MB_LANES
+# undef MB_ATTR
+# undef MB_NAME
+
+# define MB_LANES 16
+# define MB_ATTR __bfdev_target("avx512f")
+# define MB_NAME(name) __BFDEV_PASTE(mb_avx512_, name)
+# include "hash-mb-lanes.h"
+# undef MB_LANES
+# undef MB_ATTR
+# undef MB_NAME
+#endif
+
+static const struct mb_engine
+mb_engine_generic = {
+    .lanes = 1,
+};
+
+#ifdef MB_HASH_SIMD
+static const struct mb_engine
+mb_engine_simd4 = {
+    .lanes = 4,
+    .transform = {
+        [MB_HASH_MD5] = mb_simd4_md5,
+        [MB_HASH_SHA1] = mb_simd4_sha1,
+        [MB_HASH_SHA2] = mb_simd4_sha2,
+    },
+};
+#endif
+
+#ifdef MB_HASH_X86
+static const struct mb_engine
+mb_engine_avx2 = {
+    .lanes = 8,
+    .transform = {
+        [MB_HASH_MD5] = mb_avx2_md5,
+        [MB_HASH_SHA1] = mb_avx2_sha1,
+        [MB_HASH_SHA2] = mb_avx2_sha2,
+    },
+};
+
+static const struct mb_engine
+mb_engine_avx512 = {
+    .lanes = 16,
+    .transform = {
+        [MB_HASH_MD5] = mb_avx512_md5,
+        [MB_HASH_SHA1] = mb_avx512_sha1,
+        [MB_HASH_SHA2] = mb_avx512_sha2,
+    },
+};
+#endif
+
+/* simd4 is built for the baseline instruction set, it always runs */
+static const bfdev_dispatch_impl_t
+mb_engine_impls[] = {
+#ifdef MB_HASH_X86
+    BFDEV_DISPATCH_IMPL("avx512", BFDEV_CPU_FEATURE(BFDEV_CPU_AVX512F),
+                        &mb_engine_avx512),
+    BFDEV_DISPATCH_IMPL("avx2", BFDEV_CPU_FEATURE(BFDEV_CPU_AVX2),
+                        &mb_engine_avx2),
+#endif
+#ifdef MB_HASH_SIMD
+    BFDEV_DISPATCH_IMPL("simd4", 0, &mb_engine_simd4),
+#endif
+    BFDEV_DISPATCH_IMPL("generic", 0, &mb_engine_generic),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(mb_dispatch, "hash-mb", mb_engine_impls,
+                      &mb_engine_generic);
+
+/* the cpu has sha instructions for single streams */
+static bool
+mb_native;
+
+/* lanes used for a digest, one means scalar */
+static unsigned int
+mb_width(const struct mb_engine *engine, enum mb_hash hash)
+{
+    /* sha instructions beat anything narrower than 16 lanes */
+    if (mb_native && hash != MB_HASH_MD5 && engine->lanes < 16)
+        return 1;
+
+    return engine->lanes;
+}
+
+static void
+mb_hash_scalar(enum mb_hash hash, struct mb_job *job)
+{
+    uint32_t buffer[BFDEV_MD5_BLOCK_WORDS];
+    const uint8_t *data;
+    unsigned int count;
+    size_t blocks;
+
+    switch (hash) {
+        case MB_HASH_MD5:
+            data = job->data;
+            for (blocks = job->blocks; blocks--; data += MB_HASH_BLOCK) {
+                for (count = 0; count < BFDEV_MD5_BLOCK_WORDS; ++count)
+                    buffer[count] = bfdev_unaligned_get_le32(data + count * 4);
+                bfdev_md5_transform(job->state, buffer);
+            }
+            break;
+
+        case MB_HASH_SHA1:
+            sha1_blocks(job->state, job->data, job->blocks);
+            break;
+
+        case MB_HASH_SHA2: default:
+            sha2_blocks(job->state, job->data, job->blocks);
+            break;
+    }
+
+    job->blocks = 0;
+}
+
+hidden void
+mb_hash_update(enum mb_hash hash, struct mb_job *job, uint32_t *state,
+               uint8_t *buffer, unsigned long *count,
+               const void *data, size_t size)
+{
+    unsigned int partial;
+    size_t length;
+
+    partial = *count % MB_HASH_BLOCK;
+    *count += size;
+
+    job->state = state;
+    job->data = data;
+    job->blocks = 0;
+
+    if (partial) {
+        length = bfdev_min(MB_HASH_BLOCK - partial, size);
+        bfport_memcpy(buffer + partial, data, length);
+        data += length;
+        size -= length;
+
+        if (partial + length < MB_HASH_BLOCK)
+            return;
+
+        /* a lone block is not worth a lane */
+        job->data = buffer;
+        job->blocks = 1;
+        mb_hash_scalar(hash, job);
+    }
+
+    job->data = data;
+    job->blocks = size / MB_HASH_BLOCK;
+
+    length = job->blocks * MB_HASH_BLOCK;
+    bfport_memcpy(buffer, data + length, size - length);
+}
+
+hidden void
+mb_hash_final(enum mb_hash hash, struct mb_job *job, uint32_t *state,
+              const uint8_t *buffer, unsigned long count, uint8_t *tail)
+{
+    unsigned int partial, length;
+
+    partial = count % MB_HASH_BLOCK;
+    length = partial + 1 + BFDEV_BYTES_PER_U64 > MB_HASH_BLOCK ?
+             MB_HASH_BLOCK * 2 : MB_HASH_BLOCK;
+
+    bfport_memcpy(tail, buffer, partial);
+    tail[partial] = 0x80;
+    bfport_memset(tail + partial + 1, 0, length - partial - 1);
+
+    if (hash == MB_HASH_MD5)
+        bfdev_unaligned_set_le64(tail + length - 8, (uint64_t)count << 3);
+    else
+        bfdev_unaligned_set_be64(tail + length - 8, (uint64_t)count << 3);
+
+    job->state = state;
+    job->data = tail;
+    job->blocks = length / MB_HASH_BLOCK;
+}
+
+/*
+ * Keeps every lane busy with the next stream as soon as its previous
+ * one drains. Idle lanes hash a copy of a busy lane into scratch state,
+ * until so few streams are left that scalar code gets them done faster.
+ */
+hidden void
+mb_hash_blocks(enum mb_hash hash, struct mb_job *jobs, unsigned int nr)
+{
+    uint32_t scratch[MB_HASH_LANES][BFDEV_SHA256_DIGEST_WORDS];
+    const uint8_t *data[MB_HASH_LANES];
+    uint32_t *state[MB_HASH_LANES];
+    struct mb_job *lanes[MB_HASH_LANES];
+    const struct mb_engine *engine;
+    unsigned int lane, busy, next, width;
+    const uint8_t *idle;
+    size_t blocks;
+
+    engine = bfdev_dispatch_ops(&mb_dispatch, struct mb_engine);
+    width = mb_width(engine, hash);
+    if (width == 1) {
+        for (next = 0; next < nr; ++next)
+            mb_hash_scalar(hash, &jobs[next]);
+        return;
+    }
+
+    /* idle lanes only need defined input, their output is thrown away */
+    bfport_memset(scratch, 0, sizeof(scratch));
+    for (lane = 0; lane < width; ++lane)
+        lanes[lane] = NULL;
+
+    for (next = 0;;) {
+        for (busy = lane = 0; lane < width; ++lane) {
+            while (!lanes[lane] && next < nr) {
+                if (jobs[next].blocks)
+                    lanes[lane] = &jobs[next];
+                next++;
+            }
+            busy += !!lanes[lane];
+        }
+
+        if (!busy)
+            break;
+
+        if (busy <= width / 4 && next == nr) {
+            for (lane = 0; lane < width; ++lane) {
+                if (lanes[lane])
+                    mb_hash_scalar(hash, lanes[lane]);
+            }
+            break;
+        }
+
+        blocks = SIZE_MAX;
+        idle = NULL;
+
+        for (lane = 0; lane < width; ++lane) {
+            if (lanes[lane]) {
+                blocks = bfdev_min(blocks, lanes[lane]->blocks);
+                state[lane] = lanes[lane]->state;
+                data[lane] = idle = lanes[lane]->data;
+            }
+        }
+
+        for (lane = 0; lane < width; ++lane) {
+            if (!lanes[lane]) {
+                state[lane] = scratch[lane];
+                data[lane] = idle;
+            }
+        }
+
+        engine->transform[hash](state, data, blocks);
+
+        for (lane = 0; lane < width; ++lane) {
+            if (!lanes[lane])
+                continue;
+
+            lanes[lane]->data += blocks * MB_HASH_BLOCK;
+            lanes[lane]->blocks -= blocks;
+            if (!lanes[lane]->blocks)
+                lanes[lane] = NULL;
+        }
+    }
+}
+
+static __bfdev_ctor int
+mb_hash_init(void)
+{
+#ifdef SHA_ACCEL_X86
+    mb_native = bfdev_cpu_has_all(BFDEV_CPU_FEATURE(BFDEV_CPU_SHANI) |
+                                  BFDEV_CPU_FEATURE(BFDEV_CPU_SSE41));
+#endif
+
+#ifdef SHA_ACCEL_ARM64
+    mb_native = bfdev_cpu_has_all(BFDEV_CPU_FEATURE(BFDEV_CPU_SHA1) |
+                                  BFDEV_CPU_FEATURE(BFDEV_CPU_SHA2));
+#endif
+
+    return bfdev_dispatch_register(&mb_dispatch);
+}
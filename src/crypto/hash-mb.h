@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_HASH_MB_H_
+#define _LOCAL_HASH_MB_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+#if defined(__x86_64__) && defined(__GNUC__)
+# define MB_HASH_X86
+#endif
+
+/* four 32-bit lanes of gcc vectors lower to sse2 or neon */
+#if defined(__GNUC__) && (defined(__SSE2__) || defined(__aarch64__))
+# define MB_HASH_SIMD
+#endif
+
+/* every digest shares the same block size */
+#define MB_HASH_BLOCK 64
+#define MB_HASH_BATCH 64
+#define MB_HASH_LANES 16
+
+enum mb_hash {
+    MB_HASH_MD5 = 0,
+    MB_HASH_SHA1,
+    MB_HASH_SHA2,
+    MB_HASH_NR,
+};
+
+/**
+ * struct mb_job - whole blocks of one message stream.
+ * @state: chaining state of the stream.
+ * @data: first block to hash.
+ * @blocks: number of blocks at @data.
+ */
+struct mb_job {
+    uint32_t *state;
+    const uint8_t *data;
+    size_t blocks;
+};
+
+typedef void
+(*mb_transform_t)(uint32_t *const *state, const uint8_t *const *data,
+                  size_t blocks);
+
+/*
+ * mb_hash_update() - buffer a partial block and queue the whole ones.
+ * mb_hash_final() - queue the padded last blocks, built in @tail.
+ * mb_hash_blocks() - run queued jobs side by side in vector lanes.
+ */
+
+extern hidden void
+mb_hash_update(enum mb_hash hash, struct mb_job *job, uint32_t *state,
+               uint8_t *buffer, unsigned long *count,
+               const void *data, size_t size);
+
+extern hidden void
+mb_hash_final(enum mb_hash hash, struct mb_job *job, uint32_t *state,
+              const uint8_t *buffer, unsigned long count, uint8_t *tail);
+
+extern hidden void
+mb_hash_blocks(enum mb_hash hash, struct mb_job *jobs, unsigned int nr);
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_HASH_MB_H_ */
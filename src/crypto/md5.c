@@ -7,6 +7,7 @@
 #include <bfdev/md5.h>
 #include <bfdev/crypto/md5.h>
 #include <bfdev/crypto/md5-base.h>
+#include "hash-mb.h"
 #include <export.h>
 
 static inline void
@@ -30,6 +31,45 @@ bfdev_md5_finish(bfdev_md5_ctx_t *ctx, void *hash)
     bfdev_md5_base_final(ctx, hash);
 }
 
+export void
+bfdev_md5_update_mb(bfdev_md5_ctx_t *const *ctx, const char *const *data,
+                    const size_t *size, unsigned int nr)
+{
+    struct mb_job jobs[MB_HASH_BATCH];
+    unsigned int index, count;
+
+    for (; nr; ctx += count, data += count, size += count, nr -= count) {
+        count = bfdev_min(nr, MB_HASH_BATCH);
+        for (index = 0; index < count; ++index)
+            mb_hash_update(MB_HASH_MD5, &jobs[index], ctx[index]->digest,
+                           (uint8_t *)ctx[index]->block, &ctx[index]->count,
+                           data[index], size[index]);
+
+        mb_hash_blocks(MB_HASH_MD5, jobs, count);
+    }
+}
+
+export void
+bfdev_md5_finish_mb(bfdev_md5_ctx_t *const *ctx, void *const *hash,
+                    unsigned int nr)
+{
+    uint8_t tail[MB_HASH_BATCH][MB_HASH_BLOCK * 2];
+    struct mb_job jobs[MB_HASH_BATCH];
+    unsigned int index, count;
+
+    for (; nr; ctx += count, hash += count, nr -= count) {
+        count = bfdev_min(nr, MB_HASH_BATCH);
+        for (index = 0; index < count; ++index)
+            mb_hash_final(MB_HASH_MD5, &jobs[index], ctx[index]->digest,
+                          (uint8_t *)ctx[index]->block, ctx[index]->count,
+                          tail[index]);
+
+        mb_hash_blocks(MB_HASH_MD5, jobs, count);
+        for (index = 0; index < count; ++index)
+            bfdev_md5_base_final(ctx[index], hash[index]);
+    }
+}
+
 export void
 bfdev_md5_init(bfdev_md5_ctx_t *ctx)
 {
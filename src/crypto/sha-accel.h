@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_SHA_ACCEL_H_
+#define _LOCAL_SHA_ACCEL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/cpufeature.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+#if defined(__x86_64__) && defined(__GNUC__)
+# define SHA_ACCEL_X86
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+# define SHA_ACCEL_ARM64
+#endif
+
+typedef void
+(*sha_blocks_t)(uint32_t *state, const uint8_t *data, size_t blocks);
+
+struct sha_ops {
+    sha_blocks_t blocks;
+};
+
+/* sha-ni works on xmm registers, its shuffles need sse4.1 */
+#define SHA_SHANI_FEATURES ( \
+    BFDEV_CPU_FEATURE(BFDEV_CPU_SHANI) | \
+    BFDEV_CPU_FEATURE(BFDEV_CPU_SSE41) \
+)
+
+/*
+ * sha1_*() - run the sha1 compression over whole blocks.
+ * sha2_*() - run the sha256 compression over whole blocks.
+ * @state: chaining state, same layout as the generic code.
+ * @data: the blocks to hash.
+ * @blocks: number of blocks.
+ */
+
+extern hidden void
+sha1_blocks(uint32_t *state, const uint8_t *data, size_t blocks);
+
+extern hidden void
+sha2_blocks(uint32_t *state, const uint8_t *data, size_t blocks);
+
+#ifdef SHA_ACCEL_X86
+extern hidden void
+sha1_shani(uint32_t *state, const uint8_t *data, size_t blocks);
+
+extern hidden void
+sha2_shani(uint32_t *state, const uint8_t *data, size_t blocks);
+#endif
+
+#ifdef SHA_ACCEL_ARM64
+extern hidden void
+sha1_armv8(uint32_t *state, const uint8_t *data, size_t blocks);
+
+extern hidden void
+sha2_armv8(uint32_t *state, const uint8_t *data, size_t blocks);
+#endif
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_SHA_ACCEL_H_ */
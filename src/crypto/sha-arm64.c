@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/crypto/sha2.h>
+#include "sha-accel.h"
+#include <export.h>
+
+#ifdef SHA_ACCEL_ARM64
+#include <arm_neon.h>
+
+#ifdef __clang__
+# define ARMV8_TARGET __bfdev_target("sha2")
+#else
+# define ARMV8_TARGET __bfdev_target("+crypto")
+#endif
+
+static const uint32_t
+sha1_armv8_k[4] = {
+    0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6,
+};
+
+static ARMV8_TARGET __bfdev_always_inline uint32x4_t
+armv8_load(const uint8_t *src)
+{
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src)));
+}
+
+hidden ARMV8_TARGET void
+sha1_armv8(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    uint32x4_t abcd, save, tmp, msg[4];
+    uint32_t e0, e1, esave;
+    unsigned int count;
+
+    abcd = vld1q_u32(state);
+    e0 = state[4];
+
+    for (; blocks--; data += 64) {
+        save = abcd;
+        esave = e0;
+
+        for (count = 0; count < 4; ++count)
+            msg[count] = armv8_load(data + count * 16);
+
+        for (count = 0; count < 20; ++count) {
+            tmp = vaddq_u32(msg[count & 3], vdupq_n_u32(sha1_armv8_k[count / 5]));
+            e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+
+            if (count < 5)
+                abcd = vsha1cq_u32(abcd, e0, tmp);
+            else if (count >= 10 && count < 15)
+                abcd = vsha1mq_u32(abcd, e0, tmp);
+            else
+                abcd = vsha1pq_u32(abcd, e0, tmp);
+            e0 = e1;
+
+            if (count < 16) {
+                msg[count & 3] = vsha1su1q_u32(vsha1su0q_u32(msg[count & 3],
+                    msg[(count + 1) & 3], msg[(count + 2) & 3]),
+                    msg[(count + 3) & 3]);
+            }
+        }
+
+        abcd = vaddq_u32(abcd, save);
+        e0 += esave;
+    }
+
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+hidden ARMV8_TARGET void
+sha2_armv8(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    uint32x4_t state0, state1, save0, save1, tmp, prev, msg[4];
+    unsigned int count;
+
+    state0 = vld1q_u32(state);
+    state1 = vld1q_u32(state + 4);
+
+    for (; blocks--; data += 64) {
+        save0 = state0;
+        save1 = state1;
+
+        for (count = 0; count < 4; ++count)
+            msg[count] = armv8_load(data + count * 16);
+
+        for (count = 0; count < 16; ++count) {
+            tmp = vaddq_u32(msg[count & 3], vld1q_u32(bfdev_sha2_k + count * 4));
+
+            if (count < 12) {
+                msg[count & 3] = vsha256su1q_u32(vsha256su0q_u32(
+                    msg[count & 3], msg[(count + 1) & 3]),
+                    msg[(count + 2) & 3], msg[(count + 3) & 3]);
+            }
+
+            prev = state0;
+            state0 = vsha256hq_u32(state0, state1, tmp);
+            state1 = vsha256h2q_u32(state1, prev, tmp);
+        }
+
+        state0 = vaddq_u32(state0, save0);
+        state1 = vaddq_u32(state1, save1);
+    }
+
+    vst1q_u32(state, state0);
+    vst1q_u32(state + 4, state1);
+}
+
+#endif /* SHA_ACCEL_ARM64 */
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/crypto/sha2.h>
+#include "sha-accel.h"
+#include <export.h>
+
+#ifdef SHA_ACCEL_X86
+#include <immintrin.h>
+
+#define SHANI_TARGET __bfdev_target("sha,sse4.1")
+
+/*
+ * The message lives in four vectors of four words, each one reused
+ * for the schedule as soon as its rounds are done. sha1rnds4 takes
+ * the round function as an immediate, hence the unrolled groups.
+ */
+#define SHANI_SHA1_GROUP(count, func) do {                              \
+    if ((count) >= 4) {                                                 \
+        msg[(count) & 3] = _mm_sha1msg2_epu32(_mm_xor_si128(            \
+            _mm_sha1msg1_epu32(msg[(count) & 3], msg[((count) + 1) & 3]),\
+            msg[((count) + 2) & 3]), msg[((count) + 3) & 3]);           \
+    }                                                                   \
+    if (count)                                                          \
+        e0 = _mm_sha1nexte_epu32(prev, msg[(count) & 3]);               \
+    else                                                                \
+        e0 = _mm_add_epi32(e0, msg[0]);                                 \
+    prev = abcd;                                                        \
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, func);                         \
+} while (0)
+
+hidden SHANI_TARGET void
+sha1_shani(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    __m128i abcd, prev, save, e0, e1, swap, msg[4];
+    unsigned int count;
+
+    swap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+    e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+    for (; blocks--; data += 64) {
+        save = abcd;
+        e1 = e0;
+
+        for (count = 0; count < 4; ++count) {
+            msg[count] = _mm_loadu_si128((const __m128i *)data + count);
+            msg[count] = _mm_shuffle_epi8(msg[count], swap);
+        }
+
+        SHANI_SHA1_GROUP( 0, 0);
+        SHANI_SHA1_GROUP( 1, 0);
+        SHANI_SHA1_GROUP( 2, 0);
+        SHANI_SHA1_GROUP( 3, 0);
+        SHANI_SHA1_GROUP( 4, 0);
+        SHANI_SHA1_GROUP( 5, 1);
+        SHANI_SHA1_GROUP( 6, 1);
+        SHANI_SHA1_GROUP( 7, 1);
+        SHANI_SHA1_GROUP( 8, 1);
+        SHANI_SHA1_GROUP( 9, 1);
+        SHANI_SHA1_GROUP(10, 2);
+        SHANI_SHA1_GROUP(11, 2);
+        SHANI_SHA1_GROUP(12, 2);
+        SHANI_SHA1_GROUP(13, 2);
+        SHANI_SHA1_GROUP(14, 2);
+        SHANI_SHA1_GROUP(15, 3);
+        SHANI_SHA1_GROUP(16, 3);
+        SHANI_SHA1_GROUP(17, 3);
+        SHANI_SHA1_GROUP(18, 3);
+        SHANI_SHA1_GROUP(19, 3);
+
+        e0 = _mm_sha1nexte_epu32(prev, e1);
+        abcd = _mm_add_epi32(abcd, save);
+    }
+
+    _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+/*
+ * sha256rnds2 wants the state split as ABEF and CDGH, converted from
+ * and back to the linear layout around the blocks.
+ */
+hidden SHANI_TARGET void
+sha2_shani(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    __m128i state0, state1, save0, save1, tmp, swap, msg[4];
+    unsigned int count;
+
+    swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0xb1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state + 1), 0x1b);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    for (; blocks--; data += 64) {
+        save0 = state0;
+        save1 = state1;
+
+        for (count = 0; count < 4; ++count) {
+            msg[count] = _mm_loadu_si128((const __m128i *)data + count);
+            msg[count] = _mm_shuffle_epi8(msg[count], swap);
+        }
+
+        for (count = 0; count < 16; ++count) {
+            tmp = _mm_add_epi32(msg[count & 3], _mm_loadu_si128(
+                (const __m128i *)bfdev_sha2_k + count));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);
+            state0 = _mm_sha256rnds2_epu32(state0, state1,
+                                           _mm_shuffle_epi32(tmp, 0x0e));
+
+            if (count < 12) {
+                tmp = _mm_alignr_epi8(msg[(count + 3) & 3],
+                                      msg[(count + 2) & 3], 4);
+                msg[count & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(
+                    _mm_sha256msg1_epu32(msg[count & 3], msg[(count + 1) & 3]),
+                    tmp), msg[(count + 3) & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, save0);
+        state1 = _mm_add_epi32(state1, save1);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128((__m128i *)state, state0);
+    _mm_storeu_si128((__m128i *)state + 1, state1);
+}
+
+#endif /* SHA_ACCEL_X86 */
@@ -7,19 +7,74 @@
 #include <bfdev/sha1.h>
 #include <bfdev/crypto/sha1.h>
 #include <bfdev/crypto/sha1-base.h>
+#include <bfdev/dispatch.h>
+#include "hash-mb.h"
+#include "sha-accel.h"
 #include <export.h>
 
 static void
-sha1_transform_block(bfdev_sha1_ctx_t *ctx, const void *src, size_t blocks)
+sha1_generic(uint32_t *state, const uint8_t *data, size_t blocks)
 {
     uint32_t buffer[BFDEV_SHA1_WORKSPACE_WORDS];
 
     while (blocks--) {
-        bfdev_sha1_transform(ctx->state, buffer, src);
-        src += BFDEV_SHA1_BLOCK_SIZE;
+        bfdev_sha1_transform(state, buffer, data);
+        data += BFDEV_SHA1_BLOCK_SIZE;
     }
 }
 
+static const struct sha_ops
+sha1_generic_ops = {
+    .blocks = sha1_generic,
+};
+
+#ifdef SHA_ACCEL_X86
+static const struct sha_ops
+sha1_shani_ops = {
+    .blocks = sha1_shani,
+};
+#endif
+
+#ifdef SHA_ACCEL_ARM64
+static const struct sha_ops
+sha1_armv8_ops = {
+    .blocks = sha1_armv8,
+};
+#endif
+
+static const bfdev_dispatch_impl_t
+sha1_impls[] = {
+#ifdef SHA_ACCEL_X86
+    BFDEV_DISPATCH_IMPL("shani", SHA_SHANI_FEATURES, &sha1_shani_ops),
+#endif
+#ifdef SHA_ACCEL_ARM64
+    BFDEV_DISPATCH_IMPL("armv8", BFDEV_CPU_FEATURE(BFDEV_CPU_SHA1),
+                        &sha1_armv8_ops),
+#endif
+    BFDEV_DISPATCH_IMPL("generic", 0, &sha1_generic_ops),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(sha1_dispatch, "sha1", sha1_impls, &sha1_generic_ops);
+
+static __bfdev_always_inline const struct sha_ops *
+sha1_ops(void)
+{
+    return bfdev_dispatch_ops(&sha1_dispatch, struct sha_ops);
+}
+
+hidden void
+sha1_blocks(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    sha1_ops()->blocks(state, data, blocks);
+}
+
+static void
+sha1_transform_block(bfdev_sha1_ctx_t *ctx, const void *src, size_t blocks)
+{
+    sha1_ops()->blocks(ctx->state, src, blocks);
+}
+
 export void
 bfdev_sha1_update(bfdev_sha1_ctx_t *ctx, const char *data, size_t size)
 {
@@ -33,9 +88,54 @@ bfdev_sha1_finish(bfdev_sha1_ctx_t *ctx, void *hash)
     bfdev_sha1_base_finish(ctx, hash);
 }
 
+export void
+bfdev_sha1_update_mb(bfdev_sha1_ctx_t *const *ctx, const char *const *data,
+                     const size_t *size, unsigned int nr)
+{
+    struct mb_job jobs[MB_HASH_BATCH];
+    unsigned int index, count;
+
+    for (; nr; ctx += count, data += count, size += count, nr -= count) {
+        count = bfdev_min(nr, MB_HASH_BATCH);
+        for (index = 0; index < count; ++index)
+            mb_hash_update(MB_HASH_SHA1, &jobs[index], ctx[index]->state,
+                           ctx[index]->buffer, &ctx[index]->count,
+                           data[index], size[index]);
+
+        mb_hash_blocks(MB_HASH_SHA1, jobs, count);
+    }
+}
+
+export void
+bfdev_sha1_finish_mb(bfdev_sha1_ctx_t *const *ctx, void *const *hash,
+                     unsigned int nr)
+{
+    uint8_t tail[MB_HASH_BATCH][MB_HASH_BLOCK * 2];
+    struct mb_job jobs[MB_HASH_BATCH];
+    unsigned int index, count;
+
+    for (; nr; ctx += count, hash += count, nr -= count) {
+        count = bfdev_min(nr, MB_HASH_BATCH);
+        for (index = 0; index < count; ++index)
+            mb_hash_final(MB_HASH_SHA1, &jobs[index], ctx[index]->state,
+                          ctx[index]->buffer, ctx[index]->count,
+                          tail[index]);
+
+        mb_hash_blocks(MB_HASH_SHA1, jobs, count);
+        for (index = 0; index < count; ++index)
+            bfdev_sha1_base_finish(ctx[index], hash[index]);
+    }
+}
+
 export void
 bfdev_sha1_init(bfdev_sha1_ctx_t *ctx)
 {
     bfdev_sha1_digest_init(ctx->state);
     ctx->count = 0;
 }
+
+static __bfdev_ctor int
+sha1_init(void)
+{
+    return bfdev_dispatch_register(&sha1_dispatch);
+}
@@ -7,19 +7,74 @@
 #include <bfdev/sha2.h>
 #include <bfdev/crypto/sha2.h>
 #include <bfdev/crypto/sha2-base.h>
+#include <bfdev/dispatch.h>
+#include "hash-mb.h"
+#include "sha-accel.h"
 #include <export.h>
 
 static void
-sha2_transform_block(bfdev_sha2_ctx_t *ctx, const void *src, size_t blocks)
+sha2_generic(uint32_t *state, const uint8_t *data, size_t blocks)
 {
     uint32_t buffer[BFDEV_SHA2_WORKSPACE_WORDS];
 
     while (blocks--) {
-        bfdev_sha2_transform(ctx->state, buffer, src);
-        src += BFDEV_SHA2_BLOCK_SIZE;
+        bfdev_sha2_transform(state, buffer, data);
+        data += BFDEV_SHA2_BLOCK_SIZE;
     }
 }
 
+static const struct sha_ops
+sha2_generic_ops = {
+    .blocks = sha2_generic,
+};
+
+#ifdef SHA_ACCEL_X86
+static const struct sha_ops
+sha2_shani_ops = {
+    .blocks = sha2_shani,
+};
+#endif
+
+#ifdef SHA_ACCEL_ARM64
+static const struct sha_ops
+sha2_armv8_ops = {
+    .blocks = sha2_armv8,
+};
+#endif
+
+static const bfdev_dispatch_impl_t
+sha2_impls[] = {
+#ifdef SHA_ACCEL_X86
+    BFDEV_DISPATCH_IMPL("shani", SHA_SHANI_FEATURES, &sha2_shani_ops),
+#endif
+#ifdef SHA_ACCEL_ARM64
+    BFDEV_DISPATCH_IMPL("armv8", BFDEV_CPU_FEATURE(BFDEV_CPU_SHA2),
+                        &sha2_armv8_ops),
+#endif
+    BFDEV_DISPATCH_IMPL("generic", 0, &sha2_generic_ops),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(sha2_dispatch, "sha2", sha2_impls, &sha2_generic_ops);
+
+static __bfdev_always_inline const struct sha_ops *
+sha2_ops(void)
+{
+    return bfdev_dispatch_ops(&sha2_dispatch, struct sha_ops);
+}
+
+hidden void
+sha2_blocks(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    sha2_ops()->blocks(state, data, blocks);
+}
+
+static void
+sha2_transform_block(bfdev_sha2_ctx_t *ctx, const void *src, size_t blocks)
+{
+    sha2_ops()->blocks(ctx->state, src, blocks);
+}
+
 export void
 bfdev_sha2_update(bfdev_sha2_ctx_t *ctx, const char *data, size_t size)
 {
@@ -40,6 +95,59 @@ bfdev_sha256_finish(bfdev_sha2_ctx_t *ctx, void *hash)
     bfdev_sha2_base_finish(ctx, BFDEV_SHA256_DIGEST_WORDS, hash);
 }
 
+static void
+sha2_finish_mb(bfdev_sha2_ctx_t *const *ctx, void *const *hash,
+               unsigned int nr, unsigned int dsize)
+{
+    uint8_t tail[MB_HASH_BATCH][MB_HASH_BLOCK * 2];
+    struct mb_job jobs[MB_HASH_BATCH];
+    unsigned int index, count;
+
+    for (; nr; ctx += count, hash += count, nr -= count) {
+        count = bfdev_min(nr, MB_HASH_BATCH);
+        for (index = 0; index < count; ++index)
+            mb_hash_final(MB_HASH_SHA2, &jobs[index], ctx[index]->state,
+                          ctx[index]->buffer, ctx[index]->count,
+                          tail[index]);
+
+        mb_hash_blocks(MB_HASH_SHA2, jobs, count);
+        for (index = 0; index < count; ++index)
+            bfdev_sha2_base_finish(ctx[index], dsize, hash[index]);
+    }
+}
+
+export void
+bfdev_sha2_update_mb(bfdev_sha2_ctx_t *const *ctx, const char *const *data,
+                     const size_t *size, unsigned int nr)
+{
+    struct mb_job jobs[MB_HASH_BATCH];
+    unsigned int index, count;
+
+    for (; nr; ctx += count, data += count, size += count, nr -= count) {
+        count = bfdev_min(nr, MB_HASH_BATCH);
+        for (index = 0; index < count; ++index)
+            mb_hash_update(MB_HASH_SHA2, &jobs[index], ctx[index]->state,
+                           ctx[index]->buffer, &ctx[index]->count,
+                           data[index], size[index]);
+
+        mb_hash_blocks(MB_HASH_SHA2, jobs, count);
+    }
+}
+
+export void
+bfdev_sha224_finish_mb(bfdev_sha2_ctx_t *const *ctx, void *const *hash,
+                       unsigned int nr)
+{
+    sha2_finish_mb(ctx, hash, nr, BFDEV_SHA224_DIGEST_WORDS);
+}
+
+export void
+bfdev_sha256_finish_mb(bfdev_sha2_ctx_t *const *ctx, void *const *hash,
+                       unsigned int nr)
+{
+    sha2_finish_mb(ctx, hash, nr, BFDEV_SHA256_DIGEST_WORDS);
+}
+
 export void
 bfdev_sha224_init(bfdev_sha2_ctx_t *ctx)
 {
@@ -53,3 +161,9 @@ bfdev_sha256_init(bfdev_sha2_ctx_t *ctx)
     bfdev_sha256_digest_init(ctx->state);
     ctx->count = 0;
 }
+
+static __bfdev_ctor int
+sha2_init(void)
+{
+    return bfdev_dispatch_register(&sha2_dispatch);
+}
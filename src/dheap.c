@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/dheap.h>
+#include <export.h>
+
+static __bfdev_always_inline unsigned int
+dheap_ways(const bfdev_dheap_t *heap)
+{
+    return heap->ways ?: BFDEV_DHEAP_WAYS;
+}
+
+static __bfdev_always_inline bfdev_dheap_node_t **
+dheap_base(const bfdev_dheap_t *heap)
+{
+    return heap->nodes.data;
+}
+
+static __bfdev_always_inline void
+dheap_place(bfdev_dheap_node_t **base, unsigned long index,
+            bfdev_dheap_node_t *node)
+{
+    base[index] = node;
+    node->index = index;
+}
+
+static void
+dheap_sift_up(bfdev_dheap_t *heap, unsigned long index,
+              bfdev_dheap_node_t *node)
+{
+    bfdev_dheap_node_t **base;
+    unsigned long parent;
+    unsigned int ways;
+
+    base = dheap_base(heap);
+    ways = dheap_ways(heap);
+
+    while (index) {
+        parent = (index - 1) / ways;
+        if (heap->cmp(node, base[parent], heap->pdata) >= 0)
+            break;
+
+        /* move the parent down into the hole */
+        dheap_place(base, index, base[parent]);
+        index = parent;
+    }
+
+    dheap_place(base, index, node);
+}
+
+static void
+dheap_sift_down(bfdev_dheap_t *heap, unsigned long index,
+                bfdev_dheap_node_t *node)
+{
+    bfdev_dheap_node_t **base;
+    unsigned long count, child, last, best;
+    unsigned int ways;
+
+    base = dheap_base(heap);
+    ways = dheap_ways(heap);
+    count = bfdev_dheap_count(heap);
+
+    for (;;) {
+        child = index * ways + 1;
+        if (child >= count)
+            break;
+
+        last = bfdev_min(child + ways, count);
+        for (best = child++; child < last; ++child) {
+            if (heap->cmp(base[child], base[best], heap->pdata) < 0)
+                best = child;
+        }
+
+        if (heap->cmp(base[best], node, heap->pdata) >= 0)
+            break;
+
+        /* move the smallest child up into the hole */
+        dheap_place(base, index, base[best]);
+        index = best;
+    }
+
+    dheap_place(base, index, node);
+}
+
+static void
+dheap_adjust(bfdev_dheap_t *heap, unsigned long index,
+             bfdev_dheap_node_t *node)
+{
+    bfdev_dheap_node_t **base;
+    unsigned long parent;
+
+    base = dheap_base(heap);
+    if (index) {
+        parent = (index - 1) / dheap_ways(heap);
+        if (heap->cmp(node, base[parent], heap->pdata) < 0) {
+            dheap_sift_up(heap, index, node);
+            return;
+        }
+    }
+
+    dheap_sift_down(heap, index, node);
+}
+
+export int
+bfdev_dheap_insert(bfdev_dheap_t *heap, bfdev_dheap_node_t *node)
+{
+    bfdev_dheap_node_t **slot;
+    unsigned long index;
+
+    index = bfdev_dheap_count(heap);
+    slot = bfdev_array_push(&heap->nodes, 1);
+    if (bfdev_unlikely(!slot))
+        return -BFDEV_ENOMEM;
+
+    dheap_sift_up(heap, index, node);
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_dheap_delete(bfdev_dheap_t *heap, bfdev_dheap_node_t *node)
+{
+    bfdev_dheap_node_t **slot, *last;
+    unsigned long index;
+
+    index = node->index;
+    BFDEV_BUG_ON(index >= bfdev_dheap_count(heap));
+    BFDEV_BUG_ON(dheap_base(heap)[index] != node);
+
+    slot = bfdev_array_pop(&heap->nodes, 1);
+    last = *slot;
+
+    /* fill the hole with the last leaf */
+    if (last != node)
+        dheap_adjust(heap, index, last);
+}
+
+export bfdev_dheap_node_t *
+bfdev_dheap_pop(bfdev_dheap_t *heap)
+{
+    bfdev_dheap_node_t **slot, *node, *last;
+
+    if (bfdev_unlikely(bfdev_dheap_empty(heap)))
+        return NULL;
+
+    node = dheap_base(heap)[0];
+    slot = bfdev_array_pop(&heap->nodes, 1);
+    last = *slot;
+
+    if (last != node)
+        dheap_sift_down(heap, 0, last);
+
+    return node;
+}
+
+export void
+bfdev_dheap_update(bfdev_dheap_t *heap, bfdev_dheap_node_t *node)
+{
+    BFDEV_BUG_ON(node->index >= bfdev_dheap_count(heap));
+    dheap_adjust(heap, node->index, node);
+}
+
+export int
+bfdev_dheap_heapify(bfdev_dheap_t *heap, bfdev_dheap_node_t **nodes,
+                    unsigned long num)
+{
+    bfdev_dheap_node_t **base, **slot;
+    unsigned long count, index;
+
+    if (bfdev_unlikely(!num))
+        return -BFDEV_ENOERR;
+
+    slot = bfdev_array_push(&heap->nodes, num);
+    if (bfdev_unlikely(!slot))
+        return -BFDEV_ENOMEM;
+
+    base = dheap_base(heap);
+    count = bfdev_dheap_count(heap);
+    bfport_memcpy(slot, nodes, num * sizeof(*nodes));
+
+    for (index = count - num; index < count; ++index)
+        base[index]->index = index;
+
+    if (count < 2)
+        return -BFDEV_ENOERR;
+
+    /* Floyd's method: sift down every internal node from the bottom */
+    index = (count - 2) / dheap_ways(heap) + 1;
+    while (index--)
+        dheap_sift_down(heap, index, base[index]);
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_dheap_release(bfdev_dheap_t *heap)
+{
+    bfdev_array_release(&heap->nodes);
+}
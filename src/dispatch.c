@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/dispatch.h>
+#include <bfdev/atomic.h>
+#include <export.h>
+
+static
+BFDEV_LIST_HEAD(dispatch_modules);
+
+static bool
+dispatch_match(const char *name, const char *str, size_t length)
+{
+    return bfport_strlen(name) == length && !bfport_memcmp(name, str, length);
+}
+
+/*
+ * Look up the implementation the environment asks for. An entry naming
+ * the module wins over a bare one, whatever their order.
+ */
+static const char *
+dispatch_override(const char *module, size_t *plength)
+{
+    const char *list, *walk, *found;
+    size_t length, equal, flength;
+
+    list = bfport_getenv("BFDEV_DISPATCH");
+    if (!list)
+        return NULL;
+
+    found = NULL;
+    flength = 0;
+
+    for (walk = list; *walk; walk += length) {
+        walk += bfport_strspn(walk, ", ");
+        length = bfport_strcspn(walk, ", ");
+        if (!length)
+            continue;
+
+        equal = bfport_strcspn(walk, "=");
+        if (equal >= length) {
+            if (!found) {
+                found = walk;
+                flength = length;
+            }
+            continue;
+        }
+
+        if (dispatch_match(module, walk, equal)) {
+            *plength = length - equal - 1;
+            return walk + equal + 1;
+        }
+    }
+
+    *plength = flength;
+    return found;
+}
+
+static const bfdev_dispatch_impl_t *
+dispatch_impl_find(bfdev_dispatch_t *dispatch, const char *name,
+                   size_t length)
+{
+    unsigned int index;
+
+    for (index = 0; index < dispatch->count; ++index) {
+        if (dispatch_match(dispatch->impls[index].name, name, length))
+            return &dispatch->impls[index];
+    }
+
+    return NULL;
+}
+
+static const bfdev_dispatch_impl_t *
+dispatch_default(bfdev_dispatch_t *dispatch)
+{
+    const bfdev_dispatch_impl_t *impl;
+    const char *name;
+    unsigned int index;
+    size_t length;
+
+    name = dispatch_override(dispatch->name, &length);
+    if (name) {
+        impl = dispatch_impl_find(dispatch, name, length);
+        if (impl && bfdev_dispatch_usable(impl))
+            return impl;
+    }
+
+    for (index = 0; index < dispatch->count; ++index) {
+        impl = &dispatch->impls[index];
+        if (bfdev_dispatch_usable(impl))
+            return impl;
+    }
+
+    return NULL;
+}
+
+static void
+dispatch_apply(bfdev_dispatch_t *dispatch, const bfdev_dispatch_impl_t *impl)
+{
+    dispatch->selected = impl;
+    BFDEV_WRITE_ONCE(dispatch->ops, impl->ops);
+}
+
+static bool
+dispatch_exist(bfdev_dispatch_t *dispatch)
+{
+    bfdev_dispatch_t *walk;
+
+    bfdev_list_for_each_entry(walk, &dispatch_modules, list) {
+        if (walk == dispatch)
+            return true;
+    }
+
+    return false;
+}
+
+export bool
+bfdev_dispatch_usable(const bfdev_dispatch_impl_t *impl)
+{
+    return impl->ops && bfdev_cpu_has_all(impl->features);
+}
+
+export int
+bfdev_dispatch_select(bfdev_dispatch_t *dispatch, const char *name)
+{
+    const bfdev_dispatch_impl_t *impl;
+
+    if (!name) {
+        impl = dispatch_default(dispatch);
+        if (bfdev_unlikely(!impl))
+            return -BFDEV_EINVAL;
+    } else {
+        impl = dispatch_impl_find(dispatch, name, bfport_strlen(name));
+        if (!impl)
+            return -BFDEV_ENOENT;
+
+        if (!bfdev_dispatch_usable(impl))
+            return -BFDEV_EOPNOTSUPP;
+    }
+
+    dispatch_apply(dispatch, impl);
+    return -BFDEV_ENOERR;
+}
+
+export bfdev_dispatch_t *
+bfdev_dispatch_find(const char *name)
+{
+    bfdev_dispatch_t *walk;
+
+    bfdev_list_for_each_entry(walk, &dispatch_modules, list) {
+        if (!bfport_strcmp(walk->name, name))
+            return walk;
+    }
+
+    return NULL;
+}
+
+export int
+bfdev_dispatch_register(bfdev_dispatch_t *dispatch)
+{
+    const bfdev_dispatch_impl_t *impl;
+
+    if (!(dispatch->name && dispatch->impls && dispatch->count))
+        return -BFDEV_EINVAL;
+
+    if (bfdev_dispatch_find(dispatch->name))
+        return -BFDEV_EALREADY;
+
+    impl = dispatch_default(dispatch);
+    if (!impl)
+        return -BFDEV_EINVAL;
+
+    dispatch_apply(dispatch, impl);
+    bfdev_list_add_prev(&dispatch_modules, &dispatch->list);
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_dispatch_unregister(bfdev_dispatch_t *dispatch)
+{
+    if (!dispatch_exist(dispatch))
+        return -BFDEV_ENOENT;
+
+    bfdev_list_del(&dispatch->list);
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,167 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/ebr.h>
+#include <bfdev/llist.h>
+#include <export.h>
+
+static void
+ebr_release(bfdev_ebr_t *ebr, bfdev_ebr_limbo_t *limbo)
+{
+    bfdev_ebr_node_t *node, *next;
+
+    for (node = limbo->head; node; node = next) {
+        next = node->next;
+        node->release(ebr->alloc, node);
+    }
+
+    limbo->head = NULL;
+    limbo->count = 0;
+}
+
+/*
+ * A pointer retired while the global epoch was E is unreachable for
+ * every critical section entered after E + 1 was published, so it
+ * can be released once the global epoch has reached E + 2.
+ */
+export void
+bfdev_ebr_collect(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread,
+                  bfdev_atomic_t epoch)
+{
+    bfdev_ebr_limbo_t *limbo;
+    unsigned int count;
+
+    thread->epoch = epoch;
+    for (count = 0; count < BFDEV_EBR_EPOCHS; ++count) {
+        limbo = &thread->limbo[count];
+        if (limbo->count && epoch - limbo->epoch >= 2)
+            ebr_release(ebr, limbo);
+    }
+}
+
+static void
+ebr_advance(bfdev_ebr_t *ebr)
+{
+    bfdev_ebr_thread_t *thread;
+    bfdev_slist_head_t *walk;
+    bfdev_atomic_t epoch, active;
+
+    epoch = bfdev_atomic_read(&ebr->epoch);
+    for (walk = BFDEV_READ_ONCE(ebr->threads.next); walk;
+         walk = BFDEV_READ_ONCE(walk->next)) {
+        thread = bfdev_container_of(walk, bfdev_ebr_thread_t, list);
+        active = bfdev_atomic_read(&thread->active);
+        if ((active & 1) && (bfdev_atomic_t)((uintptr_t)active >> 1) != epoch)
+            return;
+    }
+
+    bfdev_cmpxchg(&ebr->epoch, epoch, epoch + 1);
+}
+
+export void
+bfdev_ebr_retire(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread,
+                 bfdev_ebr_node_t *node, bfdev_ebr_release_t release)
+{
+    bfdev_ebr_limbo_t *limbo;
+    bfdev_atomic_t epoch;
+
+    epoch = bfdev_atomic_read(&ebr->epoch);
+    limbo = &thread->limbo[(uintptr_t)epoch % BFDEV_EBR_EPOCHS];
+
+    /* the slot still holds nodes from three or more epochs ago */
+    if (limbo->epoch != epoch) {
+        ebr_release(ebr, limbo);
+        limbo->epoch = epoch;
+    }
+
+    node->release = release;
+    node->next = limbo->head;
+    limbo->head = node;
+    limbo->count++;
+
+    if (++thread->retired >= BFDEV_EBR_RECLAIM) {
+        thread->retired = 0;
+        ebr_advance(ebr);
+        bfdev_ebr_collect(ebr, thread, bfdev_atomic_read(&ebr->epoch));
+    }
+}
+
+export bool
+bfdev_ebr_reclaim(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread)
+{
+    unsigned int count;
+
+    BFDEV_BUG_ON(thread->nest);
+
+    thread->retired = 0;
+    ebr_advance(ebr);
+    bfdev_ebr_collect(ebr, thread, bfdev_atomic_read(&ebr->epoch));
+
+    for (count = 0; count < BFDEV_EBR_EPOCHS; ++count) {
+        if (thread->limbo[count].count)
+            return false;
+    }
+
+    return true;
+}
+
+export bfdev_ebr_thread_t *
+bfdev_ebr_attach(bfdev_ebr_t *ebr)
+{
+    bfdev_ebr_thread_t *thread;
+    bfdev_slist_head_t *walk;
+    unsigned int count;
+
+    for (walk = BFDEV_READ_ONCE(ebr->threads.next); walk;
+         walk = BFDEV_READ_ONCE(walk->next)) {
+        thread = bfdev_container_of(walk, bfdev_ebr_thread_t, list);
+        if (!bfdev_atomic_read(&thread->used) &&
+            bfdev_cmpxchg(&thread->used, 0, 1) == 0)
+            return thread;
+    }
+
+    thread = bfdev_malloc(ebr->alloc, sizeof(*thread));
+    if (bfdev_unlikely(!thread))
+        return NULL;
+
+    thread->active = 0;
+    thread->used = 1;
+    thread->nest = 0;
+    thread->retired = 0;
+    thread->epoch = bfdev_atomic_read(&ebr->epoch);
+
+    for (count = 0; count < BFDEV_EBR_EPOCHS; ++count) {
+        thread->limbo[count] = (bfdev_ebr_limbo_t) {
+            .head = NULL, .count = 0, .epoch = 0,
+        };
+    }
+
+    bfdev_llist_add(&ebr->threads, &thread->list);
+
+    return thread;
+}
+
+export void
+bfdev_ebr_detach(bfdev_ebr_t *ebr, bfdev_ebr_thread_t *thread)
+{
+    BFDEV_BUG_ON(thread->nest);
+    bfdev_xchg(&thread->used, 0);
+}
+
+export void
+bfdev_ebr_destroy(bfdev_ebr_t *ebr)
+{
+    bfdev_ebr_thread_t *thread, *tmp;
+    unsigned int count;
+
+    bfdev_slist_for_each_entry_safe(thread, tmp, &ebr->threads, list) {
+        for (count = 0; count < BFDEV_EBR_EPOCHS; ++count)
+            ebr_release(ebr, &thread->limbo[count]);
+        bfdev_free(ebr->alloc, thread);
+    }
+
+    bfdev_slist_head_init(&ebr->threads);
+}
@@ -27,6 +27,23 @@
     bfport_memcpy(fold1, fold2, len - llen);                \
 } while (0)
 
+static __bfdev_always_inline unsigned long
+fifo_spans(void *data, unsigned long mask, unsigned long esize,
+           bfdev_fifo_span_t *spans, unsigned long len, unsigned long offset)
+{
+    unsigned long llen;
+
+    offset &= mask;
+    llen = bfdev_min(len, mask + 1 - offset);
+
+    spans[0].data = data + offset * esize;
+    spans[0].len = llen;
+    spans[1].data = data;
+    spans[1].len = len - llen;
+
+    return len;
+}
+
 static __bfdev_always_inline void
 fifo_out_copy(bfdev_fifo_t *fifo, void *buff, unsigned long len,
               unsigned long offset)
@@ -51,12 +68,13 @@ static __bfdev_always_inline unsigned long
 fifo_record_peek(bfdev_fifo_t *fifo, unsigned long recsize)
 {
     unsigned long mask, offset, length;
+    unsigned int shift;
     uint8_t *data;
 
     mask = fifo->mask;
     offset = fifo->out;
     data = fifo->data;
-    length = 0;
+    length = shift = 0;
 
     if (fifo->esize != 1) {
         offset *= fifo->esize;
@@ -64,10 +82,11 @@ fifo_record_peek(bfdev_fifo_t *fifo, unsigned long recsize)
         mask += fifo->esize - 1;
     }
 
+    /* stored least significant byte first, see record_poke */
     while (recsize--) {
-        length <<= BFDEV_BITS_PER_U8;
-        length |= data[offset & mask];
+        length |= (unsigned long)data[offset & mask] << shift;
         offset += fifo->esize;
+        shift += BFDEV_BITS_PER_U8;
     }
 
     return length;
@@ -80,7 +99,7 @@ fifo_record_poke(bfdev_fifo_t *fifo, unsigned long len, unsigned long recsize)
     uint8_t *data;
 
     mask = fifo->mask;
-    offset = fifo->out;
+    offset = fifo->in;
     data = fifo->data;
 
     if (fifo->esize != 1) {
@@ -150,6 +169,44 @@ bfdev_fifo_in_flat(bfdev_fifo_t *fifo, const void *buff, unsigned long len)
     return len;
 }
 
+export unsigned long
+bfdev_fifo_reserve_flat(bfdev_fifo_t *fifo, bfdev_fifo_span_t *spans,
+                        unsigned long len)
+{
+    unsigned long unused;
+
+    unused = fifo_unused(fifo);
+    bfdev_min_adj(len, unused);
+
+    return fifo_spans(fifo->data, fifo->mask, fifo->esize,
+                      spans, len, fifo->in);
+}
+
+export void
+bfdev_fifo_commit_flat(bfdev_fifo_t *fifo, unsigned long len)
+{
+    fifo->in += len;
+}
+
+export unsigned long
+bfdev_fifo_peek_spans_flat(bfdev_fifo_t *fifo, bfdev_fifo_span_t *spans,
+                           unsigned long len)
+{
+    unsigned long valid;
+
+    valid = fifo_valid(fifo);
+    bfdev_min_adj(len, valid);
+
+    return fifo_spans(fifo->data, fifo->mask, fifo->esize,
+                      spans, len, fifo->out);
+}
+
+export void
+bfdev_fifo_consume_flat(bfdev_fifo_t *fifo, unsigned long len)
+{
+    fifo->out += len;
+}
+
 export unsigned long
 bfdev_fifo_peek_record(bfdev_fifo_t *fifo, void *buff, unsigned long len,
                        unsigned long record)
@@ -232,3 +289,152 @@ bfdev_fifo_dynamic_free(bfdev_fifo_t *fifo)
     bfdev_free(alloc, fifo->data);
     fifo->data = NULL;
 }
+
+static __bfdev_always_inline void
+fifo_spsc_out_copy(bfdev_fifo_spsc_t *fifo, void *buff, unsigned long len,
+                   unsigned long offset)
+{
+    FIFO_GENERIC_COPY(
+        buff, fifo->data + offset,
+        buff + llen, fifo->data
+    );
+}
+
+static __bfdev_always_inline void
+fifo_spsc_in_copy(bfdev_fifo_spsc_t *fifo, const void *buff, unsigned long len,
+                  unsigned long offset)
+{
+    FIFO_GENERIC_COPY(
+        fifo->data + offset, buff,
+        fifo->data, buff + llen
+    );
+}
+
+export unsigned long
+bfdev_fifo_spsc_peek_flat(bfdev_fifo_spsc_t *fifo, void *buff,
+                          unsigned long len)
+{
+    unsigned long valid;
+
+    valid = bfdev_fifo_spsc_valid(fifo, len);
+    bfdev_min_adj(len, valid);
+    fifo_spsc_out_copy(fifo, buff, len, fifo->out);
+
+    return len;
+}
+
+export unsigned long
+bfdev_fifo_spsc_out_flat(bfdev_fifo_spsc_t *fifo, void *buff,
+                         unsigned long len)
+{
+    unsigned long llen;
+
+    llen = bfdev_fifo_spsc_peek_flat(fifo, buff, len);
+    if (llen) {
+        /* the slots may be reused once the producer sees the new index */
+        bfdev_atomic_write_release(
+            (bfdev_atomic_t *)&fifo->out, fifo->out + llen
+        );
+    }
+
+    return llen;
+}
+
+export unsigned long
+bfdev_fifo_spsc_in_flat(bfdev_fifo_spsc_t *fifo, const void *buff,
+                        unsigned long len)
+{
+    unsigned long unused;
+
+    unused = bfdev_fifo_spsc_unused(fifo, len);
+    bfdev_min_adj(len, unused);
+    if (!len)
+        return 0;
+
+    /* data must be visible before the consumer sees the new index */
+    fifo_spsc_in_copy(fifo, buff, len, fifo->in);
+    bfdev_atomic_write_release(
+        (bfdev_atomic_t *)&fifo->in, fifo->in + len
+    );
+
+    return len;
+}
+
+export unsigned long
+bfdev_fifo_spsc_reserve_flat(bfdev_fifo_spsc_t *fifo, bfdev_fifo_span_t *spans,
+                             unsigned long len)
+{
+    unsigned long unused;
+
+    unused = bfdev_fifo_spsc_unused(fifo, len);
+    bfdev_min_adj(len, unused);
+
+    return fifo_spans(fifo->data, fifo->mask, fifo->esize,
+                      spans, len, fifo->in);
+}
+
+export void
+bfdev_fifo_spsc_commit_flat(bfdev_fifo_spsc_t *fifo, unsigned long len)
+{
+    bfdev_atomic_write_release(
+        (bfdev_atomic_t *)&fifo->in, fifo->in + len
+    );
+}
+
+export unsigned long
+bfdev_fifo_spsc_peek_spans_flat(bfdev_fifo_spsc_t *fifo,
+                                bfdev_fifo_span_t *spans, unsigned long len)
+{
+    unsigned long valid;
+
+    valid = bfdev_fifo_spsc_valid(fifo, len);
+    bfdev_min_adj(len, valid);
+
+    return fifo_spans(fifo->data, fifo->mask, fifo->esize,
+                      spans, len, fifo->out);
+}
+
+export void
+bfdev_fifo_spsc_consume_flat(bfdev_fifo_spsc_t *fifo, unsigned long len)
+{
+    bfdev_atomic_write_release(
+        (bfdev_atomic_t *)&fifo->out, fifo->out + len
+    );
+}
+
+export int
+bfdev_fifo_spsc_dynamic_alloc(bfdev_fifo_spsc_t *fifo,
+                              const bfdev_alloc_t *alloc,
+                              size_t esize, size_t size)
+{
+    size = bfdev_pow2_roundup(size);
+    if (size < 2)
+        return -BFDEV_EINVAL;
+
+    fifo->data = bfdev_malloc_array(alloc, size, esize);
+    if (!fifo->data)
+        return -BFDEV_ENOMEM;
+
+    fifo->in = fifo->cout = 0;
+    fifo->out = fifo->cin = 0;
+    fifo->mask = size - 1;
+    fifo->esize = esize;
+    fifo->alloc = alloc;
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_fifo_spsc_dynamic_free(bfdev_fifo_spsc_t *fifo)
+{
+    const bfdev_alloc_t *alloc;
+
+    fifo->in = fifo->cout = 0;
+    fifo->out = fifo->cin = 0;
+    fifo->mask = 0;
+    fifo->esize = 0;
+
+    alloc = fifo->alloc;
+    bfdev_free(alloc, fifo->data);
+    fifo->data = NULL;
+}
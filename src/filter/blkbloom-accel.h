@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_BLKBLOOM_ACCEL_H_
+#define _LOCAL_BLKBLOOM_ACCEL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <bfdev/blkbloom.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+#if defined(__x86_64__) && defined(__GNUC__)
+# define BLKBLOOM_ACCEL_X86
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+# define BLKBLOOM_ACCEL_ARM64
+#endif
+
+/* how many keys ahead the batch loops prefetch */
+#define BLKBLOOM_PREFETCH 8
+
+/* odd multipliers, one per word, spreading the key over 6-bit indexes */
+#define BLKBLOOM_SALT0 0x47b6137bU
+#define BLKBLOOM_SALT1 0x44974d91U
+#define BLKBLOOM_SALT2 0x8824ad5bU
+#define BLKBLOOM_SALT3 0xa2b7289dU
+#define BLKBLOOM_SALT4 0x705495c7U
+#define BLKBLOOM_SALT5 0x2df1424bU
+#define BLKBLOOM_SALT6 0x9efc4947U
+#define BLKBLOOM_SALT7 0x5c6bfb31U
+
+static inline unsigned long
+blkbloom_block(unsigned long blocks, uint64_t hash)
+{
+    return (unsigned long)(((hash >> 32) * blocks) >> 32);
+}
+
+/* the rw flag of __builtin_prefetch must be a constant expression */
+#define blkbloom_prefetch(table, blocks, hashes, index, count, write) do {  \
+    if ((index) + BLKBLOOM_PREFETCH < (count))                              \
+        __builtin_prefetch((table) + blkbloom_block((blocks),               \
+            (hashes)[(index) + BLKBLOOM_PREFETCH]), (write));               \
+} while (0)
+
+/*
+ * blkbloom_probe_*() - test a batch of hashes.
+ * @table: the blocks of the filter.
+ * @blocks: number of blocks.
+ * @hashes: 64-bit hashes of the keys.
+ * @result: answer of every hash, may be NULL.
+ * @count: number of hashes.
+ *
+ * Returns the number of hashes whose bits were all set.
+ */
+
+typedef unsigned int
+(*blkbloom_probe_t)(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                    const uint64_t *hashes, bool *result, unsigned int count);
+
+/*
+ * blkbloom_insert_*() - set the bits of a batch of hashes.
+ * Returns the number of hashes whose bits were already all set.
+ */
+
+typedef unsigned int
+(*blkbloom_insert_t)(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                     const uint64_t *hashes, unsigned int count);
+
+struct blkbloom_ops {
+    blkbloom_probe_t probe;
+    blkbloom_insert_t insert;
+};
+
+extern hidden unsigned int
+blkbloom_probe_generic(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                       const uint64_t *hashes, bool *result, unsigned int count);
+
+extern hidden unsigned int
+blkbloom_insert_generic(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                        const uint64_t *hashes, unsigned int count);
+
+#ifdef BLKBLOOM_ACCEL_X86
+extern hidden unsigned int
+blkbloom_probe_avx2(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                    const uint64_t *hashes, bool *result, unsigned int count);
+
+extern hidden unsigned int
+blkbloom_insert_avx2(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                     const uint64_t *hashes, unsigned int count);
+#endif
+
+#ifdef BLKBLOOM_ACCEL_ARM64
+extern hidden unsigned int
+blkbloom_probe_neon(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                    const uint64_t *hashes, bool *result, unsigned int count);
+
+extern hidden unsigned int
+blkbloom_insert_neon(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                     const uint64_t *hashes, unsigned int count);
+#endif
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_BLKBLOOM_ACCEL_H_ */
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include "blkbloom-accel.h"
+#include <export.h>
+
+#ifdef BLKBLOOM_ACCEL_ARM64
+#include <arm_neon.h>
+
+static const uint32_t
+neon_salt[BFDEV_BLKBLOOM_WORDS] = {
+    BLKBLOOM_SALT0, BLKBLOOM_SALT1, BLKBLOOM_SALT2, BLKBLOOM_SALT3,
+    BLKBLOOM_SALT4, BLKBLOOM_SALT5, BLKBLOOM_SALT6, BLKBLOOM_SALT7,
+};
+
+/* NEON shifts take signed per-lane counts, positive means left */
+static inline void
+neon_mask(uint64_t hash, uint32x4_t salt0, uint32x4_t salt1, uint64x2_t *mask)
+{
+    uint32x4_t key, index0, index1;
+    uint64x2_t one;
+
+    one = vdupq_n_u64(1);
+    key = vdupq_n_u32((uint32_t)hash);
+    index0 = vshrq_n_u32(vmulq_u32(key, salt0), 26);
+    index1 = vshrq_n_u32(vmulq_u32(key, salt1), 26);
+
+    mask[0] = vshlq_u64(one, vreinterpretq_s64_u64(
+        vmovl_u32(vget_low_u32(index0))));
+    mask[1] = vshlq_u64(one, vreinterpretq_s64_u64(
+        vmovl_high_u32(index0)));
+    mask[2] = vshlq_u64(one, vreinterpretq_s64_u64(
+        vmovl_u32(vget_low_u32(index1))));
+    mask[3] = vshlq_u64(one, vreinterpretq_s64_u64(
+        vmovl_high_u32(index1)));
+}
+
+hidden unsigned int
+blkbloom_probe_neon(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                    const uint64_t *hashes, bool *result, unsigned int count)
+{
+    const bfdev_blkbloom_block_t *block;
+    uint32x4_t salt0, salt1;
+    uint64x2_t mask[4], miss;
+    unsigned int index, hits;
+    bool hit;
+
+    salt0 = vld1q_u32(neon_salt);
+    salt1 = vld1q_u32(neon_salt + 4);
+
+    for (index = hits = 0; index < count; ++index) {
+        blkbloom_prefetch(table, blocks, hashes, index, count, 0);
+        block = table + blkbloom_block(blocks, hashes[index]);
+        neon_mask(hashes[index], salt0, salt1, mask);
+
+        miss = vbicq_u64(mask[0], vld1q_u64(block->word + 0));
+        miss = vorrq_u64(miss, vbicq_u64(mask[1], vld1q_u64(block->word + 2)));
+        miss = vorrq_u64(miss, vbicq_u64(mask[2], vld1q_u64(block->word + 4)));
+        miss = vorrq_u64(miss, vbicq_u64(mask[3], vld1q_u64(block->word + 6)));
+        hit = !vmaxvq_u32(vreinterpretq_u32_u64(miss));
+
+        if (result)
+            result[index] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
+
+hidden unsigned int
+blkbloom_insert_neon(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                     const uint64_t *hashes, unsigned int count)
+{
+    bfdev_blkbloom_block_t *block;
+    uint64x2_t mask[4], value, miss;
+    uint32x4_t salt0, salt1;
+    unsigned int index, word, hits;
+
+    salt0 = vld1q_u32(neon_salt);
+    salt1 = vld1q_u32(neon_salt + 4);
+
+    for (index = hits = 0; index < count; ++index) {
+        blkbloom_prefetch(table, blocks, hashes, index, count, 1);
+        block = table + blkbloom_block(blocks, hashes[index]);
+        neon_mask(hashes[index], salt0, salt1, mask);
+
+        miss = vdupq_n_u64(0);
+        for (word = 0; word < 4; ++word) {
+            value = vld1q_u64(block->word + word * 2);
+            miss = vorrq_u64(miss, vbicq_u64(mask[word], value));
+            vst1q_u64(block->word + word * 2, vorrq_u64(value, mask[word]));
+        }
+
+        hits += !vmaxvq_u32(vreinterpretq_u32_u64(miss));
+    }
+
+    return hits;
+}
+
+#endif /* BLKBLOOM_ACCEL_ARM64 */
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include "blkbloom-accel.h"
+#include <export.h>
+
+#ifdef BLKBLOOM_ACCEL_X86
+#include <immintrin.h>
+
+#define AVX2_TARGET __bfdev_target("avx2")
+
+/*
+ * All eight salts are applied with one vpmulld, the top six bits of
+ * every product are widened to 64-bit lanes and turned into single
+ * bit masks by a variable shift. The block is exactly two registers.
+ */
+static inline AVX2_TARGET void
+avx2_mask(uint64_t hash, __m256i salt, __m256i *low, __m256i *high)
+{
+    __m256i index, one;
+
+    one = _mm256_set1_epi64x(1);
+    index = _mm256_mullo_epi32(_mm256_set1_epi32((uint32_t)hash), salt);
+    index = _mm256_srli_epi32(index, 26);
+
+    *low = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(
+        _mm256_castsi256_si128(index)));
+    *high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(
+        _mm256_extracti128_si256(index, 1)));
+}
+
+static inline AVX2_TARGET __m256i
+avx2_salt(void)
+{
+    return _mm256_setr_epi32(
+        BLKBLOOM_SALT0, BLKBLOOM_SALT1, BLKBLOOM_SALT2, BLKBLOOM_SALT3,
+        BLKBLOOM_SALT4, BLKBLOOM_SALT5, BLKBLOOM_SALT6, BLKBLOOM_SALT7
+    );
+}
+
+hidden AVX2_TARGET unsigned int
+blkbloom_probe_avx2(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                    const uint64_t *hashes, bool *result, unsigned int count)
+{
+    const bfdev_blkbloom_block_t *block;
+    __m256i salt, low, high, vlow, vhigh;
+    unsigned int index, hits;
+    bool hit;
+
+    salt = avx2_salt();
+    for (index = hits = 0; index < count; ++index) {
+        blkbloom_prefetch(table, blocks, hashes, index, count, 0);
+        block = table + blkbloom_block(blocks, hashes[index]);
+        avx2_mask(hashes[index], salt, &low, &high);
+
+        vlow = _mm256_load_si256((const void *)block->word);
+        vhigh = _mm256_load_si256((const void *)(block->word + 4));
+
+        /* vptest sets the carry when no masked bit is clear */
+        hit = _mm256_testc_si256(vlow, low) & _mm256_testc_si256(vhigh, high);
+
+        if (result)
+            result[index] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
+
+hidden AVX2_TARGET unsigned int
+blkbloom_insert_avx2(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                     const uint64_t *hashes, unsigned int count)
+{
+    bfdev_blkbloom_block_t *block;
+    __m256i salt, low, high, vlow, vhigh;
+    unsigned int index, hits;
+
+    salt = avx2_salt();
+    for (index = hits = 0; index < count; ++index) {
+        blkbloom_prefetch(table, blocks, hashes, index, count, 1);
+        block = table + blkbloom_block(blocks, hashes[index]);
+        avx2_mask(hashes[index], salt, &low, &high);
+
+        vlow = _mm256_load_si256((const void *)block->word);
+        vhigh = _mm256_load_si256((const void *)(block->word + 4));
+        hits += _mm256_testc_si256(vlow, low) & _mm256_testc_si256(vhigh, high);
+
+        _mm256_store_si256((void *)block->word, _mm256_or_si256(vlow, low));
+        _mm256_store_si256((void *)(block->word + 4), _mm256_or_si256(vhigh, high));
+    }
+
+    return hits;
+}
+
+#endif /* BLKBLOOM_ACCEL_X86 */
@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/blkbloom.h>
+#include <bfdev/align.h>
+#include <bfdev/math.h>
+#include <bfdev/limits.h>
+#include <bfdev/dispatch.h>
+#include "blkbloom-accel.h"
+#include <export.h>
+
+static const uint32_t
+blkbloom_salt[BFDEV_BLKBLOOM_WORDS] = {
+    BLKBLOOM_SALT0, BLKBLOOM_SALT1, BLKBLOOM_SALT2, BLKBLOOM_SALT3,
+    BLKBLOOM_SALT4, BLKBLOOM_SALT5, BLKBLOOM_SALT6, BLKBLOOM_SALT7,
+};
+
+static inline uint64_t
+blkbloom_mask(uint32_t key, unsigned int index)
+{
+    return 1ULL << ((key * blkbloom_salt[index]) >> 26);
+}
+
+hidden unsigned int
+blkbloom_probe_generic(const bfdev_blkbloom_block_t *table, unsigned long blocks,
+                       const uint64_t *hashes, bool *result, unsigned int count)
+{
+    const bfdev_blkbloom_block_t *block;
+    unsigned int index, word, hits;
+    uint64_t mask, miss;
+
+    for (index = hits = 0; index < count; ++index) {
+        blkbloom_prefetch(table, blocks, hashes, index, count, 0);
+        block = table + blkbloom_block(blocks, hashes[index]);
+
+        for (word = 0, miss = 0; word < BFDEV_BLKBLOOM_WORDS; ++word) {
+            mask = blkbloom_mask((uint32_t)hashes[index], word);
+            miss |= mask & ~block->word[word];
+        }
+
+        if (result)
+            result[index] = !miss;
+        hits += !miss;
+    }
+
+    return hits;
+}
+
+hidden unsigned int
+blkbloom_insert_generic(bfdev_blkbloom_block_t *table, unsigned long blocks,
+                        const uint64_t *hashes, unsigned int count)
+{
+    bfdev_blkbloom_block_t *block;
+    unsigned int index, word, hits;
+    uint64_t mask, miss;
+
+    for (index = hits = 0; index < count; ++index) {
+        blkbloom_prefetch(table, blocks, hashes, index, count, 1);
+        block = table + blkbloom_block(blocks, hashes[index]);
+
+        for (word = 0, miss = 0; word < BFDEV_BLKBLOOM_WORDS; ++word) {
+            mask = blkbloom_mask((uint32_t)hashes[index], word);
+            miss |= mask & ~block->word[word];
+            block->word[word] |= mask;
+        }
+
+        hits += !miss;
+    }
+
+    return hits;
+}
+
+static const struct blkbloom_ops
+blkbloom_generic_ops = {
+    .probe = blkbloom_probe_generic,
+    .insert = blkbloom_insert_generic,
+};
+
+#ifdef BLKBLOOM_ACCEL_X86
+static const struct blkbloom_ops
+blkbloom_avx2_ops = {
+    .probe = blkbloom_probe_avx2,
+    .insert = blkbloom_insert_avx2,
+};
+#endif
+
+#ifdef BLKBLOOM_ACCEL_ARM64
+static const struct blkbloom_ops
+blkbloom_neon_ops = {
+    .probe = blkbloom_probe_neon,
+    .insert = blkbloom_insert_neon,
+};
+#endif
+
+static const bfdev_dispatch_impl_t
+blkbloom_impls[] = {
+#ifdef BLKBLOOM_ACCEL_X86
+    BFDEV_DISPATCH_IMPL("avx2", BFDEV_CPU_FEATURE(BFDEV_CPU_AVX2),
+                        &blkbloom_avx2_ops),
+#endif
+#ifdef BLKBLOOM_ACCEL_ARM64
+    BFDEV_DISPATCH_IMPL("neon", BFDEV_CPU_FEATURE(BFDEV_CPU_NEON),
+                        &blkbloom_neon_ops),
+#endif
+    BFDEV_DISPATCH_IMPL("generic", 0, &blkbloom_generic_ops),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(blkbloom_dispatch, "blkbloom", blkbloom_impls,
+                      &blkbloom_generic_ops);
+
+static __bfdev_always_inline const struct blkbloom_ops *
+blkbloom_ops(void)
+{
+    return bfdev_dispatch_ops(&blkbloom_dispatch, struct blkbloom_ops);
+}
+
+export bool
+bfdev_blkbloom_peek_hash(const bfdev_blkbloom_t *bloom, uint64_t hash)
+{
+    return blkbloom_ops()->probe(bloom->table, bloom->blocks, &hash, NULL, 1);
+}
+
+export bool
+bfdev_blkbloom_push_hash(bfdev_blkbloom_t *bloom, uint64_t hash)
+{
+    return blkbloom_ops()->insert(bloom->table, bloom->blocks, &hash, 1);
+}
+
+export bool
+bfdev_blkbloom_peek(const bfdev_blkbloom_t *bloom, const void *key)
+{
+    uint64_t hash;
+
+    hash = bloom->hash(key, bloom->pdata);
+    return bfdev_blkbloom_peek_hash(bloom, hash);
+}
+
+export bool
+bfdev_blkbloom_push(bfdev_blkbloom_t *bloom, const void *key)
+{
+    uint64_t hash;
+
+    hash = bloom->hash(key, bloom->pdata);
+    return bfdev_blkbloom_push_hash(bloom, hash);
+}
+
+export unsigned int
+bfdev_blkbloom_peek_batch(const bfdev_blkbloom_t *bloom, const uint64_t *hashes,
+                          bool *result, unsigned int count)
+{
+    return blkbloom_ops()->probe(bloom->table, bloom->blocks, hashes, result, count);
+}
+
+export unsigned int
+bfdev_blkbloom_push_batch(bfdev_blkbloom_t *bloom, const uint64_t *hashes,
+                          unsigned int count)
+{
+    return blkbloom_ops()->insert(bloom->table, bloom->blocks, hashes, count);
+}
+
+export void
+bfdev_blkbloom_flush(bfdev_blkbloom_t *bloom)
+{
+    size_t size;
+
+    size = bloom->blocks * sizeof(*bloom->table);
+    bfport_memset(bloom->table, 0, size);
+}
+
+export bfdev_blkbloom_t *
+bfdev_blkbloom_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                      bfdev_blkbloom_hash_t hash, void *pdata)
+{
+    bfdev_blkbloom_t *bloom;
+    unsigned long blocks;
+    size_t size;
+
+    blocks = BFDEV_DIV_ROUND_UP(capacity, BFDEV_BLKBLOOM_BLOCK_BITS);
+    if (bfdev_unlikely(!blocks || (uint64_t)blocks > BFDEV_UINT32_MAX))
+        return NULL;
+
+    size = blocks * sizeof(*bloom->table);
+    bloom = bfdev_zalloc(alloc, sizeof(*bloom) + size +
+                         BFDEV_BLKBLOOM_BLOCK_SIZE - 1);
+    if (bfdev_unlikely(!bloom))
+        return NULL;
+
+    bloom->table = bfdev_align_ptr_high((void *)bloom->memory,
+                                        BFDEV_BLKBLOOM_BLOCK_SIZE);
+    bloom->blocks = blocks;
+    bloom->alloc = alloc;
+    bloom->hash = hash;
+    bloom->pdata = pdata;
+
+    return bloom;
+}
+
+export void
+bfdev_blkbloom_destroy(bfdev_blkbloom_t *bloom)
+{
+    const bfdev_alloc_t *alloc;
+
+    alloc = bloom->alloc;
+    bfdev_free(alloc, bloom);
+}
+
+static __bfdev_ctor int
+blkbloom_accel_init(void)
+{
+    return bfdev_dispatch_register(&blkbloom_dispatch);
+}
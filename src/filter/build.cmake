@@ -0,0 +1,15 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+#
+# Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+#
+
+set(BFDEV_SOURCE
+    ${BFDEV_SOURCE}
+    ${CMAKE_CURRENT_LIST_DIR}/blkbloom.c
+    ${CMAKE_CURRENT_LIST_DIR}/blkbloom-arm64.c
+    ${CMAKE_CURRENT_LIST_DIR}/blkbloom-x86.c
+    ${CMAKE_CURRENT_LIST_DIR}/cbloom.c
+    ${CMAKE_CURRENT_LIST_DIR}/cuckoo.c
+    ${CMAKE_CURRENT_LIST_DIR}/sbloom.c
+    ${CMAKE_CURRENT_LIST_DIR}/xorfilter.c
+)
@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/cbloom.h>
+#include <bfdev/math.h>
+#include <bfdev/limits.h>
+#include "filter-mix.h"
+#include <export.h>
+
+static inline unsigned long
+cbloom_index(const bfdev_cbloom_t *bloom, uint64_t hash, unsigned int func)
+{
+    uint32_t value, step;
+
+    /* keep the step odd, a zero step probes one index k times */
+    step = (uint32_t)(hash >> 32);
+    step |= 1;
+
+    value = (uint32_t)hash + func * step;
+    return filter_range32(value, bloom->capacity);
+}
+
+static inline unsigned int
+cbloom_get(const bfdev_cbloom_t *bloom, unsigned long index)
+{
+    return (bloom->counters[index >> 1] >> ((index & 1) * 4)) & 0xf;
+}
+
+static inline void
+cbloom_inc(bfdev_cbloom_t *bloom, unsigned long index)
+{
+    bloom->counters[index >> 1] += 1U << ((index & 1) * 4);
+}
+
+static inline void
+cbloom_dec(bfdev_cbloom_t *bloom, unsigned long index)
+{
+    bloom->counters[index >> 1] -= 1U << ((index & 1) * 4);
+}
+
+export bool
+bfdev_cbloom_peek(const bfdev_cbloom_t *bloom, const void *key)
+{
+    unsigned int func;
+    uint64_t hash;
+
+    hash = bloom->hash(key, bloom->pdata);
+    for (func = 0; func < bloom->funcs; ++func) {
+        if (!cbloom_get(bloom, cbloom_index(bloom, hash, func)))
+            return false;
+    }
+
+    return true;
+}
+
+export bool
+bfdev_cbloom_push(bfdev_cbloom_t *bloom, const void *key)
+{
+    unsigned int func, value;
+    unsigned long index;
+    uint64_t hash;
+    bool retval;
+
+    retval = true;
+    hash = bloom->hash(key, bloom->pdata);
+
+    for (func = 0; func < bloom->funcs; ++func) {
+        index = cbloom_index(bloom, hash, func);
+        value = cbloom_get(bloom, index);
+
+        if (!value)
+            retval = false;
+        if (value < BFDEV_CBLOOM_SATURATED)
+            cbloom_inc(bloom, index);
+    }
+
+    return retval;
+}
+
+export int
+bfdev_cbloom_pop(bfdev_cbloom_t *bloom, const void *key)
+{
+    unsigned int func, value;
+    unsigned long index;
+    uint64_t hash;
+
+    hash = bloom->hash(key, bloom->pdata);
+    for (func = 0; func < bloom->funcs; ++func) {
+        if (!cbloom_get(bloom, cbloom_index(bloom, hash, func)))
+            return -BFDEV_ENOENT;
+    }
+
+    /* a saturated counter lost track of its count, keep it */
+    for (func = 0; func < bloom->funcs; ++func) {
+        index = cbloom_index(bloom, hash, func);
+        value = cbloom_get(bloom, index);
+
+        if (value && value < BFDEV_CBLOOM_SATURATED)
+            cbloom_dec(bloom, index);
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_cbloom_flush(bfdev_cbloom_t *bloom)
+{
+    size_t size;
+
+    size = BFDEV_DIV_ROUND_UP(bloom->capacity, 2);
+    bfport_memset(bloom->counters, 0, size);
+}
+
+export bfdev_cbloom_t *
+bfdev_cbloom_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                    unsigned int funcs, bfdev_cbloom_hash_t hash, void *pdata)
+{
+    bfdev_cbloom_t *bloom;
+    size_t size;
+
+    if (bfdev_unlikely(!capacity || !funcs))
+        return NULL;
+
+    if (bfdev_unlikely((uint64_t)capacity - 1 > BFDEV_UINT32_MAX))
+        return NULL;
+
+    size = BFDEV_DIV_ROUND_UP(capacity, 2);
+    bloom = bfdev_zalloc(alloc, sizeof(*bloom) + size);
+    if (bfdev_unlikely(!bloom))
+        return NULL;
+
+    bloom->capacity = capacity;
+    bloom->alloc = alloc;
+    bloom->hash = hash;
+    bloom->funcs = funcs;
+    bloom->pdata = pdata;
+
+    return bloom;
+}
+
+export void
+bfdev_cbloom_destroy(bfdev_cbloom_t *bloom)
+{
+    const bfdev_alloc_t *alloc;
+
+    alloc = bloom->alloc;
+    bfdev_free(alloc, bloom);
+}
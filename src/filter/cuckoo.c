@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/cuckoo.h>
+#include <bfdev/math.h>
+#include <bfdev/log2.h>
+#include <export.h>
+
+#define CUCKOO_RANDOM_SEED 0x2545f491U
+#define CUCKOO_LOAD_PERCENT 95
+
+static inline uint16_t
+cuckoo_fingerprint(uint64_t hash)
+{
+    uint16_t fp;
+
+    fp = (uint16_t)(hash >> 48);
+    return fp ?: 1;
+}
+
+static inline unsigned long
+cuckoo_alternate(const bfdev_cuckoo_t *cuckoo, unsigned long index,
+                 uint16_t fp)
+{
+    return (index ^ (fp * 0x5bd1e995U)) & cuckoo->mask;
+}
+
+static inline uint32_t
+cuckoo_random(bfdev_cuckoo_t *cuckoo)
+{
+    uint32_t value;
+
+    value = cuckoo->random;
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+
+    return cuckoo->random = value;
+}
+
+static bool
+cuckoo_bucket_find(const bfdev_cuckoo_bucket_t *bucket, uint16_t fp)
+{
+    unsigned int slot;
+
+    for (slot = 0; slot < BFDEV_CUCKOO_SLOTS; ++slot) {
+        if (bucket->fp[slot] == fp)
+            return true;
+    }
+
+    return false;
+}
+
+static bool
+cuckoo_bucket_replace(bfdev_cuckoo_bucket_t *bucket, uint16_t old,
+                      uint16_t fp)
+{
+    unsigned int slot;
+
+    for (slot = 0; slot < BFDEV_CUCKOO_SLOTS; ++slot) {
+        if (bucket->fp[slot] == old) {
+            bucket->fp[slot] = fp;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+cuckoo_insert(bfdev_cuckoo_t *cuckoo, unsigned long index, uint16_t fp)
+{
+    unsigned int kick, slot;
+    uint16_t evict;
+
+    if (cuckoo_bucket_replace(&cuckoo->buckets[index], 0, fp))
+        return;
+
+    index = cuckoo_alternate(cuckoo, index, fp);
+    if (cuckoo_bucket_replace(&cuckoo->buckets[index], 0, fp))
+        return;
+
+    /* both buckets are full, evict random fingerprints until one fits */
+    for (kick = 0; kick < BFDEV_CUCKOO_KICKS; ++kick) {
+        slot = cuckoo_random(cuckoo) % BFDEV_CUCKOO_SLOTS;
+        evict = cuckoo->buckets[index].fp[slot];
+        cuckoo->buckets[index].fp[slot] = fp;
+
+        fp = evict;
+        index = cuckoo_alternate(cuckoo, index, fp);
+        if (cuckoo_bucket_replace(&cuckoo->buckets[index], 0, fp))
+            return;
+    }
+
+    /* the last one homeless is kept aside rather than lost */
+    cuckoo->victim = fp;
+    cuckoo->vindex = index;
+}
+
+export bool
+bfdev_cuckoo_peek(const bfdev_cuckoo_t *cuckoo, const void *key)
+{
+    unsigned long index1, index2;
+    uint64_t hash;
+    uint16_t fp;
+
+    hash = cuckoo->hash(key, cuckoo->pdata);
+    fp = cuckoo_fingerprint(hash);
+    index1 = (unsigned long)hash & cuckoo->mask;
+    index2 = cuckoo_alternate(cuckoo, index1, fp);
+
+    if (cuckoo_bucket_find(&cuckoo->buckets[index1], fp) ||
+        cuckoo_bucket_find(&cuckoo->buckets[index2], fp))
+        return true;
+
+    return cuckoo->victim == fp &&
+           (cuckoo->vindex == index1 || cuckoo->vindex == index2);
+}
+
+export int
+bfdev_cuckoo_push(bfdev_cuckoo_t *cuckoo, const void *key)
+{
+    uint64_t hash;
+    uint16_t fp;
+
+    if (cuckoo->victim)
+        return -BFDEV_ENOSPC;
+
+    hash = cuckoo->hash(key, cuckoo->pdata);
+    fp = cuckoo_fingerprint(hash);
+
+    cuckoo_insert(cuckoo, (unsigned long)hash & cuckoo->mask, fp);
+    cuckoo->count++;
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_cuckoo_pop(bfdev_cuckoo_t *cuckoo, const void *key)
+{
+    unsigned long index1, index2;
+    uint64_t hash;
+    uint16_t fp;
+
+    hash = cuckoo->hash(key, cuckoo->pdata);
+    fp = cuckoo_fingerprint(hash);
+    index1 = (unsigned long)hash & cuckoo->mask;
+    index2 = cuckoo_alternate(cuckoo, index1, fp);
+
+    if (cuckoo->victim == fp &&
+        (cuckoo->vindex == index1 || cuckoo->vindex == index2)) {
+        cuckoo->victim = 0;
+        cuckoo->count--;
+        return -BFDEV_ENOERR;
+    }
+
+    if (!cuckoo_bucket_replace(&cuckoo->buckets[index1], fp, 0) &&
+        !cuckoo_bucket_replace(&cuckoo->buckets[index2], fp, 0))
+        return -BFDEV_ENOENT;
+
+    cuckoo->count--;
+
+    /* a slot was freed, give the victim another chance */
+    if (cuckoo->victim) {
+        fp = cuckoo->victim;
+        cuckoo->victim = 0;
+        cuckoo_insert(cuckoo, cuckoo->vindex, fp);
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_cuckoo_flush(bfdev_cuckoo_t *cuckoo)
+{
+    size_t size;
+
+    size = (cuckoo->mask + 1) * sizeof(*cuckoo->buckets);
+    bfport_memset(cuckoo->buckets, 0, size);
+
+    cuckoo->count = 0;
+    cuckoo->victim = 0;
+    cuckoo->random = CUCKOO_RANDOM_SEED;
+}
+
+export bfdev_cuckoo_t *
+bfdev_cuckoo_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                    bfdev_cuckoo_hash_t hash, void *pdata)
+{
+    bfdev_cuckoo_t *cuckoo;
+    unsigned long buckets;
+    size_t size;
+
+    if (bfdev_unlikely(!capacity))
+        return NULL;
+
+    buckets = BFDEV_DIV_ROUND_UP(capacity, BFDEV_CUCKOO_SLOTS);
+    buckets = bfdev_pow2_roundup(buckets);
+
+    /* cuckoo hashing stalls well before the table is completely full */
+    if (capacity * 100 > buckets * BFDEV_CUCKOO_SLOTS * CUCKOO_LOAD_PERCENT)
+        buckets <<= 1;
+
+    size = buckets * sizeof(*cuckoo->buckets);
+    cuckoo = bfdev_zalloc(alloc, sizeof(*cuckoo) + size);
+    if (bfdev_unlikely(!cuckoo))
+        return NULL;
+
+    cuckoo->mask = buckets - 1;
+    cuckoo->random = CUCKOO_RANDOM_SEED;
+    cuckoo->alloc = alloc;
+    cuckoo->hash = hash;
+    cuckoo->pdata = pdata;
+
+    return cuckoo;
+}
+
+export void
+bfdev_cuckoo_destroy(bfdev_cuckoo_t *cuckoo)
+{
+    const bfdev_alloc_t *alloc;
+
+    alloc = cuckoo->alloc;
+    bfdev_free(alloc, cuckoo);
+}
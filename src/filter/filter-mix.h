@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_FILTER_MIX_H_
+#define _LOCAL_FILTER_MIX_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+
+BFDEV_BEGIN_DECLS
+
+/* murmur3 finalizer, every input bit reaches every output bit */
+static inline uint64_t
+filter_mix64(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return value;
+}
+
+static inline uint64_t
+filter_splitmix64(uint64_t *state)
+{
+    uint64_t value;
+
+    value = (*state += 0x9e3779b97f4a7c15ULL);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+
+    return value ^ (value >> 31);
+}
+
+/* maps a 32-bit value onto [0, range) without a division */
+static inline unsigned long
+filter_range32(uint32_t value, unsigned long range)
+{
+    return (unsigned long)(((uint64_t)value * range) >> 32);
+}
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_FILTER_MIX_H_ */
@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/sbloom.h>
+#include <bfdev/bitops.h>
+#include <bfdev/hash.h>
+#include <bfdev/minmax.h>
+#include <bfdev/limits.h>
+#include "filter-mix.h"
+#include <export.h>
+
+/* optimal bits per key and hash function, 1 / ln(2) in 1/1024 */
+#define SBLOOM_BITS_SCALE 1477
+
+static inline uint32_t
+sbloom_index(const bfdev_sbloom_stage_t *stage, uint64_t hash,
+             unsigned int func)
+{
+    uint32_t value, step;
+
+    /* keep the step odd, a zero step probes one index k times */
+    step = (uint32_t)(hash >> 32);
+    step |= 1;
+
+    value = (uint32_t)hash + func * step;
+    return filter_range32(value, stage->bits);
+}
+
+static inline uint64_t
+sbloom_hash(const bfdev_sbloom_stage_t *stage, uint64_t hash)
+{
+    return filter_mix64(hash + stage->salt * BFDEV_GOLDEN_RATIO_64);
+}
+
+static bool
+sbloom_stage_peek(const bfdev_sbloom_stage_t *stage, uint64_t hash)
+{
+    unsigned int func;
+
+    hash = sbloom_hash(stage, hash);
+    for (func = 0; func < stage->funcs; ++func) {
+        if (!bfdev_bit_test(stage->bitmap, sbloom_index(stage, hash, func)))
+            return false;
+    }
+
+    return true;
+}
+
+static void
+sbloom_stage_push(bfdev_sbloom_stage_t *stage, uint64_t hash)
+{
+    unsigned int func;
+
+    hash = sbloom_hash(stage, hash);
+    for (func = 0; func < stage->funcs; ++func)
+        bfdev_bit_set(stage->bitmap, sbloom_index(stage, hash, func));
+
+    stage->count++;
+}
+
+static bfdev_sbloom_stage_t *
+sbloom_stage_create(bfdev_sbloom_t *bloom, unsigned long capacity,
+                    unsigned int funcs, unsigned int salt)
+{
+    bfdev_sbloom_stage_t *stage;
+    uint64_t bits;
+
+    bits = (uint64_t)capacity * funcs * SBLOOM_BITS_SCALE / 1024;
+    bits = bfdev_max(bits, (uint64_t)BFDEV_BITS_PER_LONG);
+    if (bfdev_unlikely(bits > BFDEV_UINT32_MAX))
+        return NULL;
+
+    stage = bfdev_zalloc(bloom->alloc, sizeof(*stage) +
+                         BFDEV_BITS_TO_LONG(bits) * sizeof(*stage->bitmap));
+    if (bfdev_unlikely(!stage))
+        return NULL;
+
+    stage->capacity = capacity;
+    stage->bits = bits;
+    stage->funcs = funcs;
+    stage->salt = salt;
+    bfdev_list_add(&bloom->stages, &stage->list);
+
+    return stage;
+}
+
+export bool
+bfdev_sbloom_peek(const bfdev_sbloom_t *bloom, const void *key)
+{
+    bfdev_sbloom_stage_t *stage;
+    uint64_t hash;
+
+    hash = bloom->hash(key, bloom->pdata);
+    bfdev_list_for_each_entry(stage, &bloom->stages, list) {
+        if (sbloom_stage_peek(stage, hash))
+            return true;
+    }
+
+    return false;
+}
+
+export int
+bfdev_sbloom_push(bfdev_sbloom_t *bloom, const void *key)
+{
+    bfdev_sbloom_stage_t *stage;
+    uint64_t hash;
+
+    hash = bloom->hash(key, bloom->pdata);
+    bfdev_list_for_each_entry(stage, &bloom->stages, list) {
+        if (sbloom_stage_peek(stage, hash))
+            return -BFDEV_ENOERR;
+    }
+
+    stage = bfdev_list_first_entry(&bloom->stages, bfdev_sbloom_stage_t, list);
+    if (stage->count >= stage->capacity) {
+        stage = sbloom_stage_create(bloom, stage->capacity * 2,
+                                    stage->funcs + 1, stage->salt + 1);
+        if (bfdev_unlikely(!stage))
+            return -BFDEV_ENOMEM;
+    }
+
+    sbloom_stage_push(stage, hash);
+    bloom->count++;
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_sbloom_flush(bfdev_sbloom_t *bloom)
+{
+    bfdev_sbloom_stage_t *stage, *tmp, *first;
+
+    first = bfdev_list_last_entry(&bloom->stages, bfdev_sbloom_stage_t, list);
+    bfdev_list_for_each_entry_safe(stage, tmp, &bloom->stages, list) {
+        if (stage == first)
+            break;
+
+        bfdev_list_del(&stage->list);
+        bfdev_free(bloom->alloc, stage);
+    }
+
+    bfport_memset(first->bitmap, 0, BFDEV_BITS_TO_LONG(first->bits) *
+                  sizeof(*first->bitmap));
+    first->count = 0;
+    bloom->count = 0;
+}
+
+export bfdev_sbloom_t *
+bfdev_sbloom_create(const bfdev_alloc_t *alloc, unsigned long capacity,
+                    unsigned int error, bfdev_sbloom_hash_t hash, void *pdata)
+{
+    bfdev_sbloom_t *bloom;
+
+    if (bfdev_unlikely(!capacity))
+        return NULL;
+
+    bloom = bfdev_zalloc(alloc, sizeof(*bloom));
+    if (bfdev_unlikely(!bloom))
+        return NULL;
+
+    bloom->alloc = alloc;
+    bloom->hash = hash;
+    bloom->pdata = pdata;
+    bloom->capacity = capacity;
+    bloom->error = error;
+    bfdev_list_head_init(&bloom->stages);
+
+    /* the stages halve their rate, the first takes half the budget */
+    if (bfdev_unlikely(!sbloom_stage_create(bloom, capacity, error + 1, 0))) {
+        bfdev_free(alloc, bloom);
+        return NULL;
+    }
+
+    return bloom;
+}
+
+export void
+bfdev_sbloom_destroy(bfdev_sbloom_t *bloom)
+{
+    bfdev_sbloom_stage_t *stage, *tmp;
+
+    bfdev_list_for_each_entry_safe(stage, tmp, &bloom->stages, list) {
+        bfdev_list_del(&stage->list);
+        bfdev_free(bloom->alloc, stage);
+    }
+
+    bfdev_free(bloom->alloc, bloom);
+}
@@ -0,0 +1,433 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/xorfilter.h>
+#include <bfdev/log2.h>
+#include <bfdev/sort.h>
+#include <bfdev/minmax.h>
+#include <bfdev/limits.h>
+#include "filter-mix.h"
+#include <export.h>
+
+/*
+ * Binary fuse filter with three slots per key, after Graf and Lemire.
+ * The sizing follows the reference implementation, evaluated in 16.16
+ * fixed point since there is no libm to lean on.
+ */
+
+#define XORFILTER_SEGMENT_SHIFT 18
+#define XORFILTER_SEED 0x726b2b9d438b9d4dULL
+
+/* 1 / log2(3.33) and 2.25 in 16.16 */
+#define XORFILTER_SEGMENT_SCALE 37762ULL
+#define XORFILTER_SEGMENT_BIAS (147456ULL << 16)
+
+/* 0.875, 1.125 and 0.25 * log2(10^6) shifted by 32 */
+#define XORFILTER_FACTOR_BASE 57344
+#define XORFILTER_FACTOR_MIN 73728
+#define XORFILTER_FACTOR_LOG 21401358791ULL
+
+struct xorfilter_build {
+    uint64_t *t2hash;
+    uint64_t *order;
+    uint32_t *alone;
+    uint32_t *start;
+    uint8_t *t2count;
+    uint8_t *found;
+};
+
+static inline uint8_t
+xorfilter_fingerprint(uint64_t hash)
+{
+    return (uint8_t)(hash ^ (hash >> 32));
+}
+
+/* high half of a 64 by 32 bit product, without 128-bit arithmetic */
+static inline uint32_t
+xorfilter_mulhi(uint64_t hash, uint32_t range)
+{
+    uint64_t high, low;
+
+    high = (hash >> 32) * range;
+    low = (hash & BFDEV_UINT32_MAX) * range;
+
+    return (uint32_t)((high + (low >> 32)) >> 32);
+}
+
+static inline uint32_t
+xorfilter_slot(const bfdev_xorfilter_t *filter, uint64_t hash,
+               unsigned int index)
+{
+    uint32_t slot;
+
+    slot = xorfilter_mulhi(hash, filter->segment_span);
+    slot += index * filter->segment_length;
+    slot ^= (uint32_t)((hash & ((1ULL << 36) - 1)) >>
+                       (36 - XORFILTER_SEGMENT_SHIFT * index)) &
+            filter->segment_mask;
+
+    return slot;
+}
+
+/* log2 in 16.16 fixed point by repeated squaring */
+static uint32_t
+xorfilter_log2(uint32_t value)
+{
+    unsigned int shift, bit;
+    uint32_t result;
+    uint64_t fract;
+
+    shift = bfdev_ilog2(value);
+    fract = ((uint64_t)value << 31) >> shift;
+    result = shift << 16;
+
+    for (bit = 1U << 15; bit; bit >>= 1) {
+        fract = (fract * fract) >> 31;
+        if (fract >> 32) {
+            fract >>= 1;
+            result |= bit;
+        }
+    }
+
+    return result;
+}
+
+static void
+xorfilter_geometry(bfdev_xorfilter_t *filter, size_t count)
+{
+    uint32_t length, segments, shift;
+    uint64_t factor, capacity;
+
+    length = 4;
+    capacity = 0;
+
+    if (count > 1) {
+        shift = ((uint64_t)xorfilter_log2(count) * XORFILTER_SEGMENT_SCALE +
+                 XORFILTER_SEGMENT_BIAS) >> 32;
+        length = 1U << bfdev_min(shift, XORFILTER_SEGMENT_SHIFT);
+
+        factor = XORFILTER_FACTOR_BASE +
+                 XORFILTER_FACTOR_LOG / xorfilter_log2(count);
+        factor = bfdev_max(factor, (uint64_t)XORFILTER_FACTOR_MIN);
+        capacity = ((uint64_t)count * factor + (1U << 15)) >> 16;
+    }
+
+    /* the key spans three segments, the last two only partially */
+    segments = BFDEV_DIV_ROUND_UP(capacity, length);
+    segments = segments <= 2 ? 1 : segments - 2;
+
+    filter->segment_length = length;
+    filter->segment_mask = length - 1;
+    filter->segment_span = segments * length;
+    filter->length = (segments + 2) * length;
+}
+
+static long
+xorfilter_cmp(const void *key1, const void *key2, void *pdata)
+{
+    uint64_t value1, value2;
+
+    value1 = *(const uint64_t *)key1;
+    value2 = *(const uint64_t *)key2;
+
+    if (value1 == value2)
+        return BFDEV_EQ;
+
+    return value1 < value2 ? BFDEV_LT : BFDEV_BT;
+}
+
+static size_t
+xorfilter_unique(uint64_t *keys, size_t count)
+{
+    size_t index, unique;
+
+    bfdev_sort(keys, count, sizeof(*keys), xorfilter_cmp, NULL);
+    for (index = unique = 1; index < count; ++index) {
+        if (keys[index] != keys[unique - 1])
+            keys[unique++] = keys[index];
+    }
+
+    return unique;
+}
+
+static inline void
+xorfilter_toggle(struct xorfilter_build *build, uint32_t slot,
+                 uint64_t hash, unsigned int index)
+{
+    build->t2count[slot] += 4;
+    build->t2count[slot] ^= index;
+    build->t2hash[slot] ^= hash;
+}
+
+static inline void
+xorfilter_untoggle(struct xorfilter_build *build, uint32_t slot,
+                   uint64_t hash, unsigned int index)
+{
+    build->t2count[slot] -= 4;
+    build->t2count[slot] ^= index;
+    build->t2hash[slot] ^= hash;
+}
+
+/*
+ * One attempt with the current seed: sort the keys roughly by their
+ * first slot for locality, count how many keys hit each slot and then
+ * peel slots with a single key until none is left.
+ */
+static size_t
+xorfilter_peel(bfdev_xorfilter_t *filter, struct xorfilter_build *build,
+               const uint64_t *keys, size_t count, size_t *pdups)
+{
+    uint32_t slot[5], index, other, blocks, mask, queue;
+    unsigned int bits, found;
+    size_t key, stack, dups;
+    uint64_t hash;
+
+    *pdups = 0;
+    for (bits = 1; (1UL << bits) < filter->segment_span /
+         filter->segment_length; ++bits);
+
+    blocks = 1U << bits;
+    mask = blocks - 1;
+
+    for (index = 0; index < blocks; ++index)
+        build->start[index] = ((uint64_t)index * count) >> bits;
+
+    /* a zero hash marks a free entry, the sentinel stops the scan */
+    build->order[count] = 1;
+    for (key = 0; key < count; ++key) {
+        hash = filter_mix64(keys[key] + filter->seed);
+        index = hash >> (64 - bits);
+
+        while (build->order[build->start[index]])
+            index = (index + 1) & mask;
+
+        build->order[build->start[index]++] = hash;
+    }
+
+    for (key = dups = 0; key < count; ++key) {
+        hash = build->order[key];
+        slot[0] = xorfilter_slot(filter, hash, 0);
+        slot[1] = xorfilter_slot(filter, hash, 1);
+        slot[2] = xorfilter_slot(filter, hash, 2);
+
+        xorfilter_toggle(build, slot[0], hash, 0);
+        xorfilter_toggle(build, slot[1], hash, 1);
+        xorfilter_toggle(build, slot[2], hash, 2);
+
+        /* the same key twice cancels out, take it back out */
+        if (!(build->t2hash[slot[0]] & build->t2hash[slot[1]] &
+              build->t2hash[slot[2]]) &&
+            ((!build->t2hash[slot[0]] && build->t2count[slot[0]] == 8) ||
+             (!build->t2hash[slot[1]] && build->t2count[slot[1]] == 8) ||
+             (!build->t2hash[slot[2]] && build->t2count[slot[2]] == 8))) {
+            xorfilter_untoggle(build, slot[0], hash, 0);
+            xorfilter_untoggle(build, slot[1], hash, 1);
+            xorfilter_untoggle(build, slot[2], hash, 2);
+            dups++;
+        }
+
+        /* the count wrapped around, this seed is hopeless */
+        if (build->t2count[slot[0]] < 4 || build->t2count[slot[1]] < 4 ||
+            build->t2count[slot[2]] < 4)
+            return 0;
+    }
+
+    for (index = queue = 0; index < filter->length; ++index) {
+        build->alone[queue] = index;
+        queue += (build->t2count[index] >> 2) == 1;
+    }
+
+    for (stack = 0; queue; ) {
+        index = build->alone[--queue];
+        if ((build->t2count[index] >> 2) != 1)
+            continue;
+
+        hash = build->t2hash[index];
+        found = build->t2count[index] & 3;
+        build->found[stack] = found;
+        build->order[stack++] = hash;
+
+        slot[0] = xorfilter_slot(filter, hash, 0);
+        slot[1] = xorfilter_slot(filter, hash, 1);
+        slot[2] = xorfilter_slot(filter, hash, 2);
+        slot[3] = slot[0];
+        slot[4] = slot[1];
+
+        other = slot[found + 1];
+        build->alone[queue] = other;
+        queue += (build->t2count[other] >> 2) == 2;
+        xorfilter_untoggle(build, other, hash, (found + 1) % 3);
+
+        other = slot[found + 2];
+        build->alone[queue] = other;
+        queue += (build->t2count[other] >> 2) == 2;
+        xorfilter_untoggle(build, other, hash, (found + 2) % 3);
+    }
+
+    *pdups = dups;
+    return stack;
+}
+
+static void
+xorfilter_assign(bfdev_xorfilter_t *filter, struct xorfilter_build *build,
+                 size_t stack)
+{
+    uint32_t slot[5];
+    unsigned int found;
+    uint64_t hash;
+
+    /* keys come off the stack in reverse, each owns a free slot */
+    while (stack--) {
+        hash = build->order[stack];
+        found = build->found[stack];
+
+        slot[0] = xorfilter_slot(filter, hash, 0);
+        slot[1] = xorfilter_slot(filter, hash, 1);
+        slot[2] = xorfilter_slot(filter, hash, 2);
+        slot[3] = slot[0];
+        slot[4] = slot[1];
+
+        filter->fingerprints[slot[found]] = xorfilter_fingerprint(hash) ^
+            filter->fingerprints[slot[found + 1]] ^
+            filter->fingerprints[slot[found + 2]];
+    }
+}
+
+static int
+xorfilter_populate(bfdev_xorfilter_t *filter, const uint64_t *hashes,
+                   size_t count)
+{
+    struct xorfilter_build build;
+    uint64_t *unique, state;
+    size_t stack, dups, size;
+    unsigned int attempt;
+    uint32_t blocks;
+    uint8_t *memory;
+    int retval;
+
+    blocks = bfdev_pow2_roundup(filter->segment_span /
+                                filter->segment_length);
+    blocks = bfdev_max(blocks, 2U);
+
+    size = filter->length * (sizeof(uint64_t) + sizeof(uint32_t) + 1) +
+           (count + 1) * sizeof(uint64_t) + blocks * sizeof(uint32_t) +
+           count;
+
+    memory = bfdev_malloc(filter->alloc, size);
+    if (bfdev_unlikely(!memory))
+        return -BFDEV_ENOMEM;
+
+    build.t2hash = (void *)memory;
+    build.order = build.t2hash + filter->length;
+    build.alone = (void *)(build.order + count + 1);
+    build.start = build.alone + filter->length;
+    build.t2count = (void *)(build.start + blocks);
+    build.found = build.t2count + filter->length;
+
+    state = XORFILTER_SEED;
+    unique = NULL;
+    retval = -BFDEV_EAGAIN;
+
+    for (attempt = 0; attempt < BFDEV_XORFILTER_ATTEMPTS; ++attempt) {
+        filter->seed = filter_splitmix64(&state);
+
+        bfport_memset(build.t2hash, 0, filter->length * sizeof(uint64_t));
+        bfport_memset(build.order, 0, (count + 1) * sizeof(uint64_t));
+        bfport_memset(build.t2count, 0, filter->length);
+
+        stack = xorfilter_peel(filter, &build, hashes, count, &dups);
+        if (stack + dups == count) {
+            xorfilter_assign(filter, &build, stack);
+            retval = -BFDEV_ENOERR;
+            break;
+        }
+
+        /* duplicates upset the peeling, get rid of them once */
+        if (dups && !unique) {
+            unique = bfdev_malloc(filter->alloc, count * sizeof(*unique));
+            if (bfdev_unlikely(!unique)) {
+                retval = -BFDEV_ENOMEM;
+                break;
+            }
+
+            bfport_memcpy(unique, hashes, count * sizeof(*unique));
+            count = xorfilter_unique(unique, count);
+            hashes = unique;
+        }
+    }
+
+    bfdev_free(filter->alloc, unique);
+    bfdev_free(filter->alloc, memory);
+
+    return retval;
+}
+
+export bool
+bfdev_xorfilter_peek_hash(const bfdev_xorfilter_t *filter, uint64_t hash)
+{
+    uint32_t slot0, slot1, slot2;
+    uint8_t fp;
+
+    hash = filter_mix64(hash + filter->seed);
+    fp = xorfilter_fingerprint(hash);
+
+    slot0 = xorfilter_mulhi(hash, filter->segment_span);
+    slot1 = slot0 + filter->segment_length;
+    slot2 = slot1 + filter->segment_length;
+    slot1 ^= (uint32_t)(hash >> XORFILTER_SEGMENT_SHIFT) & filter->segment_mask;
+    slot2 ^= (uint32_t)hash & filter->segment_mask;
+
+    fp ^= filter->fingerprints[slot0] ^ filter->fingerprints[slot1] ^
+          filter->fingerprints[slot2];
+
+    return !fp;
+}
+
+export bool
+bfdev_xorfilter_peek(const bfdev_xorfilter_t *filter, const void *key)
+{
+    uint64_t hash;
+
+    hash = filter->hash(key, filter->pdata);
+    return bfdev_xorfilter_peek_hash(filter, hash);
+}
+
+export bfdev_xorfilter_t *
+bfdev_xorfilter_create(const bfdev_alloc_t *alloc, const uint64_t *hashes,
+                       size_t count, bfdev_xorfilter_hash_t hash, void *pdata)
+{
+    bfdev_xorfilter_t *filter;
+    bfdev_xorfilter_t geometry;
+
+    if (bfdev_unlikely((uint64_t)count >= BFDEV_UINT32_MAX))
+        return NULL;
+
+    xorfilter_geometry(&geometry, count);
+    filter = bfdev_zalloc(alloc, sizeof(*filter) + geometry.length);
+    if (bfdev_unlikely(!filter))
+        return NULL;
+
+    *filter = geometry;
+    filter->alloc = alloc;
+    filter->hash = hash;
+    filter->pdata = pdata;
+
+    if (xorfilter_populate(filter, hashes, count)) {
+        bfdev_free(alloc, filter);
+        return NULL;
+    }
+
+    return filter;
+}
+
+export void
+bfdev_xorfilter_destroy(bfdev_xorfilter_t *filter)
+{
+    const bfdev_alloc_t *alloc;
+
+    alloc = filter->alloc;
+    bfdev_free(alloc, filter);
+}
@@ -0,0 +1,327 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/fskiplist.h>
+#include <export.h>
+
+struct fskip_chunk {
+    struct fskip_chunk *next;
+    uintptr_t data[0];
+};
+
+static unsigned int
+random_level(bfdev_fskip_head_t *head)
+{
+    unsigned int level;
+    unsigned long value;
+
+    /* consume two random bits per level, p = 1/4 */
+    value = bfport_rand();
+    for (level = 1; level < head->levels; ++level) {
+        if (value & 0x3)
+            break;
+        value >>= 2;
+    }
+
+    return level;
+}
+
+static __bfdev_always_inline size_t
+fskip_node_size(unsigned int level)
+{
+    return sizeof(bfdev_fskip_node_t) + sizeof(bfdev_fskip_link_t) * level;
+}
+
+static __bfdev_always_inline uintptr_t
+fskip_prefix(bfdev_fskip_head_t *head, const void *key)
+{
+    const bfdev_fskip_ops_t *ops;
+
+    ops = head->ops;
+    if (!ops->prefix)
+        return 0;
+
+    return ops->prefix(key, head->pdata);
+}
+
+static __bfdev_always_inline long
+fskip_cmp(bfdev_fskip_head_t *head, const bfdev_fskip_node_t *node,
+          uintptr_t nprefix, const void *key, uintptr_t prefix)
+{
+    /* cached prefix decides most comparisons without the callback */
+    if (nprefix != prefix)
+        return nprefix < prefix ? -1 : 1;
+
+    return head->ops->cmp(node->key, key, head->pdata);
+}
+
+static __bfdev_always_inline long
+fskip_cmp_link(bfdev_fskip_head_t *head, const bfdev_fskip_link_t *link,
+               const void *key, uintptr_t prefix)
+{
+    return fskip_cmp(head, link->next, link->prefix, key, prefix);
+}
+
+static bfdev_fskip_node_t *
+fskip_node_alloc(bfdev_fskip_head_t *head, unsigned int level)
+{
+    struct fskip_chunk *chunk;
+    bfdev_fskip_node_t *node;
+    size_t size, csize;
+
+    node = head->freelist[level - 1];
+    if (node) {
+        head->freelist[level - 1] = node->link[0].next;
+        return node;
+    }
+
+    size = fskip_node_size(level);
+    if (bfdev_unlikely(head->brk + size > head->end)) {
+        csize = bfdev_max(BFDEV_FSKIPLIST_CHUNK, sizeof(*chunk) + size);
+        chunk = bfdev_malloc(head->alloc, csize);
+        if (bfdev_unlikely(!chunk))
+            return NULL;
+
+        chunk->next = head->chunks;
+        head->chunks = chunk;
+        head->brk = (uintptr_t)chunk->data;
+        head->end = (uintptr_t)chunk + csize;
+    }
+
+    node = (void *)head->brk;
+    head->brk += size;
+
+    return node;
+}
+
+static void
+fskip_node_free(bfdev_fskip_head_t *head, bfdev_fskip_node_t *node)
+{
+    unsigned int level;
+
+    level = node->level;
+    node->link[0].next = head->freelist[level - 1];
+    head->freelist[level - 1] = node;
+}
+
+/*
+ * Fill @head->path with the predecessors of @key on every active level
+ * and return the link following the bottom predecessor. With the finger
+ * enabled the previous path is reused: climb from the bottom until the
+ * next node is no longer smaller than @key, then only walk forward on
+ * the levels below it. @head->fprefix tracks the prefix of path[0].
+ */
+static bfdev_fskip_link_t *
+fskip_search(bfdev_fskip_head_t *head, const void *key, uintptr_t prefix)
+{
+    bfdev_fskip_node_t *walk, **path;
+    bfdev_fskip_link_t *link;
+    unsigned int level;
+    bool moved;
+
+    path = head->path;
+    walk = &head->sentinel;
+
+    if (bfdev_unlikely(!head->curr))
+        return &walk->link[0];
+
+    level = head->curr - 1;
+    moved = true;
+
+    if (head->finger && (path[0] == walk ||
+        fskip_cmp(head, path[0], head->fprefix, key, prefix) < 0)) {
+        for (level = 0; level < head->curr - 1; ++level) {
+            link = &path[level]->link[level];
+            if (!link->next || fskip_cmp_link(head, link, key, prefix) >= 0)
+                break;
+        }
+        moved = false;
+    }
+
+    for (;;) {
+        if (!moved)
+            walk = path[level];
+
+        for (;;) {
+            link = &walk->link[level];
+            if (!link->next || fskip_cmp_link(head, link, key, prefix) >= 0)
+                break;
+            head->fprefix = link->prefix;
+            walk = link->next;
+            moved = true;
+        }
+
+        path[level] = walk;
+        if (!level--)
+            break;
+    }
+
+    return link;
+}
+
+export int
+bfdev_fskiplist_insert(bfdev_fskip_head_t *head, void *key)
+{
+    bfdev_fskip_node_t *node, **path;
+    bfdev_fskip_link_t *link;
+    unsigned int level, count;
+    uintptr_t prefix;
+
+    level = random_level(head);
+    node = fskip_node_alloc(head, level);
+    if (bfdev_unlikely(!node))
+        return -BFDEV_ENOMEM;
+
+    prefix = fskip_prefix(head, key);
+    fskip_search(head, key, prefix);
+
+    path = head->path;
+    for (; head->curr < level; ++head->curr)
+        path[head->curr] = &head->sentinel;
+
+    node->key = key;
+    node->level = level;
+
+    for (count = 0; count < level; ++count) {
+        link = &path[count]->link[count];
+        node->link[count] = *link;
+        link->next = node;
+        link->prefix = prefix;
+    }
+
+    head->count++;
+
+    return -BFDEV_ENOERR;
+}
+
+export void *
+bfdev_fskiplist_delete(bfdev_fskip_head_t *head, const void *key)
+{
+    bfdev_fskip_node_t *node, **path;
+    bfdev_fskip_link_t *link;
+    unsigned int count;
+    uintptr_t prefix;
+    void *retval;
+
+    prefix = fskip_prefix(head, key);
+    link = fskip_search(head, key, prefix);
+    if (!link->next || fskip_cmp_link(head, link, key, prefix))
+        return NULL;
+
+    node = link->next;
+    path = head->path;
+    for (count = 0; count < node->level; ++count)
+        path[count]->link[count] = node->link[count];
+
+    while (head->curr && !head->sentinel.link[head->curr - 1].next)
+        head->curr--;
+
+    retval = node->key;
+    fskip_node_free(head, node);
+    head->count--;
+
+    return retval;
+}
+
+export bfdev_fskip_node_t *
+bfdev_fskiplist_find(bfdev_fskip_head_t *head, const void *key)
+{
+    bfdev_fskip_link_t *link;
+    uintptr_t prefix;
+
+    prefix = fskip_prefix(head, key);
+    link = fskip_search(head, key, prefix);
+    if (!link->next || fskip_cmp_link(head, link, key, prefix))
+        return NULL;
+
+    return link->next;
+}
+
+static void
+fskiplist_release(bfdev_fskip_head_t *head, bfdev_release_t release,
+                  void *pdata)
+{
+    struct fskip_chunk *chunk, *next;
+    bfdev_fskip_node_t *node;
+
+    if (release) {
+        bfdev_fskiplist_for_each(node, head)
+            release(node->key, pdata);
+    }
+
+    for (chunk = head->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        bfdev_free(head->alloc, chunk);
+    }
+}
+
+static void
+fskiplist_init(bfdev_fskip_head_t *head)
+{
+    unsigned int count;
+
+    for (count = 0; count < head->levels; ++count) {
+        head->sentinel.link[count].next = NULL;
+        head->path[count] = &head->sentinel;
+        head->freelist[count] = NULL;
+    }
+
+    head->chunks = NULL;
+    head->brk = head->end = 0;
+    head->curr = 0;
+    head->count = 0;
+}
+
+export void
+bfdev_fskiplist_reset(bfdev_fskip_head_t *head, bfdev_release_t release,
+                      void *pdata)
+{
+    fskiplist_release(head, release, pdata);
+    fskiplist_init(head);
+}
+
+export bfdev_fskip_head_t *
+bfdev_fskiplist_create(const bfdev_alloc_t *alloc, const bfdev_fskip_ops_t *ops,
+                       unsigned int levels, bool finger, void *pdata)
+{
+    bfdev_fskip_head_t *head;
+    size_t size;
+
+    if (bfdev_unlikely(!levels || !ops || !ops->cmp))
+        return NULL;
+
+    /* sentinel tower, search path and freelists share the head block */
+    size = sizeof(*head) + sizeof(*head->sentinel.link) * levels +
+           sizeof(*head->path) * levels * 2;
+    head = bfdev_malloc(alloc, size);
+    if (bfdev_unlikely(!head))
+        return NULL;
+
+    head->alloc = alloc;
+    head->ops = ops;
+    head->pdata = pdata;
+    head->levels = levels;
+    head->finger = finger;
+
+    head->sentinel.key = NULL;
+    head->sentinel.level = levels;
+    head->path = (void *)&head->sentinel.link[levels];
+    head->freelist = head->path + levels;
+    fskiplist_init(head);
+
+    return head;
+}
+
+export void
+bfdev_fskiplist_destroy(bfdev_fskip_head_t *head, bfdev_release_t release,
+                        void *pdata)
+{
+    const bfdev_alloc_t *alloc;
+
+    alloc = head->alloc;
+    fskiplist_release(head, release, pdata);
+    bfdev_free(alloc, head);
+}
@@ -242,17 +242,29 @@ bfdev_hashmap_del(bfdev_hashmap_t *hashmap, const void *key,
 }
 
 export bfdev_hlist_node_t *
-bfdev_hashmap_find(bfdev_hashmap_t *hashmap, const void *key)
+bfdev_hashmap_find_cpu(bfdev_hashmap_t *hashmap, const void *key,
+                       unsigned int cpu)
 {
+    bfdev_percpu_counter_t *stat;
     bfdev_hlist_node_t *exist;
     unsigned long value;
 
     value = hashmap_hash_key(hashmap, key);
     exist = hashmap_find_key(hashmap, key, value);
 
+    stat = exist ? hashmap->hits : hashmap->misses;
+    if (stat)
+        bfdev_percpu_counter_inc(stat, cpu);
+
     return exist;
 }
 
+export bfdev_hlist_node_t *
+bfdev_hashmap_find(bfdev_hashmap_t *hashmap, const void *key)
+{
+    return bfdev_hashmap_find_cpu(hashmap, key, 0);
+}
+
 export void
 bfdev_hashmap_release(bfdev_hashmap_t *hashmap)
 {
@@ -0,0 +1,480 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/lfskiplist.h>
+#include <bfdev/cmpxchg.h>
+#include <bfdev/llist.h>
+#include <export.h>
+
+#define LFSKIP_MARK ((bfdev_atomic_t)1)
+
+static __bfdev_always_inline bool
+lfskip_marked(bfdev_atomic_t value)
+{
+    return value & LFSKIP_MARK;
+}
+
+static __bfdev_always_inline bfdev_lfskip_node_t *
+lfskip_ptr(bfdev_atomic_t value)
+{
+    return (bfdev_lfskip_node_t *)(value & ~LFSKIP_MARK);
+}
+
+static __bfdev_always_inline bool
+lfskip_cas(bfdev_atomic_t *atomic, bfdev_atomic_t old, bfdev_atomic_t value)
+{
+    return bfdev_cmpxchg(atomic, old, value) == old;
+}
+
+static __bfdev_always_inline size_t
+lfskip_node_size(unsigned int level)
+{
+    return sizeof(bfdev_lfskip_node_t) + sizeof(bfdev_atomic_t) * level;
+}
+
+static __bfdev_always_inline bfdev_lfskip_node_t **
+lfskip_preds(bfdev_lfskip_thread_t *thread)
+{
+    return thread->path;
+}
+
+static __bfdev_always_inline bfdev_lfskip_node_t **
+lfskip_succs(bfdev_lfskip_head_t *head, bfdev_lfskip_thread_t *thread)
+{
+    return thread->path + head->levels;
+}
+
+static unsigned int
+random_level(bfdev_lfskip_head_t *head, bfdev_lfskip_thread_t *thread)
+{
+    unsigned int level;
+    uint32_t value;
+
+    /* consume two random bits per level, p = 1/4 */
+    value = bfdev_prandom_value(&thread->rand);
+    for (level = 1; level < head->levels; ++level) {
+        if (value & 0x3)
+            break;
+        value >>= 2;
+    }
+
+    return level;
+}
+
+/* raise the search height hint, it never drops */
+static unsigned int
+lfskip_raise(bfdev_lfskip_head_t *head, unsigned int level)
+{
+    bfdev_atomic_t curr;
+
+    curr = bfdev_atomic_read(&head->curr);
+    while ((unsigned int)curr < level) {
+        if (bfdev_try_cmpxchg(&head->curr, &curr, level))
+            return level;
+    }
+
+    return curr;
+}
+
+/* readers may still compare the key until the grace period is over */
+static void
+lfskip_release(const bfdev_alloc_t *alloc, bfdev_ebr_node_t *retire)
+{
+    bfdev_lfskip_node_t *node;
+    bfdev_lfskip_head_t *head;
+
+    node = bfdev_ebr_entry(retire, bfdev_lfskip_node_t, retire);
+    head = node->head;
+
+    if (head->release)
+        head->release(node->key, head->pdata);
+    bfdev_free(alloc, node);
+}
+
+/*
+ * Both the inserter still linking the upper levels and the deleter
+ * own a tall node, the last one to finish hands it over to reclaim.
+ */
+static void
+lfskip_put(bfdev_lfskip_head_t *head, bfdev_lfskip_thread_t *thread,
+           bfdev_lfskip_node_t *node)
+{
+    if (node->level > 1 && bfdev_atomic_sub_fetch(&node->owners, 1))
+        return;
+
+    bfdev_ebr_retire(&head->ebr, thread->ebr, &node->retire, lfskip_release);
+}
+
+/*
+ * Fill the path of @thread with the predecessors and successors of
+ * @key on every level below @top, unlinking marked nodes on the way.
+ * Returns whether the level zero successor equals @key.
+ *
+ * With @target set the walk goes on past live nodes of an equal key:
+ * while @target is being deleted an equal key may be inserted in
+ * front of its upper levels, and @target must not be retired before
+ * every level of it has been snipped out.
+ */
+static bool
+lfskip_search(bfdev_lfskip_head_t *head, bfdev_lfskip_thread_t *thread,
+              const void *key, const bfdev_lfskip_node_t *target,
+              unsigned int top)
+{
+    bfdev_lfskip_node_t *pred, *curr, *succ, **preds, **succs;
+    bfdev_atomic_t value;
+    unsigned int level;
+    long retval;
+
+    preds = lfskip_preds(thread);
+    succs = lfskip_succs(head, thread);
+
+retry:
+    pred = &head->sentinel;
+    retval = 1;
+
+    for (level = top; level--;) {
+        curr = lfskip_ptr(bfdev_atomic_read(&pred->next[level]));
+        for (;;) {
+            if (!curr) {
+                retval = 1;
+                break;
+            }
+
+            value = bfdev_atomic_read(&curr->next[level]);
+            succ = lfskip_ptr(value);
+
+            if (lfskip_marked(value)) {
+                if (!lfskip_cas(&pred->next[level], (bfdev_atomic_t)curr,
+                                (bfdev_atomic_t)succ))
+                    goto retry;
+                curr = succ;
+                continue;
+            }
+
+            retval = head->cmp(curr->key, key, head->pdata);
+            if (retval > 0 || (!retval && !target))
+                break;
+
+            pred = curr;
+            curr = succ;
+        }
+
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+
+    return !retval;
+}
+
+static void
+lfskip_link(bfdev_lfskip_head_t *head, bfdev_lfskip_thread_t *thread,
+            bfdev_lfskip_node_t *node, unsigned int top)
+{
+    bfdev_lfskip_node_t *pred, *succ, **preds, **succs;
+    bfdev_atomic_t value;
+    unsigned int level;
+
+    preds = lfskip_preds(thread);
+    succs = lfskip_succs(head, thread);
+
+    for (level = 1; level < node->level; ++level) {
+        for (;;) {
+            pred = preds[level];
+            succ = succs[level];
+
+            /* a concurrent delete stops the tower from growing */
+            value = bfdev_atomic_read(&node->next[level]);
+            if (lfskip_marked(value))
+                return;
+
+            if (lfskip_ptr(value) != succ && !lfskip_cas(&node->next[level],
+                value, (bfdev_atomic_t)succ))
+                return;
+
+            if (lfskip_cas(&pred->next[level], (bfdev_atomic_t)succ,
+                           (bfdev_atomic_t)node))
+                break;
+
+            if (!lfskip_search(head, thread, node->key, NULL, top) ||
+                succs[0] != node)
+                return;
+        }
+
+        /* marked right after linking, the deleter may have missed it */
+        if (lfskip_marked(bfdev_atomic_read(&node->next[level]))) {
+            lfskip_search(head, thread, node->key, node, top);
+            return;
+        }
+    }
+}
+
+export void
+bfdev_lfskiplist_enter(bfdev_lfskip_head_t *head,
+                       bfdev_lfskip_thread_t *thread)
+{
+    bfdev_ebr_enter(&head->ebr, thread->ebr);
+}
+
+export void
+bfdev_lfskiplist_leave(bfdev_lfskip_head_t *head,
+                       bfdev_lfskip_thread_t *thread)
+{
+    bfdev_ebr_leave(&head->ebr, thread->ebr);
+}
+
+export int
+bfdev_lfskiplist_insert(bfdev_lfskip_head_t *head,
+                        bfdev_lfskip_thread_t *thread, void *key)
+{
+    bfdev_lfskip_node_t *node, *succ, **preds, **succs;
+    unsigned int level, top, count;
+
+    level = random_level(head, thread);
+    node = bfdev_malloc(head->alloc, lfskip_node_size(level));
+    if (bfdev_unlikely(!node))
+        return -BFDEV_ENOMEM;
+
+    node->key = key;
+    node->head = head;
+    node->level = level;
+    node->owners = 2;
+
+    preds = lfskip_preds(thread);
+    succs = lfskip_succs(head, thread);
+    top = lfskip_raise(head, level);
+
+    bfdev_lfskiplist_enter(head, thread);
+    for (;;) {
+        if (lfskip_search(head, thread, key, NULL, top)) {
+            bfdev_lfskiplist_leave(head, thread);
+            bfdev_free(head->alloc, node);
+            return -BFDEV_EEXIST;
+        }
+
+        for (count = 0; count < level; ++count)
+            node->next[count] = (bfdev_atomic_t)succs[count];
+
+        succ = succs[0];
+        if (lfskip_cas(&preds[0]->next[0], (bfdev_atomic_t)succ,
+                       (bfdev_atomic_t)node))
+            break;
+    }
+
+    if (level > 1) {
+        lfskip_link(head, thread, node, top);
+        lfskip_put(head, thread, node);
+    }
+
+    bfdev_lfskiplist_leave(head, thread);
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_lfskiplist_delete(bfdev_lfskip_head_t *head,
+                        bfdev_lfskip_thread_t *thread, const void *key)
+{
+    bfdev_lfskip_node_t *node;
+    bfdev_atomic_t value, prev;
+    unsigned int level, top;
+    int retval;
+
+    retval = -BFDEV_ENOENT;
+    top = bfdev_atomic_read(&head->curr);
+    bfdev_lfskiplist_enter(head, thread);
+
+    if (!lfskip_search(head, thread, key, NULL, top))
+        goto finish;
+
+    node = lfskip_succs(head, thread)[0];
+    for (level = node->level - 1; level; --level) {
+        value = bfdev_atomic_read(&node->next[level]);
+        while (!lfskip_marked(value)) {
+            prev = bfdev_cmpxchg(&node->next[level], value, value | LFSKIP_MARK);
+            if (prev == value)
+                break;
+            value = prev;
+        }
+    }
+
+    /* marking level zero is the linearization point */
+    value = bfdev_atomic_read(&node->next[0]);
+    for (;;) {
+        if (lfskip_marked(value))
+            goto finish;
+        prev = bfdev_cmpxchg(&node->next[0], value, value | LFSKIP_MARK);
+        if (prev == value)
+            break;
+        value = prev;
+    }
+
+    /* the height hint may have been read before this tower was built */
+    retval = -BFDEV_ENOERR;
+    lfskip_search(head, thread, key, node, bfdev_max(top, node->level));
+    lfskip_put(head, thread, node);
+
+finish:
+    bfdev_lfskiplist_leave(head, thread);
+    return retval;
+}
+
+export void *
+bfdev_lfskiplist_find(bfdev_lfskip_head_t *head,
+                      bfdev_lfskip_thread_t *thread, const void *key)
+{
+    bfdev_lfskip_node_t *pred, *curr;
+    bfdev_atomic_t value;
+    unsigned int level;
+    void *retval;
+    long cmpval;
+
+    retval = NULL;
+    pred = &head->sentinel;
+    level = bfdev_atomic_read(&head->curr);
+    bfdev_lfskiplist_enter(head, thread);
+
+    /* wait-free lookup, marked nodes are skipped instead of unlinked */
+    while (level--) {
+        curr = lfskip_ptr(bfdev_atomic_read(&pred->next[level]));
+        while (curr) {
+            value = bfdev_atomic_read(&curr->next[level]);
+            if (!lfskip_marked(value)) {
+                cmpval = head->cmp(curr->key, key, head->pdata);
+                if (cmpval > 0)
+                    break;
+                if (!cmpval) {
+                    retval = curr->key;
+                    goto finish;
+                }
+                pred = curr;
+            }
+            curr = lfskip_ptr(value);
+        }
+    }
+
+finish:
+    bfdev_lfskiplist_leave(head, thread);
+    return retval;
+}
+
+export bfdev_lfskip_node_t *
+bfdev_lfskiplist_next(bfdev_lfskip_node_t *node)
+{
+    bfdev_atomic_t value;
+
+    for (;;) {
+        node = lfskip_ptr(bfdev_atomic_read(&node->next[0]));
+        if (!node)
+            return NULL;
+
+        value = bfdev_atomic_read(&node->next[0]);
+        if (!lfskip_marked(value))
+            return node;
+    }
+}
+
+export bfdev_lfskip_node_t *
+bfdev_lfskiplist_first(bfdev_lfskip_head_t *head)
+{
+    return bfdev_lfskiplist_next(&head->sentinel);
+}
+
+export bfdev_lfskip_thread_t *
+bfdev_lfskiplist_attach(bfdev_lfskip_head_t *head)
+{
+    bfdev_lfskip_thread_t *thread;
+    bfdev_slist_head_t *walk;
+    size_t size;
+
+    for (walk = BFDEV_READ_ONCE(head->threads.next); walk;
+         walk = BFDEV_READ_ONCE(walk->next)) {
+        thread = bfdev_container_of(walk, bfdev_lfskip_thread_t, list);
+        if (!bfdev_atomic_read(&thread->used) &&
+            lfskip_cas(&thread->used, 0, 1))
+            return thread;
+    }
+
+    size = sizeof(*thread) + sizeof(*thread->path) * head->levels * 2;
+    thread = bfdev_malloc(head->alloc, size);
+    if (bfdev_unlikely(!thread))
+        return NULL;
+
+    thread->ebr = bfdev_ebr_attach(&head->ebr);
+    if (bfdev_unlikely(!thread->ebr)) {
+        bfdev_free(head->alloc, thread);
+        return NULL;
+    }
+
+    thread->used = 1;
+    bfdev_prandom_seed(&thread->rand, (uintptr_t)thread);
+    bfdev_llist_add(&head->threads, &thread->list);
+
+    return thread;
+}
+
+export void
+bfdev_lfskiplist_detach(bfdev_lfskip_head_t *head,
+                        bfdev_lfskip_thread_t *thread)
+{
+    BFDEV_BUG_ON(thread->ebr->nest);
+    bfdev_xchg(&thread->used, 0);
+}
+
+export bfdev_lfskip_head_t *
+bfdev_lfskiplist_create(const bfdev_alloc_t *alloc, unsigned int levels,
+                        bfdev_cmp_t cmp, bfdev_release_t release,
+                        void *pdata)
+{
+    bfdev_lfskip_head_t *head;
+    unsigned int count;
+
+    if (bfdev_unlikely(!levels || !cmp))
+        return NULL;
+
+    head = bfdev_malloc(alloc, sizeof(*head) + sizeof(bfdev_atomic_t) * levels);
+    if (bfdev_unlikely(!head))
+        return NULL;
+
+    head->alloc = alloc;
+    head->cmp = cmp;
+    head->release = release;
+    head->pdata = pdata;
+    head->levels = levels;
+    head->curr = 1;
+    bfdev_ebr_init(&head->ebr, alloc);
+    bfdev_slist_head_init(&head->threads);
+
+    head->sentinel.key = NULL;
+    head->sentinel.level = levels;
+    for (count = 0; count < levels; ++count)
+        head->sentinel.next[count] = 0;
+
+    return head;
+}
+
+export void
+bfdev_lfskiplist_destroy(bfdev_lfskip_head_t *head)
+{
+    bfdev_lfskip_thread_t *thread, *tmp;
+    bfdev_lfskip_node_t *node, *next;
+    const bfdev_alloc_t *alloc;
+
+    alloc = head->alloc;
+    for (node = lfskip_ptr(head->sentinel.next[0]); node; node = next) {
+        next = lfskip_ptr(node->next[0]);
+        if (head->release)
+            head->release(node->key, head->pdata);
+        bfdev_free(alloc, node);
+    }
+
+    /* frees the retired towers and every reclamation record */
+    bfdev_ebr_destroy(&head->ebr);
+
+    bfdev_slist_for_each_entry_safe(thread, tmp, &head->threads, list)
+        bfdev_free(alloc, thread);
+
+    bfdev_free(alloc, head);
+}
@@ -0,0 +1,258 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/mpmc.h>
+#include <bfdev/log2.h>
+#include <bfdev/align.h>
+#include <bfdev/cmpxchg.h>
+#include <export.h>
+
+static __bfdev_always_inline bfdev_atomic_t *
+mpmc_cell(bfdev_mpmc_t *mpmc, bfdev_atomic_t pos)
+{
+    return mpmc->cells + ((unsigned long)pos & mpmc->mask) * mpmc->csize;
+}
+
+static __bfdev_always_inline long
+mpmc_diff(bfdev_atomic_t seq, bfdev_atomic_t pos)
+{
+    return (long)((unsigned long)seq - (unsigned long)pos);
+}
+
+static void
+mpmc_wake(bfdev_mpmc_t *mpmc, bfdev_atomic_t *event, bfdev_atomic_t *waiters)
+{
+    /* pairs with the waiter registration in mpmc_wait() */
+    bfdev_atomic_fence();
+
+    if (bfdev_atomic_read(waiters)) {
+        bfdev_atomic_add(event, 1);
+        mpmc->ops->wake(event, mpmc->pdata);
+    }
+}
+
+/*
+ * Scan the cells from @pos and count the ones ready for the given
+ * lap, @ahead is zero for producers and one for consumers.
+ * Returns the number of ready cells, or a negative value when the
+ * first cell belongs to an older lap (queue full or empty).
+ */
+static __bfdev_always_inline long
+mpmc_ready(bfdev_mpmc_t *mpmc, bfdev_atomic_t pos, unsigned long count,
+           unsigned long ahead)
+{
+    bfdev_atomic_t seq;
+    unsigned long index;
+
+    for (index = 0; index < count; ++index) {
+        seq = bfdev_atomic_read_acquire(mpmc_cell(mpmc, pos + index));
+        if (mpmc_diff(seq, pos + index + ahead))
+            break;
+    }
+
+    if (!index && mpmc_diff(seq, pos + ahead) < 0)
+        return -1;
+
+    return index;
+}
+
+/* claim up to @count cells of @index, returns the first position */
+static __bfdev_always_inline unsigned long
+mpmc_claim(bfdev_mpmc_t *mpmc, bfdev_atomic_t *index, unsigned long count,
+           unsigned long ahead, bfdev_atomic_t *first)
+{
+    bfdev_atomic_t pos;
+    long ready;
+
+    pos = bfdev_atomic_read(index);
+    for (;;) {
+        ready = mpmc_ready(mpmc, pos, count, ahead);
+        if (ready < 0)
+            return 0;
+
+        if (!ready) {
+            /* another thread took the first cell */
+            pos = bfdev_atomic_read(index);
+            continue;
+        }
+
+        if (bfdev_try_cmpxchg(index, &pos, pos + ready))
+            break;
+    }
+
+    *first = pos;
+    return ready;
+}
+
+export unsigned long
+bfdev_mpmc_try_in(bfdev_mpmc_t *mpmc, const void *buff, unsigned long count)
+{
+    bfdev_atomic_t pos, *cell;
+    unsigned long index;
+
+    if (bfdev_unlikely(!count))
+        return 0;
+
+    count = mpmc_claim(mpmc, &mpmc->in, count, 0, &pos);
+    if (!count)
+        return 0;
+
+    for (index = 0; index < count; ++index) {
+        cell = mpmc_cell(mpmc, pos + index);
+        bfport_memcpy(cell + 1, buff, mpmc->esize);
+        bfdev_atomic_write_release(cell, pos + index + 1);
+        buff += mpmc->esize;
+    }
+
+    if (mpmc->ops)
+        mpmc_wake(mpmc, &mpmc->readable, &mpmc->rwaiters);
+
+    return count;
+}
+
+export unsigned long
+bfdev_mpmc_try_out(bfdev_mpmc_t *mpmc, void *buff, unsigned long count)
+{
+    bfdev_atomic_t pos, *cell;
+    unsigned long index;
+
+    if (bfdev_unlikely(!count))
+        return 0;
+
+    count = mpmc_claim(mpmc, &mpmc->out, count, 1, &pos);
+    if (!count)
+        return 0;
+
+    for (index = 0; index < count; ++index) {
+        cell = mpmc_cell(mpmc, pos + index);
+        bfport_memcpy(buff, cell + 1, mpmc->esize);
+        bfdev_atomic_write_release(cell, pos + index + mpmc->mask + 1);
+        buff += mpmc->esize;
+    }
+
+    if (mpmc->ops)
+        mpmc_wake(mpmc, &mpmc->writable, &mpmc->wwaiters);
+
+    return count;
+}
+
+/*
+ * Sleep on @event unless the retry makes progress. The event is
+ * sampled before registering as a waiter, so a wakeup issued after
+ * a failed retry always changes it and the wait returns at once.
+ */
+#define MPMC_WAIT_RETRY(mpmc, event, waiters, retry) ({ \
+    bfdev_atomic_t __value;                             \
+    unsigned long __done;                               \
+                                                        \
+    __value = bfdev_atomic_read(event);                 \
+    bfdev_atomic_add(waiters, 1);                       \
+                                                        \
+    __done = (retry);                                   \
+    if (!__done)                                        \
+        mpmc->ops->wait(event, __value, mpmc->pdata);   \
+                                                        \
+    bfdev_atomic_sub(waiters, 1);                       \
+    __done;                                             \
+})
+
+export int
+bfdev_mpmc_in(bfdev_mpmc_t *mpmc, const void *buff, unsigned long count)
+{
+    unsigned long done;
+
+    if (!mpmc->ops)
+        return -BFDEV_EOPNOTSUPP;
+
+    while (count) {
+        done = bfdev_mpmc_try_in(mpmc, buff, count);
+        if (!done)
+            done = MPMC_WAIT_RETRY(mpmc, &mpmc->writable, &mpmc->wwaiters,
+                                   bfdev_mpmc_try_in(mpmc, buff, count));
+
+        buff += done * mpmc->esize;
+        count -= done;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_mpmc_out(bfdev_mpmc_t *mpmc, void *buff, unsigned long count,
+               unsigned long *done)
+{
+    unsigned long length;
+
+    if (!mpmc->ops)
+        return -BFDEV_EOPNOTSUPP;
+
+    if (bfdev_unlikely(!count)) {
+        *done = 0;
+        return -BFDEV_ENOERR;
+    }
+
+    do {
+        length = bfdev_mpmc_try_out(mpmc, buff, count);
+        if (!length)
+            length = MPMC_WAIT_RETRY(mpmc, &mpmc->readable, &mpmc->rwaiters,
+                                     bfdev_mpmc_try_out(mpmc, buff, count));
+    } while (!length);
+
+    *done = length;
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_mpmc_alloc(bfdev_mpmc_t *mpmc, const bfdev_alloc_t *alloc,
+                 size_t esize, size_t size)
+{
+    unsigned long index, csize;
+    bfdev_atomic_t *cell;
+
+    size = bfdev_pow2_roundup(size);
+    if (size < 2 || !esize)
+        return -BFDEV_EINVAL;
+
+    csize = bfdev_align_high(sizeof(*cell) + esize, sizeof(*cell));
+    mpmc->cells = bfdev_malloc_array(alloc, size, csize);
+    if (!mpmc->cells)
+        return -BFDEV_ENOMEM;
+
+    mpmc->alloc = alloc;
+    mpmc->ops = NULL;
+    mpmc->pdata = NULL;
+    mpmc->mask = size - 1;
+    mpmc->esize = esize;
+    mpmc->csize = csize;
+
+    for (index = 0; index < size; ++index) {
+        cell = mpmc_cell(mpmc, index);
+        bfdev_atomic_write(cell, index);
+    }
+
+    bfdev_atomic_write(&mpmc->in, 0);
+    bfdev_atomic_write(&mpmc->out, 0);
+    bfdev_atomic_write(&mpmc->readable, 0);
+    bfdev_atomic_write(&mpmc->writable, 0);
+    bfdev_atomic_write(&mpmc->rwaiters, 0);
+    bfdev_atomic_write(&mpmc->wwaiters, 0);
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_mpmc_free(bfdev_mpmc_t *mpmc)
+{
+    const bfdev_alloc_t *alloc;
+
+    mpmc->mask = 0;
+    mpmc->esize = 0;
+    mpmc->csize = 0;
+
+    alloc = mpmc->alloc;
+    bfdev_free(alloc, mpmc->cells);
+    mpmc->cells = NULL;
+}
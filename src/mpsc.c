@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/mpsc.h>
+#include <export.h>
+
+static __bfdev_always_inline bfdev_slist_head_t *
+mpsc_reverse(bfdev_slist_head_t *node)
+{
+    bfdev_slist_head_t *prev, *next;
+
+    for (prev = NULL; node; node = next) {
+        next = node->next;
+        node->next = prev;
+        prev = node;
+    }
+
+    return prev;
+}
+
+/* take everything pushed so far, oldest first */
+static bfdev_slist_head_t *
+mpsc_grab(bfdev_mpsc_t *mpsc)
+{
+    bfdev_slist_head_t *chain;
+
+    chain = bfdev_llist_destroy(&mpsc->head);
+    if (!chain)
+        return NULL;
+
+    return mpsc_reverse(chain);
+}
+
+export bool
+bfdev_mpsc_push_batch(bfdev_mpsc_t *mpsc, bfdev_slist_head_t *node,
+                      bfdev_slist_head_t *end)
+{
+    bool empty;
+
+    /* the cmpxchg orders the push before reading the sleeping flag */
+    empty = bfdev_llist_split(&mpsc->head, node, end);
+
+    if (empty && mpsc->ops && bfdev_atomic_read(&mpsc->sleeping)) {
+        bfdev_atomic_add(&mpsc->event, 1);
+        mpsc->ops->wake(&mpsc->event, mpsc->pdata);
+    }
+
+    return empty;
+}
+
+export bfdev_slist_head_t *
+bfdev_mpsc_pop(bfdev_mpsc_t *mpsc)
+{
+    bfdev_slist_head_t *node;
+
+    node = mpsc->batch;
+    if (!node) {
+        node = mpsc_grab(mpsc);
+        if (!node)
+            return NULL;
+    }
+
+    mpsc->batch = node->next;
+    node->next = NULL;
+
+    return node;
+}
+
+export bfdev_slist_head_t *
+bfdev_mpsc_pop_all(bfdev_mpsc_t *mpsc)
+{
+    bfdev_slist_head_t *chain, *batch, *tail;
+
+    chain = mpsc_grab(mpsc);
+    batch = mpsc->batch;
+    mpsc->batch = NULL;
+
+    if (!batch)
+        return chain;
+
+    /* entries of the private batch are older */
+    for (tail = batch; tail->next; tail = tail->next);
+    tail->next = chain;
+
+    return batch;
+}
+
+export int
+bfdev_mpsc_wait(bfdev_mpsc_t *mpsc)
+{
+    bfdev_atomic_t event;
+
+    if (!mpsc->ops)
+        return -BFDEV_EOPNOTSUPP;
+
+    while (bfdev_mpsc_check_empty(mpsc)) {
+        /*
+         * Sample the event before announcing the sleep, a push
+         * that finds the flag set afterwards always changes it.
+         */
+        event = bfdev_atomic_read(&mpsc->event);
+        bfdev_xchg(&mpsc->sleeping, 1);
+
+        if (bfdev_mpsc_check_empty(mpsc))
+            mpsc->ops->wait(&mpsc->event, event, mpsc->pdata);
+
+        bfdev_atomic_write(&mpsc->sleeping, 0);
+    }
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,193 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/notifier-rcu.h>
+#include <bfdev/minmax.h>
+#include <bfdev/cmpxchg.h>
+#include <export.h>
+
+export bfdev_notifier_ret_t
+bfdev_notifier_rcu_call(bfdev_notifier_rcu_t *head, unsigned int cpu,
+                        void *args, unsigned int call_num,
+                        unsigned int *called_num)
+{
+    bfdev_notifier_call_t *call, *end;
+    bfdev_percpu_counter_t *readers;
+    bfdev_notifier_snap_t *snap;
+    bfdev_notifier_ret_t retval;
+
+    /* the full barrier of the increment orders it before the load */
+    readers = &head->readers[bfdev_atomic_read(&head->phase) & 1];
+    bfdev_percpu_counter_inc(readers, cpu);
+
+    retval = BFDEV_NOTIFI_RET_DONE;
+    snap = (void *)bfdev_atomic_read(&head->snap);
+    if (!snap)
+        goto finish;
+
+    call = snap->calls;
+    end = call + bfdev_min(snap->count, call_num);
+
+    for (; call < end; ++call) {
+        retval = call->entry(args, call->pdata);
+        if (called_num)
+            (*called_num)++;
+
+        if (retval & BFDEV_NOTIFI_RET_STOP)
+            break;
+    }
+
+    retval &= ~BFDEV_NOTIFI_RET_REMOVE;
+
+finish:
+    bfdev_percpu_counter_dec(readers, cpu);
+    return retval;
+}
+
+export bool
+bfdev_notifier_rcu_reclaim(bfdev_notifier_rcu_t *head)
+{
+    bfdev_notifier_snap_t *snap, **prev;
+    unsigned long phase;
+
+    for (;;) {
+        phase = bfdev_atomic_read(&head->phase);
+
+        /* two flips since replacement drain every reader that saw it */
+        for (prev = &head->retired; (snap = *prev);) {
+            if (phase - snap->phase < 2) {
+                prev = &snap->retire;
+                continue;
+            }
+
+            *prev = snap->retire;
+            bfdev_free(head->alloc, snap);
+        }
+
+        if (!head->retired)
+            return true;
+
+        if (bfdev_percpu_counter_sum(&head->readers[(phase + 1) & 1]))
+            return false;
+
+        bfdev_xchg(&head->phase, phase + 1);
+    }
+}
+
+static int
+notifier_rcu_publish(bfdev_notifier_rcu_t *head)
+{
+    bfdev_notifier_snap_t *snap, *old;
+    bfdev_notifier_node_t *node;
+    unsigned int count;
+
+    count = 0;
+    bfdev_ilist_for_each_entry(node, &head->chain.nodes, list)
+        count++;
+
+    snap = NULL;
+    if (count) {
+        snap = bfdev_malloc(head->alloc, sizeof(*snap) +
+                            sizeof(*snap->calls) * count);
+        if (bfdev_unlikely(!snap))
+            return -BFDEV_ENOMEM;
+
+        snap->count = 0;
+        bfdev_ilist_for_each_entry(node, &head->chain.nodes, list) {
+            snap->calls[snap->count++] = (bfdev_notifier_call_t) {
+                .entry = node->entry,
+                .pdata = node->pdata,
+            };
+        }
+    }
+
+    old = (void *)bfdev_xchg(&head->snap, (bfdev_atomic_t)snap);
+    if (old) {
+        old->phase = bfdev_atomic_read(&head->phase);
+        old->retire = head->retired;
+        head->retired = old;
+    }
+
+    bfdev_notifier_rcu_reclaim(head);
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_notifier_rcu_register(bfdev_notifier_rcu_t *head,
+                            bfdev_notifier_node_t *node)
+{
+    int retval;
+
+    retval = bfdev_notifier_register(&head->chain, node);
+    if (bfdev_unlikely(retval))
+        return retval;
+
+    retval = notifier_rcu_publish(head);
+    if (bfdev_unlikely(retval))
+        bfdev_notifier_unregister(&head->chain, node);
+
+    return retval;
+}
+
+export int
+bfdev_notifier_rcu_unregister(bfdev_notifier_rcu_t *head,
+                              bfdev_notifier_node_t *node)
+{
+    int retval;
+
+    bfdev_notifier_unregister(&head->chain, node);
+
+    retval = notifier_rcu_publish(head);
+    if (bfdev_unlikely(retval))
+        bfdev_notifier_register(&head->chain, node);
+
+    return retval;
+}
+
+export int
+bfdev_notifier_rcu_alloc(bfdev_notifier_rcu_t *head,
+                         const bfdev_alloc_t *alloc, unsigned int nr)
+{
+    int retval;
+
+    retval = bfdev_percpu_counter_alloc(&head->readers[0], alloc, nr);
+    if (retval)
+        return retval;
+
+    retval = bfdev_percpu_counter_alloc(&head->readers[1], alloc, nr);
+    if (retval) {
+        bfdev_percpu_counter_free(&head->readers[0]);
+        return retval;
+    }
+
+    bfdev_atomic_write(&head->snap, 0);
+    bfdev_atomic_write(&head->phase, 0);
+
+    head->alloc = alloc;
+    head->retired = NULL;
+    bfdev_notifier_init(&head->chain);
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_notifier_rcu_free(bfdev_notifier_rcu_t *head)
+{
+    bfdev_notifier_snap_t *snap;
+
+    while ((snap = head->retired)) {
+        head->retired = snap->retire;
+        bfdev_free(head->alloc, snap);
+    }
+
+    snap = (void *)bfdev_atomic_read(&head->snap);
+    bfdev_free(head->alloc, snap);
+    bfdev_atomic_write(&head->snap, 0);
+
+    bfdev_percpu_counter_free(&head->readers[1]);
+    bfdev_percpu_counter_free(&head->readers[0]);
+}
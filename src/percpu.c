@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/percpu.h>
+#include <bfdev/log2.h>
+#include <bfdev/align.h>
+#include <export.h>
+
+export bfdev_atomic_t
+bfdev_percpu_counter_sum(bfdev_percpu_counter_t *counter)
+{
+    bfdev_atomic_t sum;
+    unsigned long index;
+
+    sum = 0;
+    for (index = 0; index <= counter->mask; ++index)
+        sum += bfdev_atomic_read(&counter->slots[index].value);
+
+    return sum;
+}
+
+export bfdev_atomic_t
+bfdev_percpu_counter_reset(bfdev_percpu_counter_t *counter)
+{
+    bfdev_atomic_t sum;
+    unsigned long index;
+
+    sum = 0;
+    for (index = 0; index <= counter->mask; ++index)
+        sum += bfdev_xchg(&counter->slots[index].value, 0);
+
+    return sum;
+}
+
+export int
+bfdev_percpu_counter_alloc(bfdev_percpu_counter_t *counter,
+                           const bfdev_alloc_t *alloc, unsigned int nr)
+{
+    unsigned long index;
+    void *block;
+
+    if (!nr)
+        return -BFDEV_EINVAL;
+    nr = bfdev_pow2_roundup(nr);
+
+    /* the allocator only promises malloc alignment */
+    block = bfdev_malloc(alloc, sizeof(*counter->slots) * nr +
+                         BFDEV_CACHELINE_BYTES - 1);
+    if (!block)
+        return -BFDEV_ENOMEM;
+
+    counter->alloc = alloc;
+    counter->block = block;
+    counter->slots = bfdev_align_ptr_high(block, BFDEV_CACHELINE_BYTES);
+    counter->mask = nr - 1;
+
+    for (index = 0; index < nr; ++index)
+        bfdev_atomic_write(&counter->slots[index].value, 0);
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_percpu_counter_free(bfdev_percpu_counter_t *counter)
+{
+    const bfdev_alloc_t *alloc;
+
+    alloc = counter->alloc;
+    bfdev_free(alloc, counter->block);
+
+    counter->block = NULL;
+    counter->slots = NULL;
+    counter->mask = 0;
+}
+
+export bool
+bfdev_percpu_refcnt_kill(bfdev_percpu_refcnt_t *ref)
+{
+    bfdev_percpu_counter_t *counter;
+    bfdev_atomic_t sum, drop;
+    unsigned long index;
+
+    /*
+     * Every get or put either lands on a slot before it is killed
+     * and is collected here, or sees the dead slot and goes to the
+     * atomic counter. The bias keeps the atomic counter away from
+     * zero until all slots have been collected.
+     */
+    counter = &ref->counter;
+    for (index = sum = 0; index <= counter->mask; ++index) {
+        sum += bfdev_xchg(&counter->slots[index].value,
+                          BFDEV_PERCPU_REFCNT_DEAD);
+    }
+
+    drop = BFDEV_PERCPU_REFCNT_BIAS + 1 - sum;
+    return bfdev_atomic_fetch_sub(&ref->count, drop) == drop;
+}
+
+export void
+bfdev_percpu_refcnt_reinit(bfdev_percpu_refcnt_t *ref)
+{
+    bfdev_percpu_counter_t *counter;
+    unsigned long index;
+
+    counter = &ref->counter;
+    for (index = 0; index <= counter->mask; ++index)
+        bfdev_atomic_write(&counter->slots[index].value, 0);
+
+    bfdev_atomic_write(&ref->count, BFDEV_PERCPU_REFCNT_BIAS + 1);
+}
+
+export int
+bfdev_percpu_refcnt_alloc(bfdev_percpu_refcnt_t *ref,
+                          const bfdev_alloc_t *alloc, unsigned int nr)
+{
+    int retval;
+
+    retval = bfdev_percpu_counter_alloc(&ref->counter, alloc, nr);
+    if (retval)
+        return retval;
+
+    bfdev_atomic_write(&ref->count, BFDEV_PERCPU_REFCNT_BIAS + 1);
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_percpu_refcnt_free(bfdev_percpu_refcnt_t *ref)
+{
+    bfdev_percpu_counter_free(&ref->counter);
+}
@@ -6,6 +6,8 @@
 #include <base.h>
 #include <bfdev/ratelimit.h>
 #include <bfdev/time.h>
+#include <bfdev/cmpxchg.h>
+#include <bfdev/bitops.h>
 #include <export.h>
 
 export bool
@@ -34,3 +36,42 @@ bfdev_ratelimit(bfdev_ratelimit_t *limit, bfdev_time_t current)
 
     return accept;
 }
+
+export bool
+bfdev_ratelimit_acquire(bfdev_ratelimit_atomic_t *limit,
+                        bfdev_time_t current, unsigned int count)
+{
+    uintptr_t period, begin, passed, mask, value;
+    bfdev_atomic_t state;
+    unsigned int shift;
+
+    if (!limit->interval || !count)
+        return true;
+
+    if (bfdev_unlikely(count > limit->burst))
+        return false;
+
+    /* pack the period above just enough bits for the passed count */
+    shift = bfdev_fls(limit->burst);
+    mask = ((uintptr_t)2 << (shift - 1)) - 1;
+    period = (uintptr_t)(current / limit->interval) << shift;
+
+    state = bfdev_atomic_read(&limit->state);
+    do {
+        begin = (uintptr_t)state & ~mask;
+        passed = (uintptr_t)state & mask;
+
+        /* a caller with a lagging clock counts against the newer period */
+        if (!state || (intptr_t)(period - begin) > 0) {
+            begin = period;
+            passed = 0;
+        }
+
+        if (count > limit->burst - passed)
+            return false;
+
+        value = begin | (passed + count);
+    } while (!bfdev_try_cmpxchg(&limit->state, &state, (bfdev_atomic_t)value));
+
+    return true;
+}
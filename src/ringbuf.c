@@ -9,6 +9,9 @@
 #include <bfdev/bits.h>
 #include <export.h>
 
+#define __INSIDE_RINGBUF__
+#include <port/ringbuf.h>
+
 #define RINGBUF_GENERIC_COPY(copy1, copy2, fold1, fold2) do {   \
     unsigned long size, esize, llen;                            \
                                                                 \
@@ -22,11 +25,33 @@
         len *= esize;                                           \
     }                                                           \
                                                                 \
-    llen = bfdev_min(len, size - offset);                       \
+    llen = ringbuf->mirror ? len :                              \
+           bfdev_min(len, size - offset);                       \
     bfport_memcpy(copy1, copy2, llen);                          \
     bfport_memcpy(fold1, fold2, len - llen);                    \
 } while (0)
 
+static __bfdev_always_inline unsigned long
+ringbuf_spans(bfdev_ringbuf_t *ringbuf, bfdev_ringbuf_span_t *spans,
+              unsigned long len, unsigned long offset)
+{
+    unsigned long llen;
+
+    offset &= ringbuf->mask;
+    llen = len;
+
+    /* the mirror behind the buffer takes the wraparound */
+    if (!ringbuf->mirror)
+        bfdev_min_adj(llen, ringbuf->mask + 1 - offset);
+
+    spans[0].data = ringbuf->data + offset * ringbuf->esize;
+    spans[0].len = llen;
+    spans[1].data = ringbuf->data;
+    spans[1].len = len - llen;
+
+    return len;
+}
+
 static __bfdev_always_inline void
 ringbuf_out_copy(bfdev_ringbuf_t *ringbuf, void *buff,
                  unsigned long len, unsigned long offset)
@@ -51,12 +76,13 @@ static __bfdev_always_inline unsigned long
 ringbuf_record_peek(bfdev_ringbuf_t *ringbuf, unsigned long recsize)
 {
     unsigned long mask, offset, length;
+    unsigned int shift;
     uint8_t *data;
 
     mask = ringbuf->mask;
     offset = ringbuf->out;
     data = ringbuf->data;
-    length = 0;
+    length = shift = 0;
 
     if (ringbuf->esize != 1) {
         offset *= ringbuf->esize;
@@ -64,23 +90,24 @@ ringbuf_record_peek(bfdev_ringbuf_t *ringbuf, unsigned long recsize)
         mask += ringbuf->esize - 1;
     }
 
+    /* stored least significant byte first, see record_poke */
     while (recsize--) {
-        length <<= BFDEV_BITS_PER_U8;
-        length |= data[offset & mask];
+        length |= (unsigned long)data[offset & mask] << shift;
         offset += ringbuf->esize;
+        shift += BFDEV_BITS_PER_U8;
     }
 
     return length;
 }
 
 static __bfdev_always_inline void
-ringbuf_record_poke(bfdev_ringbuf_t *ringbuf, unsigned long len, unsigned long recsize)
+ringbuf_record_poke(bfdev_ringbuf_t *ringbuf, unsigned long len,
+                    unsigned long recsize, unsigned long offset)
 {
-    unsigned long mask, offset;
+    unsigned long mask;
     uint8_t *data;
 
     mask = ringbuf->mask;
-    offset = ringbuf->out;
     data = ringbuf->data;
 
     if (ringbuf->esize != 1) {
@@ -163,6 +190,48 @@ bfdev_ringbuf_in_flat(bfdev_ringbuf_t *ringbuf, const void *buff, unsigned long
     return len;
 }
 
+export unsigned long
+bfdev_ringbuf_reserve_flat(bfdev_ringbuf_t *ringbuf,
+                           bfdev_ringbuf_span_t *spans, unsigned long len)
+{
+    unsigned long size;
+
+    size = ringbuf->mask + 1;
+    bfdev_min_adj(len, size);
+
+    return ringbuf_spans(ringbuf, spans, len, ringbuf->in);
+}
+
+export void
+bfdev_ringbuf_commit_flat(bfdev_ringbuf_t *ringbuf, unsigned long len)
+{
+    unsigned long overflow;
+
+    ringbuf->in += len;
+
+    overflow = ringbuf_overflow(ringbuf);
+    if (overflow)
+        ringbuf->out += overflow;
+}
+
+export unsigned long
+bfdev_ringbuf_peek_spans_flat(bfdev_ringbuf_t *ringbuf,
+                              bfdev_ringbuf_span_t *spans, unsigned long len)
+{
+    unsigned long valid;
+
+    valid = ringbuf_valid(ringbuf);
+    bfdev_min_adj(len, valid);
+
+    return ringbuf_spans(ringbuf, spans, len, ringbuf->out);
+}
+
+export void
+bfdev_ringbuf_consume_flat(bfdev_ringbuf_t *ringbuf, unsigned long len)
+{
+    ringbuf->out += len;
+}
+
 export unsigned long
 bfdev_ringbuf_peek_record(bfdev_ringbuf_t *ringbuf, void *buff, unsigned long len,
                           unsigned long record)
@@ -216,12 +285,40 @@ bfdev_ringbuf_in_record(bfdev_ringbuf_t *ringbuf, const void *buff, unsigned lon
         overflow -= bfdev_min(datalen, overflow);
     }
 
-    ringbuf_record_poke(ringbuf, len, record);
+    ringbuf_record_poke(ringbuf, len, record, offset - record);
     ringbuf_in_copy(ringbuf, buff, len, offset);
 
     return len;
 }
 
+export unsigned long
+bfdev_ringbuf_peek_spans_record(bfdev_ringbuf_t *ringbuf,
+                                bfdev_ringbuf_span_t *spans, unsigned long len,
+                                unsigned long record)
+{
+    unsigned long datalen;
+
+    if (ringbuf_empty(ringbuf))
+        return 0;
+
+    datalen = ringbuf_record_peek(ringbuf, record);
+    bfdev_min_adj(len, datalen);
+
+    return ringbuf_spans(ringbuf, spans, len, ringbuf->out + record);
+}
+
+export void
+bfdev_ringbuf_consume_record(bfdev_ringbuf_t *ringbuf, unsigned long record)
+{
+    unsigned long datalen;
+
+    if (ringbuf_empty(ringbuf))
+        return;
+
+    datalen = ringbuf_record_peek(ringbuf, record);
+    ringbuf->out += datalen + record;
+}
+
 export int
 bfdev_ringbuf_dynamic_alloc(bfdev_ringbuf_t *ringbuf, const bfdev_alloc_t *alloc,
                             size_t esize, size_t size)
@@ -239,6 +336,38 @@ bfdev_ringbuf_dynamic_alloc(bfdev_ringbuf_t *ringbuf, const bfdev_alloc_t *alloc
     ringbuf->mask = size - 1;
     ringbuf->esize = esize;
     ringbuf->alloc = alloc;
+    ringbuf->mirror = false;
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_ringbuf_mirror_alloc(bfdev_ringbuf_t *ringbuf, size_t esize, size_t size)
+{
+    size_t align;
+
+    align = generic_ringbuf_mirror_align();
+    if (!align)
+        return -BFDEV_EOPNOTSUPP;
+
+    size = bfdev_pow2_roundup(size);
+    if (size < 2 || !esize)
+        return -BFDEV_EINVAL;
+
+    /* both halves must start on a page boundary */
+    while ((size * esize) & (align - 1))
+        size <<= 1;
+
+    ringbuf->data = generic_ringbuf_mirror_map(size * esize);
+    if (!ringbuf->data)
+        return -BFDEV_ENOMEM;
+
+    ringbuf->in = 0;
+    ringbuf->out = 0;
+    ringbuf->mask = size - 1;
+    ringbuf->esize = esize;
+    ringbuf->alloc = NULL;
+    ringbuf->mirror = true;
 
     return -BFDEV_ENOERR;
 }
@@ -247,13 +376,21 @@ export void
 bfdev_ringbuf_dynamic_free(bfdev_ringbuf_t *ringbuf)
 {
     const bfdev_alloc_t *alloc;
+    size_t size;
 
+    size = (ringbuf->mask + 1) * ringbuf->esize;
     ringbuf->in = 0;
     ringbuf->out = 0;
     ringbuf->mask = 0;
     ringbuf->esize = 0;
 
-    alloc = ringbuf->alloc;
-    bfdev_free(alloc, ringbuf->data);
+    if (ringbuf->mirror) {
+        generic_ringbuf_mirror_unmap(ringbuf->data, size);
+        ringbuf->mirror = false;
+    } else {
+        alloc = ringbuf->alloc;
+        bfdev_free(alloc, ringbuf->data);
+    }
+
     ringbuf->data = NULL;
 }
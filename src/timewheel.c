@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/timewheel.h>
+#include <bfdev/bitops.h>
+#include <export.h>
+
+#define TIMEWHEEL_RANGE (BFDEV_TIMEWHEEL_LEVELS * BFDEV_TIMEWHEEL_BITS)
+
+#if TIMEWHEEL_RANGE >= 63
+# error "timewheel range overflows bfdev_time_t"
+#endif
+
+static __bfdev_always_inline unsigned int
+timewheel_shift(unsigned int level)
+{
+    return level * BFDEV_TIMEWHEEL_BITS;
+}
+
+static __bfdev_always_inline unsigned int
+timewheel_offset(uint64_t time, unsigned int level)
+{
+    return (time >> timewheel_shift(level)) & BFDEV_TIMEWHEEL_MASK;
+}
+
+/*
+ * A timer goes into the lowest level whose slot index is the first
+ * place it differs from the clock, so the slot is always strictly
+ * ahead of the current position and is reached within one rotation.
+ */
+static void
+timewheel_enqueue(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node,
+                  uint64_t when)
+{
+    unsigned int level, offset;
+    uint64_t clock;
+
+    clock = wheel->clock;
+    if (when == clock)
+        level = 0;
+    else
+        level = bfdev_flsuf64(when ^ clock) / BFDEV_TIMEWHEEL_BITS;
+
+    if (bfdev_likely(level < BFDEV_TIMEWHEEL_LEVELS))
+        offset = timewheel_offset(when, level);
+    else {
+        /* out of range, park in the slot that is reached last */
+        level = BFDEV_TIMEWHEEL_LEVELS - 1;
+        offset = (timewheel_offset(clock, level) - 1) & BFDEV_TIMEWHEEL_MASK;
+    }
+
+    node->index = level * BFDEV_TIMEWHEEL_SLOTS + offset;
+    bfdev_list_add_prev(&wheel->slots[level][offset], &node->list);
+    bfdev_bit_set(wheel->pending[level], offset);
+}
+
+static void
+timewheel_dequeue(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node)
+{
+    unsigned int level, offset;
+
+    level = node->index / BFDEV_TIMEWHEEL_SLOTS;
+    offset = node->index % BFDEV_TIMEWHEEL_SLOTS;
+
+    bfdev_list_del_init(&node->list);
+    node->index = BFDEV_TIMEWHEEL_IDLE;
+
+    if (bfdev_list_check_empty(&wheel->slots[level][offset]))
+        bfdev_bit_clr(wheel->pending[level], offset);
+}
+
+static void
+timewheel_cascade(bfdev_timewheel_t *wheel, unsigned int level)
+{
+    bfdev_timewheel_node_t *node, *tmp;
+    unsigned int offset;
+    uint64_t when;
+
+    BFDEV_LIST_HEAD(batch);
+
+    offset = timewheel_offset(wheel->clock, level);
+    if (!bfdev_bit_test_clr(wheel->pending[level], offset))
+        return;
+
+    bfdev_list_splice_init(&batch, &wheel->slots[level][offset]);
+    bfdev_list_for_each_entry_safe(node, tmp, &batch, list) {
+        when = bfdev_max((uint64_t)node->expires, (uint64_t)wheel->clock);
+        timewheel_enqueue(wheel, node, when);
+    }
+}
+
+static bool
+timewheel_next(const bfdev_timewheel_t *wheel, uint64_t *timep)
+{
+    unsigned int level, offset, shift;
+    uint64_t clock, base;
+
+    if (!wheel->count)
+        return false;
+
+    clock = wheel->clock;
+    for (level = 0; level < BFDEV_TIMEWHEEL_LEVELS; ++level) {
+        shift = timewheel_shift(level);
+        offset = bfdev_find_next_bit(
+            wheel->pending[level], BFDEV_TIMEWHEEL_SLOTS,
+            timewheel_offset(clock, level) + 1
+        );
+
+        if (offset < BFDEV_TIMEWHEEL_SLOTS) {
+            base = clock >> (shift + BFDEV_TIMEWHEEL_BITS);
+            base <<= BFDEV_TIMEWHEEL_BITS;
+            *timep = (base + offset) << shift;
+            return true;
+        }
+    }
+
+    /* only parked timers left, wrap around the top level */
+    level = BFDEV_TIMEWHEEL_LEVELS - 1;
+    shift = timewheel_shift(level);
+    offset = bfdev_find_first_bit(wheel->pending[level], BFDEV_TIMEWHEEL_SLOTS);
+    BFDEV_BUG_ON(offset >= BFDEV_TIMEWHEEL_SLOTS);
+
+    base = (clock >> TIMEWHEEL_RANGE) + 1;
+    base <<= BFDEV_TIMEWHEEL_BITS;
+    *timep = (base + offset) << shift;
+
+    return true;
+}
+
+export void
+bfdev_timewheel_init(bfdev_timewheel_t *wheel, bfdev_time_t clock)
+{
+    unsigned int level, offset;
+
+    wheel->clock = clock;
+    wheel->count = 0;
+
+    for (level = 0; level < BFDEV_TIMEWHEEL_LEVELS; ++level) {
+        bfdev_bitmap_zero(wheel->pending[level], BFDEV_TIMEWHEEL_SLOTS);
+        for (offset = 0; offset < BFDEV_TIMEWHEEL_SLOTS; ++offset)
+            bfdev_list_head_init(&wheel->slots[level][offset]);
+    }
+}
+
+export void
+bfdev_timewheel_add(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node,
+                    bfdev_time_t expires)
+{
+    uint64_t when;
+
+    BFDEV_BUG_ON(bfdev_timewheel_pending(node));
+
+    /* the current tick has been handled already */
+    node->expires = expires;
+    when = bfdev_time_after(expires, wheel->clock)
+         ? expires : bfdev_time_add(wheel->clock, 1);
+
+    timewheel_enqueue(wheel, node, when);
+    wheel->count++;
+}
+
+export bool
+bfdev_timewheel_del(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node)
+{
+    if (!bfdev_timewheel_pending(node))
+        return false;
+
+    timewheel_dequeue(wheel, node);
+    wheel->count--;
+
+    return true;
+}
+
+export void
+bfdev_timewheel_mod(bfdev_timewheel_t *wheel, bfdev_timewheel_node_t *node,
+                    bfdev_time_t expires)
+{
+    if (!bfdev_timewheel_del(wheel, node))
+        bfdev_list_del_init(&node->list);
+
+    bfdev_timewheel_add(wheel, node, expires);
+}
+
+export bool
+bfdev_timewheel_next(const bfdev_timewheel_t *wheel, bfdev_time_t *timep)
+{
+    uint64_t next;
+
+    if (!timewheel_next(wheel, &next))
+        return false;
+
+    *timep = next;
+    return true;
+}
+
+export unsigned long
+bfdev_timewheel_expire(bfdev_timewheel_t *wheel, bfdev_time_t now,
+                       bfdev_list_head_t *expired)
+{
+    bfdev_list_head_t *slot;
+    unsigned long count, tmp;
+    unsigned int level, offset;
+    bfdev_timewheel_node_t *node;
+    uint64_t next;
+
+    count = 0;
+    while (timewheel_next(wheel, &next)) {
+        if (bfdev_time_after((bfdev_time_t)next, now))
+            break;
+
+        wheel->clock = next;
+
+        /* cascade every level whose lower bits just wrapped */
+        level = BFDEV_TIMEWHEEL_LEVELS;
+        while (--level) {
+            if (next & ((UINT64_C(1) << timewheel_shift(level)) - 1))
+                continue;
+            timewheel_cascade(wheel, level);
+        }
+
+        offset = timewheel_offset(next, 0);
+        if (!bfdev_bit_test_clr(wheel->pending[0], offset))
+            continue;
+
+        tmp = 0;
+        slot = &wheel->slots[0][offset];
+        bfdev_list_for_each_entry(node, slot, list) {
+            node->index = BFDEV_TIMEWHEEL_IDLE;
+            tmp++;
+        }
+
+        bfdev_list_splice_tail_init(expired, slot);
+        wheel->count -= tmp;
+        count += tmp;
+    }
+
+    if (bfdev_time_after(now, wheel->clock))
+        wheel->clock = now;
+
+    return count;
+}
+
+export unsigned long
+bfdev_timewheel_run(bfdev_timewheel_t *wheel, bfdev_time_t now,
+                    bfdev_timewheel_func_t func, void *pdata)
+{
+    bfdev_timewheel_node_t *node;
+    unsigned long count;
+
+    BFDEV_LIST_HEAD(expired);
+
+    count = bfdev_timewheel_expire(wheel, now, &expired);
+    while (!bfdev_list_check_empty(&expired)) {
+        node = bfdev_list_first_entry(&expired, bfdev_timewheel_node_t, list);
+        bfdev_list_del_init(&node->list);
+        func(node, pdata);
+    }
+
+    return count;
+}
@@ -6,6 +6,8 @@
 #include <base.h>
 #include <bfdev/tokenbucket.h>
 #include <bfdev/time.h>
+#include <bfdev/cmpxchg.h>
+#include <bfdev/bitops.h>
 #include <export.h>
 
 export bool
@@ -36,3 +38,76 @@ bfdev_tokenbucket(bfdev_tokenbucket_t *limit, bfdev_time_t current)
 
     return true;
 }
+
+export bool
+bfdev_tokenbucket_acquire(bfdev_tokenbucket_atomic_t *limit,
+                          bfdev_time_t current, unsigned int count)
+{
+    uintptr_t ticks, last, used, mask, value;
+    bfdev_atomic_t state;
+    unsigned int shift;
+
+    if (!limit->interval || !count)
+        return true;
+
+    if (bfdev_unlikely(count > limit->capacity))
+        return false;
+
+    /* pack the refill time above just enough bits for the used tokens */
+    shift = bfdev_fls(limit->capacity);
+    mask = ((uintptr_t)2 << (shift - 1)) - 1;
+    ticks = (uintptr_t)(current / limit->interval) << shift;
+
+    state = bfdev_atomic_read(&limit->state);
+    do {
+        last = (uintptr_t)state & ~mask;
+        used = (uintptr_t)state & mask;
+
+        if (!used) {
+            /* a full bucket, the zero state included, has nothing to refill */
+            last = ticks;
+        } else if ((intptr_t)(ticks - last) > 0) {
+            /* generate token */
+            value = (ticks - last) >> shift;
+            used = value >= used ? 0 : used - value;
+            last = ticks;
+        }
+
+        if (limit->capacity - used < count)
+            return false;
+
+        value = last | (used + count);
+    } while (!bfdev_try_cmpxchg(&limit->state, &state, (bfdev_atomic_t)value));
+
+    return true;
+}
+
+export bool
+bfdev_tokenbucket_gcra(const bfdev_tokenbucket_t *limit, bfdev_atomic_t *tat,
+                       bfdev_time_t current, unsigned int count)
+{
+    bfdev_time_t increment, tolerance, wait;
+    bfdev_atomic_t value;
+
+    if (!limit->interval || !count)
+        return true;
+
+    increment = limit->interval * count;
+    tolerance = limit->interval * limit->capacity;
+    if (bfdev_unlikely(increment > tolerance))
+        return false;
+
+    value = bfdev_atomic_read(tat);
+    do {
+        /* how far the key is ahead of its allowance */
+        wait = (bfdev_atomic_t)((uintptr_t)value - (uintptr_t)current);
+        if (wait < 0 || wait > tolerance)
+            wait = 0;
+
+        if (wait + increment > tolerance)
+            return false;
+    } while (!bfdev_try_cmpxchg(tat, &value,
+             (bfdev_atomic_t)((uintptr_t)current + (uintptr_t)(wait + increment))));
+
+    return true;
+}
@@ -0,0 +1,448 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/wspool.h>
+#include <bfdev/cmpxchg.h>
+#include <bfdev/align.h>
+#include <bfdev/log2.h>
+#include <export.h>
+
+#define WSPOOL_SPIN 64
+#define WSPOOL_SPLIT 8
+
+struct wspool_for {
+    bfdev_wspool_task_t task;
+    bfdev_wspool_for_t func;
+    unsigned long begin, end;
+    unsigned long grain;
+    void *pdata;
+};
+
+struct wspool_reduce {
+    bfdev_wspool_task_t task;
+    bfdev_wspool_map_t map;
+    bfdev_wspool_combine_t combine;
+    unsigned long begin, end;
+    unsigned long grain;
+    void *pdata;
+    unsigned long result[BFDEV_WSPOOL_RESULT / sizeof(unsigned long)];
+};
+
+/*
+ * Only the owner moves bottom, so pushing needs nothing but a release
+ * store. A thief that read an index keeps top from moving past it until
+ * its cmpxchg, so the slot cannot be reused underneath it.
+ */
+static bool
+wspool_push(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task,
+            bfdev_atomic_t *slot)
+{
+    bfdev_atomic_t bottom, top;
+
+    bottom = bfdev_atomic_read(&worker->bottom);
+    top = bfdev_atomic_read_acquire(&worker->top);
+    if ((unsigned long)(bottom - top) > worker->pool->mask)
+        return false;
+
+    *slot = bottom;
+    bfdev_atomic_write(&worker->tasks[bottom & worker->pool->mask],
+                       (bfdev_atomic_t)task);
+    bfdev_atomic_write_release(&worker->bottom, bottom + 1);
+
+    return true;
+}
+
+static bfdev_wspool_task_t *
+wspool_take(bfdev_wspool_worker_t *worker)
+{
+    bfdev_atomic_t bottom, top, task;
+
+    bottom = bfdev_atomic_read(&worker->bottom) - 1;
+    bfdev_atomic_write(&worker->bottom, bottom);
+    bfdev_atomic_fence();
+    top = bfdev_atomic_read(&worker->top);
+
+    if (top > bottom) {
+        bfdev_atomic_write(&worker->bottom, bottom + 1);
+        return NULL;
+    }
+
+    task = bfdev_atomic_read(&worker->tasks[bottom & worker->pool->mask]);
+    if (top != bottom)
+        return (void *)task;
+
+    /* the last one, race against thieves for it */
+    if (bfdev_cmpxchg(&worker->top, top, top + 1) != top)
+        task = 0;
+    bfdev_atomic_write(&worker->bottom, bottom + 1);
+
+    return (void *)task;
+}
+
+static bfdev_wspool_task_t *
+wspool_steal(bfdev_wspool_worker_t *victim)
+{
+    bfdev_atomic_t bottom, top, task;
+
+    top = bfdev_atomic_read_acquire(&victim->top);
+    bfdev_atomic_fence();
+    bottom = bfdev_atomic_read_acquire(&victim->bottom);
+    if (top >= bottom)
+        return NULL;
+
+    task = bfdev_atomic_read(&victim->tasks[top & victim->pool->mask]);
+    if (bfdev_cmpxchg(&victim->top, top, top + 1) != top)
+        return NULL;
+
+    return (void *)task;
+}
+
+static bfdev_wspool_task_t *
+wspool_steal_any(bfdev_wspool_worker_t *worker)
+{
+    bfdev_wspool_t *pool = worker->pool;
+    bfdev_wspool_task_t *task;
+    unsigned int count, index;
+    uint32_t seed;
+
+    /* xorshift, good enough to spread thieves over victims */
+    seed = worker->seed;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    worker->seed = seed;
+
+    index = seed % pool->nr;
+    for (count = 0; count < pool->nr; ++count) {
+        if (&pool->workers[index] != worker) {
+            task = wspool_steal(&pool->workers[index]);
+            if (task)
+                return task;
+        }
+
+        if (++index == pool->nr)
+            index = 0;
+    }
+
+    return NULL;
+}
+
+static bool
+wspool_has_work(bfdev_wspool_t *pool)
+{
+    bfdev_wspool_worker_t *worker;
+    unsigned int index;
+
+    for (index = 0; index < pool->nr; ++index) {
+        worker = &pool->workers[index];
+        if (bfdev_atomic_read(&worker->top) <
+            bfdev_atomic_read(&worker->bottom))
+            return true;
+    }
+
+    return false;
+}
+
+static inline void
+wspool_execute(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task)
+{
+    task->entry(worker, task);
+    bfdev_atomic_write_release(&task->done, 1);
+}
+
+export void
+bfdev_wspool_fork(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task)
+{
+    bfdev_wspool_t *pool = worker->pool;
+    bfdev_atomic_t slot;
+
+    bfdev_atomic_write(&task->done, 0);
+    if (bfdev_unlikely(!wspool_push(worker, task, &slot))) {
+        wspool_execute(worker, task);
+        return;
+    }
+
+    if (!pool->ops)
+        return;
+
+    bfdev_atomic_fence();
+    if (!bfdev_atomic_read(&pool->sleepers))
+        return;
+
+    /*
+     * Sleepers rescan every deque after announcing themselves, they
+     * can only have missed a deque turning non-empty. The top read
+     * while pushing may predate thieves emptying the deque, so read
+     * it again: older tasks still queued now were queued all along.
+     */
+    if (bfdev_atomic_read(&worker->top) < slot)
+        return;
+
+    bfdev_atomic_add(&pool->event, 1);
+    pool->ops->wake(&pool->event, pool->pdata);
+}
+
+export void
+bfdev_wspool_join(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task)
+{
+    bfdev_wspool_task_t *other;
+
+    while (!bfdev_atomic_read_acquire(&task->done)) {
+        other = wspool_take(worker);
+        if (!other)
+            other = wspool_steal_any(worker);
+        if (other)
+            wspool_execute(worker, other);
+    }
+}
+
+static unsigned long
+wspool_grain(bfdev_wspool_t *pool, unsigned long begin,
+             unsigned long end, unsigned long grain)
+{
+    if (grain)
+        return grain;
+
+    grain = (end - begin) / (pool->nr * WSPOOL_SPLIT);
+    return grain ?: 1;
+}
+
+static void
+wspool_for_range(bfdev_wspool_worker_t *worker, struct wspool_for *range)
+{
+    struct wspool_for child;
+    unsigned long middle;
+
+    if (range->end - range->begin <= range->grain) {
+        range->func(range->begin, range->end, range->pdata);
+        return;
+    }
+
+    middle = range->begin + (range->end - range->begin) / 2;
+    child = *range;
+    child.begin = middle;
+    range->end = middle;
+
+    /* keep the lower half, offer the upper half to thieves */
+    bfdev_wspool_fork(worker, &child.task);
+    wspool_for_range(worker, range);
+    bfdev_wspool_join(worker, &child.task);
+}
+
+static void
+wspool_for_entry(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task)
+{
+    struct wspool_for *range;
+
+    range = bfdev_container_of(task, struct wspool_for, task);
+    wspool_for_range(worker, range);
+}
+
+export int
+bfdev_wspool_parallel_for(bfdev_wspool_t *pool, unsigned int index,
+                          unsigned long begin, unsigned long end,
+                          unsigned long grain, bfdev_wspool_for_t func,
+                          void *pdata)
+{
+    struct wspool_for range;
+
+    if (index >= pool->nr || begin > end)
+        return -BFDEV_EINVAL;
+
+    if (begin == end)
+        return -BFDEV_ENOERR;
+
+    range.task.entry = wspool_for_entry;
+    range.func = func;
+    range.begin = begin;
+    range.end = end;
+    range.grain = wspool_grain(pool, begin, end, grain);
+    range.pdata = pdata;
+
+    wspool_for_range(&pool->workers[index], &range);
+
+    return -BFDEV_ENOERR;
+}
+
+static void
+wspool_reduce_range(bfdev_wspool_worker_t *worker, struct wspool_reduce *range,
+                    void *result)
+{
+    struct wspool_reduce child;
+    unsigned long middle;
+
+    if (range->end - range->begin <= range->grain) {
+        range->map(range->begin, range->end, result, range->pdata);
+        return;
+    }
+
+    middle = range->begin + (range->end - range->begin) / 2;
+    child.task.entry = range->task.entry;
+    child.map = range->map;
+    child.combine = range->combine;
+    child.begin = middle;
+    child.end = range->end;
+    child.grain = range->grain;
+    child.pdata = range->pdata;
+    range->end = middle;
+
+    bfdev_wspool_fork(worker, &child.task);
+    wspool_reduce_range(worker, range, result);
+    bfdev_wspool_join(worker, &child.task);
+
+    range->combine(result, child.result, range->pdata);
+}
+
+static void
+wspool_reduce_entry(bfdev_wspool_worker_t *worker, bfdev_wspool_task_t *task)
+{
+    struct wspool_reduce *range;
+
+    range = bfdev_container_of(task, struct wspool_reduce, task);
+    wspool_reduce_range(worker, range, range->result);
+}
+
+export int
+bfdev_wspool_parallel_reduce(bfdev_wspool_t *pool, unsigned int index,
+                             unsigned long begin, unsigned long end,
+                             unsigned long grain, bfdev_wspool_map_t map,
+                             bfdev_wspool_combine_t combine,
+                             void *result, size_t rsize, void *pdata)
+{
+    struct wspool_reduce range;
+
+    if (index >= pool->nr || begin >= end)
+        return -BFDEV_EINVAL;
+
+    if (rsize > BFDEV_WSPOOL_RESULT)
+        return -BFDEV_EOVERFLOW;
+
+    range.task.entry = wspool_reduce_entry;
+    range.map = map;
+    range.combine = combine;
+    range.begin = begin;
+    range.end = end;
+    range.grain = wspool_grain(pool, begin, end, grain);
+    range.pdata = pdata;
+
+    wspool_reduce_range(&pool->workers[index], &range, result);
+
+    return -BFDEV_ENOERR;
+}
+
+export int
+bfdev_wspool_run(bfdev_wspool_t *pool, unsigned int index)
+{
+    bfdev_wspool_worker_t *worker;
+    bfdev_wspool_task_t *task;
+    bfdev_atomic_t event;
+    unsigned int idle;
+
+    if (index >= pool->nr)
+        return -BFDEV_EINVAL;
+
+    worker = &pool->workers[index];
+    for (idle = 0;;) {
+        task = wspool_take(worker);
+        if (!task)
+            task = wspool_steal_any(worker);
+
+        if (task) {
+            wspool_execute(worker, task);
+            idle = 0;
+            continue;
+        }
+
+        if (bfdev_atomic_read_acquire(&pool->stop))
+            break;
+
+        if (!pool->ops || ++idle < WSPOOL_SPIN)
+            continue;
+
+        /* announce before the final scan, pairs with fork */
+        event = bfdev_atomic_read(&pool->event);
+        bfdev_atomic_add(&pool->sleepers, 1);
+
+        if (!wspool_has_work(pool) && !bfdev_atomic_read(&pool->stop))
+            pool->ops->wait(&pool->event, event, pool->pdata);
+
+        bfdev_atomic_sub(&pool->sleepers, 1);
+        idle = 0;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_wspool_stop(bfdev_wspool_t *pool)
+{
+    bfdev_atomic_write_release(&pool->stop, 1);
+    bfdev_atomic_fence();
+
+    if (pool->ops) {
+        bfdev_atomic_add(&pool->event, 1);
+        pool->ops->wake(&pool->event, pool->pdata);
+    }
+}
+
+export void
+bfdev_wspool_reset(bfdev_wspool_t *pool)
+{
+    bfdev_atomic_write(&pool->stop, 0);
+}
+
+export int
+bfdev_wspool_alloc(bfdev_wspool_t *pool, const bfdev_alloc_t *alloc,
+                   unsigned int nr, unsigned long depth)
+{
+    bfdev_wspool_worker_t *worker;
+    bfdev_atomic_t *tasks;
+    unsigned int index;
+    void *block;
+
+    if (!nr || !depth)
+        return -BFDEV_EINVAL;
+    depth = bfdev_pow2_roundup(depth);
+
+    /* the allocator only promises malloc alignment */
+    block = bfdev_malloc(alloc, sizeof(*worker) * nr +
+                         sizeof(*tasks) * depth * nr +
+                         BFDEV_CACHELINE_BYTES - 1);
+    if (!block)
+        return -BFDEV_ENOMEM;
+
+    pool->alloc = alloc;
+    pool->ops = NULL;
+    pool->pdata = NULL;
+    pool->block = block;
+    pool->workers = bfdev_align_ptr_high(block, BFDEV_CACHELINE_BYTES);
+    pool->nr = nr;
+    pool->mask = depth - 1;
+    pool->stop = 0;
+    pool->event = 0;
+    pool->sleepers = 0;
+
+    tasks = (bfdev_atomic_t *)(pool->workers + nr);
+    for (index = 0; index < nr; ++index) {
+        worker = &pool->workers[index];
+        worker->top = 0;
+        worker->bottom = 0;
+        worker->pool = pool;
+        worker->tasks = tasks + depth * index;
+        worker->seed = index * 0x9e3779b9U + 1;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+export void
+bfdev_wspool_free(bfdev_wspool_t *pool)
+{
+    bfdev_free(pool->alloc, pool->block);
+    pool->block = NULL;
+    pool->workers = NULL;
+    pool->nr = 0;
+}
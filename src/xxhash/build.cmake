@@ -0,0 +1,11 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+#
+# Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+#
+
+set(BFDEV_SOURCE
+    ${BFDEV_SOURCE}
+    ${CMAKE_CURRENT_LIST_DIR}/xxh3.c
+    ${CMAKE_CURRENT_LIST_DIR}/xxh3-arm64.c
+    ${CMAKE_CURRENT_LIST_DIR}/xxh3-x86.c
+)
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#ifndef _LOCAL_XXH3_ACCEL_H_
+#define _LOCAL_XXH3_ACCEL_H_
+
+#include <bfdev/config.h>
+#include <bfdev/types.h>
+#include <export.h>
+
+BFDEV_BEGIN_DECLS
+
+#if defined(__x86_64__) && defined(__GNUC__)
+# define XXH3_ACCEL_X86
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+# define XXH3_ACCEL_ARM64
+#endif
+
+#define XXH_PRIME32_1 0x9e3779b1U
+#define XXH_PRIME32_2 0x85ebca77U
+#define XXH_PRIME32_3 0xc2b2ae3dU
+
+#define XXH_PRIME64_1 0x9e3779b185ebca87ULL
+#define XXH_PRIME64_2 0xc2b2ae3d27d4eb4fULL
+#define XXH_PRIME64_3 0x165667b19e3779f9ULL
+#define XXH_PRIME64_4 0x85ebca77c2b2ae63ULL
+#define XXH_PRIME64_5 0x27d4eb2f165667c5ULL
+
+/*
+ * xxh3_accumulate_*() - fold whole stripes into the accumulators.
+ * @acc: the eight accumulators, no alignment required.
+ * @data: @stripes times 64 bytes of input.
+ * @secret: secret of the first stripe, advancing 8 bytes per stripe.
+ * @stripes: number of stripes.
+ */
+
+typedef void
+(*xxh3_accumulate_t)(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes);
+
+/*
+ * xxh3_scramble_*() - mix the accumulators at the end of a block.
+ * @acc: the eight accumulators.
+ * @secret: 64 bytes of secret.
+ */
+
+typedef void
+(*xxh3_scramble_t)(uint64_t *acc, const uint8_t *secret);
+
+struct xxh3_ops {
+    xxh3_accumulate_t accumulate;
+    xxh3_scramble_t scramble;
+};
+
+extern hidden void
+xxh3_accumulate_generic(uint64_t *acc, const uint8_t *data,
+                        const uint8_t *secret, size_t stripes);
+
+extern hidden void
+xxh3_scramble_generic(uint64_t *acc, const uint8_t *secret);
+
+#ifdef XXH3_ACCEL_X86
+extern hidden void
+xxh3_accumulate_sse2(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes);
+
+extern hidden void
+xxh3_scramble_sse2(uint64_t *acc, const uint8_t *secret);
+
+extern hidden void
+xxh3_accumulate_avx2(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes);
+
+extern hidden void
+xxh3_scramble_avx2(uint64_t *acc, const uint8_t *secret);
+
+extern hidden void
+xxh3_accumulate_avx512(uint64_t *acc, const uint8_t *data,
+                       const uint8_t *secret, size_t stripes);
+
+extern hidden void
+xxh3_scramble_avx512(uint64_t *acc, const uint8_t *secret);
+#endif
+
+#ifdef XXH3_ACCEL_ARM64
+extern hidden void
+xxh3_accumulate_neon(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes);
+
+extern hidden void
+xxh3_scramble_neon(uint64_t *acc, const uint8_t *secret);
+#endif
+
+BFDEV_END_DECLS
+
+#endif /* _LOCAL_XXH3_ACCEL_H_ */
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include "xxh3-accel.h"
+#include <export.h>
+
+#ifdef XXH3_ACCEL_ARM64
+#include <arm_neon.h>
+
+/*
+ * The narrowing moves split each keyed lane into its halves, so one
+ * widening multiply gives the products of two lanes at once.
+ */
+hidden void
+xxh3_accumulate_neon(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes)
+{
+    uint64x2_t vacc[4], value, key;
+    unsigned int index;
+
+    for (index = 0; index < 4; ++index)
+        vacc[index] = vld1q_u64(acc + index * 2);
+
+    for (; stripes; --stripes) {
+        for (index = 0; index < 4; ++index) {
+            value = vreinterpretq_u64_u8(vld1q_u8(data + index * 16));
+            key = veorq_u64(value, vreinterpretq_u64_u8(
+                vld1q_u8(secret + index * 16)));
+
+            vacc[index] = vaddq_u64(vacc[index], vextq_u64(value, value, 1));
+            vacc[index] = vmlal_u32(vacc[index], vmovn_u64(key),
+                                    vshrn_n_u64(key, 32));
+        }
+
+        data += 64;
+        secret += 8;
+    }
+
+    for (index = 0; index < 4; ++index)
+        vst1q_u64(acc + index * 2, vacc[index]);
+}
+
+hidden void
+xxh3_scramble_neon(uint64_t *acc, const uint8_t *secret)
+{
+    uint64x2_t value, high;
+    unsigned int index;
+
+    for (index = 0; index < 4; ++index) {
+        value = vld1q_u64(acc + index * 2);
+        value = veorq_u64(value, vshrq_n_u64(value, 47));
+        value = veorq_u64(value, vreinterpretq_u64_u8(
+            vld1q_u8(secret + index * 16)));
+
+        high = vmull_n_u32(vshrn_n_u64(value, 32), XXH_PRIME32_1);
+        high = vshlq_n_u64(high, 32);
+        value = vmlal_n_u32(high, vmovn_u64(value), XXH_PRIME32_1);
+        vst1q_u64(acc + index * 2, value);
+    }
+}
+
+#endif /* XXH3_ACCEL_ARM64 */
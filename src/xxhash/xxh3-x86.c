@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include "xxh3-accel.h"
+#include <export.h>
+
+#ifdef XXH3_ACCEL_X86
+#include <immintrin.h>
+
+#define AVX2_TARGET __bfdev_target("avx2")
+#define AVX512_TARGET __bfdev_target("avx512f")
+
+/*
+ * Every 64-bit lane takes the product of the low and high half of
+ * its keyed input, which is exactly what pmuludq computes once the
+ * high half is shuffled down. The plain input is added to the
+ * neighbouring lane, hence the swap of each pair.
+ */
+
+hidden void
+xxh3_accumulate_sse2(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes)
+{
+    __m128i vacc[4], value, key, product;
+    unsigned int index;
+
+    for (index = 0; index < 4; ++index)
+        vacc[index] = _mm_loadu_si128((const void *)(acc + index * 2));
+
+    for (; stripes; --stripes) {
+        for (index = 0; index < 4; ++index) {
+            value = _mm_loadu_si128((const void *)(data + index * 16));
+            key = _mm_xor_si128(value, _mm_loadu_si128(
+                (const void *)(secret + index * 16)));
+
+            product = _mm_mul_epu32(key, _mm_shuffle_epi32(key,
+                _MM_SHUFFLE(0, 3, 0, 1)));
+            value = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            vacc[index] = _mm_add_epi64(vacc[index],
+                _mm_add_epi64(product, value));
+        }
+
+        data += 64;
+        secret += 8;
+    }
+
+    for (index = 0; index < 4; ++index)
+        _mm_storeu_si128((void *)(acc + index * 2), vacc[index]);
+}
+
+hidden void
+xxh3_scramble_sse2(uint64_t *acc, const uint8_t *secret)
+{
+    __m128i value, low, high, prime;
+    unsigned int index;
+
+    prime = _mm_set1_epi32(XXH_PRIME32_1);
+    for (index = 0; index < 4; ++index) {
+        value = _mm_loadu_si128((const void *)(acc + index * 2));
+        value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+        value = _mm_xor_si128(value, _mm_loadu_si128(
+            (const void *)(secret + index * 16)));
+
+        low = _mm_mul_epu32(value, prime);
+        high = _mm_mul_epu32(_mm_shuffle_epi32(value,
+            _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        value = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+        _mm_storeu_si128((void *)(acc + index * 2), value);
+    }
+}
+
+hidden AVX2_TARGET void
+xxh3_accumulate_avx2(uint64_t *acc, const uint8_t *data,
+                     const uint8_t *secret, size_t stripes)
+{
+    __m256i vacc[2], value, key, product;
+    unsigned int index;
+
+    for (index = 0; index < 2; ++index)
+        vacc[index] = _mm256_loadu_si256((const void *)(acc + index * 4));
+
+    for (; stripes; --stripes) {
+        for (index = 0; index < 2; ++index) {
+            value = _mm256_loadu_si256((const void *)(data + index * 32));
+            key = _mm256_xor_si256(value, _mm256_loadu_si256(
+                (const void *)(secret + index * 32)));
+
+            product = _mm256_mul_epu32(key, _mm256_shuffle_epi32(key,
+                _MM_SHUFFLE(0, 3, 0, 1)));
+            value = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            vacc[index] = _mm256_add_epi64(vacc[index],
+                _mm256_add_epi64(product, value));
+        }
+
+        data += 64;
+        secret += 8;
+    }
+
+    for (index = 0; index < 2; ++index)
+        _mm256_storeu_si256((void *)(acc + index * 4), vacc[index]);
+}
+
+hidden AVX2_TARGET void
+xxh3_scramble_avx2(uint64_t *acc, const uint8_t *secret)
+{
+    __m256i value, low, high, prime;
+    unsigned int index;
+
+    prime = _mm256_set1_epi32(XXH_PRIME32_1);
+    for (index = 0; index < 2; ++index) {
+        value = _mm256_loadu_si256((const void *)(acc + index * 4));
+        value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+        value = _mm256_xor_si256(value, _mm256_loadu_si256(
+            (const void *)(secret + index * 32)));
+
+        low = _mm256_mul_epu32(value, prime);
+        high = _mm256_mul_epu32(_mm256_shuffle_epi32(value,
+            _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        value = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+        _mm256_storeu_si256((void *)(acc + index * 4), value);
+    }
+}
+
+hidden AVX512_TARGET void
+xxh3_accumulate_avx512(uint64_t *acc, const uint8_t *data,
+                       const uint8_t *secret, size_t stripes)
+{
+    __m512i vacc, value, key, product;
+
+    vacc = _mm512_loadu_si512(acc);
+    for (; stripes; --stripes) {
+        value = _mm512_loadu_si512(data);
+        key = _mm512_xor_si512(value, _mm512_loadu_si512(secret));
+
+        product = _mm512_mul_epu32(key, _mm512_shuffle_epi32(key,
+            (_MM_PERM_ENUM)_MM_SHUFFLE(0, 3, 0, 1)));
+        value = _mm512_shuffle_epi32(value,
+            (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2));
+        vacc = _mm512_add_epi64(vacc, _mm512_add_epi64(product, value));
+
+        data += 64;
+        secret += 8;
+    }
+
+    _mm512_storeu_si512(acc, vacc);
+}
+
+hidden AVX512_TARGET void
+xxh3_scramble_avx512(uint64_t *acc, const uint8_t *secret)
+{
+    __m512i value, low, high, prime;
+
+    prime = _mm512_set1_epi32(XXH_PRIME32_1);
+    value = _mm512_loadu_si512(acc);
+
+    /* value ^ (value >> 47) ^ secret in one go */
+    value = _mm512_ternarylogic_epi32(value, _mm512_srli_epi64(value, 47),
+                                      _mm512_loadu_si512(secret), 0x96);
+
+    low = _mm512_mul_epu32(value, prime);
+    high = _mm512_mul_epu32(_mm512_srli_epi64(value, 32), prime);
+    value = _mm512_add_epi64(low, _mm512_slli_epi64(high, 32));
+    _mm512_storeu_si512(acc, value);
+}
+
+#endif /* XXH3_ACCEL_X86 */
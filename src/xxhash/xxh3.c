@@ -0,0 +1,723 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#include <base.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/unaligned.h>
+#include <bfdev/bitops.h>
+#include <bfdev/swab.h>
+#include <bfdev/minmax.h>
+#include <bfdev/dispatch.h>
+#include "xxh3-accel.h"
+#include <export.h>
+
+#define XXH_PRIME_MX1 0x165667919e3779f9ULL
+#define XXH_PRIME_MX2 0x9fb21c651e98df25ULL
+
+#define XXH3_MIDSIZE_MAX 240
+#define XXH3_MIDSIZE_START 3
+#define XXH3_MIDSIZE_LAST 17
+#define XXH3_SECRET_MIN 136
+#define XXH3_LASTACC_START 7
+#define XXH3_MERGEACCS_START 11
+
+/* stripes between two scrambles, each one moves 8 bytes into the secret */
+#define XXH3_BLOCK_STRIPES \
+    ((BFDEV_XXH3_SECRET_SIZE - BFDEV_XXH3_STRIPE_SIZE) / 8)
+
+#define XXH3_SCRAMBLE_SECRET \
+    (BFDEV_XXH3_SECRET_SIZE - BFDEV_XXH3_STRIPE_SIZE)
+
+#define XXH3_LASTACC_SECRET \
+    (XXH3_SCRAMBLE_SECRET - XXH3_LASTACC_START)
+
+static const uint8_t
+xxh3_secret[BFDEV_XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe,
+    0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78,
+    0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e,
+    0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e,
+    0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f,
+    0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3,
+    0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49,
+    0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28,
+    0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const uint64_t
+xxh3_acc_init[BFDEV_XXH3_ACC_WORDS] = {
+    XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+    XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1,
+};
+
+static const struct xxh3_ops
+xxh3_generic_ops = {
+    .accumulate = xxh3_accumulate_generic,
+    .scramble = xxh3_scramble_generic,
+};
+
+#ifdef XXH3_ACCEL_X86
+static const struct xxh3_ops
+xxh3_sse2_ops = {
+    .accumulate = xxh3_accumulate_sse2,
+    .scramble = xxh3_scramble_sse2,
+};
+
+static const struct xxh3_ops
+xxh3_avx2_ops = {
+    .accumulate = xxh3_accumulate_avx2,
+    .scramble = xxh3_scramble_avx2,
+};
+
+static const struct xxh3_ops
+xxh3_avx512_ops = {
+    .accumulate = xxh3_accumulate_avx512,
+    .scramble = xxh3_scramble_avx512,
+};
+#endif
+
+#ifdef XXH3_ACCEL_ARM64
+static const struct xxh3_ops
+xxh3_neon_ops = {
+    .accumulate = xxh3_accumulate_neon,
+    .scramble = xxh3_scramble_neon,
+};
+#endif
+
+static const bfdev_dispatch_impl_t
+xxh3_impls[] = {
+#ifdef XXH3_ACCEL_X86
+    BFDEV_DISPATCH_IMPL("avx512", BFDEV_CPU_FEATURE(BFDEV_CPU_AVX512F),
+                        &xxh3_avx512_ops),
+    BFDEV_DISPATCH_IMPL("avx2", BFDEV_CPU_FEATURE(BFDEV_CPU_AVX2),
+                        &xxh3_avx2_ops),
+    BFDEV_DISPATCH_IMPL("sse2", BFDEV_CPU_FEATURE(BFDEV_CPU_SSE2),
+                        &xxh3_sse2_ops),
+#endif
+#ifdef XXH3_ACCEL_ARM64
+    BFDEV_DISPATCH_IMPL("neon", BFDEV_CPU_FEATURE(BFDEV_CPU_NEON),
+                        &xxh3_neon_ops),
+#endif
+    BFDEV_DISPATCH_IMPL("generic", 0, &xxh3_generic_ops),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(xxh3_dispatch, "xxh3", xxh3_impls, &xxh3_generic_ops);
+
+static __bfdev_always_inline const struct xxh3_ops *
+xxh3_ops(void)
+{
+    return bfdev_dispatch_ops(&xxh3_dispatch, struct xxh3_ops);
+}
+
+static __bfdev_always_inline uint64_t
+xxh_read64(const uint8_t *ptr)
+{
+    return bfdev_unaligned_get_le64(ptr);
+}
+
+static __bfdev_always_inline uint32_t
+xxh_read32(const uint8_t *ptr)
+{
+    return bfdev_unaligned_get_le32(ptr);
+}
+
+static __bfdev_always_inline bfdev_xxh128_t
+xxh_mul128(uint64_t a, uint64_t b)
+{
+    bfdev_xxh128_t result;
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product;
+
+    product = (unsigned __int128)a * b;
+    result.low = (uint64_t)product;
+    result.high = (uint64_t)(product >> 64);
+#else
+    uint64_t lolo, hilo, lohi, cross;
+
+    lolo = (a & 0xffffffff) * (b & 0xffffffff);
+    hilo = (a >> 32) * (b & 0xffffffff);
+    lohi = (a & 0xffffffff) * (b >> 32);
+    cross = (lolo >> 32) + (hilo & 0xffffffff) + lohi;
+
+    result.high = (hilo >> 32) + (cross >> 32) + (a >> 32) * (b >> 32);
+    result.low = (cross << 32) | (lolo & 0xffffffff);
+#endif
+
+    return result;
+}
+
+static __bfdev_always_inline uint64_t
+xxh_fold64(uint64_t a, uint64_t b)
+{
+    bfdev_xxh128_t product;
+
+    product = xxh_mul128(a, b);
+
+    return product.low ^ product.high;
+}
+
+static __bfdev_always_inline uint64_t
+xxh64_avalanche(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+static __bfdev_always_inline uint64_t
+xxh3_avalanche(uint64_t hash)
+{
+    hash ^= hash >> 37;
+    hash *= XXH_PRIME_MX1;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+static __bfdev_always_inline uint64_t
+xxh3_rrmxmx(uint64_t hash, uint64_t length)
+{
+    hash ^= bfdev_rol64(hash, 49) ^ bfdev_rol64(hash, 24);
+    hash *= XXH_PRIME_MX2;
+    hash ^= (hash >> 35) + length;
+    hash *= XXH_PRIME_MX2;
+    hash ^= hash >> 28;
+
+    return hash;
+}
+
+static __bfdev_always_inline uint64_t
+xxh3_mix16(const uint8_t *data, const uint8_t *secret, uint64_t seed)
+{
+    return xxh_fold64(xxh_read64(data) ^ (xxh_read64(secret) + seed),
+                      xxh_read64(data + 8) ^ (xxh_read64(secret + 8) - seed));
+}
+
+static __bfdev_always_inline void
+xxh3_mix32(bfdev_xxh128_t *acc, const uint8_t *data1, const uint8_t *data2,
+           const uint8_t *secret, uint64_t seed)
+{
+    acc->low += xxh3_mix16(data1, secret, seed);
+    acc->low ^= xxh_read64(data2) + xxh_read64(data2 + 8);
+    acc->high += xxh3_mix16(data2, secret + 16, seed);
+    acc->high ^= xxh_read64(data1) + xxh_read64(data1 + 8);
+}
+
+hidden void
+xxh3_accumulate_generic(uint64_t *acc, const uint8_t *data,
+                        const uint8_t *secret, size_t stripes)
+{
+    uint64_t value, key;
+    unsigned int index;
+
+    for (; stripes; --stripes) {
+        for (index = 0; index < BFDEV_XXH3_ACC_WORDS; ++index) {
+            value = xxh_read64(data + index * 8);
+            key = value ^ xxh_read64(secret + index * 8);
+            acc[index ^ 1] += value;
+            acc[index] += (key & 0xffffffff) * (key >> 32);
+        }
+
+        data += BFDEV_XXH3_STRIPE_SIZE;
+        secret += 8;
+    }
+}
+
+hidden void
+xxh3_scramble_generic(uint64_t *acc, const uint8_t *secret)
+{
+    unsigned int index;
+    uint64_t value;
+
+    for (index = 0; index < BFDEV_XXH3_ACC_WORDS; ++index) {
+        value = acc[index];
+        value ^= value >> 47;
+        value ^= xxh_read64(secret + index * 8);
+        acc[index] = value * XXH_PRIME32_1;
+    }
+}
+
+/*
+ * Accumulate whole stripes, scrambling whenever a block fills up.
+ * @pstripes tracks the stripes already done in the current block,
+ * which lets a stream stop and resume anywhere on a stripe boundary.
+ */
+static void
+xxh3_consume(uint64_t *acc, unsigned int *pstripes, const uint8_t *data,
+             size_t stripes, const uint8_t *secret)
+{
+    unsigned int done;
+    size_t count;
+
+    for (done = *pstripes; stripes; stripes -= count) {
+        count = bfdev_min(stripes, (size_t)(XXH3_BLOCK_STRIPES - done));
+        xxh3_ops()->accumulate(acc, data, secret + done * 8, count);
+        data += count * BFDEV_XXH3_STRIPE_SIZE;
+
+        done += count;
+        if (done == XXH3_BLOCK_STRIPES) {
+            xxh3_ops()->scramble(acc, secret + XXH3_SCRAMBLE_SECRET);
+            done = 0;
+        }
+    }
+
+    *pstripes = done;
+}
+
+static uint64_t
+xxh3_merge(const uint64_t *acc, const uint8_t *secret, uint64_t result)
+{
+    unsigned int index;
+
+    for (index = 0; index < BFDEV_XXH3_ACC_WORDS / 2; ++index) {
+        result += xxh_fold64(acc[index * 2] ^ xxh_read64(secret + index * 16),
+                             acc[index * 2 + 1] ^ xxh_read64(secret + index * 16 + 8));
+    }
+
+    return xxh3_avalanche(result);
+}
+
+static void
+xxh3_derive_secret(uint8_t *secret, uint64_t seed)
+{
+    unsigned int index;
+
+    for (index = 0; index < BFDEV_XXH3_SECRET_SIZE; index += 16) {
+        bfdev_unaligned_set_le64(secret + index,
+                                 xxh_read64(xxh3_secret + index) + seed);
+        bfdev_unaligned_set_le64(secret + index + 8,
+                                 xxh_read64(xxh3_secret + index + 8) - seed);
+    }
+}
+
+static void
+xxh3_long(uint64_t *acc, const uint8_t *data, size_t length,
+          const uint8_t *secret)
+{
+    unsigned int stripes;
+
+    stripes = 0;
+    bfport_memcpy(acc, xxh3_acc_init, sizeof(xxh3_acc_init));
+
+    /* the last stripe always goes in on its own */
+    xxh3_consume(acc, &stripes, data, (length - 1) / BFDEV_XXH3_STRIPE_SIZE,
+                 secret);
+    xxh3_ops()->accumulate(acc, data + length - BFDEV_XXH3_STRIPE_SIZE,
+                    secret + XXH3_LASTACC_SECRET, 1);
+}
+
+static uint64_t
+xxh3_64_short(const uint8_t *data, size_t length, uint64_t seed)
+{
+    const uint8_t *secret = xxh3_secret;
+    uint64_t acc, low, high;
+    uint32_t combined;
+    unsigned int index;
+
+    if (length > 16) {
+        acc = length * XXH_PRIME64_1;
+
+        if (length > 128) {
+            for (index = 0; index < 8; ++index)
+                acc += xxh3_mix16(data + 16 * index, secret + 16 * index, seed);
+            acc = xxh3_avalanche(acc);
+
+            for (index = 8; index < length / 16; ++index) {
+                acc += xxh3_mix16(data + 16 * index, secret + XXH3_MIDSIZE_START +
+                                  16 * (index - 8), seed);
+            }
+
+            acc += xxh3_mix16(data + length - 16, secret + XXH3_SECRET_MIN -
+                              XXH3_MIDSIZE_LAST, seed);
+
+            return xxh3_avalanche(acc);
+        }
+
+        if (length > 32) {
+            if (length > 64) {
+                if (length > 96) {
+                    acc += xxh3_mix16(data + 48, secret + 96, seed);
+                    acc += xxh3_mix16(data + length - 64, secret + 112, seed);
+                }
+                acc += xxh3_mix16(data + 32, secret + 64, seed);
+                acc += xxh3_mix16(data + length - 48, secret + 80, seed);
+            }
+            acc += xxh3_mix16(data + 16, secret + 32, seed);
+            acc += xxh3_mix16(data + length - 32, secret + 48, seed);
+        }
+        acc += xxh3_mix16(data, secret, seed);
+        acc += xxh3_mix16(data + length - 16, secret + 16, seed);
+
+        return xxh3_avalanche(acc);
+    }
+
+    if (length > 8) {
+        low = xxh_read64(data) ^
+              ((xxh_read64(secret + 24) ^ xxh_read64(secret + 32)) + seed);
+        high = xxh_read64(data + length - 8) ^
+               ((xxh_read64(secret + 40) ^ xxh_read64(secret + 48)) - seed);
+        acc = length + bfdev_swab64(low) + high + xxh_fold64(low, high);
+
+        return xxh3_avalanche(acc);
+    }
+
+    if (length >= 4) {
+        seed ^= (uint64_t)bfdev_swab32((uint32_t)seed) << 32;
+        acc = xxh_read32(data + length - 4) +
+              ((uint64_t)xxh_read32(data) << 32);
+        acc ^= (xxh_read64(secret + 8) ^ xxh_read64(secret + 16)) - seed;
+
+        return xxh3_rrmxmx(acc, length);
+    }
+
+    if (length) {
+        combined = (uint32_t)data[0] << 16 | (uint32_t)data[length >> 1] << 24 |
+                   data[length - 1] | (uint32_t)length << 8;
+        acc = combined ^ ((xxh_read32(secret) ^ xxh_read32(secret + 4)) + seed);
+
+        return xxh64_avalanche(acc);
+    }
+
+    return xxh64_avalanche(seed ^ xxh_read64(secret + 56) ^
+                           xxh_read64(secret + 64));
+}
+
+static bfdev_xxh128_t
+xxh3_128_mid(const uint8_t *data, size_t length, uint64_t seed)
+{
+    const uint8_t *secret = xxh3_secret;
+    bfdev_xxh128_t acc, result;
+    unsigned int index;
+
+    acc.low = length * XXH_PRIME64_1;
+    acc.high = 0;
+
+    if (length > 128) {
+        for (index = 0; index < 4; ++index) {
+            xxh3_mix32(&acc, data + 32 * index, data + 32 * index + 16,
+                       secret + 32 * index, seed);
+        }
+
+        acc.low = xxh3_avalanche(acc.low);
+        acc.high = xxh3_avalanche(acc.high);
+
+        for (index = 4; index < length / 32; ++index) {
+            xxh3_mix32(&acc, data + 32 * index, data + 32 * index + 16,
+                       secret + XXH3_MIDSIZE_START + 32 * (index - 4), seed);
+        }
+
+        xxh3_mix32(&acc, data + length - 16, data + length - 32,
+                   secret + XXH3_SECRET_MIN - XXH3_MIDSIZE_LAST - 16,
+                   0ULL - seed);
+    } else {
+        if (length > 32) {
+            if (length > 64) {
+                if (length > 96) {
+                    xxh3_mix32(&acc, data + 48, data + length - 64,
+                               secret + 96, seed);
+                }
+                xxh3_mix32(&acc, data + 32, data + length - 48,
+                           secret + 64, seed);
+            }
+            xxh3_mix32(&acc, data + 16, data + length - 32,
+                       secret + 32, seed);
+        }
+        xxh3_mix32(&acc, data, data + length - 16, secret, seed);
+    }
+
+    result.low = xxh3_avalanche(acc.low + acc.high);
+    result.high = 0ULL - xxh3_avalanche(acc.low * XXH_PRIME64_1 +
+                                        acc.high * XXH_PRIME64_4 +
+                                        (length - seed) * XXH_PRIME64_2);
+
+    return result;
+}
+
+static bfdev_xxh128_t
+xxh3_128_short(const uint8_t *data, size_t length, uint64_t seed)
+{
+    const uint8_t *secret = xxh3_secret;
+    bfdev_xxh128_t result, product;
+    uint64_t low, high, value;
+    uint32_t combined;
+
+    if (length > 16)
+        return xxh3_128_mid(data, length, seed);
+
+    if (length > 8) {
+        low = xxh_read64(data);
+        high = xxh_read64(data + length - 8);
+
+        product = xxh_mul128(low ^ high ^ ((xxh_read64(secret + 32) ^
+                             xxh_read64(secret + 40)) - seed), XXH_PRIME64_1);
+        product.low += (uint64_t)(length - 1) << 54;
+
+        high ^= (xxh_read64(secret + 48) ^ xxh_read64(secret + 56)) + seed;
+        product.high += high + (high & 0xffffffff) * (XXH_PRIME32_2 - 1);
+        product.low ^= bfdev_swab64(product.high);
+
+        result = xxh_mul128(product.low, XXH_PRIME64_2);
+        result.high += product.high * XXH_PRIME64_2;
+        result.low = xxh3_avalanche(result.low);
+        result.high = xxh3_avalanche(result.high);
+
+        return result;
+    }
+
+    if (length >= 4) {
+        seed ^= (uint64_t)bfdev_swab32((uint32_t)seed) << 32;
+        value = xxh_read32(data) +
+                ((uint64_t)xxh_read32(data + length - 4) << 32);
+        value ^= (xxh_read64(secret + 16) ^ xxh_read64(secret + 24)) + seed;
+
+        product = xxh_mul128(value, XXH_PRIME64_1 + (length << 2));
+        product.high += product.low << 1;
+        product.low ^= product.high >> 3;
+        product.low ^= product.low >> 35;
+        product.low *= XXH_PRIME_MX2;
+        product.low ^= product.low >> 28;
+        product.high = xxh3_avalanche(product.high);
+
+        return product;
+    }
+
+    if (length) {
+        combined = (uint32_t)data[0] << 16 | (uint32_t)data[length >> 1] << 24 |
+                   data[length - 1] | (uint32_t)length << 8;
+
+        low = combined ^ ((xxh_read32(secret) ^ xxh_read32(secret + 4)) + seed);
+        high = bfdev_rol32(bfdev_swab32(combined), 13) ^
+               ((xxh_read32(secret + 8) ^ xxh_read32(secret + 12)) - seed);
+
+        result.low = xxh64_avalanche(low);
+        result.high = xxh64_avalanche(high);
+
+        return result;
+    }
+
+    result.low = xxh64_avalanche(seed ^ xxh_read64(secret + 64) ^
+                                 xxh_read64(secret + 72));
+    result.high = xxh64_avalanche(seed ^ xxh_read64(secret + 80) ^
+                                  xxh_read64(secret + 88));
+
+    return result;
+}
+
+static __bfdev_always_inline uint64_t
+xxh3_64_merge(const uint64_t *acc, const uint8_t *secret, uint64_t length)
+{
+    return xxh3_merge(acc, secret + XXH3_MERGEACCS_START,
+                      length * XXH_PRIME64_1);
+}
+
+static __bfdev_always_inline bfdev_xxh128_t
+xxh3_128_merge(const uint64_t *acc, const uint8_t *secret, uint64_t length)
+{
+    bfdev_xxh128_t result;
+
+    result.low = xxh3_merge(acc, secret + XXH3_MERGEACCS_START,
+                            length * XXH_PRIME64_1);
+    result.high = xxh3_merge(acc, secret + BFDEV_XXH3_SECRET_SIZE -
+                             BFDEV_XXH3_STRIPE_SIZE - XXH3_MERGEACCS_START,
+                             ~(length * XXH_PRIME64_2));
+
+    return result;
+}
+
+export uint64_t
+bfdev_xxh3(const void *data, size_t length, uint64_t seed)
+{
+    uint8_t custom[BFDEV_XXH3_SECRET_SIZE];
+    uint64_t acc[BFDEV_XXH3_ACC_WORDS];
+    const uint8_t *secret;
+
+    if (length <= XXH3_MIDSIZE_MAX)
+        return xxh3_64_short(data, length, seed);
+
+    secret = xxh3_secret;
+    if (seed) {
+        xxh3_derive_secret(custom, seed);
+        secret = custom;
+    }
+
+    xxh3_long(acc, data, length, secret);
+
+    return xxh3_64_merge(acc, secret, length);
+}
+
+export bfdev_xxh128_t
+bfdev_xxh128(const void *data, size_t length, uint64_t seed)
+{
+    uint8_t custom[BFDEV_XXH3_SECRET_SIZE];
+    uint64_t acc[BFDEV_XXH3_ACC_WORDS];
+    const uint8_t *secret;
+
+    if (length <= XXH3_MIDSIZE_MAX)
+        return xxh3_128_short(data, length, seed);
+
+    secret = xxh3_secret;
+    if (seed) {
+        xxh3_derive_secret(custom, seed);
+        secret = custom;
+    }
+
+    xxh3_long(acc, data, length, secret);
+
+    return xxh3_128_merge(acc, secret, length);
+}
+
+export void
+bfdev_xxh3_init(bfdev_xxh3_ctx_t *ctx, uint64_t seed)
+{
+    bfport_memcpy(ctx->acc, xxh3_acc_init, sizeof(xxh3_acc_init));
+    xxh3_derive_secret(ctx->secret, seed);
+
+    ctx->seed = seed;
+    ctx->total = 0;
+    ctx->buffered = 0;
+    ctx->stripes = 0;
+}
+
+export void
+bfdev_xxh3_update(bfdev_xxh3_ctx_t *ctx, const void *data, size_t length)
+{
+    const uint8_t *src;
+    size_t fill, stripes;
+
+    src = data;
+    ctx->total += length;
+
+    if (ctx->buffered + length <= BFDEV_XXH3_BUFFER_SIZE) {
+        bfport_memcpy(ctx->buffer + ctx->buffered, src, length);
+        ctx->buffered += length;
+        return;
+    }
+
+    /* input ending the stream must stay buffered, consume only on more */
+    if (ctx->buffered) {
+        fill = BFDEV_XXH3_BUFFER_SIZE - ctx->buffered;
+        bfport_memcpy(ctx->buffer + ctx->buffered, src, fill);
+        src += fill;
+        length -= fill;
+
+        xxh3_consume(ctx->acc, &ctx->stripes, ctx->buffer,
+                     BFDEV_XXH3_BUFFER_SIZE / BFDEV_XXH3_STRIPE_SIZE,
+                     ctx->secret);
+        ctx->buffered = 0;
+    }
+
+    if (length > BFDEV_XXH3_BUFFER_SIZE) {
+        stripes = (length - 1) / BFDEV_XXH3_STRIPE_SIZE;
+        xxh3_consume(ctx->acc, &ctx->stripes, src, stripes, ctx->secret);
+        src += stripes * BFDEV_XXH3_STRIPE_SIZE;
+        length -= stripes * BFDEV_XXH3_STRIPE_SIZE;
+
+        /* a short tail needs the stripe in front of it */
+        bfport_memcpy(ctx->buffer + BFDEV_XXH3_BUFFER_SIZE -
+                      BFDEV_XXH3_STRIPE_SIZE, src - BFDEV_XXH3_STRIPE_SIZE,
+                      BFDEV_XXH3_STRIPE_SIZE);
+    }
+
+    bfport_memcpy(ctx->buffer, src, length);
+    ctx->buffered = length;
+}
+
+static void
+xxh3_stream_acc(const bfdev_xxh3_ctx_t *ctx, uint64_t *acc)
+{
+    uint8_t last[BFDEV_XXH3_STRIPE_SIZE];
+    unsigned int stripes, catchup;
+    const uint8_t *stripe;
+
+    stripes = ctx->stripes;
+    bfport_memcpy(acc, ctx->acc, sizeof(ctx->acc));
+
+    if (ctx->buffered >= BFDEV_XXH3_STRIPE_SIZE) {
+        xxh3_consume(acc, &stripes, ctx->buffer, (ctx->buffered - 1) /
+                     BFDEV_XXH3_STRIPE_SIZE, ctx->secret);
+        stripe = ctx->buffer + ctx->buffered - BFDEV_XXH3_STRIPE_SIZE;
+    } else {
+        catchup = BFDEV_XXH3_STRIPE_SIZE - ctx->buffered;
+        bfport_memcpy(last, ctx->buffer + BFDEV_XXH3_BUFFER_SIZE - catchup,
+                      catchup);
+        bfport_memcpy(last + catchup, ctx->buffer, ctx->buffered);
+        stripe = last;
+    }
+
+    xxh3_ops()->accumulate(acc, stripe, ctx->secret + XXH3_LASTACC_SECRET, 1);
+}
+
+export uint64_t
+bfdev_xxh3_finish(const bfdev_xxh3_ctx_t *ctx)
+{
+    uint64_t acc[BFDEV_XXH3_ACC_WORDS];
+
+    if (ctx->total <= XXH3_MIDSIZE_MAX)
+        return xxh3_64_short(ctx->buffer, ctx->total, ctx->seed);
+
+    xxh3_stream_acc(ctx, acc);
+
+    return xxh3_64_merge(acc, ctx->secret, ctx->total);
+}
+
+export bfdev_xxh128_t
+bfdev_xxh128_finish(const bfdev_xxh3_ctx_t *ctx)
+{
+    uint64_t acc[BFDEV_XXH3_ACC_WORDS];
+
+    if (ctx->total <= XXH3_MIDSIZE_MAX)
+        return xxh3_128_short(ctx->buffer, ctx->total, ctx->seed);
+
+    xxh3_stream_acc(ctx, acc);
+
+    return xxh3_128_merge(acc, ctx->secret, ctx->total);
+}
+
+static __bfdev_always_inline size_t
+xxh3_key_length(const void *key, void *pdata)
+{
+    if (!pdata)
+        return bfport_strlen(key);
+
+    return (uintptr_t)pdata;
+}
+
+export unsigned long
+bfdev_xxh3_key(const void *key, void *pdata)
+{
+    return bfdev_xxh3(key, xxh3_key_length(key, pdata), 0);
+}
+
+export unsigned int
+bfdev_xxh3_bloom(unsigned int func, const void *key, void *pdata)
+{
+    return bfdev_xxh3(key, xxh3_key_length(key, pdata), func);
+}
+
+static __bfdev_ctor int
+xxh3_accel_init(void)
+{
+    return bfdev_dispatch_register(&xxh3_dispatch);
+}
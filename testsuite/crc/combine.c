@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crc-combine"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <bfdev/crc.h>
+#include <bfdev/log.h>
+#include <bfdev/wspool.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 4096
+#define TEST_STEP 37
+#define TEST_LARGE ((1UL << 20) + 77)
+#define TEST_GRAIN (TEST_LARGE / 7)
+#define TEST_THREADS 4
+#define TEST_DEPTH 64
+
+#define GENERIC_CRC_COMBINE(name, type, unit) do {              \
+    type crc, crc1, crc2;                                       \
+    size_t split;                                               \
+                                                                \
+    for (split = 0; split <= TEST_SIZE; split += TEST_STEP) {   \
+        crc = (type)((uint64_t)rand() << 32 | rand());          \
+        crc1 = bfdev_##name(buff, split * unit, crc);           \
+        crc2 = bfdev_##name(buff + split, (TEST_SIZE - split)   \
+                            * unit, 0);                         \
+        crc1 = bfdev_##name##_combine(crc1, crc2, (TEST_SIZE    \
+                                      - split) * unit);         \
+        if (crc1 != bfdev_##name(buff, TEST_SIZE * unit, crc))  \
+            return -BFDEV_EFAULT;                               \
+    }                                                           \
+} while (0)
+
+#define GENERIC_CRC_PARALLEL(name, type) do {                   \
+    type crc, value;                                            \
+    unsigned long grain;                                        \
+    int retval;                                                 \
+                                                                \
+    for (grain = 0; grain < TEST_LARGE; grain += TEST_GRAIN) {  \
+        crc = value = (type)((uint64_t)rand() << 32 | rand());  \
+        retval = bfdev_##name##_parallel(&pool, 0, large,       \
+                                         TEST_LARGE, grain,     \
+                                         &value);               \
+        if (retval)                                             \
+            goto finish;                                        \
+                                                                \
+        if (value != bfdev_##name(large, TEST_LARGE, crc)) {    \
+            retval = -BFDEV_EFAULT;                             \
+            goto finish;                                        \
+        }                                                       \
+    }                                                           \
+} while (0)
+
+struct helper {
+    pthread_t tid;
+    bfdev_wspool_t *pool;
+    unsigned int index;
+};
+
+static uint8_t
+buff[TEST_SIZE];
+
+static void
+test_fill(uint8_t *data, size_t len)
+{
+    size_t index;
+
+    for (index = 0; index < len; ++index)
+        data[index] = (uint8_t)rand();
+}
+
+static void *
+helper_run(void *pdata)
+{
+    struct helper *helper = pdata;
+
+    bfdev_wspool_run(helper->pool, helper->index);
+    return NULL;
+}
+
+TESTSUITE(
+    "crc:combine", NULL, NULL,
+    "crc combine of split buffers"
+) {
+    test_fill(buff, sizeof(buff));
+
+    GENERIC_CRC_COMBINE(crc4, uint8_t, 8);
+    GENERIC_CRC_COMBINE(crc7, uint8_t, 1);
+    GENERIC_CRC_COMBINE(crc8, uint8_t, 1);
+    GENERIC_CRC_COMBINE(crc16, uint16_t, 1);
+    GENERIC_CRC_COMBINE(crc32, uint32_t, 1);
+    GENERIC_CRC_COMBINE(crc32c, uint32_t, 1);
+    GENERIC_CRC_COMBINE(crc64, uint64_t, 1);
+    GENERIC_CRC_COMBINE(crc_ccitt, uint16_t, 1);
+    GENERIC_CRC_COMBINE(crc_itut, uint16_t, 1);
+    GENERIC_CRC_COMBINE(crc_t10dif, uint16_t, 1);
+    GENERIC_CRC_COMBINE(crc_rocksoft, uint64_t, 1);
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "crc:parallel", NULL, NULL,
+    "crc on a work-stealing pool"
+) {
+    struct helper helpers[TEST_THREADS];
+    bfdev_wspool_t pool;
+    unsigned int index;
+    uint8_t *large;
+    int retval;
+
+    large = malloc(TEST_LARGE);
+    if (!large)
+        return -BFDEV_ENOMEM;
+
+    retval = bfdev_wspool_alloc(&pool, NULL, TEST_THREADS, TEST_DEPTH);
+    if (retval) {
+        free(large);
+        return retval;
+    }
+
+    test_fill(large, TEST_LARGE);
+    for (index = 1; index < TEST_THREADS; ++index) {
+        helpers[index] = (struct helper) {
+            .pool = &pool,
+            .index = index,
+        };
+        pthread_create(&helpers[index].tid, NULL, helper_run,
+                       &helpers[index]);
+    }
+
+    GENERIC_CRC_PARALLEL(crc7, uint8_t);
+    GENERIC_CRC_PARALLEL(crc8, uint8_t);
+    GENERIC_CRC_PARALLEL(crc16, uint16_t);
+    GENERIC_CRC_PARALLEL(crc32, uint32_t);
+    GENERIC_CRC_PARALLEL(crc32c, uint32_t);
+    GENERIC_CRC_PARALLEL(crc64, uint64_t);
+    GENERIC_CRC_PARALLEL(crc_ccitt, uint16_t);
+    GENERIC_CRC_PARALLEL(crc_itut, uint16_t);
+    GENERIC_CRC_PARALLEL(crc_t10dif, uint16_t);
+    GENERIC_CRC_PARALLEL(crc_rocksoft, uint64_t);
+
+finish:
+    bfdev_wspool_stop(&pool);
+    for (index = 1; index < TEST_THREADS; ++index)
+        pthread_join(helpers[index].tid, NULL);
+
+    bfdev_wspool_free(&pool);
+    free(large);
+
+    return retval;
+}
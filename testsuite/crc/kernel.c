@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crc-kernel"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <bfdev/crc.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 1024
+#define TEST_ALIGN 16
+#define TEST_CHECK "123456789"
+
+#define GENERIC_CRC_KERNEL(name, type) do {                     \
+    type (*func)(const void *, size_t, type);                   \
+    type (*generic)(const void *, size_t, type);                \
+    unsigned int accel;                                         \
+    size_t offset, len;                                         \
+    type crc;                                                   \
+                                                                \
+    generic = bfdev_##name##_kernel(BFDEV_CRC_GENERIC);         \
+    for (accel = 1; accel < BFDEV_CRC_ACCEL_NR; ++accel) {      \
+        func = bfdev_##name##_kernel(accel);                    \
+        if (!func)                                              \
+            continue;                                           \
+                                                                \
+        bfdev_log_info(#name " %s\n", bfdev_crc_accel_name(accel)); \
+        for (offset = 0; offset < TEST_ALIGN; ++offset) {       \
+            for (len = 0; len <= TEST_SIZE; ++len) {            \
+                crc = (type)((uint64_t)rand() << 32 | rand());  \
+                if (func(buff + offset, len, crc) !=            \
+                    generic(buff + offset, len, crc))           \
+                    return -BFDEV_EFAULT;                       \
+            }                                                   \
+        }                                                       \
+    }                                                           \
+} while (0)
+
+static uint8_t
+buff[TEST_SIZE + TEST_ALIGN];
+
+static void
+test_fill(void)
+{
+    unsigned int index;
+
+    for (index = 0; index < sizeof(buff); ++index)
+        buff[index] = (uint8_t)rand();
+}
+
+TESTSUITE(
+    "crc:check", NULL, NULL,
+    "crc check values"
+) {
+    if (~bfdev_crc32(TEST_CHECK, 9, ~0U) != 0xcbf43926)
+        return -BFDEV_EFAULT;
+
+    if (~bfdev_crc32c(TEST_CHECK, 9, ~0U) != 0xe3069283)
+        return -BFDEV_EFAULT;
+
+    if (bfdev_crc64(TEST_CHECK, 9, 0) != 0x6c40df5f0b497347ULL)
+        return -BFDEV_EFAULT;
+
+    if (~bfdev_crc_rocksoft(TEST_CHECK, 9, ~0ULL) != 0xae8b14860a799888ULL)
+        return -BFDEV_EFAULT;
+
+    if (bfdev_crc_t10dif(TEST_CHECK, 9, 0) != 0xd0db)
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "crc:kernel", NULL, NULL,
+    "crc kernels against generic"
+) {
+    test_fill();
+
+    GENERIC_CRC_KERNEL(crc32, uint32_t);
+    GENERIC_CRC_KERNEL(crc32c, uint32_t);
+    GENERIC_CRC_KERNEL(crc64, uint64_t);
+    GENERIC_CRC_KERNEL(crc_t10dif, uint16_t);
+    GENERIC_CRC_KERNEL(crc_rocksoft, uint64_t);
+
+    return -BFDEV_ENOERR;
+}
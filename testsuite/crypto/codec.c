@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crypto-codec"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <bfdev/base64.h>
+#include <bfdev/base32.h>
+#include <bfdev/ascii85.h>
+#include <bfdev/align.h>
+#include <bfdev/minmax.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 4099
+#define TEST_LOOP 64
+#define TEST_CHUNK 97
+
+static uint8_t plain[TEST_SIZE], output[TEST_SIZE + 8];
+static uint8_t expect[TEST_SIZE * 2], encoded[TEST_SIZE * 2];
+
+static const char
+base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char
+base32_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+/* slow but obvious, one output digit per group of bits */
+static size_t
+reference_encode(uint8_t *buff, const uint8_t *data, size_t size,
+                 const char *alphabet, unsigned int bits, unsigned int group)
+{
+    unsigned int have, digit;
+    size_t index, length;
+    uint32_t value;
+
+    value = have = 0;
+    for (index = length = 0; index < size; ++index) {
+        value = value << 8 | data[index];
+        for (have += 8; have >= bits; have -= bits) {
+            digit = (value >> (have - bits)) & ((1U << bits) - 1);
+            buff[length++] = alphabet[digit];
+        }
+    }
+
+    if (have)
+        buff[length++] = alphabet[(value << (bits - have)) & ((1U << bits) - 1)];
+
+    while (length % group)
+        buff[length++] = '=';
+
+    return length;
+}
+
+static void
+random_fill(uint8_t *buff, size_t size)
+{
+    size_t index;
+
+    for (index = 0; index < size; ++index)
+        buff[index] = (uint8_t)rand();
+
+    /* give ascii85 a few zero groups */
+    if (size > 64 && rand() % 2)
+        memset(buff + rand() % (size - 8), 0, 8);
+}
+
+#define GENERIC_STREAM(name, length, elen, dlen) do {                   \
+    bfdev_##name##_ctx_t ctx;                                           \
+    size_t offset, chunk, done, total;                                  \
+    int retval;                                                         \
+                                                                        \
+    bfdev_##name##_init(&ctx);                                          \
+    for (offset = total = 0; offset < length; offset += chunk) {        \
+        chunk = rand() % TEST_CHUNK;                                    \
+        chunk = bfdev_min(chunk, length - offset);                      \
+        total += bfdev_##name##_encode_update(&ctx, encoded + total,    \
+                                              plain + offset, chunk);   \
+    }                                                                   \
+    total += bfdev_##name##_encode_finish(&ctx, encoded + total);       \
+                                                                        \
+    if (total != elen || memcmp(encoded, expect, elen)) {               \
+        bfdev_log_err(#name " stream encode %zu mismatch\n", length);   \
+        return -BFDEV_EFAULT;                                           \
+    }                                                                   \
+                                                                        \
+    bfdev_##name##_init(&ctx);                                          \
+    for (offset = total = 0; offset < elen; offset += chunk) {          \
+        chunk = rand() % TEST_CHUNK;                                    \
+        chunk = bfdev_min(chunk, elen - offset);                        \
+        retval = bfdev_##name##_decode_update(&ctx, output + total,     \
+                                              encoded + offset,         \
+                                              &done, chunk);            \
+        if (retval)                                                     \
+            return retval;                                              \
+        total += done;                                                  \
+    }                                                                   \
+                                                                        \
+    retval = bfdev_##name##_decode_finish(&ctx, output + total, &done); \
+    if (retval)                                                         \
+        return retval;                                                  \
+    total += done;                                                      \
+                                                                        \
+    if (total != dlen || memcmp(output, plain, length)) {               \
+        bfdev_log_err(#name " stream decode %zu mismatch\n", length);   \
+        return -BFDEV_EFAULT;                                           \
+    }                                                                   \
+} while (0)
+
+static int
+test_radix(void)
+{
+    unsigned int loop;
+    size_t length, elen;
+    int retval;
+
+    for (loop = 0; loop < TEST_LOOP; ++loop) {
+        length = loop < 16 ? loop : (size_t)rand() % TEST_SIZE;
+        random_fill(plain, length);
+
+        elen = reference_encode(expect, plain, length, base64_alphabet, 6, 4);
+        bfdev_base64_encode(encoded, plain, length);
+        if (memcmp(encoded, expect, elen)) {
+            bfdev_log_err("base64 encode %zu mismatch\n", length);
+            return -BFDEV_EFAULT;
+        }
+
+        retval = bfdev_base64_decode(output, encoded, elen);
+        if (retval || memcmp(output, plain, length)) {
+            bfdev_log_err("base64 decode %zu mismatch\n", length);
+            return retval ?: -BFDEV_EFAULT;
+        }
+        GENERIC_STREAM(base64, length, elen, length);
+
+        elen = reference_encode(expect, plain, length, base32_alphabet, 5, 8);
+        bfdev_base32_encode(encoded, plain, length);
+        if (memcmp(encoded, expect, elen)) {
+            bfdev_log_err("base32 encode %zu mismatch\n", length);
+            return -BFDEV_EFAULT;
+        }
+
+        retval = bfdev_base32_decode(output, encoded, elen);
+        if (retval || memcmp(output, plain, length)) {
+            bfdev_log_err("base32 decode %zu mismatch\n", length);
+            return retval ?: -BFDEV_EFAULT;
+        }
+        GENERIC_STREAM(base32, length, elen, length);
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "crypto:radix", NULL, NULL,
+    "base64 and base32 one-shot and streaming"
+) {
+    return test_radix();
+}
+
+static int
+test_ascii85(void)
+{
+    unsigned int loop;
+    size_t length, elen, dlen;
+    int retval;
+
+    for (loop = 0; loop < TEST_LOOP; ++loop) {
+        length = loop < 16 ? loop : (size_t)rand() % TEST_SIZE;
+        random_fill(plain, length);
+
+        bfdev_ascii85_encode(expect, plain, &elen, length);
+        retval = bfdev_ascii85_decode(output, expect, &dlen, elen);
+        if (retval || memcmp(output, plain, length)) {
+            bfdev_log_err("ascii85 decode %zu mismatch\n", length);
+            return retval ?: -BFDEV_EFAULT;
+        }
+
+        /* short groups come back zero filled */
+        if (dlen != bfdev_align_high(length, 4)) {
+            bfdev_log_err("ascii85 decode %zu length %zu\n", length, dlen);
+            return -BFDEV_EFAULT;
+        }
+        GENERIC_STREAM(ascii85, length, elen, dlen);
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "crypto:ascii85", NULL, NULL,
+    "ascii85 one-shot and streaming"
+) {
+    return test_ascii85();
+}
+
+/* every byte outside the alphabet must fail, wherever it lands */
+static int
+test_invalid(void)
+{
+    bfdev_base64_ctx_t ctx;
+    unsigned int value;
+    size_t elen, place, done;
+    int retval;
+
+    random_fill(plain, TEST_SIZE);
+    elen = reference_encode(expect, plain, TEST_SIZE / 3 * 3,
+                            base64_alphabet, 6, 4);
+
+    for (value = 0; value < 256; ++value) {
+        if (strchr(base64_alphabet, value) || value == '=')
+            continue;
+
+        memcpy(encoded, expect, elen);
+        place = rand() % elen;
+        encoded[place] = value;
+
+        retval = bfdev_base64_decode(output, encoded, elen);
+        if (retval != -BFDEV_EINVAL) {
+            bfdev_log_err("base64 accepted %#04x at %zu\n", value, place);
+            return -BFDEV_EFAULT;
+        }
+
+        bfdev_base64_init(&ctx);
+        retval = bfdev_base64_decode_update(&ctx, output, encoded,
+                                            &done, elen);
+        if (retval != -BFDEV_EINVAL) {
+            bfdev_log_err("base64 stream accepted %#04x\n", value);
+            return -BFDEV_EFAULT;
+        }
+
+        /* the groups ahead of the bad character are still reported */
+        if (done != place / 4 * 3 || memcmp(output, plain, done)) {
+            bfdev_log_err("base64 stream lost %zu bytes before %zu\n",
+                          done, place);
+            return -BFDEV_EFAULT;
+        }
+    }
+
+    /* a lone digit can not hold a byte */
+    if (bfdev_base64_decode(output, "QUJDR", 5) != -BFDEV_EPROTO)
+        return -BFDEV_EFAULT;
+
+    /* padding may be left out */
+    retval = bfdev_base64_decode(output, "QUJDRA", 6);
+    if (retval || memcmp(output, "ABCD", 4))
+        return retval ?: -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "crypto:invalid", NULL, NULL,
+    "base64 rejects characters outside the alphabet"
+) {
+    return test_invalid();
+}
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crypto-mbhash"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <bfdev/sha1.h>
+#include <bfdev/sha2.h>
+#include <bfdev/md5.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_STREAMS 100
+#define TEST_SIZE 5000
+#define TEST_SPLIT 3
+
+#define GENERIC_MULTIBUF(name, ctxname, init, finish, dsize) do {   \
+    bfdev_##ctxname##_ctx_t serial, *ctxs[TEST_STREAMS];            \
+    uint8_t expect[dsize];                                          \
+    unsigned int index;                                             \
+                                                                    \
+    for (index = 0; index < TEST_STREAMS; ++index) {                \
+        ctxs[index] = &contexts.ctxname[index];                     \
+        hashes[index] = digests[index];                             \
+        bfdev_##init##_init(ctxs[index]);                           \
+    }                                                               \
+                                                                    \
+    for (index = 0; index < TEST_SPLIT; ++index)                    \
+        bfdev_##name##_update_mb(ctxs, (const char *const *)        \
+                                 datas[index], sizes[index],        \
+                                 TEST_STREAMS);                     \
+    bfdev_##finish##_finish_mb(ctxs, hashes, TEST_STREAMS);         \
+                                                                    \
+    for (index = 0; index < TEST_STREAMS; ++index) {                \
+        bfdev_##init##_init(&serial);                               \
+        bfdev_##name##_update(&serial, (const char *)streams[index],\
+                              lengths[index]);                      \
+        bfdev_##finish##_finish(&serial, expect);                   \
+        if (memcmp(expect, digests[index], dsize)) {                \
+            bfdev_log_err(#finish " stream %u mismatch\n", index);  \
+            return -BFDEV_EFAULT;                                   \
+        }                                                           \
+    }                                                               \
+} while (0)
+
+static union {
+    bfdev_sha1_ctx_t sha1[TEST_STREAMS];
+    bfdev_sha2_ctx_t sha2[TEST_STREAMS];
+    bfdev_md5_ctx_t md5[TEST_STREAMS];
+} contexts;
+
+static uint8_t streams[TEST_STREAMS][TEST_SIZE];
+static uint8_t digests[TEST_STREAMS][BFDEV_SHA256_DIGEST_SIZE];
+static const uint8_t *datas[TEST_SPLIT][TEST_STREAMS];
+static size_t sizes[TEST_SPLIT][TEST_STREAMS];
+static size_t lengths[TEST_STREAMS];
+static void *hashes[TEST_STREAMS];
+
+static void
+test_prepare(void)
+{
+    unsigned int index, split;
+    size_t offset, size;
+
+    for (index = 0; index < TEST_STREAMS; ++index) {
+        for (offset = 0; offset < TEST_SIZE; ++offset)
+            streams[index][offset] = (uint8_t)rand();
+
+        /* mix empty, sub-block and long streams */
+        lengths[index] = rand() % (TEST_SIZE + 1);
+        if (index % 7 == 0)
+            lengths[index] = index % 130;
+
+        for (offset = split = 0; split < TEST_SPLIT; ++split) {
+            size = lengths[index] - offset;
+            if (split + 1 < TEST_SPLIT)
+                size = rand() % (size + 1);
+
+            datas[split][index] = streams[index] + offset;
+            sizes[split][index] = size;
+            offset += size;
+        }
+    }
+}
+
+TESTSUITE(
+    "crypto:mbhash", NULL, NULL,
+    "multi-buffer hashing"
+) {
+    test_prepare();
+
+    GENERIC_MULTIBUF(sha1, sha1, sha1, sha1, BFDEV_SHA1_DIGEST_SIZE);
+    GENERIC_MULTIBUF(sha2, sha2, sha224, sha224, BFDEV_SHA224_DIGEST_SIZE);
+    GENERIC_MULTIBUF(sha2, sha2, sha256, sha256, BFDEV_SHA256_DIGEST_SIZE);
+    GENERIC_MULTIBUF(md5, md5, md5, md5, BFDEV_MD5_DIGEST_SIZE);
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "crypto-sha"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <string.h>
+#include <bfdev/sha1.h>
+#include <bfdev/sha2.h>
+#include <bfdev/dispatch.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_MESSAGES 4
+
+/* the fips 180 example messages */
+static const char *
+test_messages[TEST_MESSAGES] = {
+    "",
+    "abc",
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+    "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+};
+
+static const char *
+test_sha1[TEST_MESSAGES] = {
+    "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+    "a9993e364706816aba3e25717850c26c9cd0d89d",
+    "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+    "a49b2446a02c645bf419f995b67091253a04a259",
+};
+
+static const char *
+test_sha224[TEST_MESSAGES] = {
+    "d14a028c2a3a2bc9476102bb288234c415a2b01f828ea62ac5b3e42f",
+    "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7",
+    "75388b16512776cc5dba5da1fd890150b0c6455cb4f58b1952522525",
+    "c97ca9a559850ce97a04a96def6d99a9e0e0e2ab14e6b8df265fc0b3",
+};
+
+static const char *
+test_sha256[TEST_MESSAGES] = {
+    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+    "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+    "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+    "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+};
+
+#define GENERIC_KAT(name, ctxname, expects, dsize) do {             \
+    bfdev_##ctxname##_ctx_t ctx, *ctxs[TEST_MESSAGES];              \
+    bfdev_##ctxname##_ctx_t mbctx[TEST_MESSAGES];                   \
+    uint8_t digest[TEST_MESSAGES][dsize];                           \
+    void *hashes[TEST_MESSAGES];                                    \
+    size_t sizes[TEST_MESSAGES];                                    \
+    unsigned int index, offset;                                     \
+                                                                    \
+    for (index = 0; index < TEST_MESSAGES; ++index) {               \
+        sizes[index] = strlen(test_messages[index]);                \
+                                                                    \
+        bfdev_##name##_init(&ctx);                                  \
+        bfdev_##ctxname##_update(&ctx, test_messages[index],        \
+                                 sizes[index]);                     \
+        bfdev_##name##_finish(&ctx, digest[index]);                 \
+        if (test_check(#name, impl, index, digest[index],           \
+                       expects[index], dsize))                      \
+            return -BFDEV_EFAULT;                                   \
+                                                                    \
+        /* feed byte by byte to walk every buffer offset */         \
+        bfdev_##name##_init(&ctx);                                  \
+        for (offset = 0; offset < sizes[index]; ++offset)           \
+            bfdev_##ctxname##_update(&ctx,                          \
+                test_messages[index] + offset, 1);                  \
+        bfdev_##name##_finish(&ctx, digest[index]);                 \
+        if (test_check(#name, impl, index, digest[index],           \
+                       expects[index], dsize))                      \
+            return -BFDEV_EFAULT;                                   \
+    }                                                               \
+                                                                    \
+    for (index = 0; index < TEST_MESSAGES; ++index) {               \
+        ctxs[index] = &mbctx[index];                                \
+        hashes[index] = digest[index];                              \
+        bfdev_##name##_init(ctxs[index]);                           \
+    }                                                               \
+                                                                    \
+    bfdev_##ctxname##_update_mb(ctxs, test_messages, sizes,         \
+                                TEST_MESSAGES);                     \
+    bfdev_##name##_finish_mb(ctxs, hashes, TEST_MESSAGES);          \
+    for (index = 0; index < TEST_MESSAGES; ++index) {               \
+        if (test_check(#name "-mb", impl, index, digest[index],     \
+                       expects[index], dsize))                      \
+            return -BFDEV_EFAULT;                                   \
+    }                                                               \
+} while (0)
+
+static int
+test_check(const char *name, const char *impl, unsigned int index,
+           const uint8_t *digest, const char *expect, unsigned int size)
+{
+    char buff[BFDEV_SHA256_DIGEST_SIZE * 2 + 1];
+    unsigned int count;
+
+    for (count = 0; count < size; ++count)
+        sprintf(buff + count * 2, "%02x", digest[count]);
+
+    if (strcmp(buff, expect)) {
+        bfdev_log_err("%s %s message %u: %s\n", name, impl, index, buff);
+        return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_sha1_kat(const char *impl)
+{
+    GENERIC_KAT(sha1, sha1, test_sha1, BFDEV_SHA1_DIGEST_SIZE);
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_sha2_kat(const char *impl)
+{
+    GENERIC_KAT(sha224, sha2, test_sha224, BFDEV_SHA224_DIGEST_SIZE);
+    GENERIC_KAT(sha256, sha2, test_sha256, BFDEV_SHA256_DIGEST_SIZE);
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_sha_kat(const char *impl)
+{
+    return test_sha1_kat(impl) ?: test_sha2_kat(impl);
+}
+
+static int
+test_impls(const char *name, int (*kat)(const char *impl))
+{
+    bfdev_dispatch_t *dispatch;
+    const char *impl;
+    unsigned int index;
+    int retval;
+
+    dispatch = bfdev_dispatch_find(name);
+    if (!dispatch) {
+        bfdev_log_err("module %s is not registered\n", name);
+        return -BFDEV_ENOENT;
+    }
+
+    retval = -BFDEV_ENOERR;
+    for (index = 0; index < dispatch->count; ++index) {
+        if (!bfdev_dispatch_usable(&dispatch->impls[index]))
+            continue;
+
+        impl = dispatch->impls[index].name;
+        bfdev_dispatch_select(dispatch, impl);
+        bfdev_log_info("%s: %s\n", name, impl);
+
+        retval = kat(impl);
+        if (retval)
+            break;
+    }
+
+    bfdev_dispatch_select(dispatch, NULL);
+    return retval;
+}
+
+TESTSUITE(
+    "crypto:sha1", NULL, NULL,
+    "sha1 fips 180 known answers"
+) {
+    return test_impls("sha1", test_sha1_kat);
+}
+
+TESTSUITE(
+    "crypto:sha2", NULL, NULL,
+    "sha224 and sha256 fips 180 known answers"
+) {
+    return test_impls("sha2", test_sha2_kat);
+}
+
+TESTSUITE(
+    "crypto:sha_mb", NULL, NULL,
+    "multi-buffer engines give the fips 180 known answers"
+) {
+    return test_impls("hash-mb", test_sha_kat);
+}
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "dispatch-registry"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <string.h>
+#include <bfdev/dispatch.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/crc.h>
+#include <bfdev/base64.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 4099
+
+static const int
+test_ops[2] = {1, 2};
+
+/* no cpu reports a feature past the known ones */
+static const bfdev_dispatch_impl_t
+test_impls[] = {
+    BFDEV_DISPATCH_IMPL("future", BFDEV_CPU_FEATURE(BFDEV_CPU_FEATURE_NR),
+                        &test_ops[0]),
+    BFDEV_DISPATCH_IMPL("missing", 0, NULL),
+    BFDEV_DISPATCH_IMPL("generic", 0, &test_ops[1]),
+};
+
+static
+BFDEV_DEFINE_DISPATCH(test_dispatch, "dispatch-test", test_impls,
+                      &test_ops[1]);
+
+static int
+test_registry(void)
+{
+    if (bfdev_dispatch_register(&test_dispatch))
+        return -BFDEV_EFAULT;
+
+    if (test_dispatch.selected != &test_impls[2] ||
+        *bfdev_dispatch_ops(&test_dispatch, int) != 2)
+        return -BFDEV_EFAULT;
+
+    if (bfdev_dispatch_register(&test_dispatch) != -BFDEV_EALREADY ||
+        bfdev_dispatch_find("dispatch-test") != &test_dispatch)
+        return -BFDEV_EFAULT;
+
+    if (bfdev_dispatch_select(&test_dispatch, "future") != -BFDEV_EOPNOTSUPP ||
+        bfdev_dispatch_select(&test_dispatch, "missing") != -BFDEV_EOPNOTSUPP ||
+        bfdev_dispatch_select(&test_dispatch, "unknown") != -BFDEV_ENOENT ||
+        test_dispatch.selected != &test_impls[2])
+        return -BFDEV_EFAULT;
+
+    if (bfdev_dispatch_unregister(&test_dispatch) ||
+        bfdev_dispatch_find("dispatch-test") ||
+        bfdev_dispatch_unregister(&test_dispatch) != -BFDEV_ENOENT)
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+struct test_result {
+    uint64_t xxh3;
+    uint32_t crc32c;
+    uint64_t crc64;
+    char base64[BFDEV_DIV_ROUND_UP(TEST_SIZE, 3) * 4];
+};
+
+static void
+test_compute(struct test_result *result, const uint8_t *data)
+{
+    memset(result, 0, sizeof(*result));
+    result->xxh3 = bfdev_xxh3(data, TEST_SIZE, 0);
+    result->crc32c = bfdev_crc32c(data, TEST_SIZE, ~0U);
+    result->crc64 = bfdev_crc64(data, TEST_SIZE, 0);
+    bfdev_base64_encode(result->base64, data, TEST_SIZE);
+}
+
+static int
+test_module(const char *name, const uint8_t *data,
+            const struct test_result *expect)
+{
+    struct test_result result;
+    bfdev_dispatch_t *dispatch;
+    unsigned int index;
+    int retval;
+
+    dispatch = bfdev_dispatch_find(name);
+    if (!dispatch) {
+        bfdev_log_err("module %s is not registered\n", name);
+        return -BFDEV_ENOENT;
+    }
+
+    retval = -BFDEV_ENOERR;
+    for (index = 0; index < dispatch->count; ++index) {
+        if (!bfdev_dispatch_usable(&dispatch->impls[index]))
+            continue;
+
+        bfdev_dispatch_select(dispatch, dispatch->impls[index].name);
+        test_compute(&result, data);
+
+        bfdev_log_info("%s: %s\n", name, dispatch->impls[index].name);
+        if (memcmp(&result, expect, sizeof(result))) {
+            bfdev_log_err("%s: %s disagrees with generic\n",
+                          name, dispatch->impls[index].name);
+            retval = -BFDEV_EFAULT;
+        }
+    }
+
+    bfdev_dispatch_select(dispatch, NULL);
+    return retval;
+}
+
+static const char *
+test_modules[] = {
+    "xxh3", "crc32c", "crc64", "base64",
+};
+
+static int
+test_dispatch_modules(void)
+{
+    bfdev_dispatch_t *dispatch;
+    struct test_result expect;
+    unsigned int index;
+    uint8_t *data;
+    int retval;
+
+    data = malloc(TEST_SIZE);
+    if (!data)
+        return -BFDEV_ENOMEM;
+
+    for (index = 0; index < TEST_SIZE; ++index)
+        data[index] = rand();
+
+    /* the reference runs generic everywhere */
+    retval = -BFDEV_ENOERR;
+    for (index = 0; index < BFDEV_ARRAY_SIZE(test_modules); ++index) {
+        dispatch = bfdev_dispatch_find(test_modules[index]);
+        if (!dispatch || bfdev_dispatch_select(dispatch, "generic")) {
+            bfdev_log_err("%s: no generic\n", test_modules[index]);
+            retval = -BFDEV_ENOENT;
+            goto failed;
+        }
+    }
+
+    test_compute(&expect, data);
+    for (index = 0; index < BFDEV_ARRAY_SIZE(test_modules); ++index) {
+        retval = test_module(test_modules[index], data, &expect);
+        if (retval)
+            break;
+    }
+
+failed:
+    free(data);
+    return retval;
+}
+
+TESTSUITE(
+    "dispatch:registry", NULL, NULL,
+    "dispatch register and select"
+) {
+    return test_registry();
+}
+
+TESTSUITE(
+    "dispatch:modules", NULL, NULL,
+    "every usable implementation agrees with generic"
+) {
+    return test_dispatch_modules();
+}
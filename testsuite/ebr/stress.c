@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "ebr-stress"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <bfdev/ebr.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_THREADS 8
+#define TEST_SLOTS 64
+#define TEST_LOOP 200000
+#define TEST_MAGIC 0x6562725aUL
+
+struct test_object {
+    unsigned long magic;
+    unsigned long value;
+    bfdev_ebr_node_t ebr;
+};
+
+struct test_worker {
+    pthread_t tid;
+    unsigned int index;
+    bool failed;
+};
+
+static BFDEV_DEFINE_EBR(ebr, NULL);
+static bfdev_atomic_t slots[TEST_SLOTS];
+static bfdev_atomic_t allocated;
+static bfdev_atomic_t released;
+
+static void
+test_free(const bfdev_alloc_t *alloc, struct test_object *object)
+{
+    /* a reader still holding it would catch the poison */
+    object->magic = 0;
+    bfdev_atomic_add(&released, 1);
+    bfdev_free(alloc, object);
+}
+
+static void
+test_release(const bfdev_alloc_t *alloc, bfdev_ebr_node_t *node)
+{
+    test_free(alloc, bfdev_ebr_entry(node, struct test_object, ebr));
+}
+
+static struct test_object *
+test_object(unsigned long value)
+{
+    struct test_object *object;
+
+    object = bfdev_malloc(NULL, sizeof(*object));
+    if (!object)
+        return NULL;
+
+    object->magic = TEST_MAGIC;
+    object->value = value;
+    bfdev_atomic_add(&allocated, 1);
+
+    return object;
+}
+
+static void *
+test_worker(void *pdata)
+{
+    struct test_object *object, *old;
+    struct test_worker *worker = pdata;
+    bfdev_ebr_thread_t *thread;
+    bfdev_prandom_t rand;
+    unsigned long count;
+    unsigned int slot;
+
+    thread = bfdev_ebr_attach(&ebr);
+    if (!thread) {
+        worker->failed = true;
+        return NULL;
+    }
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < TEST_LOOP && !worker->failed; ++count) {
+        slot = bfdev_prandom_value(&rand) % TEST_SLOTS;
+        bfdev_ebr_enter(&ebr, thread);
+
+        /* readers far outnumber writers */
+        if (count % 8) {
+            object = (void *)bfdev_atomic_read(&slots[slot]);
+            if (object && object->magic != TEST_MAGIC)
+                worker->failed = true;
+            bfdev_ebr_leave(&ebr, thread);
+            continue;
+        }
+
+        object = test_object(count);
+        if (!object) {
+            worker->failed = true;
+            bfdev_ebr_leave(&ebr, thread);
+            break;
+        }
+
+        old = (void *)bfdev_xchg(&slots[slot], (bfdev_atomic_t)object);
+        if (old) {
+            if (old->magic != TEST_MAGIC)
+                worker->failed = true;
+            bfdev_ebr_retire(&ebr, thread, &old->ebr, test_release);
+        }
+
+        bfdev_ebr_leave(&ebr, thread);
+    }
+
+    bfdev_ebr_detach(&ebr, thread);
+    return NULL;
+}
+
+TESTSUITE(
+    "ebr:stress", NULL, NULL,
+    "ebr concurrent retire stress test"
+) {
+    struct test_worker workers[TEST_THREADS];
+    struct test_object *object;
+    bfdev_ebr_thread_t *thread;
+    unsigned int count;
+    int retval;
+
+    for (count = 0; count < TEST_THREADS; ++count) {
+        workers[count] = (struct test_worker) {.index = count};
+        pthread_create(&workers[count].tid, NULL, test_worker, &workers[count]);
+    }
+
+    retval = -BFDEV_ENOERR;
+    for (count = 0; count < TEST_THREADS; ++count) {
+        pthread_join(workers[count].tid, NULL);
+        if (workers[count].failed)
+            retval = -BFDEV_EFAULT;
+    }
+
+    /* with everyone gone two epoch advances drain any record */
+    thread = bfdev_ebr_attach(&ebr);
+    if (!thread)
+        return -BFDEV_ENOMEM;
+
+    for (count = 0; count < BFDEV_EBR_EPOCHS; ++count) {
+        if (bfdev_ebr_reclaim(&ebr, thread))
+            break;
+    }
+
+    bfdev_ebr_detach(&ebr, thread);
+    if (count == BFDEV_EBR_EPOCHS)
+        retval = -BFDEV_EBUSY;
+
+    for (count = 0; count < TEST_SLOTS; ++count) {
+        object = (void *)bfdev_xchg(&slots[count], 0);
+        if (object)
+            test_free(NULL, object);
+    }
+
+    bfdev_ebr_destroy(&ebr);
+    bfdev_log_info("allocated %ld released %ld\n",
+                   (long)allocated, (long)released);
+
+    if (allocated != released)
+        retval = -BFDEV_EFAULT;
+
+    return retval;
+}
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "fifo-concurrent"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <sched.h>
+#include <pthread.h>
+#include <bfdev/fifo.h>
+#include <bfdev/log.h>
+#include <bfdev/minmax.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 64
+#define TEST_BATCH 48
+#define TEST_LOOP 1000000
+
+struct test_pdata {
+    BFDEV_DECLARE_FIFO_SPSC(fifo, uint64_t, TEST_SIZE);
+    bool failed;
+};
+
+static void *
+test_producer(void *pdata)
+{
+    struct test_pdata *test = pdata;
+    uint64_t buff[TEST_BATCH], value;
+    bfdev_prandom_t rand;
+    unsigned long length, count;
+
+    bfdev_prandom_seed(&rand, 1);
+    for (value = 1; value <= TEST_LOOP;) {
+        /* mix single puts with batches that wrap the buffer */
+        if (value & 1) {
+            if (bfdev_fifo_spsc_put(&test->fifo, value))
+                value++;
+            else
+                sched_yield();
+            continue;
+        }
+
+        length = bfdev_prandom_value(&rand) % TEST_BATCH + 1;
+        length = bfdev_min(length, TEST_LOOP - value + 1);
+        for (count = 0; count < length; ++count)
+            buff[count] = value + count;
+
+        length = bfdev_fifo_spsc_in(&test->fifo, buff, length);
+        if (!length)
+            sched_yield();
+        value += length;
+    }
+
+    return NULL;
+}
+
+static void *
+test_consumer(void *pdata)
+{
+    struct test_pdata *test = pdata;
+    uint64_t buff[TEST_BATCH], expect;
+    bfdev_prandom_t rand;
+    unsigned long length, count;
+
+    bfdev_prandom_seed(&rand, 2);
+    for (expect = 1; expect <= TEST_LOOP && !test->failed;) {
+        if (expect & 1) {
+            if (!bfdev_fifo_spsc_get(&test->fifo, buff)) {
+                sched_yield();
+                continue;
+            }
+            length = 1;
+        } else {
+            length = bfdev_prandom_value(&rand) % TEST_BATCH + 1;
+            length = bfdev_fifo_spsc_out(&test->fifo, buff, length);
+            if (!length) {
+                sched_yield();
+                continue;
+            }
+        }
+
+        for (count = 0; count < length; ++count) {
+            if (buff[count] != expect + count) {
+                bfdev_log_err("expect %llu got %llu\n",
+                              (unsigned long long)(expect + count),
+                              (unsigned long long)buff[count]);
+                test->failed = true;
+            }
+        }
+
+        expect += length;
+    }
+
+    return NULL;
+}
+
+TESTSUITE(
+    "fifo:spsc", NULL, NULL,
+    "spsc fifo ordering across threads"
+) {
+    static struct test_pdata test;
+    pthread_t producer, consumer;
+
+    test.fifo = BFDEV_FIFO_SPSC_INIT(&test.fifo);
+    test.failed = false;
+
+    pthread_create(&consumer, NULL, test_consumer, &test);
+    pthread_create(&producer, NULL, test_producer, &test);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    if (test.failed)
+        return -BFDEV_EFAULT;
+
+    if (!bfdev_fifo_spsc_check_empty(&test.fifo))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "fifo-record"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <string.h>
+#include <bfdev/fifo.h>
+#include <bfdev/ringbuf.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 1024
+#define TEST_ROUNDS 8
+
+/* longer than 255 checks the byte order of two byte headers */
+static const unsigned long
+test_lengths[] = {
+    300, 1, 257, 40, 0, 255, 3, 90,
+};
+
+static void
+test_fill(uint8_t *buff, unsigned long length, unsigned int seed)
+{
+    unsigned long count;
+
+    for (count = 0; count < length; ++count)
+        buff[count] = (uint8_t)(seed * 31 + count);
+}
+
+static unsigned long
+test_limit(unsigned long length, unsigned long record)
+{
+    /* a one byte header keeps only the low byte of the length */
+    return record == 1 ? length & 0xff : length;
+}
+
+static int
+test_fifo_queue(bfdev_fifo_t *fifo, unsigned long record)
+{
+    uint8_t expect[TEST_SIZE], buff[TEST_SIZE];
+    unsigned long length, retval;
+    unsigned int round, index;
+
+    /* several records queued at once, and headers crossing the end */
+    for (round = 0; round < TEST_ROUNDS; ++round) {
+        for (index = 0; index < BFDEV_ARRAY_SIZE(test_lengths); ++index) {
+            length = test_limit(test_lengths[index], record);
+            test_fill(expect, length, round + index);
+            retval = bfdev_fifo_in_record(fifo, expect, length, record);
+            if (retval != length)
+                return -BFDEV_EFAULT;
+        }
+
+        for (index = 0; index < BFDEV_ARRAY_SIZE(test_lengths); ++index) {
+            length = test_limit(test_lengths[index], record);
+            test_fill(expect, length, round + index);
+
+            retval = bfdev_fifo_peek_record(fifo, buff, sizeof(buff), record);
+            if (retval != length || memcmp(buff, expect, length))
+                return -BFDEV_EFAULT;
+
+            memset(buff, 0, sizeof(buff));
+            retval = bfdev_fifo_out_record(fifo, buff, sizeof(buff), record);
+            if (retval != length || memcmp(buff, expect, length))
+                return -BFDEV_EFAULT;
+        }
+
+        if (fifo->in != fifo->out)
+            return -BFDEV_EFAULT;
+
+        /* shift the start so the next round wraps elsewhere */
+        bfdev_fifo_in_record(fifo, expect, round * 37 % 128, record);
+        bfdev_fifo_out_record(fifo, buff, sizeof(buff), record);
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_ringbuf_queue(bfdev_ringbuf_t *ringbuf, unsigned long record)
+{
+    uint8_t expect[TEST_SIZE], buff[TEST_SIZE];
+    bfdev_ringbuf_span_t spans[2];
+    unsigned long length, retval, total, size;
+    unsigned int round, index, first;
+
+    size = ringbuf->mask + 1;
+
+    for (round = 0; round < TEST_ROUNDS; ++round) {
+        for (index = 0; index < BFDEV_ARRAY_SIZE(test_lengths); ++index) {
+            test_fill(expect, test_lengths[index], round + index);
+            bfdev_ringbuf_in_record(ringbuf, expect, test_lengths[index], record);
+        }
+
+        /* older records may have been overwritten, find the survivors */
+        total = 0;
+        first = BFDEV_ARRAY_SIZE(test_lengths);
+        while (first && total + test_lengths[first - 1] + record <= size)
+            total += test_lengths[--first] + record;
+
+        for (index = 0; index < first; ++index)
+            bfdev_ringbuf_consume_record(ringbuf, record);
+
+        for (index = first; index < BFDEV_ARRAY_SIZE(test_lengths); ++index) {
+            length = test_lengths[index];
+            test_fill(expect, length, round + index);
+
+            retval = bfdev_ringbuf_peek_spans_record(ringbuf, spans,
+                                                     size, record);
+            if (retval != length || spans[0].len + spans[1].len != length)
+                return -BFDEV_EFAULT;
+
+            if (memcmp(spans[0].data, expect, spans[0].len) ||
+                memcmp(spans[1].data, expect + spans[0].len, spans[1].len))
+                return -BFDEV_EFAULT;
+
+            memset(buff, 0, sizeof(buff));
+            retval = bfdev_ringbuf_out_record(ringbuf, buff, sizeof(buff), record);
+            if (retval != length || memcmp(buff, expect, length))
+                return -BFDEV_EFAULT;
+        }
+
+        if (ringbuf->in != ringbuf->out)
+            return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "fifo:record", NULL, NULL,
+    "fifo record header round trip"
+) {
+    BFDEV_DECLARE_FIFO_RECORD(byte, uint8_t, TEST_SIZE, 1);
+    BFDEV_DECLARE_FIFO_RECORD(word, uint8_t, TEST_SIZE, 2);
+    int retval;
+
+    byte = BFDEV_FIFO_INIT(&byte);
+    retval = test_fifo_queue(&byte.fifo, bfdev_fifo_recsize(&byte));
+    if (retval) {
+        bfdev_log_err("one byte header failed\n");
+        return retval;
+    }
+
+    word = BFDEV_FIFO_INIT(&word);
+    retval = test_fifo_queue(&word.fifo, bfdev_fifo_recsize(&word));
+    if (retval) {
+        bfdev_log_err("two byte header failed\n");
+        return retval;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "fifo:ringbuf_record", NULL, NULL,
+    "ringbuf record header round trip"
+) {
+    BFDEV_DECLARE_RINGBUF_RECORD(ringbuf, uint8_t, TEST_SIZE, 2);
+    BFDEV_DEFINE_RINGBUF_DYNAMIC_RECORD(mirror, uint8_t, 2);
+    int retval;
+
+    ringbuf = BFDEV_RINGBUF_INIT(&ringbuf);
+    retval = test_ringbuf_queue(&ringbuf.ringbuf, bfdev_ringbuf_recsize(&ringbuf));
+    if (retval) {
+        bfdev_log_err("ringbuf failed\n");
+        return retval;
+    }
+
+    retval = bfdev_ringbuf_alloc_mirror(&mirror, TEST_SIZE);
+    if (retval == -BFDEV_EOPNOTSUPP)
+        return -BFDEV_ENOERR;
+    else if (retval)
+        return retval;
+
+    retval = test_ringbuf_queue(&mirror.ringbuf, bfdev_ringbuf_recsize(&mirror));
+    if (retval)
+        bfdev_log_err("double-mapped ringbuf failed\n");
+
+    bfdev_ringbuf_free(&mirror);
+    return retval;
+}
@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "fifo-spans"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <sched.h>
+#include <pthread.h>
+#include <bfdev/fifo.h>
+#include <bfdev/ringbuf.h>
+#include <bfdev/log.h>
+#include <bfdev/minmax.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 16
+#define TEST_LOOP 100000
+#define TEST_THREAD_SIZE 64
+#define TEST_THREAD_LOOP 1000000
+
+struct test_pdata {
+    BFDEV_DECLARE_FIFO_SPSC(fifo, uint64_t, TEST_THREAD_SIZE);
+    bool failed;
+};
+
+static void
+test_produce(void *data, unsigned long length, uint64_t *value)
+{
+    uint64_t *buff = data;
+    unsigned long count;
+
+    for (count = 0; count < length; ++count)
+        buff[count] = (*value)++;
+}
+
+static bool
+test_verify(const void *data, unsigned long length, uint64_t *expect)
+{
+    const uint64_t *buff = data;
+    unsigned long count;
+    bool passed = true;
+
+    for (count = 0; count < length; ++count) {
+        if (buff[count] != *expect) {
+            bfdev_log_err("expect %llu got %llu\n",
+                          (unsigned long long)*expect,
+                          (unsigned long long)buff[count]);
+            /* resync so a threaded producer is still drained */
+            *expect = buff[count];
+            passed = false;
+        }
+        (*expect)++;
+    }
+
+    return passed;
+}
+
+TESTSUITE(
+    "fifo:spans", NULL, NULL,
+    "fifo zero-copy reserve and peek"
+) {
+    BFDEV_DEFINE_FIFO(fifo, uint64_t, TEST_SIZE);
+    bfdev_fifo_span_t spans[2];
+    uint64_t value, expect;
+    unsigned long length, unused, count;
+    bfdev_prandom_t rand;
+    bool wrapped;
+
+    bfdev_prandom_seed(&rand, 1);
+    value = expect = 0;
+    wrapped = false;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        length = bfdev_prandom_value(&rand) % (TEST_SIZE + 4);
+        unused = TEST_SIZE - bfdev_fifo_len(&fifo);
+        length = bfdev_fifo_reserve(&fifo, spans, length);
+        if (length > unused ||
+            spans[0].len + spans[1].len != length)
+            return -BFDEV_EFAULT;
+
+        wrapped |= !!spans[1].len;
+        test_produce(spans[0].data, spans[0].len, &value);
+        test_produce(spans[1].data, spans[1].len, &value);
+        bfdev_fifo_commit(&fifo, length);
+
+        length = bfdev_prandom_value(&rand) % (TEST_SIZE + 4);
+        length = bfdev_fifo_peek_spans(&fifo, spans, length);
+        if (length > bfdev_fifo_len(&fifo) ||
+            spans[0].len + spans[1].len != length)
+            return -BFDEV_EFAULT;
+
+        if (!test_verify(spans[0].data, spans[0].len, &expect) ||
+            !test_verify(spans[1].data, spans[1].len, &expect))
+            return -BFDEV_EFAULT;
+        bfdev_fifo_consume(&fifo, length);
+    }
+
+    if (!wrapped || value - expect != bfdev_fifo_len(&fifo))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "fifo:ringbuf_spans", NULL, NULL,
+    "ringbuf zero-copy reserve overwrites the oldest objects"
+) {
+    BFDEV_DEFINE_RINGBUF(ringbuf, uint64_t, TEST_SIZE);
+    bfdev_ringbuf_span_t spans[2];
+    uint64_t value, expect;
+    unsigned long length, count;
+    bfdev_prandom_t rand;
+
+    bfdev_prandom_seed(&rand, 2);
+    value = expect = 0;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        length = bfdev_prandom_value(&rand) % (TEST_SIZE + 4);
+        length = bfdev_ringbuf_reserve(&ringbuf, spans, length);
+        if (length > TEST_SIZE ||
+            spans[0].len + spans[1].len != length)
+            return -BFDEV_EFAULT;
+
+        test_produce(spans[0].data, spans[0].len, &value);
+        test_produce(spans[1].data, spans[1].len, &value);
+        bfdev_ringbuf_commit(&ringbuf, length);
+
+        /* only the newest objects survive an overrun */
+        if (value - expect > TEST_SIZE)
+            expect = value - TEST_SIZE;
+        if (bfdev_ringbuf_len(&ringbuf) != value - expect)
+            return -BFDEV_EFAULT;
+
+        length = bfdev_prandom_value(&rand) % (TEST_SIZE / 2);
+        length = bfdev_ringbuf_peek_spans(&ringbuf, spans, length);
+        if (spans[0].len + spans[1].len != length)
+            return -BFDEV_EFAULT;
+
+        if (!test_verify(spans[0].data, spans[0].len, &expect) ||
+            !test_verify(spans[1].data, spans[1].len, &expect))
+            return -BFDEV_EFAULT;
+        bfdev_ringbuf_consume(&ringbuf, length);
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static void *
+test_producer(void *pdata)
+{
+    struct test_pdata *test = pdata;
+    bfdev_fifo_span_t spans[2];
+    bfdev_prandom_t rand;
+    unsigned long length;
+    uint64_t value;
+
+    bfdev_prandom_seed(&rand, 3);
+    for (value = 0; value < TEST_THREAD_LOOP;) {
+        length = bfdev_prandom_value(&rand) % TEST_THREAD_SIZE + 1;
+        length = bfdev_min(length, TEST_THREAD_LOOP - value);
+        length = bfdev_fifo_spsc_reserve(&test->fifo, spans, length);
+        if (!length) {
+            sched_yield();
+            continue;
+        }
+
+        test_produce(spans[0].data, spans[0].len, &value);
+        test_produce(spans[1].data, spans[1].len, &value);
+        bfdev_fifo_spsc_commit(&test->fifo, length);
+    }
+
+    return NULL;
+}
+
+static void *
+test_consumer(void *pdata)
+{
+    struct test_pdata *test = pdata;
+    bfdev_fifo_span_t spans[2];
+    bfdev_prandom_t rand;
+    unsigned long length;
+    uint64_t expect;
+
+    bfdev_prandom_seed(&rand, 4);
+    for (expect = 0; expect < TEST_THREAD_LOOP;) {
+        length = bfdev_prandom_value(&rand) % TEST_THREAD_SIZE + 1;
+        length = bfdev_fifo_spsc_peek_spans(&test->fifo, spans, length);
+        if (!length) {
+            sched_yield();
+            continue;
+        }
+
+        if (!test_verify(spans[0].data, spans[0].len, &expect))
+            test->failed = true;
+        if (!test_verify(spans[1].data, spans[1].len, &expect))
+            test->failed = true;
+        bfdev_fifo_spsc_consume(&test->fifo, length);
+    }
+
+    return NULL;
+}
+
+TESTSUITE(
+    "fifo:spsc_spans", NULL, NULL,
+    "spsc fifo zero-copy ordering across threads"
+) {
+    static struct test_pdata test;
+    pthread_t producer, consumer;
+
+    test.fifo = BFDEV_FIFO_SPSC_INIT(&test.fifo);
+    test.failed = false;
+
+    pthread_create(&consumer, NULL, test_consumer, &test);
+    pthread_create(&producer, NULL, test_producer, &test);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    if (test.failed)
+        return -BFDEV_EFAULT;
+
+    if (!bfdev_fifo_spsc_check_empty(&test.fifo))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "filter-blkbloom"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <bfdev/blkbloom.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_KEYS 65536
+#define TEST_BITS 12
+#define TEST_FPR_LIMIT 0.01
+
+static uint64_t hashes[TEST_KEYS];
+static bool result[TEST_KEYS];
+
+static uint64_t
+blkbloom_hash(const void *key, void *pdata)
+{
+    return bfdev_xxh3(key, sizeof(uint64_t), 0);
+}
+
+static void
+fill_hashes(uint64_t base)
+{
+    unsigned int index;
+    uint64_t key;
+
+    for (index = 0; index < TEST_KEYS; ++index) {
+        key = base + index;
+        hashes[index] = blkbloom_hash(&key, NULL);
+    }
+}
+
+static int
+test_blkbloom(void)
+{
+    bfdev_blkbloom_t *bloom;
+    unsigned int index, hits;
+    uint64_t key;
+    double rate;
+    int retval;
+
+    bloom = bfdev_blkbloom_create(NULL, TEST_KEYS * TEST_BITS,
+                                  blkbloom_hash, NULL);
+    if (!bloom)
+        return -BFDEV_ENOMEM;
+
+    /* first half one by one, second half as a batch */
+    for (key = 0; key < TEST_KEYS / 2; ++key)
+        bfdev_blkbloom_push(bloom, &key);
+
+    fill_hashes(0);
+    bfdev_blkbloom_push_batch(bloom, hashes + TEST_KEYS / 2, TEST_KEYS / 2);
+
+    retval = -BFDEV_EFAULT;
+    hits = bfdev_blkbloom_peek_batch(bloom, hashes, result, TEST_KEYS);
+    if (hits != TEST_KEYS) {
+        bfdev_log_err("batch lost %u keys\n", TEST_KEYS - hits);
+        goto failed;
+    }
+
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (!bfdev_blkbloom_peek(bloom, &key)) {
+            bfdev_log_err("key %llu lost\n", (unsigned long long)key);
+            goto failed;
+        }
+    }
+
+    /* everything pushed again must report as present */
+    hits = bfdev_blkbloom_push_batch(bloom, hashes, TEST_KEYS);
+    if (hits != TEST_KEYS) {
+        bfdev_log_err("push missed %u old keys\n", TEST_KEYS - hits);
+        goto failed;
+    }
+
+    fill_hashes(TEST_KEYS);
+    hits = bfdev_blkbloom_peek_batch(bloom, hashes, result, TEST_KEYS);
+    for (index = 0; index < TEST_KEYS; ++index) {
+        if (result[index] != bfdev_blkbloom_peek_hash(bloom, hashes[index])) {
+            bfdev_log_err("batch and single probe disagree\n");
+            goto failed;
+        }
+    }
+
+    rate = (double)hits / TEST_KEYS;
+    bfdev_log_info("false positive rate %.4lf\n", rate);
+    if (rate > TEST_FPR_LIMIT)
+        goto failed;
+
+    bfdev_blkbloom_flush(bloom);
+    fill_hashes(0);
+    if (bfdev_blkbloom_peek_batch(bloom, hashes, NULL, TEST_KEYS))
+        goto failed;
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    bfdev_blkbloom_destroy(bloom);
+    return retval;
+}
+
+TESTSUITE(
+    "filter:blkbloom", NULL, NULL,
+    "split block bloom filter single and batch"
+) {
+    return test_blkbloom();
+}
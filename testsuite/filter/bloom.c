@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "filter-bloom"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <bfdev/bloom.h>
+#include <bfdev/byteorder.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_KEYS 4096
+#define TEST_BITS (TEST_KEYS * 12)
+#define TEST_FUNCS 6
+#define TEST_HASHID 0x78783362
+
+static unsigned int
+bloom_hash(unsigned int func, const void *key, void *pdata)
+{
+    return (unsigned int)bfdev_xxh3(key, sizeof(unsigned int), func);
+}
+
+static bool
+bloom_lost(bfdev_bloom_t *bloom, unsigned int base, unsigned int count)
+{
+    unsigned int key;
+
+    for (key = base; key < base + count; ++key) {
+        if (!bfdev_bloom_peek(bloom, &key)) {
+            bfdev_log_err("key %u lost\n", key);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int
+test_image(bfdev_bloom_t *bloom)
+{
+    bfdev_bloom_t *copy, attach;
+    unsigned long *buff;
+    uint8_t *image;
+    size_t size;
+    int retval;
+
+    size = bfdev_bloom_export_size(bloom);
+    buff = malloc(size);
+    if (!buff)
+        return -BFDEV_ENOMEM;
+
+    image = (void *)buff;
+    retval = -BFDEV_EFAULT;
+
+    if (bfdev_bloom_export(bloom, image, size - 1, TEST_HASHID) !=
+        -BFDEV_ENOSPC)
+        goto failed;
+
+    if (bfdev_bloom_export(bloom, image, size, TEST_HASHID) ||
+        bfdev_bloom_check(image, size, TEST_HASHID))
+        goto failed;
+
+    if (bfdev_bloom_check(image, size, TEST_HASHID + 1) != -BFDEV_EINVAL ||
+        bfdev_bloom_check(image, size - 1, TEST_HASHID) != -BFDEV_EBADMSG)
+        goto failed;
+
+    copy = bfdev_bloom_import(NULL, image, size, bloom_hash,
+                              TEST_HASHID, NULL);
+    if (!copy)
+        goto failed;
+
+    if (bloom_lost(copy, 0, TEST_KEYS)) {
+        bfdev_bloom_destroy(copy);
+        goto failed;
+    }
+    bfdev_bloom_destroy(copy);
+
+    if (bfdev_bloom_attach(&attach, image, size, bloom_hash,
+                           TEST_HASHID, NULL) ||
+        bloom_lost(&attach, 0, TEST_KEYS))
+        goto failed;
+
+    /* a single flipped bit must be caught */
+    image[size - 1] ^= 0x10;
+    if (bfdev_bloom_check(image, size, TEST_HASHID) != -BFDEV_EBADMSG)
+        goto failed;
+
+    image[4] = BFDEV_BLOOM_VERSION + 1;
+    if (bfdev_bloom_check(image, size, TEST_HASHID) != -BFDEV_EPROTO)
+        goto failed;
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    free(buff);
+    return retval;
+}
+
+static int
+test_forged(uint8_t *image, size_t size, uint32_t capacity, uint64_t length)
+{
+    bfdev_bloom_header_t *header;
+    bfdev_bloom_t *copy, attach;
+
+    header = (void *)image;
+    header->capacity = bfdev_cpu_to_le32(capacity);
+    header->length = bfdev_cpu_to_le64(length);
+
+    if (bfdev_bloom_check(image, size, TEST_HASHID) != -BFDEV_EBADMSG ||
+        bfdev_bloom_attach(&attach, image, size, bloom_hash,
+                           TEST_HASHID, NULL) != -BFDEV_EBADMSG) {
+        bfdev_log_err("capacity %#x length %llu accepted\n",
+                      capacity, (unsigned long long)length);
+        return -BFDEV_EFAULT;
+    }
+
+    copy = bfdev_bloom_import(NULL, image, size, bloom_hash,
+                              TEST_HASHID, NULL);
+    if (copy) {
+        bfdev_log_err("capacity %#x length %llu imported\n",
+                      capacity, (unsigned long long)length);
+        bfdev_bloom_destroy(copy);
+        return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_malformed(bfdev_bloom_t *bloom)
+{
+    bfdev_bloom_t *huge;
+    unsigned long *buff;
+    uint8_t *image;
+    size_t size;
+    int retval;
+
+    /* rounding up to whole words would wrap to an empty bitmap */
+    huge = bfdev_bloom_create(NULL, BFDEV_UINT_MAX, bloom_hash,
+                              TEST_FUNCS, NULL);
+    if (huge) {
+        bfdev_bloom_destroy(huge);
+        return -BFDEV_EFAULT;
+    }
+
+    size = bfdev_bloom_export_size(bloom);
+    buff = malloc(size);
+    if (!buff)
+        return -BFDEV_ENOMEM;
+
+    image = (void *)buff;
+    retval = bfdev_bloom_export(bloom, image, size, TEST_HASHID);
+    if (retval)
+        goto failed;
+
+    retval = test_forged(image, size, BFDEV_UINT_MAX, 0);
+    if (retval)
+        goto failed;
+
+    retval = test_forged(image, size, BFDEV_UINT_MAX - 1,
+                         size - sizeof(bfdev_bloom_header_t));
+    if (retval)
+        goto failed;
+
+    /* not a whole number of words, yet the length still matches */
+    retval = test_forged(image, size, TEST_BITS - 1,
+                         size - sizeof(bfdev_bloom_header_t));
+
+failed:
+    free(buff);
+    return retval;
+}
+
+static int
+test_merge(bfdev_bloom_t *bloom)
+{
+    bfdev_bloom_t *other, *mismatch;
+    unsigned int key, hits;
+    int retval;
+
+    other = bfdev_bloom_create(NULL, TEST_BITS, bloom_hash, TEST_FUNCS, NULL);
+    mismatch = bfdev_bloom_create(NULL, TEST_BITS, bloom_hash, 1, NULL);
+    retval = -BFDEV_ENOMEM;
+    if (!other || !mismatch)
+        goto failed;
+
+    for (key = TEST_KEYS; key < TEST_KEYS * 2; ++key)
+        bfdev_bloom_push(other, &key);
+
+    retval = -BFDEV_EFAULT;
+    if (bfdev_bloom_union(bloom, mismatch) != -BFDEV_EINVAL)
+        goto failed;
+
+    if (bfdev_bloom_union(other, bloom) || bloom_lost(other, 0, TEST_KEYS * 2))
+        goto failed;
+
+    /* the intersection keeps the first set, and little of the rest */
+    if (bfdev_bloom_intersect(other, bloom) || bloom_lost(other, 0, TEST_KEYS))
+        goto failed;
+
+    for (hits = 0, key = TEST_KEYS; key < TEST_KEYS * 2; ++key)
+        hits += bfdev_bloom_peek(other, &key);
+
+    bfdev_log_info("intersection false positives %u\n", hits);
+    if (hits > TEST_KEYS / 16)
+        goto failed;
+
+    bfdev_bloom_flush(other);
+    for (key = 0; key < TEST_KEYS * 2; ++key) {
+        if (bfdev_bloom_peek(other, &key))
+            goto failed;
+    }
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    if (other)
+        bfdev_bloom_destroy(other);
+    if (mismatch)
+        bfdev_bloom_destroy(mismatch);
+    return retval;
+}
+
+static int
+test_bloom(void)
+{
+    bfdev_bloom_t *bloom;
+    unsigned int key;
+    int retval;
+
+    bloom = bfdev_bloom_create(NULL, TEST_BITS, bloom_hash, TEST_FUNCS, NULL);
+    if (!bloom)
+        return -BFDEV_ENOMEM;
+
+    for (key = 0; key < TEST_KEYS; ++key)
+        bfdev_bloom_push(bloom, &key);
+
+    retval = test_image(bloom);
+    if (!retval)
+        retval = test_malformed(bloom);
+    if (!retval)
+        retval = test_merge(bloom);
+
+    bfdev_bloom_destroy(bloom);
+    return retval;
+}
+
+TESTSUITE(
+    "filter:bloom", NULL, NULL,
+    "bloom filter image and set operations"
+) {
+    return test_bloom();
+}
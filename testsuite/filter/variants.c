@@ -0,0 +1,288 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "filter-variants"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <bfdev/cbloom.h>
+#include <bfdev/cuckoo.h>
+#include <bfdev/sbloom.h>
+#include <bfdev/xorfilter.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_KEYS 20000
+#define TEST_PROBES 100000
+
+static uint64_t hashes[TEST_KEYS * 2];
+
+static uint64_t
+filter_hash(const void *key, void *pdata)
+{
+    return bfdev_xxh3(key, sizeof(uint64_t), 0);
+}
+
+/* keys [TEST_KEYS, TEST_KEYS + TEST_PROBES) were never pushed */
+#define FALSE_POSITIVE(peek, filter, limit) ({                      \
+    unsigned int __hits;                                            \
+    uint64_t __key;                                                 \
+    double __rate;                                                  \
+                                                                    \
+    __hits = 0;                                                     \
+    for (__key = TEST_KEYS; __key < TEST_KEYS + TEST_PROBES; ++__key) \
+        __hits += peek(filter, &__key);                             \
+                                                                    \
+    __rate = (double)__hits / TEST_PROBES;                          \
+    bfdev_log_info(#peek " false positive rate %.5lf\n", __rate);   \
+    __rate <= (limit);                                              \
+})
+
+static int
+test_cbloom(void)
+{
+    bfdev_cbloom_t *bloom;
+    uint64_t key;
+    int retval;
+
+    bloom = bfdev_cbloom_create(NULL, TEST_KEYS * 10, 7, filter_hash, NULL);
+    if (!bloom)
+        return -BFDEV_ENOMEM;
+
+    retval = -BFDEV_EFAULT;
+    for (key = 0; key < TEST_KEYS; ++key)
+        bfdev_cbloom_push(bloom, &key);
+
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (!bfdev_cbloom_peek(bloom, &key))
+            goto failed;
+    }
+
+    if (!FALSE_POSITIVE(bfdev_cbloom_peek, bloom, 0.02))
+        goto failed;
+
+    /* drop the odd half, the even half must stay */
+    for (key = 1; key < TEST_KEYS; key += 2) {
+        if (bfdev_cbloom_pop(bloom, &key))
+            goto failed;
+    }
+
+    for (key = 0; key < TEST_KEYS; key += 2) {
+        if (!bfdev_cbloom_peek(bloom, &key))
+            goto failed;
+    }
+
+    for (key = 0; key < TEST_KEYS; key += 2)
+        bfdev_cbloom_pop(bloom, &key);
+
+    /* with every key gone, nothing may be left behind */
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (bfdev_cbloom_peek(bloom, &key))
+            goto failed;
+    }
+
+    key = 0;
+    if (bfdev_cbloom_pop(bloom, &key) != -BFDEV_ENOENT)
+        goto failed;
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    bfdev_cbloom_destroy(bloom);
+    return retval;
+}
+
+TESTSUITE(
+    "filter:cbloom", NULL, NULL,
+    "counting bloom filter push, peek and pop"
+) {
+    return test_cbloom();
+}
+
+static int
+test_cuckoo(void)
+{
+    bfdev_cuckoo_t *cuckoo;
+    unsigned long count;
+    uint64_t key;
+    int retval;
+
+    cuckoo = bfdev_cuckoo_create(NULL, TEST_KEYS, filter_hash, NULL);
+    if (!cuckoo)
+        return -BFDEV_ENOMEM;
+
+    retval = -BFDEV_EFAULT;
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (bfdev_cuckoo_push(cuckoo, &key))
+            goto failed;
+    }
+
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (!bfdev_cuckoo_peek(cuckoo, &key))
+            goto failed;
+    }
+
+    if (!FALSE_POSITIVE(bfdev_cuckoo_peek, cuckoo, 0.001))
+        goto failed;
+
+    /* keep going until the table refuses */
+    for (count = 0; !bfdev_cuckoo_push(cuckoo, &key); ++key)
+        count++;
+
+    bfdev_log_info("cuckoo load %lu of %lu slots\n", cuckoo->count,
+                   (cuckoo->mask + 1) * BFDEV_CUCKOO_SLOTS);
+
+    for (key = 0; key < TEST_KEYS + count; ++key) {
+        if (!bfdev_cuckoo_peek(cuckoo, &key))
+            goto failed;
+    }
+
+    for (key = 0; key < TEST_KEYS + count; ++key) {
+        if (bfdev_cuckoo_pop(cuckoo, &key))
+            goto failed;
+    }
+
+    if (cuckoo->count || cuckoo->victim)
+        goto failed;
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    bfdev_cuckoo_destroy(cuckoo);
+    return retval;
+}
+
+TESTSUITE(
+    "filter:cuckoo", NULL, NULL,
+    "cuckoo filter up to full load and back"
+) {
+    return test_cuckoo();
+}
+
+static int
+test_sbloom(void)
+{
+    bfdev_sbloom_t *bloom;
+    unsigned int stages;
+    bfdev_list_head_t *node;
+    uint64_t key;
+    int retval;
+
+    /* start tiny so the filter has to grow a few times */
+    bloom = bfdev_sbloom_create(NULL, TEST_KEYS / 64, 7, filter_hash, NULL);
+    if (!bloom)
+        return -BFDEV_ENOMEM;
+
+    retval = -BFDEV_EFAULT;
+    for (key = 0; key < TEST_KEYS; ++key) {
+        retval = bfdev_sbloom_push(bloom, &key);
+        if (retval)
+            goto failed;
+    }
+
+    retval = -BFDEV_EFAULT;
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (!bfdev_sbloom_peek(bloom, &key))
+            goto failed;
+    }
+
+    stages = 0;
+    bfdev_list_for_each(node, &bloom->stages)
+        stages++;
+
+    bfdev_log_info("sbloom grew to %u stages\n", stages);
+    if (stages < 4)
+        goto failed;
+
+    /* 2^-7 summed over all stages, plus some sampling noise */
+    if (!FALSE_POSITIVE(bfdev_sbloom_peek, bloom, 0.01))
+        goto failed;
+
+    bfdev_sbloom_flush(bloom);
+    for (key = 0; key < TEST_KEYS; ++key) {
+        if (bfdev_sbloom_peek(bloom, &key))
+            goto failed;
+    }
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    bfdev_sbloom_destroy(bloom);
+    return retval;
+}
+
+TESTSUITE(
+    "filter:sbloom", NULL, NULL,
+    "scalable bloom filter growth and error bound"
+) {
+    return test_sbloom();
+}
+
+static int
+test_xorfilter(void)
+{
+    bfdev_xorfilter_t *filter;
+    unsigned int count;
+    uint64_t key;
+    int retval;
+
+    for (key = 0; key < TEST_KEYS; ++key)
+        hashes[key] = filter_hash(&key, NULL);
+
+    /* the second half repeats the first */
+    for (key = 0; key < TEST_KEYS; ++key)
+        hashes[TEST_KEYS + key] = hashes[key];
+
+    retval = -BFDEV_EFAULT;
+    for (count = 0; count <= 2; ++count) {
+        filter = bfdev_xorfilter_create(NULL, hashes, count * TEST_KEYS,
+                                        filter_hash, NULL);
+        if (!filter)
+            return -BFDEV_ENOMEM;
+
+        if (count) {
+            for (key = 0; key < TEST_KEYS; ++key) {
+                if (!bfdev_xorfilter_peek(filter, &key))
+                    goto failed;
+            }
+
+            bfdev_log_info("xorfilter %.2lf bits per key\n",
+                           filter->length * 8.0 / TEST_KEYS);
+            if (!FALSE_POSITIVE(bfdev_xorfilter_peek, filter, 0.006))
+                goto failed;
+        }
+
+        bfdev_xorfilter_destroy(filter);
+    }
+
+    /* tiny sets take the fallback geometry */
+    for (count = 1; count < 16; ++count) {
+        filter = bfdev_xorfilter_create(NULL, hashes, count,
+                                        filter_hash, NULL);
+        if (!filter)
+            return -BFDEV_ENOMEM;
+
+        for (key = 0; key < count; ++key) {
+            if (!bfdev_xorfilter_peek(filter, &key))
+                goto failed;
+        }
+
+        bfdev_xorfilter_destroy(filter);
+    }
+
+    return -BFDEV_ENOERR;
+
+failed:
+    bfdev_xorfilter_destroy(filter);
+    return retval;
+}
+
+TESTSUITE(
+    "filter:xorfilter", NULL, NULL,
+    "binary fuse filter with and without duplicates"
+) {
+    return test_xorfilter();
+}
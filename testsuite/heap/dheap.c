@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "heap-dheap"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <bfdev/dheap.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_LOOP 4096
+
+struct test_node {
+    bfdev_dheap_node_t node;
+    unsigned long value;
+};
+
+#define dheap_to_test(ptr) \
+    bfdev_dheap_entry(ptr, struct test_node, node)
+
+static long
+test_cmp(const bfdev_dheap_node_t *key1,
+         const bfdev_dheap_node_t *key2, void *pdata)
+{
+    struct test_node *node1, *node2;
+
+    node1 = dheap_to_test(key1);
+    node2 = dheap_to_test(key2);
+
+    if (node1->value == node2->value)
+        return 0;
+
+    return node1->value < node2->value ? -1 : 1;
+}
+
+static int
+test_check(bfdev_dheap_t *heap)
+{
+    bfdev_dheap_node_t *node, *parent;
+    unsigned long index;
+
+    bfdev_dheap_for_each(node, index, heap) {
+        if (node->index != index) {
+            bfdev_log_err("node %lu records index %lu\n", index, node->index);
+            return -BFDEV_EFAULT;
+        }
+
+        if (!index)
+            continue;
+
+        parent = bfdev_dheap_find(heap, (index - 1) / heap->ways);
+        if (test_cmp(parent, node, NULL) > 0) {
+            bfdev_log_err("node %lu is smaller than its parent\n", index);
+            return -BFDEV_EFAULT;
+        }
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_drain(bfdev_dheap_t *heap, unsigned long expect)
+{
+    bfdev_dheap_node_t *node;
+    unsigned long last, count;
+
+    for (last = count = 0; (node = bfdev_dheap_pop(heap)); ++count) {
+        if (dheap_to_test(node)->value < last) {
+            bfdev_log_err("pop out of order\n");
+            return -BFDEV_EFAULT;
+        }
+
+        last = dheap_to_test(node)->value;
+    }
+
+    if (count != expect) {
+        bfdev_log_err("pop %lu nodes, expect %lu\n", count, expect);
+        return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_ways(struct test_node *nodes, bfdev_dheap_node_t **array,
+          unsigned int ways)
+{
+    BFDEV_DEFINE_DHEAP(heap, NULL, ways, test_cmp, NULL);
+    bfdev_prandom_t rand;
+    unsigned long count, queued;
+    int retval;
+
+    bfdev_prandom_seed(&rand, ways);
+    for (count = 0; count < TEST_LOOP; ++count) {
+        nodes[count].value = bfdev_prandom_value(&rand) % (TEST_LOOP / 2);
+        retval = bfdev_dheap_insert(&heap, &nodes[count].node);
+        if (retval)
+            goto failed;
+    }
+
+    retval = test_check(&heap);
+    if (retval)
+        goto failed;
+
+    /* delete every third node and move the others around */
+    queued = TEST_LOOP;
+    for (count = 0; count < TEST_LOOP; ++count) {
+        if (count % 3 == 0) {
+            bfdev_dheap_delete(&heap, &nodes[count].node);
+            queued--;
+            continue;
+        }
+
+        nodes[count].value = bfdev_prandom_value(&rand) % TEST_LOOP;
+        bfdev_dheap_update(&heap, &nodes[count].node);
+    }
+
+    if (bfdev_dheap_count(&heap) != queued) {
+        retval = -BFDEV_EFAULT;
+        goto failed;
+    }
+
+    retval = test_check(&heap);
+    if (retval)
+        goto failed;
+
+    retval = test_drain(&heap, queued);
+    if (retval)
+        goto failed;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        nodes[count].value = bfdev_prandom_value(&rand);
+        array[count] = &nodes[count].node;
+    }
+
+    retval = bfdev_dheap_heapify(&heap, array, TEST_LOOP);
+    if (retval)
+        goto failed;
+
+    retval = test_check(&heap);
+    if (retval)
+        goto failed;
+
+    retval = test_drain(&heap, TEST_LOOP);
+
+failed:
+    bfdev_dheap_release(&heap);
+    return retval;
+}
+
+TESTSUITE(
+    "heap:dheap", NULL, NULL,
+    "d-ary heap order and index test"
+) {
+    static const unsigned int ways[] = {2, 3, 4, 8};
+    bfdev_dheap_node_t **array;
+    struct test_node *nodes;
+    unsigned int count;
+    int retval;
+
+    nodes = malloc(sizeof(*nodes) * TEST_LOOP);
+    array = malloc(sizeof(*array) * TEST_LOOP);
+
+    retval = -BFDEV_ENOMEM;
+    if (!nodes || !array)
+        goto failed;
+
+    for (count = 0; count < BFDEV_ARRAY_SIZE(ways); ++count) {
+        retval = test_ways(nodes, array, ways[count]);
+        if (retval) {
+            bfdev_log_err("failed with %u ways\n", ways[count]);
+            break;
+        }
+    }
+
+failed:
+    free(array);
+    free(nodes);
+
+    return retval;
+}
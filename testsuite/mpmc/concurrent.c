@@ -0,0 +1,287 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "mpmc-concurrent"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <sched.h>
+#include <pthread.h>
+#include <bfdev/mpmc.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 64
+#define TEST_BATCH 16
+#define TEST_PRODUCERS 4
+#define TEST_CONSUMERS 4
+#define TEST_ITEMS (1UL << 16)
+#define TEST_TOTAL (TEST_PRODUCERS * TEST_ITEMS)
+
+#define TEST_VALUE(producer, seq) \
+    (((uint64_t)(producer) << 32) | ((seq) + 1))
+
+struct test_worker {
+    pthread_t tid;
+    unsigned int index;
+    bool blocking;
+    bool failed;
+};
+
+static bfdev_mpmc_t mpmc;
+static bfdev_atomic_t seen[TEST_TOTAL];
+static bfdev_atomic_t consumed;
+
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wait_cond = PTHREAD_COND_INITIALIZER;
+
+static void
+cond_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    pthread_mutex_lock(&wait_lock);
+    while (bfdev_atomic_read(event) == value)
+        pthread_cond_wait(&wait_cond, &wait_lock);
+    pthread_mutex_unlock(&wait_lock);
+}
+
+static void
+cond_wake(bfdev_atomic_t *event, void *pdata)
+{
+    pthread_mutex_lock(&wait_lock);
+    pthread_cond_broadcast(&wait_cond);
+    pthread_mutex_unlock(&wait_lock);
+}
+
+static const bfdev_mpmc_ops_t
+cond_ops = {
+    .wait = cond_wait,
+    .wake = cond_wake,
+};
+
+static void *
+test_producer(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    uint64_t buff[TEST_BATCH];
+    unsigned long seq, length, count;
+    bfdev_prandom_t rand;
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (seq = 0; seq < TEST_ITEMS;) {
+        length = bfdev_prandom_value(&rand) % TEST_BATCH + 1;
+        if (length > TEST_ITEMS - seq)
+            length = TEST_ITEMS - seq;
+
+        for (count = 0; count < length; ++count)
+            buff[count] = TEST_VALUE(worker->index, seq + count);
+
+        if (worker->blocking) {
+            if (bfdev_mpmc_in(&mpmc, buff, length)) {
+                worker->failed = true;
+                break;
+            }
+        } else {
+            length = bfdev_mpmc_try_in(&mpmc, buff, length);
+            if (!length)
+                sched_yield();
+        }
+
+        seq += length;
+    }
+
+    return NULL;
+}
+
+static void *
+test_consumer(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    uint64_t buff[TEST_BATCH], last[TEST_PRODUCERS] = {};
+    unsigned long length, count, producer, seq;
+    bfdev_prandom_t rand;
+
+    bfdev_prandom_seed(&rand, worker->index + TEST_PRODUCERS + 1);
+    for (;;) {
+        length = bfdev_prandom_value(&rand) % TEST_BATCH + 1;
+
+        if (worker->blocking) {
+            if (bfdev_mpmc_out(&mpmc, buff, length, &length)) {
+                worker->failed = true;
+                break;
+            }
+        } else {
+            if (bfdev_atomic_read(&consumed) >= TEST_TOTAL)
+                break;
+            length = bfdev_mpmc_try_out(&mpmc, buff, length);
+            if (!length) {
+                sched_yield();
+                continue;
+            }
+        }
+
+        for (count = 0; count < length; ++count) {
+            /*
+             * Zero is the poison telling a blocking consumer to stop,
+             * hand back the ones of the other consumers in this batch.
+             */
+            if (!buff[count]) {
+                while (++count < length)
+                    bfdev_mpmc_put(&mpmc, &buff[count]);
+                return NULL;
+            }
+
+            producer = buff[count] >> 32;
+            seq = (uint32_t)buff[count] - 1;
+            if (producer >= TEST_PRODUCERS || seq >= TEST_ITEMS) {
+                worker->failed = true;
+                continue;
+            }
+
+            /* each consumer sees a producer's elements in order */
+            if (buff[count] <= last[producer])
+                worker->failed = true;
+            last[producer] = buff[count];
+
+            bfdev_atomic_add(&seen[producer * TEST_ITEMS + seq], 1);
+        }
+
+        bfdev_atomic_add(&consumed, length);
+    }
+
+    return NULL;
+}
+
+static int
+test_concurrent(bool blocking)
+{
+    struct test_worker producers[TEST_PRODUCERS];
+    struct test_worker consumers[TEST_CONSUMERS];
+    uint64_t poison = 0;
+    unsigned long index;
+    int retval;
+
+    retval = bfdev_mpmc_alloc(&mpmc, NULL, sizeof(uint64_t), TEST_SIZE);
+    if (retval)
+        return retval;
+
+    if (blocking)
+        bfdev_mpmc_set_wait(&mpmc, &cond_ops, NULL);
+
+    for (index = 0; index < TEST_TOTAL; ++index)
+        bfdev_atomic_write(&seen[index], 0);
+    bfdev_atomic_write(&consumed, 0);
+
+    for (index = 0; index < TEST_CONSUMERS; ++index) {
+        consumers[index].index = index;
+        consumers[index].blocking = blocking;
+        consumers[index].failed = false;
+        pthread_create(&consumers[index].tid, NULL,
+                       test_consumer, &consumers[index]);
+    }
+
+    for (index = 0; index < TEST_PRODUCERS; ++index) {
+        producers[index].index = index;
+        producers[index].blocking = blocking;
+        producers[index].failed = false;
+        pthread_create(&producers[index].tid, NULL,
+                       test_producer, &producers[index]);
+    }
+
+    for (index = 0; index < TEST_PRODUCERS; ++index) {
+        pthread_join(producers[index].tid, NULL);
+        if (producers[index].failed)
+            retval = -BFDEV_EFAULT;
+    }
+
+    if (blocking) {
+        for (index = 0; index < TEST_CONSUMERS; ++index)
+            bfdev_mpmc_put(&mpmc, &poison);
+    }
+
+    for (index = 0; index < TEST_CONSUMERS; ++index) {
+        pthread_join(consumers[index].tid, NULL);
+        if (consumers[index].failed)
+            retval = -BFDEV_EFAULT;
+    }
+
+    for (index = 0; index < TEST_TOTAL; ++index) {
+        if (bfdev_atomic_read(&seen[index]) != 1) {
+            bfdev_log_err("element %lu seen %ld times\n", index,
+                          (long)bfdev_atomic_read(&seen[index]));
+            retval = -BFDEV_EFAULT;
+            break;
+        }
+    }
+
+    if (!bfdev_mpmc_check_empty(&mpmc))
+        retval = -BFDEV_EFAULT;
+
+    bfdev_mpmc_free(&mpmc);
+    return retval;
+}
+
+TESTSUITE(
+    "mpmc:sequence", NULL, NULL,
+    "mpmc queue ordering and wraparound"
+) {
+    uint64_t buff[TEST_SIZE * 2], value, expect;
+    unsigned long length, count, loop;
+    int retval;
+
+    retval = bfdev_mpmc_alloc(&mpmc, NULL, sizeof(uint64_t), TEST_SIZE);
+    if (retval)
+        return retval;
+
+    /* blocking variants need wait operations */
+    if (bfdev_mpmc_put(&mpmc, buff) != -BFDEV_EOPNOTSUPP)
+        retval = -BFDEV_EFAULT;
+
+    value = expect = 0;
+    for (loop = 0; !retval && loop < TEST_SIZE * 4; ++loop) {
+        for (count = 0; count < TEST_SIZE * 2; ++count)
+            buff[count] = value + count;
+
+        /* a bulk enqueue stops at the free cells */
+        length = bfdev_mpmc_try_in(&mpmc, buff, loop % (TEST_SIZE * 2) + 1);
+        if (bfdev_mpmc_len(&mpmc) > TEST_SIZE) {
+            retval = -BFDEV_EFAULT;
+            break;
+        }
+        value += length;
+
+        length = bfdev_mpmc_try_out(&mpmc, buff, loop % 7 + 1);
+        for (count = 0; count < length; ++count) {
+            if (buff[count] != expect++) {
+                retval = -BFDEV_EFAULT;
+                break;
+            }
+        }
+    }
+
+    while (!retval && bfdev_mpmc_try_get(&mpmc, buff)) {
+        if (buff[0] != expect++)
+            retval = -BFDEV_EFAULT;
+    }
+
+    if (!retval && (expect != value || !bfdev_mpmc_check_empty(&mpmc)))
+        retval = -BFDEV_EFAULT;
+
+    bfdev_mpmc_free(&mpmc);
+    return retval;
+}
+
+TESTSUITE(
+    "mpmc:try", NULL, NULL,
+    "mpmc non-blocking delivery across threads"
+) {
+    return test_concurrent(false);
+}
+
+TESTSUITE(
+    "mpmc:blocking", NULL, NULL,
+    "mpmc blocking delivery across threads"
+) {
+    return test_concurrent(true);
+}
@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "mpsc-concurrent"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <bfdev/mpsc.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 64
+#define TEST_BATCH 8
+#define TEST_PRODUCERS 4
+#define TEST_ITEMS (1UL << 15)
+#define TEST_TOTAL (TEST_PRODUCERS * TEST_ITEMS)
+
+struct test_node {
+    bfdev_slist_head_t list;
+    unsigned int producer;
+    unsigned long seq;
+};
+
+struct test_producer {
+    pthread_t tid;
+    unsigned int index;
+    struct test_node *nodes;
+};
+
+#define slist_to_test(ptr) \
+    bfdev_slist_entry(ptr, struct test_node, list)
+
+static bfdev_mpsc_t mpsc;
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wait_cond = PTHREAD_COND_INITIALIZER;
+
+static void
+cond_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    pthread_mutex_lock(&wait_lock);
+    while (bfdev_atomic_read(event) == value)
+        pthread_cond_wait(&wait_cond, &wait_lock);
+    pthread_mutex_unlock(&wait_lock);
+}
+
+static void
+cond_wake(bfdev_atomic_t *event, void *pdata)
+{
+    pthread_mutex_lock(&wait_lock);
+    pthread_cond_broadcast(&wait_cond);
+    pthread_mutex_unlock(&wait_lock);
+}
+
+static const bfdev_mpsc_ops_t
+cond_ops = {
+    .wait = cond_wait,
+    .wake = cond_wake,
+};
+
+/* link nodes [first, first + count) so that @first is dequeued first */
+static void
+test_push_batch(struct test_node *nodes, unsigned long first,
+                unsigned long count)
+{
+    unsigned long index;
+
+    for (index = first + 1; index < first + count; ++index)
+        nodes[index].list.next = &nodes[index - 1].list;
+
+    bfdev_mpsc_push_batch(&mpsc, &nodes[first + count - 1].list,
+                          &nodes[first].list);
+}
+
+static void *
+test_producer(void *pdata)
+{
+    struct test_producer *producer = pdata;
+    unsigned long seq, length;
+    bfdev_prandom_t rand;
+
+    bfdev_prandom_seed(&rand, producer->index + 1);
+    for (seq = 0; seq < TEST_ITEMS; seq += length) {
+        length = bfdev_prandom_value(&rand) % TEST_BATCH + 1;
+        if (length > TEST_ITEMS - seq)
+            length = TEST_ITEMS - seq;
+
+        if (length == 1)
+            bfdev_mpsc_push(&mpsc, &producer->nodes[seq].list);
+        else
+            test_push_batch(producer->nodes, seq, length);
+    }
+
+    return NULL;
+}
+
+TESTSUITE(
+    "mpsc:order", NULL, NULL,
+    "mpsc queue single and batched fifo order"
+) {
+    struct test_node nodes[TEST_SIZE];
+    bfdev_slist_head_t *node, *tmp;
+    unsigned long index, expect;
+
+    bfdev_mpsc_init(&mpsc, NULL, NULL);
+    if (!bfdev_mpsc_check_empty(&mpsc) || bfdev_mpsc_pop(&mpsc) ||
+        bfdev_mpsc_wait(&mpsc) != -BFDEV_EOPNOTSUPP)
+        return -BFDEV_EFAULT;
+
+    for (index = 0; index < TEST_SIZE; ++index)
+        nodes[index].seq = index;
+
+    /* only the push onto an empty queue reports it */
+    if (!bfdev_mpsc_push(&mpsc, &nodes[0].list))
+        return -BFDEV_EFAULT;
+    test_push_batch(nodes, 1, 5);
+    if (bfdev_mpsc_push(&mpsc, &nodes[6].list))
+        return -BFDEV_EFAULT;
+
+    /* leave part of the private batch behind */
+    for (expect = 0; expect < 3; ++expect) {
+        node = bfdev_mpsc_pop(&mpsc);
+        if (!node || slist_to_test(node)->seq != expect)
+            return -BFDEV_EFAULT;
+    }
+
+    test_push_batch(nodes, 7, TEST_SIZE - 8);
+    bfdev_mpsc_push(&mpsc, &nodes[TEST_SIZE - 1].list);
+
+    /* the private batch stays ahead of newer pushes */
+    bfdev_mpsc_for_each_chain(node, tmp, bfdev_mpsc_pop_all(&mpsc)) {
+        if (slist_to_test(node)->seq != expect++)
+            return -BFDEV_EFAULT;
+    }
+
+    if (expect != TEST_SIZE || !bfdev_mpsc_check_empty(&mpsc))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "mpsc:concurrent", NULL, NULL,
+    "mpsc queue delivery across threads"
+) {
+    struct test_producer producers[TEST_PRODUCERS];
+    unsigned long expect[TEST_PRODUCERS] = {};
+    bfdev_slist_head_t *node, *tmp;
+    struct test_node *entry;
+    unsigned long index, count;
+    int retval;
+
+    bfdev_mpsc_init(&mpsc, &cond_ops, NULL);
+    retval = -BFDEV_ENOERR;
+
+    for (index = 0; index < TEST_PRODUCERS; ++index) {
+        producers[index].nodes = malloc(sizeof(struct test_node) * TEST_ITEMS);
+        if (!producers[index].nodes) {
+            while (index--)
+                free(producers[index].nodes);
+            return -BFDEV_ENOMEM;
+        }
+
+        for (count = 0; count < TEST_ITEMS; ++count) {
+            producers[index].nodes[count].producer = index;
+            producers[index].nodes[count].seq = count;
+        }
+    }
+
+    for (index = 0; index < TEST_PRODUCERS; ++index) {
+        producers[index].index = index;
+        pthread_create(&producers[index].tid, NULL,
+                       test_producer, &producers[index]);
+    }
+
+    /* alternate single pops with taking the whole queue */
+    for (count = 0; count < TEST_TOTAL;) {
+        bfdev_mpsc_wait(&mpsc);
+
+        if (count & 1) {
+            node = bfdev_mpsc_pop(&mpsc);
+            entry = slist_to_test(node);
+            if (entry->seq != expect[entry->producer]++)
+                retval = -BFDEV_EFAULT;
+            count++;
+            continue;
+        }
+
+        bfdev_mpsc_for_each_chain(node, tmp, bfdev_mpsc_pop_all(&mpsc)) {
+            entry = slist_to_test(node);
+            if (entry->seq != expect[entry->producer]++)
+                retval = -BFDEV_EFAULT;
+            count++;
+        }
+    }
+
+    for (index = 0; index < TEST_PRODUCERS; ++index) {
+        pthread_join(producers[index].tid, NULL);
+        if (expect[index] != TEST_ITEMS)
+            retval = -BFDEV_EFAULT;
+        free(producers[index].nodes);
+    }
+
+    if (!bfdev_mpsc_check_empty(&mpsc))
+        retval = -BFDEV_EFAULT;
+
+    return retval;
+}
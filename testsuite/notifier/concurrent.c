@@ -0,0 +1,251 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "notifier-concurrent"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include <bfdev/notifier-rcu.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <testsuite.h>
+
+#define TEST_READERS 4
+#define TEST_LOOP 20000
+#define TEST_MAGIC 0x5a5a5a5aUL
+#define TEST_POISON 0xdeadbeefUL
+
+struct test_record {
+    unsigned int count;
+    int priority[16];
+};
+
+struct test_data {
+    unsigned long magic;
+    int priority;
+};
+
+struct test_reader {
+    pthread_t tid;
+    unsigned int index;
+    bool failed;
+};
+
+static bfdev_notifier_rcu_t chain;
+static bfdev_atomic_t stopping;
+
+static bfdev_notifier_ret_t
+test_record_entry(void *args, void *pdata)
+{
+    struct test_record *record = args;
+    struct test_data *data = pdata;
+
+    record->priority[record->count++] = data->priority;
+
+    /* removal is not supported and must be ignored */
+    if (data->priority == 20)
+        return BFDEV_NOTIFI_RET_REMOVE;
+
+    return BFDEV_NOTIFI_RET_DONE;
+}
+
+static bfdev_notifier_ret_t
+test_stop_entry(void *args, void *pdata)
+{
+    test_record_entry(args, pdata);
+    return BFDEV_NOTIFI_RET_STOP;
+}
+
+static bfdev_notifier_ret_t
+test_check_entry(void *args, void *pdata)
+{
+    struct test_data *data = pdata;
+    bool *failed = args;
+
+    if (data->magic != TEST_MAGIC)
+        *failed = true;
+
+    return BFDEV_NOTIFI_RET_DONE;
+}
+
+static void *
+test_reader(void *pdata)
+{
+    struct test_reader *reader = pdata;
+
+    while (!bfdev_atomic_read(&stopping)) {
+        bfdev_notifier_rcu_call(&chain, reader->index, &reader->failed,
+                                UINT_MAX, NULL);
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+static bool
+test_check_order(struct test_record *record, unsigned int count)
+{
+    unsigned int index;
+
+    if (record->count != count)
+        return false;
+
+    for (index = 1; index < count; ++index) {
+        if (record->priority[index - 1] > record->priority[index])
+            return false;
+    }
+
+    return true;
+}
+
+TESTSUITE(
+    "notifier:rcu", NULL, NULL,
+    "read-mostly notifier priority order and limits"
+) {
+    static const int priority[] = {
+        10, 30, 20, -5, 30, 0,
+    };
+    struct test_data datas[BFDEV_ARRAY_SIZE(priority)];
+    bfdev_notifier_node_t nodes[BFDEV_ARRAY_SIZE(priority)];
+    bfdev_notifier_node_t stop;
+    struct test_data stop_data;
+    struct test_record record;
+    unsigned int index, called;
+    bfdev_notifier_ret_t ret;
+    int retval;
+
+    retval = bfdev_notifier_rcu_alloc(&chain, NULL, 2);
+    if (retval)
+        return retval;
+
+    /* an empty chain calls nothing */
+    record.count = 0;
+    bfdev_notifier_rcu_call(&chain, 0, &record, UINT_MAX, NULL);
+    if (record.count)
+        goto failed;
+
+    for (index = 0; index < BFDEV_ARRAY_SIZE(priority); ++index) {
+        datas[index].priority = priority[index];
+        nodes[index].priority = priority[index];
+        nodes[index].entry = test_record_entry;
+        nodes[index].pdata = &datas[index];
+        if (bfdev_notifier_rcu_register(&chain, &nodes[index]))
+            goto failed;
+    }
+
+    /* the node returning remove stays on the chain */
+    for (index = 0; index < 2; ++index) {
+        record.count = 0;
+        bfdev_notifier_rcu_call(&chain, index, &record, UINT_MAX, NULL);
+        if (!test_check_order(&record, BFDEV_ARRAY_SIZE(priority)))
+            goto failed;
+    }
+
+    record.count = called = 0;
+    bfdev_notifier_rcu_call(&chain, 0, &record, 3, &called);
+    if (called != 3 || !test_check_order(&record, 3))
+        goto failed;
+
+    stop_data.priority = 15;
+    stop.priority = 15;
+    stop.entry = test_stop_entry;
+    stop.pdata = &stop_data;
+    if (bfdev_notifier_rcu_register(&chain, &stop))
+        goto failed;
+
+    record.count = called = 0;
+    ret = bfdev_notifier_rcu_call(&chain, 0, &record, UINT_MAX, &called);
+    if (!(ret & BFDEV_NOTIFI_RET_STOP) || called != 4 ||
+        !test_check_order(&record, 4) || record.priority[3] != 15)
+        goto failed;
+
+    bfdev_notifier_rcu_unregister(&chain, &stop);
+    bfdev_notifier_rcu_unregister(&chain, &nodes[1]);
+
+    record.count = 0;
+    bfdev_notifier_rcu_call(&chain, 0, &record, UINT_MAX, NULL);
+    if (!test_check_order(&record, BFDEV_ARRAY_SIZE(priority) - 1))
+        goto failed;
+
+    /* nobody is reading, every replaced array goes at once */
+    if (!bfdev_notifier_rcu_reclaim(&chain))
+        goto failed;
+
+    bfdev_notifier_rcu_free(&chain);
+    return -BFDEV_ENOERR;
+
+failed:
+    bfdev_notifier_rcu_free(&chain);
+    return -BFDEV_EFAULT;
+}
+
+TESTSUITE(
+    "notifier:rcu_reclaim", NULL, NULL,
+    "read-mostly notifier reclaim against running callers"
+) {
+    struct test_reader readers[TEST_READERS];
+    bfdev_notifier_node_t node, keep;
+    struct test_data *value, keep_data;
+    unsigned int index, count;
+    int retval;
+
+    retval = bfdev_notifier_rcu_alloc(&chain, NULL, TEST_READERS);
+    if (retval)
+        return retval;
+
+    keep_data.magic = TEST_MAGIC;
+    keep.priority = 0;
+    keep.entry = test_check_entry;
+    keep.pdata = &keep_data;
+    bfdev_notifier_rcu_register(&chain, &keep);
+
+    bfdev_atomic_write(&stopping, 0);
+    for (index = 0; index < TEST_READERS; ++index) {
+        readers[index].index = index;
+        readers[index].failed = false;
+        pthread_create(&readers[index].tid, NULL,
+                       test_reader, &readers[index]);
+    }
+
+    node.priority = 1;
+    node.entry = test_check_entry;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        value = malloc(sizeof(*value));
+        if (!value) {
+            retval = -BFDEV_ENOMEM;
+            break;
+        }
+
+        value->magic = TEST_MAGIC;
+        node.pdata = value;
+
+        if (bfdev_notifier_rcu_register(&chain, &node)) {
+            free(value);
+            retval = -BFDEV_ENOMEM;
+            break;
+        }
+        bfdev_notifier_rcu_unregister(&chain, &node);
+
+        /* callers may only see the data until reclaim lets go */
+        while (!bfdev_notifier_rcu_reclaim(&chain))
+            sched_yield();
+
+        value->magic = TEST_POISON;
+        free(value);
+    }
+
+    bfdev_atomic_write(&stopping, 1);
+    for (index = 0; index < TEST_READERS; ++index) {
+        pthread_join(readers[index].tid, NULL);
+        if (readers[index].failed)
+            retval = -BFDEV_EFAULT;
+    }
+
+    bfdev_notifier_rcu_free(&chain);
+    return retval;
+}
@@ -0,0 +1,226 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "percpu-concurrent"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <sched.h>
+#include <pthread.h>
+#include <bfdev/percpu.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_SLOTS 3
+#define TEST_THREADS 8
+#define TEST_LOOP 100000
+
+struct test_worker {
+    pthread_t tid;
+    unsigned int index;
+    bfdev_atomic_t total;
+    bool failed;
+};
+
+static bfdev_percpu_counter_t counter;
+static bfdev_percpu_refcnt_t refcnt;
+static bfdev_atomic_t running;
+static bfdev_atomic_t released;
+
+static void *
+test_counter_worker(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    bfdev_prandom_t rand;
+    bfdev_atomic_t value;
+    unsigned int count;
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < TEST_LOOP; ++count) {
+        value = bfdev_prandom_value(&rand) % 16;
+        if (count & 1) {
+            bfdev_percpu_counter_sub(&counter, worker->index, value);
+            worker->total -= value;
+        } else {
+            bfdev_percpu_counter_add(&counter, worker->index, value);
+            worker->total += value;
+        }
+    }
+
+    bfdev_atomic_sub(&running, 1);
+    return NULL;
+}
+
+static void *
+test_refcnt_worker(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    unsigned int count;
+
+    /* the reference every worker keeps across the kill */
+    bfdev_percpu_refcnt_get(&refcnt, worker->index);
+    bfdev_atomic_sub(&running, 1);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        if (!bfdev_percpu_refcnt_tryget(&refcnt, worker->index)) {
+            worker->failed = true;
+            break;
+        }
+
+        if (count & 1)
+            bfdev_percpu_refcnt_get(&refcnt, worker->index);
+        if (count & 1 && bfdev_percpu_refcnt_put(&refcnt, worker->index))
+            worker->failed = true;
+
+        if (bfdev_percpu_refcnt_put(&refcnt, worker->index))
+            worker->failed = true;
+    }
+
+    if (bfdev_percpu_refcnt_put(&refcnt, worker->index))
+        bfdev_atomic_add(&released, 1);
+
+    return NULL;
+}
+
+TESTSUITE(
+    "percpu:counter", NULL, NULL,
+    "per-cpu counter sum and reset"
+) {
+    struct test_worker workers[TEST_THREADS];
+    bfdev_atomic_t expect, collected;
+    unsigned int index;
+    int retval;
+
+    retval = bfdev_percpu_counter_alloc(&counter, NULL, TEST_SLOTS);
+    if (retval)
+        return retval;
+
+    /* indexes beyond the slots fold back onto them */
+    bfdev_percpu_counter_add(&counter, 0, 10);
+    bfdev_percpu_counter_add(&counter, 5, 7);
+    bfdev_percpu_counter_dec(&counter, 1000);
+    bfdev_percpu_counter_inc(&counter, 3);
+    if (bfdev_percpu_counter_sum(&counter) != 17 ||
+        bfdev_percpu_counter_reset(&counter) != 17 ||
+        bfdev_percpu_counter_sum(&counter) != 0) {
+        retval = -BFDEV_EFAULT;
+        goto finish;
+    }
+
+    /* resets racing with updates lose nothing */
+    bfdev_atomic_write(&running, TEST_THREADS);
+    for (index = 0; index < TEST_THREADS; ++index) {
+        workers[index].index = index;
+        workers[index].total = 0;
+        pthread_create(&workers[index].tid, NULL,
+                       test_counter_worker, &workers[index]);
+    }
+
+    collected = 0;
+    while (bfdev_atomic_read(&running)) {
+        collected += bfdev_percpu_counter_reset(&counter);
+        sched_yield();
+    }
+
+    expect = 0;
+    for (index = 0; index < TEST_THREADS; ++index) {
+        pthread_join(workers[index].tid, NULL);
+        expect += workers[index].total;
+    }
+
+    collected += bfdev_percpu_counter_sum(&counter);
+    if (collected != expect)
+        retval = -BFDEV_EFAULT;
+
+finish:
+    bfdev_percpu_counter_free(&counter);
+    return retval;
+}
+
+TESTSUITE(
+    "percpu:refcnt", NULL, NULL,
+    "per-cpu refcount kill and release"
+) {
+    int retval;
+
+    retval = bfdev_percpu_refcnt_alloc(&refcnt, NULL, TEST_SLOTS);
+    if (retval)
+        return retval;
+
+    /* gets and puts may land on different slots */
+    bfdev_percpu_refcnt_get(&refcnt, 0);
+    bfdev_percpu_refcnt_get(&refcnt, 1);
+    if (bfdev_percpu_refcnt_put(&refcnt, 2) ||
+        bfdev_percpu_refcnt_check_dead(&refcnt))
+        goto failed;
+
+    /* one reference is left after the initial one is dropped */
+    if (bfdev_percpu_refcnt_kill(&refcnt) ||
+        !bfdev_percpu_refcnt_check_dead(&refcnt) ||
+        bfdev_percpu_refcnt_tryget_live(&refcnt, 0))
+        goto failed;
+
+    /* a failed tryget_live leaves the count alone */
+    if (!bfdev_percpu_refcnt_tryget(&refcnt, 1) ||
+        bfdev_percpu_refcnt_put(&refcnt, 3) ||
+        !bfdev_percpu_refcnt_put(&refcnt, 2) ||
+        bfdev_percpu_refcnt_tryget(&refcnt, 0))
+        goto failed;
+
+    bfdev_percpu_refcnt_reinit(&refcnt);
+    if (bfdev_percpu_refcnt_check_dead(&refcnt) ||
+        !bfdev_percpu_refcnt_kill(&refcnt))
+        goto failed;
+
+    bfdev_percpu_refcnt_free(&refcnt);
+    return -BFDEV_ENOERR;
+
+failed:
+    bfdev_percpu_refcnt_free(&refcnt);
+    return -BFDEV_EFAULT;
+}
+
+TESTSUITE(
+    "percpu:refcnt_kill", NULL, NULL,
+    "per-cpu refcount killed while in use"
+) {
+    struct test_worker workers[TEST_THREADS];
+    unsigned int index;
+    int retval;
+
+    retval = bfdev_percpu_refcnt_alloc(&refcnt, NULL, TEST_SLOTS);
+    if (retval)
+        return retval;
+
+    bfdev_atomic_write(&running, TEST_THREADS);
+    bfdev_atomic_write(&released, 0);
+
+    for (index = 0; index < TEST_THREADS; ++index) {
+        workers[index].index = index;
+        workers[index].failed = false;
+        pthread_create(&workers[index].tid, NULL,
+                       test_refcnt_worker, &workers[index]);
+    }
+
+    /* kill once every worker holds its reference */
+    while (bfdev_atomic_read(&running))
+        sched_yield();
+    if (bfdev_percpu_refcnt_kill(&refcnt))
+        retval = -BFDEV_EFAULT;
+
+    for (index = 0; index < TEST_THREADS; ++index) {
+        pthread_join(workers[index].tid, NULL);
+        if (workers[index].failed)
+            retval = -BFDEV_EFAULT;
+    }
+
+    /* exactly one put has seen the last reference go */
+    if (bfdev_atomic_read(&released) != 1 ||
+        bfdev_percpu_refcnt_tryget(&refcnt, 0))
+        retval = -BFDEV_EFAULT;
+
+    bfdev_percpu_refcnt_free(&refcnt);
+    return retval;
+}
@@ -0,0 +1,306 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "percpu-stat"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <pthread.h>
+#include <bfdev/percpu.h>
+#include <bfdev/cache.h>
+#include <bfdev/hashmap.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_SLOTS 4
+#define TEST_THREADS 4
+#define TEST_KEYS 64
+#define TEST_LOOP 20000
+#define TEST_CACHE 16
+
+struct test_node {
+    bfdev_hlist_node_t node;
+    unsigned long value;
+};
+
+struct test_worker {
+    pthread_t tid;
+    unsigned int index;
+    bfdev_cache_head_t *cache;
+    unsigned long hits;
+    bool failed;
+};
+
+#define node_to_test(ptr) \
+    bfdev_container_of(ptr, struct test_node, node)
+
+static bfdev_percpu_counter_t hits;
+static bfdev_percpu_counter_t misses;
+static bfdev_hashmap_t hashmap;
+
+static unsigned long
+test_hash_key(const void *key, void *pdata)
+{
+    return (unsigned long)(uintptr_t)key;
+}
+
+static unsigned long
+test_hash_node(const bfdev_hlist_node_t *node, void *pdata)
+{
+    return node_to_test(node)->value;
+}
+
+static long
+test_equal(const bfdev_hlist_node_t *node1,
+           const bfdev_hlist_node_t *node2, void *pdata)
+{
+    return node_to_test(node1)->value != node_to_test(node2)->value;
+}
+
+static long
+test_find(const bfdev_hlist_node_t *node, const void *key, void *pdata)
+{
+    return node_to_test(node)->value != (unsigned long)(uintptr_t)key;
+}
+
+static const bfdev_hashmap_ops_t
+test_hashmap_ops = {
+    .hash_key = test_hash_key,
+    .hash_node = test_hash_node,
+    .equal = test_equal,
+    .find = test_find,
+};
+
+static unsigned long
+test_cache_hash(const void *tag, void *pdata)
+{
+    return (unsigned long)(uintptr_t)tag;
+}
+
+static long
+test_cache_find(const void *node, const void *tag, void *pdata)
+{
+    return node != tag;
+}
+
+static const bfdev_cache_ops_t
+test_cache_ops = {
+    .hash = test_cache_hash,
+    .find = test_cache_find,
+};
+
+static void *
+test_hashmap_worker(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    bfdev_hlist_node_t *node;
+    bfdev_prandom_t rand;
+    unsigned long value;
+    unsigned int count;
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < TEST_LOOP; ++count) {
+        value = bfdev_prandom_value(&rand) % (TEST_KEYS * 2);
+        node = bfdev_hashmap_find_cpu(&hashmap, (void *)(uintptr_t)value,
+                                      worker->index);
+
+        /* only even keys are inserted */
+        if (!!node == !!(value & 1)) {
+            worker->failed = true;
+            break;
+        }
+
+        if (node)
+            worker->hits++;
+    }
+
+    return NULL;
+}
+
+static void *
+test_cache_worker(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    bfdev_cache_node_t *node;
+    bfdev_prandom_t rand;
+    unsigned long value;
+    unsigned int count;
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < TEST_LOOP; ++count) {
+        value = bfdev_prandom_value(&rand) % TEST_KEYS;
+        node = bfdev_cache_get(worker->cache, (void *)(uintptr_t)value);
+        if (!node) {
+            worker->failed = true;
+            break;
+        }
+
+        if (node->status == BFDEV_CACHE_PENDING)
+            bfdev_cache_committed(worker->cache);
+
+        bfdev_cache_put(worker->cache, node);
+    }
+
+    return NULL;
+}
+
+static int
+test_counter_check(const char *name, unsigned long expect_hits,
+                   unsigned long expect_misses)
+{
+    bfdev_atomic_t value;
+
+    value = bfdev_percpu_counter_sum(&hits);
+    if (value != (bfdev_atomic_t)expect_hits) {
+        bfdev_log_err("%s: hits %ld expect %lu\n",
+                      name, (long)value, expect_hits);
+        return -BFDEV_EFAULT;
+    }
+
+    value = bfdev_percpu_counter_sum(&misses);
+    if (value != (bfdev_atomic_t)expect_misses) {
+        bfdev_log_err("%s: misses %ld expect %lu\n",
+                      name, (long)value, expect_misses);
+        return -BFDEV_EFAULT;
+    }
+
+    bfdev_log_info("%s: hits %lu misses %lu\n",
+                   name, expect_hits, expect_misses);
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_counter_alloc(void)
+{
+    int retval;
+
+    retval = bfdev_percpu_counter_alloc(&hits, NULL, TEST_SLOTS);
+    if (retval)
+        return retval;
+
+    retval = bfdev_percpu_counter_alloc(&misses, NULL, TEST_SLOTS);
+    if (retval)
+        bfdev_percpu_counter_free(&hits);
+
+    return retval;
+}
+
+static void
+test_counter_free(void)
+{
+    bfdev_percpu_counter_free(&misses);
+    bfdev_percpu_counter_free(&hits);
+}
+
+TESTSUITE(
+    "percpu:hashmap_stat", NULL, NULL,
+    "hashmap lookups from several readers land in shared counters"
+) {
+    struct test_node nodes[TEST_KEYS];
+    struct test_worker workers[TEST_THREADS];
+    unsigned long total;
+    unsigned int count;
+    int retval;
+
+    retval = test_counter_alloc();
+    if (retval)
+        return retval;
+
+    bfdev_hashmap_init(&hashmap, NULL, &test_hashmap_ops, NULL);
+    for (count = 0; count < TEST_KEYS; ++count) {
+        nodes[count].value = count * 2;
+        retval = bfdev_hashmap_add(&hashmap, &nodes[count].node);
+        if (retval)
+            goto failed;
+    }
+
+    /* inserts must not be accounted */
+    bfdev_hashmap_stat(&hashmap, &hits, &misses);
+    retval = test_counter_check("hashmap insert", 0, 0);
+    if (retval)
+        goto failed;
+
+    for (count = 0; count < TEST_THREADS; ++count) {
+        workers[count].index = count;
+        workers[count].hits = 0;
+        workers[count].failed = false;
+        pthread_create(&workers[count].tid, NULL,
+                       test_hashmap_worker, &workers[count]);
+    }
+
+    total = 0;
+    for (count = 0; count < TEST_THREADS; ++count) {
+        pthread_join(workers[count].tid, NULL);
+        if (workers[count].failed) {
+            bfdev_log_err("hashmap reader %u found a wrong key\n", count);
+            retval = -BFDEV_EFAULT;
+        }
+        total += workers[count].hits;
+    }
+
+    if (!retval)
+        retval = test_counter_check("hashmap", total,
+                                    TEST_THREADS * TEST_LOOP - total);
+
+failed:
+    bfdev_hashmap_release(&hashmap);
+    test_counter_free();
+    return retval;
+}
+
+TESTSUITE(
+    "percpu:cache_stat", NULL, NULL,
+    "per-thread caches account hits and misses to shared counters"
+) {
+    struct test_worker workers[TEST_THREADS];
+    unsigned long total_hits, total_misses;
+    unsigned int count;
+    int retval;
+
+    retval = test_counter_alloc();
+    if (retval)
+        return retval;
+
+    for (count = 0; count < TEST_THREADS; ++count) {
+        workers[count].cache = bfdev_cache_create(
+            count & 1 ? "lfu" : "lru", NULL,
+            &test_cache_ops, TEST_CACHE, 1, NULL
+        );
+        if (!workers[count].cache) {
+            while (count--)
+                bfdev_cache_destroy(workers[count].cache);
+            test_counter_free();
+            return -BFDEV_ENOMEM;
+        }
+
+        workers[count].index = count;
+        workers[count].failed = false;
+        bfdev_cache_stat(workers[count].cache, &hits, &misses, count);
+    }
+
+    for (count = 0; count < TEST_THREADS; ++count)
+        pthread_create(&workers[count].tid, NULL,
+                       test_cache_worker, &workers[count]);
+
+    total_hits = total_misses = 0;
+    for (count = 0; count < TEST_THREADS; ++count) {
+        pthread_join(workers[count].tid, NULL);
+        if (workers[count].failed) {
+            bfdev_log_err("cache worker %u failed to obtain\n", count);
+            retval = -BFDEV_EFAULT;
+        }
+
+        total_hits += workers[count].cache->hits;
+        total_misses += workers[count].cache->misses;
+        bfdev_cache_destroy(workers[count].cache);
+    }
+
+    if (!retval)
+        retval = test_counter_check("cache", total_hits, total_misses);
+
+    test_counter_free();
+    return retval;
+}
@@ -0,0 +1,264 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "segtree-stab"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <string.h>
+#include <bfdev/segtree.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/minmax.h>
+#include <bfdev/prandom.h>
+#include <bfdev/sort.h>
+#include <testsuite.h>
+
+#define TEST_NODES 512
+#define TEST_POINTS 256
+#define TEST_RANGE 4096
+#define TEST_WIDTH 256
+
+struct test_pdata {
+    bfdev_segtree_node_t nodes[TEST_NODES];
+    bfdev_segtree_node_t *sorted[TEST_NODES];
+    bool inserted[TEST_NODES];
+    unsigned long points[TEST_POINTS];
+    bool hits[TEST_NODES][TEST_POINTS];
+};
+
+static long
+test_cmp(const void *key1, const void *key2, void *pdata)
+{
+    const bfdev_segtree_node_t *node1, *node2;
+
+    node1 = *(bfdev_segtree_node_t *const *)key1;
+    node2 = *(bfdev_segtree_node_t *const *)key2;
+
+    if (node1->start == node2->start)
+        return 0;
+
+    return node1->start < node2->start ? -1 : 1;
+}
+
+static long
+test_point_cmp(const void *key1, const void *key2, void *pdata)
+{
+    unsigned long point1, point2;
+
+    point1 = *(const unsigned long *)key1;
+    point2 = *(const unsigned long *)key2;
+
+    if (point1 == point2)
+        return 0;
+
+    return point1 < point2 ? -1 : 1;
+}
+
+/* returns the black height, or -1 if an invariant is broken */
+static int
+test_check_node(bfdev_rb_node_t *rb, bfdev_rb_node_t *parent,
+                unsigned long *count)
+{
+    bfdev_segtree_node_t *node, *child;
+    unsigned long subtree;
+    int left, right;
+
+    if (!rb)
+        return 1;
+
+    node = bfdev_segtree_entry(rb, bfdev_segtree_node_t, node);
+    if (rb->parent != parent)
+        return -1;
+
+    if (parent && parent->color == BFDEV_RB_RED && rb->color == BFDEV_RB_RED)
+        return -1;
+
+    left = test_check_node(rb->left, rb, count);
+    right = test_check_node(rb->right, rb, count);
+    if (left < 0 || left != right)
+        return -1;
+
+    subtree = node->end;
+    if (rb->left) {
+        child = bfdev_segtree_entry(rb->left, bfdev_segtree_node_t, node);
+        if (child->start > node->start)
+            return -1;
+        subtree = bfdev_max(subtree, child->subtree);
+    }
+
+    if (rb->right) {
+        child = bfdev_segtree_entry(rb->right, bfdev_segtree_node_t, node);
+        if (child->start < node->start)
+            return -1;
+        subtree = bfdev_max(subtree, child->subtree);
+    }
+
+    if (node->subtree != subtree)
+        return -1;
+
+    ++*count;
+    return left + (rb->color == BFDEV_RB_BLACK);
+}
+
+static int
+test_check(bfdev_rb_root_cached_t *root, unsigned long expect)
+{
+    bfdev_rb_node_t *rb, *first;
+    unsigned long count;
+
+    rb = root->root.node;
+    if (rb && rb->color != BFDEV_RB_BLACK) {
+        bfdev_log_err("red root\n");
+        return -BFDEV_EFAULT;
+    }
+
+    count = 0;
+    if (test_check_node(rb, NULL, &count) < 0 || count != expect) {
+        bfdev_log_err("broken tree, %lu of %lu nodes\n", count, expect);
+        return -BFDEV_EFAULT;
+    }
+
+    for (first = rb; first && first->left; first = first->left);
+    if (root->leftmost != first) {
+        bfdev_log_err("stale leftmost\n");
+        return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_stab_hit(bfdev_segtree_node_t *node, size_t index, void *pdata)
+{
+    struct test_pdata *test = pdata;
+    bool *hit;
+
+    hit = &test->hits[node - test->nodes][index];
+    if (*hit)
+        return -BFDEV_EALREADY;
+
+    *hit = true;
+    return 0;
+}
+
+static int
+test_stab(bfdev_rb_root_cached_t *root, struct test_pdata *test)
+{
+    bfdev_segtree_node_t *node;
+    unsigned int index, point;
+    bool expect;
+    int retval;
+
+    memset(test->hits, 0, sizeof(test->hits));
+    retval = bfdev_segtree_stab(root, test->points, TEST_POINTS,
+                                test_stab_hit, test);
+    if (retval) {
+        bfdev_log_err("pair reported twice\n");
+        return retval;
+    }
+
+    for (index = 0; index < TEST_NODES; ++index) {
+        node = &test->nodes[index];
+        for (point = 0; point < TEST_POINTS; ++point) {
+            expect = test->inserted[index] &&
+                     node->start <= test->points[point] &&
+                     test->points[point] <= node->end;
+            if (test->hits[index][point] != expect) {
+                bfdev_log_err("segment [%lu, %lu] point %lu: %d expect %d\n",
+                              node->start, node->end, test->points[point],
+                              test->hits[index][point], expect);
+                return -BFDEV_EFAULT;
+            }
+        }
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_round(struct test_pdata *test, bfdev_prandom_t *rand, unsigned int count)
+{
+    BFDEV_RB_ROOT_CACHED(root);
+    bfdev_segtree_node_t *node;
+    unsigned int index, live;
+    int retval;
+
+    for (index = 0; index < TEST_NODES; ++index) {
+        node = &test->nodes[index];
+        node->start = bfdev_prandom_value(rand) % TEST_RANGE;
+        node->end = node->start + bfdev_prandom_value(rand) % TEST_WIDTH;
+        test->sorted[index] = node;
+        test->inserted[index] = index < count;
+    }
+
+    for (index = 0; index < TEST_POINTS; ++index)
+        test->points[index] = bfdev_prandom_value(rand) % (TEST_RANGE + TEST_WIDTH);
+
+    bfdev_sort(test->sorted, count, sizeof(*test->sorted), test_cmp, NULL);
+    bfdev_sort(test->points, TEST_POINTS, sizeof(*test->points),
+               test_point_cmp, NULL);
+
+    bfdev_segtree_build(&root, test->sorted, count);
+    retval = test_check(&root, count);
+    if (retval)
+        return retval;
+
+    retval = test_stab(&root, test);
+    if (retval)
+        return retval;
+
+    /* a built tree must keep working with the regular updates */
+    live = count;
+    for (index = 0; index < TEST_NODES; ++index) {
+        node = &test->nodes[index];
+        if (!test->inserted[index]) {
+            bfdev_segtree_insert(&root, node);
+            live++;
+        } else if (index % 2) {
+            bfdev_segtree_delete(&root, node);
+            live--;
+        }
+        test->inserted[index] = !test->inserted[index] || !(index % 2);
+    }
+
+    retval = test_check(&root, live);
+    if (retval)
+        return retval;
+
+    return test_stab(&root, test);
+}
+
+TESTSUITE(
+    "segtree:stab", NULL, NULL,
+    "segtree batch stab and bulk build against brute force"
+) {
+    /* cover empty, tiny, complete and partial last levels */
+    static const unsigned int counts[] = {
+        0, 1, 2, 3, 5, 12, 63, 100, 300, 511, TEST_NODES,
+    };
+    struct test_pdata *test;
+    bfdev_prandom_t rand;
+    unsigned int index;
+    int retval;
+
+    test = malloc(sizeof(*test));
+    if (!test)
+        return -BFDEV_ENOMEM;
+
+    retval = -BFDEV_ENOERR;
+    bfdev_prandom_seed(&rand, 0);
+
+    for (index = 0; index < BFDEV_ARRAY_SIZE(counts); ++index) {
+        retval = test_round(test, &rand, counts[index]);
+        if (retval) {
+            bfdev_log_err("failed building %u nodes\n", counts[index]);
+            break;
+        }
+    }
+
+    free(test);
+    return retval;
+}
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "skiplist-fskiplist"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <string.h>
+#include <bfdev/fskiplist.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+/* keys start at one, a NULL key reads as not found */
+#define TEST_KEYS 1024
+#define TEST_LOOP 65536
+#define TEST_LEVELS 16
+
+static long
+test_cmp(const void *key1, const void *key2, void *pdata)
+{
+    uintptr_t value1, value2;
+
+    value1 = (uintptr_t)key1;
+    value2 = (uintptr_t)key2;
+
+    if (value1 == value2)
+        return 0;
+
+    return value1 < value2 ? -1 : 1;
+}
+
+static uintptr_t
+test_exact(const void *key, void *pdata)
+{
+    return (uintptr_t)key;
+}
+
+/* coarse prefix, ties must fall back to the callback */
+static uintptr_t
+test_coarse(const void *key, void *pdata)
+{
+    return (uintptr_t)key >> 4;
+}
+
+static const bfdev_fskip_ops_t
+test_ops[] = {
+    { .cmp = test_cmp },
+    { .cmp = test_cmp, .prefix = test_exact },
+    { .cmp = test_cmp, .prefix = test_coarse },
+};
+
+static int
+test_verify(bfdev_fskip_head_t *head, const unsigned int *model)
+{
+    unsigned int counts[TEST_KEYS + 1];
+    bfdev_fskip_node_t *node;
+    unsigned long total;
+    uintptr_t last;
+
+    memset(counts, 0, sizeof(counts));
+    total = last = 0;
+
+    bfdev_fskiplist_for_each(node, head) {
+        if ((uintptr_t)node->key < last) {
+            bfdev_log_err("iteration out of order\n");
+            return -BFDEV_EFAULT;
+        }
+
+        last = (uintptr_t)node->key;
+        counts[last]++;
+        total++;
+    }
+
+    if (total != head->count || memcmp(counts, model, sizeof(counts))) {
+        bfdev_log_err("content differs from model\n");
+        return -BFDEV_EFAULT;
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+static int
+test_one(const bfdev_fskip_ops_t *ops, bool finger, uint64_t seed)
+{
+    unsigned int model[TEST_KEYS + 1];
+    bfdev_fskip_head_t *head;
+    bfdev_fskip_node_t *node;
+    bfdev_prandom_t rand;
+    unsigned long count;
+    uintptr_t key;
+    void *found;
+    int retval;
+
+    head = bfdev_fskiplist_create(NULL, ops, TEST_LEVELS, finger, NULL);
+    if (!head)
+        return -BFDEV_ENOMEM;
+
+    memset(model, 0, sizeof(model));
+    bfdev_prandom_seed(&rand, seed);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        key = bfdev_prandom_value(&rand) % TEST_KEYS + 1;
+
+        /* runs of nearby keys exercise the finger */
+        if (count & 0x100)
+            key = (count >> 1) % TEST_KEYS + 1;
+
+        switch (bfdev_prandom_value(&rand) % 3) {
+            case 0:
+                retval = bfdev_fskiplist_insert(head, (void *)key);
+                if (retval)
+                    goto failed;
+                model[key]++;
+                break;
+
+            case 1:
+                found = bfdev_fskiplist_delete(head, (void *)key);
+                if (!found != !model[key] || (found && (uintptr_t)found != key))
+                    goto mismatch;
+                if (found)
+                    model[key]--;
+                break;
+
+            default:
+                node = bfdev_fskiplist_find(head, (void *)key);
+                if (!node != !model[key] || (node && (uintptr_t)node->key != key))
+                    goto mismatch;
+                break;
+        }
+    }
+
+    retval = test_verify(head, model);
+    if (retval)
+        goto failed;
+
+    /* the recycled arena must serve a second round */
+    bfdev_fskiplist_reset(head, NULL, NULL);
+    memset(model, 0, sizeof(model));
+
+    for (count = 0; count < TEST_KEYS; ++count) {
+        key = TEST_KEYS - count;
+        retval = bfdev_fskiplist_insert(head, (void *)key);
+        if (retval)
+            goto failed;
+        model[key]++;
+    }
+
+    retval = test_verify(head, model);
+    goto failed;
+
+mismatch:
+    bfdev_log_err("operation %lu on key %lu differs from model\n",
+                  count, (unsigned long)key);
+    retval = -BFDEV_EFAULT;
+
+failed:
+    bfdev_fskiplist_destroy(head, NULL, NULL);
+    return retval;
+}
+
+TESTSUITE(
+    "skiplist:fskiplist", NULL, NULL,
+    "forward skiplist against a counting model"
+) {
+    unsigned int index;
+    int retval;
+
+    for (index = 0; index < BFDEV_ARRAY_SIZE(test_ops) * 2; ++index) {
+        retval = test_one(&test_ops[index / 2], index % 2, index);
+        if (retval) {
+            bfdev_log_err("failed with ops %u finger %u\n",
+                          index / 2, index % 2);
+            return retval;
+        }
+    }
+
+    return -BFDEV_ENOERR;
+}
@@ -0,0 +1,377 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "skiplist-lfskiplist"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <bfdev/lfskiplist.h>
+#include <bfdev/log.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_THREADS 8
+#define TEST_LOOP 100000
+#define TEST_LEVELS 16
+
+/* few shared keys keep insert and delete of one key racing */
+#define TEST_SHARED 32
+#define TEST_PRIVATE 256
+
+#define TEST_KEYS (TEST_SHARED + TEST_THREADS * TEST_PRIVATE)
+
+#define TEST_RELEASE_WRITERS 2
+#define TEST_RELEASE_READERS 4
+#define TEST_RELEASE_KEYS 64
+
+struct test_worker {
+    pthread_t tid;
+    unsigned int index;
+    bool failed;
+};
+
+static bfdev_lfskip_head_t *lfskip;
+static bfdev_atomic_t inserted[TEST_KEYS + 1];
+static bfdev_atomic_t deleted[TEST_KEYS + 1];
+
+static long
+test_cmp(const void *key1, const void *key2, void *pdata)
+{
+    uintptr_t value1, value2;
+
+    value1 = (uintptr_t)key1;
+    value2 = (uintptr_t)key2;
+
+    if (value1 == value2)
+        return 0;
+
+    return value1 < value2 ? -1 : 1;
+}
+
+static void *
+test_worker(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    bool owned[TEST_PRIVATE] = {};
+    bfdev_lfskip_thread_t *thread;
+    bfdev_prandom_t rand;
+    unsigned long count;
+    unsigned int index, op;
+    uintptr_t key, base;
+    void *found;
+    int retval;
+
+    thread = bfdev_lfskiplist_attach(lfskip);
+    if (!thread) {
+        worker->failed = true;
+        return NULL;
+    }
+
+    base = TEST_SHARED + worker->index * TEST_PRIVATE + 1;
+    bfdev_prandom_seed(&rand, worker->index + 1);
+
+    for (count = 0; count < TEST_LOOP && !worker->failed; ++count) {
+        index = bfdev_prandom_value(&rand);
+
+        if (index & 1) {
+            key = (index >> 1) % TEST_SHARED + 1;
+            if (index & 2) {
+                retval = bfdev_lfskiplist_insert(lfskip, thread, (void *)key);
+                if (!retval)
+                    bfdev_atomic_add(&inserted[key], 1);
+                else if (retval != -BFDEV_EEXIST)
+                    worker->failed = true;
+            } else {
+                retval = bfdev_lfskiplist_delete(lfskip, thread, (void *)key);
+                if (!retval)
+                    bfdev_atomic_add(&deleted[key], 1);
+                else if (retval != -BFDEV_ENOENT)
+                    worker->failed = true;
+            }
+            continue;
+        }
+
+        /* keys private to this thread must follow its own model */
+        op = (index >> 1) % 3;
+        index = (index >> 3) % TEST_PRIVATE;
+        key = base + index;
+
+        switch (op) {
+            case 0:
+                retval = bfdev_lfskiplist_insert(lfskip, thread, (void *)key);
+                if (retval != (owned[index] ? -BFDEV_EEXIST : -BFDEV_ENOERR))
+                    worker->failed = true;
+                owned[index] = true;
+                break;
+
+            case 1:
+                retval = bfdev_lfskiplist_delete(lfskip, thread, (void *)key);
+                if (retval != (owned[index] ? -BFDEV_ENOERR : -BFDEV_ENOENT))
+                    worker->failed = true;
+                owned[index] = false;
+                break;
+
+            default:
+                found = bfdev_lfskiplist_find(lfskip, thread, (void *)key);
+                if ((uintptr_t)found != (owned[index] ? key : 0))
+                    worker->failed = true;
+                break;
+        }
+    }
+
+    for (index = 0; index < TEST_PRIVATE; ++index)
+        inserted[base + index] = owned[index];
+
+    bfdev_lfskiplist_detach(lfskip, thread);
+    return NULL;
+}
+
+static int
+test_verify(void)
+{
+    bool present[TEST_KEYS + 1] = {};
+    bfdev_lfskip_thread_t *thread;
+    bfdev_lfskip_node_t *node;
+    uintptr_t key, last;
+    long balance;
+    int retval;
+
+    thread = bfdev_lfskiplist_attach(lfskip);
+    if (!thread)
+        return -BFDEV_ENOMEM;
+
+    last = 0;
+    retval = -BFDEV_ENOERR;
+    bfdev_lfskiplist_enter(lfskip, thread);
+
+    bfdev_lfskiplist_for_each(node, lfskip) {
+        key = (uintptr_t)node->key;
+        if (key <= last || key > TEST_KEYS) {
+            bfdev_log_err("iteration out of order at %lu\n", (unsigned long)key);
+            retval = -BFDEV_EFAULT;
+            break;
+        }
+
+        present[key] = true;
+        last = key;
+    }
+
+    bfdev_lfskiplist_leave(lfskip, thread);
+    bfdev_lfskiplist_detach(lfskip, thread);
+
+    for (key = 1; key <= TEST_KEYS; ++key) {
+        balance = (long)inserted[key] - (long)deleted[key];
+        if (balance != present[key]) {
+            bfdev_log_err("key %lu: %ld inserted %ld deleted, present %d\n",
+                          (unsigned long)key, (long)inserted[key],
+                          (long)deleted[key], present[key]);
+            retval = -BFDEV_EFAULT;
+        }
+    }
+
+    return retval;
+}
+
+TESTSUITE(
+    "skiplist:lfskiplist", NULL, NULL,
+    "lock-free skiplist concurrent insert and delete test"
+) {
+    struct test_worker workers[TEST_THREADS];
+    unsigned int count;
+    int retval;
+
+    lfskip = bfdev_lfskiplist_create(NULL, TEST_LEVELS, test_cmp, NULL, NULL);
+    if (!lfskip)
+        return -BFDEV_ENOMEM;
+
+    for (count = 0; count <= TEST_KEYS; ++count) {
+        inserted[count] = 0;
+        deleted[count] = 0;
+    }
+
+    for (count = 0; count < TEST_THREADS; ++count) {
+        workers[count] = (struct test_worker) {.index = count};
+        pthread_create(&workers[count].tid, NULL, test_worker, &workers[count]);
+    }
+
+    retval = -BFDEV_ENOERR;
+    for (count = 0; count < TEST_THREADS; ++count) {
+        pthread_join(workers[count].tid, NULL);
+        if (workers[count].failed) {
+            bfdev_log_err("worker %u failed\n", count);
+            retval = -BFDEV_EFAULT;
+        }
+    }
+
+    if (!retval)
+        retval = test_verify();
+
+    bfdev_lfskiplist_destroy(lfskip);
+    return retval;
+}
+
+struct test_key {
+    uintptr_t value;
+    bfdev_atomic_t live;
+};
+
+static bfdev_atomic_t test_inserted;
+static bfdev_atomic_t test_released;
+static bfdev_atomic_t test_stop;
+
+static long
+test_key_cmp(const void *key1, const void *key2, void *pdata)
+{
+    const struct test_key *tkey1 = key1, *tkey2 = key2;
+
+    return test_cmp((void *)tkey1->value, (void *)tkey2->value, pdata);
+}
+
+/* poison before freeing, so a reader still holding the key notices */
+static void
+test_key_release(void *key, void *pdata)
+{
+    struct test_key *tkey = key;
+
+    bfdev_atomic_write(&tkey->live, 0);
+    bfdev_atomic_add(&test_released, 1);
+    free(tkey);
+}
+
+static void *
+test_writer(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    bfdev_lfskip_thread_t *thread;
+    struct test_key *tkey, probe;
+    bfdev_prandom_t rand;
+    unsigned long count;
+    int retval;
+
+    thread = bfdev_lfskiplist_attach(lfskip);
+    if (!thread) {
+        worker->failed = true;
+        return NULL;
+    }
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    for (count = 0; count < TEST_LOOP; ++count) {
+        tkey = malloc(sizeof(*tkey));
+        if (!tkey) {
+            worker->failed = true;
+            break;
+        }
+
+        tkey->value = bfdev_prandom_value(&rand) % TEST_RELEASE_KEYS;
+        tkey->live = 1;
+
+        retval = bfdev_lfskiplist_insert(lfskip, thread, tkey);
+        if (!retval)
+            bfdev_atomic_add(&test_inserted, 1);
+        else {
+            /* a rejected key stays with the caller */
+            free(tkey);
+            if (retval != -BFDEV_EEXIST)
+                worker->failed = true;
+        }
+
+        probe.value = bfdev_prandom_value(&rand) % TEST_RELEASE_KEYS;
+        retval = bfdev_lfskiplist_delete(lfskip, thread, &probe);
+        if (retval && retval != -BFDEV_ENOENT)
+            worker->failed = true;
+    }
+
+    bfdev_lfskiplist_detach(lfskip, thread);
+    return NULL;
+}
+
+static void *
+test_reader(void *pdata)
+{
+    struct test_worker *worker = pdata;
+    bfdev_lfskip_thread_t *thread;
+    struct test_key *found, probe;
+    bfdev_prandom_t rand;
+
+    thread = bfdev_lfskiplist_attach(lfskip);
+    if (!thread) {
+        worker->failed = true;
+        return NULL;
+    }
+
+    bfdev_prandom_seed(&rand, worker->index + 1);
+    while (!bfdev_atomic_read(&test_stop)) {
+        probe.value = bfdev_prandom_value(&rand) % TEST_RELEASE_KEYS;
+
+        /* the found key may be used until the section is left */
+        bfdev_lfskiplist_enter(lfskip, thread);
+        found = bfdev_lfskiplist_find(lfskip, thread, &probe);
+        if (found && (!bfdev_atomic_read(&found->live) ||
+                      found->value != probe.value))
+            worker->failed = true;
+        bfdev_lfskiplist_leave(lfskip, thread);
+    }
+
+    bfdev_lfskiplist_detach(lfskip, thread);
+    return NULL;
+}
+
+TESTSUITE(
+    "skiplist:lfskiplist_release", NULL, NULL,
+    "lock-free skiplist releases keys only after readers are done"
+) {
+    struct test_worker writers[TEST_RELEASE_WRITERS];
+    struct test_worker readers[TEST_RELEASE_READERS];
+    unsigned int count;
+    int retval;
+
+    lfskip = bfdev_lfskiplist_create(NULL, TEST_LEVELS, test_key_cmp,
+                                     test_key_release, NULL);
+    if (!lfskip)
+        return -BFDEV_ENOMEM;
+
+    test_inserted = 0;
+    test_released = 0;
+    test_stop = 0;
+
+    for (count = 0; count < TEST_RELEASE_READERS; ++count) {
+        readers[count] = (struct test_worker) {.index = count};
+        pthread_create(&readers[count].tid, NULL, test_reader, &readers[count]);
+    }
+
+    for (count = 0; count < TEST_RELEASE_WRITERS; ++count) {
+        writers[count] = (struct test_worker) {.index = count + 100};
+        pthread_create(&writers[count].tid, NULL, test_writer, &writers[count]);
+    }
+
+    retval = -BFDEV_ENOERR;
+    for (count = 0; count < TEST_RELEASE_WRITERS; ++count) {
+        pthread_join(writers[count].tid, NULL);
+        if (writers[count].failed) {
+            bfdev_log_err("writer %u failed\n", count);
+            retval = -BFDEV_EFAULT;
+        }
+    }
+
+    bfdev_atomic_write(&test_stop, 1);
+    for (count = 0; count < TEST_RELEASE_READERS; ++count) {
+        pthread_join(readers[count].tid, NULL);
+        if (readers[count].failed) {
+            bfdev_log_err("reader %u saw a released key\n", count);
+            retval = -BFDEV_EFAULT;
+        }
+    }
+
+    /* every inserted key is released exactly once, deleted or not */
+    bfdev_lfskiplist_destroy(lfskip);
+    if (test_released != test_inserted) {
+        bfdev_log_err("%ld keys inserted, %ld released\n",
+                      (long)test_inserted, (long)test_released);
+        retval = -BFDEV_EFAULT;
+    }
+
+    return retval;
+}
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "timewheel-selftest"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdlib.h>
+#include <bfdev/timewheel.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/prandom.h>
+#include <testsuite.h>
+
+#define TEST_LOOP 4096
+#define TEST_SPAN (1UL << 20)
+
+struct test_timer {
+    bfdev_timewheel_node_t node;
+    bool armed;
+    bool wrong;
+};
+
+#define timewheel_to_test(ptr) \
+    bfdev_timewheel_entry(ptr, struct test_timer, node)
+
+static void
+test_fire(bfdev_timewheel_node_t *node, void *pdata)
+{
+    struct test_timer *timer;
+
+    timer = timewheel_to_test(node);
+
+    /* fired twice, or before its time */
+    if (!timer->armed || bfdev_time_after(node->expires, *(bfdev_time_t *)pdata))
+        timer->wrong = true;
+
+    timer->armed = false;
+}
+
+TESTSUITE(
+    "timewheel:expire", NULL, NULL,
+    "timewheel expiry order test"
+) {
+    struct test_timer *timers, *timer;
+    bfdev_timewheel_t wheel;
+    bfdev_prandom_t rand;
+    bfdev_time_t now;
+    unsigned long count, fired;
+    int retval;
+
+    timers = malloc(sizeof(*timers) * TEST_LOOP);
+    if (!timers)
+        return -BFDEV_ENOMEM;
+
+    bfdev_prandom_seed(&rand, 0);
+    bfdev_timewheel_init(&wheel, 1000);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        timer = &timers[count];
+        bfdev_timewheel_node_init(&timer->node);
+        timer->armed = true;
+        timer->wrong = false;
+        bfdev_timewheel_add(&wheel, &timer->node,
+            1000 + bfdev_prandom_value(&rand) % TEST_SPAN);
+    }
+
+    /* cancel and move some before the clock runs */
+    for (count = 0; count < TEST_LOOP; count += 7) {
+        timer = &timers[count];
+        if (count % 2) {
+            bfdev_timewheel_del(&wheel, &timer->node);
+            timer->armed = false;
+        } else {
+            bfdev_timewheel_mod(&wheel, &timer->node,
+                1000 + bfdev_prandom_value(&rand) % TEST_SPAN);
+        }
+    }
+
+    retval = -BFDEV_EFAULT;
+    for (now = 1000, fired = 0; bfdev_timewheel_count(&wheel); ) {
+        now += bfdev_prandom_value(&rand) % 4096;
+        fired += bfdev_timewheel_run(&wheel, now, test_fire, &now);
+
+        for (count = 0; count < TEST_LOOP; ++count) {
+            timer = &timers[count];
+
+            /* due timers must fire on the first advance past them */
+            if (timer->armed && !bfdev_time_after(timer->node.expires, now)) {
+                bfdev_log_err("timer %lu missed\n", count);
+                goto failed;
+            }
+
+            if (timer->wrong) {
+                bfdev_log_err("timer %lu fired wrongly\n", count);
+                goto failed;
+            }
+        }
+    }
+
+    if (bfdev_timewheel_next(&wheel, &now))
+        goto failed;
+
+    for (count = 0; count < TEST_LOOP; count += 7)
+        fired += count % 2;
+
+    if (fired != TEST_LOOP) {
+        bfdev_log_err("fired %lu timers\n", fired);
+        goto failed;
+    }
+
+    retval = -BFDEV_ENOERR;
+
+failed:
+    free(timers);
+    return retval;
+}
+
+TESTSUITE(
+    "timewheel:collected", NULL, NULL,
+    "timewheel del and mod of collected timers"
+) {
+    struct test_timer timers[4];
+    bfdev_timewheel_t wheel;
+    unsigned int count;
+
+    BFDEV_LIST_HEAD(expired);
+
+    bfdev_timewheel_init(&wheel, 0);
+    for (count = 0; count < BFDEV_ARRAY_SIZE(timers); ++count) {
+        bfdev_timewheel_node_init(&timers[count].node);
+        bfdev_timewheel_add(&wheel, &timers[count].node, count + 1);
+    }
+
+    if (bfdev_timewheel_expire(&wheel, 2, &expired) != 2)
+        return -BFDEV_EFAULT;
+
+    if (bfdev_timewheel_count(&wheel) != 2 ||
+        bfdev_timewheel_pending(&timers[0].node) ||
+        !bfdev_timewheel_pending(&timers[2].node))
+        return -BFDEV_EFAULT;
+
+    /* collected timers no longer count against the wheel */
+    if (bfdev_timewheel_del(&wheel, &timers[0].node) ||
+        bfdev_timewheel_count(&wheel) != 2)
+        return -BFDEV_EFAULT;
+
+    bfdev_timewheel_mod(&wheel, &timers[1].node, 10);
+    if (bfdev_timewheel_count(&wheel) != 3 ||
+        bfdev_list_first_entry(&expired, bfdev_timewheel_node_t, list)
+        != &timers[0].node || !bfdev_list_check_end(&expired, &timers[0].node.list))
+        return -BFDEV_EFAULT;
+
+    bfdev_list_del_init(&timers[0].node.list);
+    if (!bfdev_timewheel_del(&wheel, &timers[2].node) ||
+        bfdev_timewheel_del(&wheel, &timers[2].node))
+        return -BFDEV_EFAULT;
+
+    if (bfdev_timewheel_expire(&wheel, 10, &expired) != 2 ||
+        bfdev_timewheel_count(&wheel))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
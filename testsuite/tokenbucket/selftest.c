@@ -0,0 +1,146 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "tokenbucket-selftest"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <pthread.h>
+#include <bfdev/tokenbucket.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <bfdev/minmax.h>
+#include <testsuite.h>
+
+#define TEST_INTERVAL 10
+#define TEST_THREADS 8
+#define TEST_LOOP 1000
+
+static const unsigned int
+test_capacity[] = {
+    1, 2, 3, 4, 7, 8, 100,
+};
+
+static bfdev_tokenbucket_atomic_t shared;
+static bfdev_atomic_t granted;
+
+static unsigned int
+test_drain(bfdev_tokenbucket_atomic_t *bucket, bfdev_time_t current)
+{
+    unsigned int count;
+
+    for (count = 0; bfdev_tokenbucket_atomic(bucket, current); ++count) {
+        if (count > bucket->capacity)
+            break;
+    }
+
+    return count;
+}
+
+static void *
+test_worker(void *pdata)
+{
+    unsigned int count;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        if (bfdev_tokenbucket_acquire(&shared, 0, 1))
+            bfdev_atomic_add(&granted, 1);
+    }
+
+    return NULL;
+}
+
+TESTSUITE(
+    "tokenbucket:atomic", NULL, NULL,
+    "atomic tokenbucket drain and refill from time zero"
+) {
+    BFDEV_DEFINE_TOKENBUCKET_ATOMIC(bucket, TEST_INTERVAL, 0);
+    unsigned int index, capacity;
+
+    for (index = 0; index < BFDEV_ARRAY_SIZE(test_capacity); ++index) {
+        capacity = test_capacity[index];
+        bfdev_tokenbucket_atomic_init(&bucket, TEST_INTERVAL, capacity);
+
+        /* a drained bucket at time zero must not look fresh */
+        if (test_drain(&bucket, 0) != capacity ||
+            test_drain(&bucket, TEST_INTERVAL - 1) != 0)
+            return -BFDEV_EFAULT;
+
+        /* one token per interval */
+        if (test_drain(&bucket, TEST_INTERVAL) != 1 ||
+            test_drain(&bucket, TEST_INTERVAL * 3) != bfdev_min(capacity, 2))
+            return -BFDEV_EFAULT;
+
+        /* refill stops at the capacity */
+        if (test_drain(&bucket, TEST_INTERVAL * 1000) != capacity)
+            return -BFDEV_EFAULT;
+
+        bfdev_tokenbucket_atomic_reset(&bucket);
+        if (test_drain(&bucket, TEST_INTERVAL * 1000) != capacity)
+            return -BFDEV_EFAULT;
+    }
+
+    /* bulk requests are all or nothing */
+    bfdev_tokenbucket_atomic_init(&bucket, TEST_INTERVAL, 4);
+    if (!bfdev_tokenbucket_acquire(&bucket, 0, 3) ||
+        bfdev_tokenbucket_acquire(&bucket, 0, 2) ||
+        !bfdev_tokenbucket_acquire(&bucket, 0, 1) ||
+        bfdev_tokenbucket_acquire(&bucket, 0, 1) ||
+        bfdev_tokenbucket_acquire(&bucket, TEST_INTERVAL * 100, 5) ||
+        !bfdev_tokenbucket_acquire(&bucket, TEST_INTERVAL * 100, 4) ||
+        !bfdev_tokenbucket_acquire(&bucket, TEST_INTERVAL * 100, 0))
+        return -BFDEV_EFAULT;
+
+    /* no interval never limits */
+    bfdev_tokenbucket_atomic_init(&bucket, 0, 0);
+    if (!bfdev_tokenbucket_atomic(&bucket, 0))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "tokenbucket:contention", NULL, NULL,
+    "atomic tokenbucket hands out exactly its capacity"
+) {
+    pthread_t threads[TEST_THREADS];
+    unsigned int index;
+
+    bfdev_tokenbucket_atomic_init(&shared, TEST_INTERVAL, 100);
+    bfdev_atomic_write(&granted, 0);
+
+    for (index = 0; index < TEST_THREADS; ++index)
+        pthread_create(&threads[index], NULL, test_worker, NULL);
+    for (index = 0; index < TEST_THREADS; ++index)
+        pthread_join(threads[index], NULL);
+
+    if (bfdev_atomic_read(&granted) != 100)
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "tokenbucket:gcra", NULL, NULL,
+    "gcra drain and refill from time zero"
+) {
+    BFDEV_DEFINE_TOKENBUCKET(limit, TEST_INTERVAL, 4);
+    bfdev_atomic_t tat = 0;
+    unsigned int count;
+
+    for (count = 0; count < 4; ++count) {
+        if (!bfdev_tokenbucket_gcra(&limit, &tat, 0, 1))
+            return -BFDEV_EFAULT;
+    }
+
+    if (bfdev_tokenbucket_gcra(&limit, &tat, 0, 1) ||
+        bfdev_tokenbucket_gcra(&limit, &tat, TEST_INTERVAL - 1, 1) ||
+        !bfdev_tokenbucket_gcra(&limit, &tat, TEST_INTERVAL, 1) ||
+        bfdev_tokenbucket_gcra(&limit, &tat, TEST_INTERVAL, 1) ||
+        bfdev_tokenbucket_gcra(&limit, &tat, TEST_INTERVAL * 100, 5) ||
+        !bfdev_tokenbucket_gcra(&limit, &tat, TEST_INTERVAL * 100, 4))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
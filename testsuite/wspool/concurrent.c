@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "wspool-concurrent"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <pthread.h>
+#include <bfdev/wspool.h>
+#include <bfdev/log.h>
+#include <bfdev/macro.h>
+#include <testsuite.h>
+
+#define TEST_THREADS 4
+#define TEST_DEPTH 4
+#define TEST_SIZE 100003
+#define TEST_ROUNDS 3
+
+struct test_helper {
+    pthread_t tid;
+    bfdev_wspool_t *pool;
+    unsigned int index;
+    int retval;
+};
+
+struct test_span {
+    unsigned long begin, end;
+    unsigned long sum;
+    bool broken;
+};
+
+static bfdev_atomic_t marks[TEST_SIZE];
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wait_cond = PTHREAD_COND_INITIALIZER;
+
+static void
+cond_wait(bfdev_atomic_t *event, bfdev_atomic_t value, void *pdata)
+{
+    pthread_mutex_lock(&wait_lock);
+    while (bfdev_atomic_read(event) == value)
+        pthread_cond_wait(&wait_cond, &wait_lock);
+    pthread_mutex_unlock(&wait_lock);
+}
+
+static void
+cond_wake(bfdev_atomic_t *event, void *pdata)
+{
+    pthread_mutex_lock(&wait_lock);
+    pthread_cond_broadcast(&wait_cond);
+    pthread_mutex_unlock(&wait_lock);
+}
+
+static const bfdev_wspool_ops_t
+cond_ops = {
+    .wait = cond_wait,
+    .wake = cond_wake,
+};
+
+static void *
+test_helper(void *pdata)
+{
+    struct test_helper *helper = pdata;
+
+    helper->retval = bfdev_wspool_run(helper->pool, helper->index);
+    return NULL;
+}
+
+static void
+test_mark(unsigned long begin, unsigned long end, void *pdata)
+{
+    for (; begin < end; ++begin)
+        bfdev_atomic_add(&marks[begin], 1);
+}
+
+static void
+test_map(unsigned long begin, unsigned long end, void *result, void *pdata)
+{
+    struct test_span *span = result;
+
+    span->begin = begin;
+    span->end = end;
+    span->broken = false;
+
+    for (span->sum = 0; begin < end; ++begin)
+        span->sum += begin;
+}
+
+/* only adjacent pieces in range order may be combined */
+static void
+test_combine(void *result, const void *other, void *pdata)
+{
+    const struct test_span *next = other;
+    struct test_span *span = result;
+
+    if (span->end != next->begin || next->broken)
+        span->broken = true;
+
+    span->end = next->end;
+    span->sum += next->sum;
+}
+
+static int
+test_round(bfdev_wspool_t *pool, unsigned long grain)
+{
+    struct test_span span;
+    unsigned long index;
+    int retval;
+
+    for (index = 0; index < TEST_SIZE; ++index)
+        bfdev_atomic_write(&marks[index], 0);
+
+    retval = bfdev_wspool_parallel_for(pool, 0, 0, TEST_SIZE,
+                                       grain, test_mark, NULL);
+    if (retval)
+        return retval;
+
+    for (index = 0; index < TEST_SIZE; ++index) {
+        if (bfdev_atomic_read(&marks[index]) != 1) {
+            bfdev_log_err("index %lu marked %ld times\n", index,
+                          (long)bfdev_atomic_read(&marks[index]));
+            return -BFDEV_EFAULT;
+        }
+    }
+
+    retval = bfdev_wspool_parallel_reduce(pool, 0, 1, TEST_SIZE, grain,
+                                          test_map, test_combine, &span,
+                                          sizeof(span), NULL);
+    if (retval)
+        return retval;
+
+    if (span.broken || span.begin != 1 || span.end != TEST_SIZE ||
+        span.sum != (unsigned long)TEST_SIZE * (TEST_SIZE - 1) / 2)
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "wspool:rounds", NULL, NULL,
+    "work-stealing pool across stop and reset"
+) {
+    static const unsigned long grains[] = {
+        0, 1, 97, TEST_SIZE,
+    };
+    struct test_helper helpers[TEST_THREADS];
+    bfdev_wspool_t pool;
+    unsigned int index, round, count;
+    struct test_span span;
+    int retval;
+
+    retval = bfdev_wspool_alloc(&pool, NULL, TEST_THREADS, TEST_DEPTH);
+    if (retval)
+        return retval;
+
+    if (bfdev_wspool_run(&pool, TEST_THREADS) != -BFDEV_EINVAL ||
+        bfdev_wspool_parallel_for(&pool, TEST_THREADS, 0, 1, 0,
+                                  test_mark, NULL) != -BFDEV_EINVAL ||
+        bfdev_wspool_parallel_reduce(&pool, 0, 0, 1, 0, test_map,
+                                     test_combine, &span,
+                                     BFDEV_WSPOOL_RESULT + 1,
+                                     NULL) != -BFDEV_EOVERFLOW) {
+        bfdev_wspool_free(&pool);
+        return -BFDEV_EFAULT;
+    }
+
+    /* spinning helpers first, then sleeping ones */
+    for (round = 0; round < TEST_ROUNDS && !retval; ++round) {
+        if (round)
+            bfdev_wspool_set_wait(&pool, &cond_ops, NULL);
+
+        for (index = 1; index < TEST_THREADS; ++index) {
+            helpers[index] = (struct test_helper) {
+                .pool = &pool,
+                .index = index,
+            };
+            pthread_create(&helpers[index].tid, NULL,
+                           test_helper, &helpers[index]);
+        }
+
+        for (count = 0; count < BFDEV_ARRAY_SIZE(grains) && !retval; ++count)
+            retval = test_round(&pool, grains[count]);
+
+        bfdev_wspool_stop(&pool);
+        for (index = 1; index < TEST_THREADS; ++index) {
+            pthread_join(helpers[index].tid, NULL);
+            if (helpers[index].retval)
+                retval = -BFDEV_EFAULT;
+        }
+
+        /* a stopped pool sends helpers back at once */
+        if (!retval && bfdev_wspool_run(&pool, 1))
+            retval = -BFDEV_EFAULT;
+
+        bfdev_wspool_reset(&pool);
+    }
+
+    bfdev_wspool_free(&pool);
+    return retval;
+}
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2024 John Sanpe <sanpeqf@gmail.com>
+ */
+
+#define MODULE_NAME "xxhash-vectors"
+#define bfdev_log_fmt(fmt) MODULE_NAME ": " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <bfdev/xxhash.h>
+#include <bfdev/minmax.h>
+#include <bfdev/macro.h>
+#include <bfdev/log.h>
+#include <testsuite.h>
+
+#define TEST_SIZE 5000
+#define TEST_CHUNK 300
+#define TEST_LOOP 100
+
+struct vector {
+    size_t length;
+    uint64_t seed;
+    uint64_t hash;
+    uint64_t low;
+    uint64_t high;
+};
+
+/* data bytes are (index * 7 + 3) & 0xff */
+static const struct vector
+vectors[] = {
+    {   0, 0, 0x2d06800538d394c2ULL, 0x6001c324468d497fULL, 0x99aa06d3014798d8ULL},
+    {   0, 0x1234567890abcdefULL, 0xb5991a1202758c1dULL, 0xac58ea339c643281ULL, 0xb67ab81a27f3a0beULL},
+    {   1, 0, 0x13e608bc156defedULL, 0x13e608bc156defedULL, 0x22bbb76b211a39baULL},
+    {   1, 0x1234567890abcdefULL, 0xf9024169eda18259ULL, 0xf9024169eda18259ULL, 0xc3f356137c392987ULL},
+    {   3, 0, 0xa9088dda485b481cULL, 0xa9088dda485b481cULL, 0xce31763cbf8245a5ULL},
+    {   3, 0x1234567890abcdefULL, 0xb1650cf53c3bfa4aULL, 0xb1650cf53c3bfa4aULL, 0x8e8e1e137f39217fULL},
+    {   4, 0, 0x6d9253b16c8b1ed3ULL, 0x788a609154b0fe20ULL, 0x47197970590746b1ULL},
+    {   4, 0x1234567890abcdefULL, 0x4a1246d0fb3b24acULL, 0xb7fc0f34d8f89fddULL, 0xaa666b91cc8e1073ULL},
+    {   8, 0, 0x60539db630471163ULL, 0x3cd024e3d63a1588ULL, 0xe3bc8a5f46171555ULL},
+    {   8, 0x1234567890abcdefULL, 0x4e3a3c685e7041f4ULL, 0x404586be9a9eea20ULL, 0x4086e38a166e21b2ULL},
+    {   9, 0, 0xfeff668361d723a8ULL, 0xeafab1c7f123109fULL, 0xc72c88247a9a56d7ULL},
+    {   9, 0x1234567890abcdefULL, 0xd015937d83642a47ULL, 0x54f1c42641da2da7ULL, 0xeb63cd9497c2be81ULL},
+    {  16, 0, 0xb8c859b0f030b585ULL, 0x60d75c5e47d40a24ULL, 0xce0b9647ab24f884ULL},
+    {  16, 0x1234567890abcdefULL, 0xd95ae03fbddf7a62ULL, 0xe2b826a99b99a7c5ULL, 0x91f9559637c20775ULL},
+    {  17, 0, 0x714a04408e79b80fULL, 0xeeed7654312a26d7ULL, 0xbfd327edcc2fbd12ULL},
+    {  17, 0x1234567890abcdefULL, 0xb3863e74762be2adULL, 0xb97322865e83ddd7ULL, 0x0d93b5cca64cb30fULL},
+    { 100, 0, 0xb5937857f0d78c9fULL, 0x0cc97f05750182b2ULL, 0x2207ed96998d91f2ULL},
+    { 100, 0x1234567890abcdefULL, 0xb8ddedc9833420e7ULL, 0x3d5d24dd3e9ac557ULL, 0xc5137d7d818cbc13ULL},
+    { 128, 0, 0x67425a03650261bfULL, 0xc580008b6c92ac53ULL, 0x1b1962a096bac78bULL},
+    { 128, 0x1234567890abcdefULL, 0xb203911ea7be499bULL, 0x663de2be6b1c43b9ULL, 0x64b7326d24dfb3f5ULL},
+    { 129, 0, 0xc664bf3311c6abc4ULL, 0xbd91ce7ace4d385bULL, 0x293e4968c4619023ULL},
+    { 129, 0x1234567890abcdefULL, 0x514cc53e4dcf1a90ULL, 0x484637037b8012ccULL, 0x3cf84e126990e13bULL},
+    { 200, 0, 0x746cd0025327bf5bULL, 0x380142cdd5843bbdULL, 0x32200a52a918beafULL},
+    { 200, 0x1234567890abcdefULL, 0x0bf8c2946ba35673ULL, 0x26807c79e343186aULL, 0x344703ec377b0383ULL},
+    { 240, 0, 0x64556dc6b462a6cfULL, 0x04e0b5f034bee80bULL, 0xad46c1021b076bc7ULL},
+    { 240, 0x1234567890abcdefULL, 0x594b752a2f7f28b0ULL, 0x966f6ffd1f5e29f6ULL, 0xb6ea0cf664562e2bULL},
+    { 241, 0, 0x8beadd3a8874fe17ULL, 0x8beadd3a8874fe17ULL, 0xac6c3492c3d6b45dULL},
+    { 241, 0x1234567890abcdefULL, 0x2ebccff302188d4aULL, 0x2ebccff302188d4aULL, 0x456af2c3e7a6eb6dULL},
+    { 256, 0, 0x3c38817f6d79c0daULL, 0x3c38817f6d79c0daULL, 0x77f21db933350c7eULL},
+    { 256, 0x1234567890abcdefULL, 0xcd6e6cc91d8fa715ULL, 0xcd6e6cc91d8fa715ULL, 0x3cd65ab5256204e6ULL},
+    { 257, 0, 0x2a300c3495738ea6ULL, 0x2a300c3495738ea6ULL, 0x75f2e27f8efc335dULL},
+    { 257, 0x1234567890abcdefULL, 0x55840c9d0cb13e7cULL, 0x55840c9d0cb13e7cULL, 0xe88fa16152b3a6faULL},
+    {1024, 0, 0x9b81661c641c72b1ULL, 0x9b81661c641c72b1ULL, 0x18bc0eaca9a33636ULL},
+    {1024, 0x1234567890abcdefULL, 0xd528c5411ed85abfULL, 0xd528c5411ed85abfULL, 0xc59c7dd52cb8e211ULL},
+    {1025, 0, 0x806c2072ed713576ULL, 0x806c2072ed713576ULL, 0xbf447251cfa98d7cULL},
+    {1025, 0x1234567890abcdefULL, 0x167b5c86f888fdceULL, 0x167b5c86f888fdceULL, 0x6dd7f7a36d21db49ULL},
+    {2048, 0, 0xabe604813ba62ed1ULL, 0xabe604813ba62ed1ULL, 0xf81f6e8f418d8075ULL},
+    {2048, 0x1234567890abcdefULL, 0xb3e7d09eedc7f0bfULL, 0xb3e7d09eedc7f0bfULL, 0xc4a320239dedb1a9ULL},
+    {5000, 0, 0x799aaddd7339581dULL, 0x799aaddd7339581dULL, 0xc98ae385d09887ccULL},
+    {5000, 0x1234567890abcdefULL, 0xe893403bb65365a8ULL, 0xe893403bb65365a8ULL, 0xabb2f59b19f77d20ULL},
+};
+
+static uint8_t data[TEST_SIZE];
+
+static void
+test_prepare(void)
+{
+    unsigned int index;
+
+    for (index = 0; index < TEST_SIZE; ++index)
+        data[index] = (uint8_t)(index * 7 + 3);
+}
+
+static int
+test_vectors(void)
+{
+    const struct vector *vector;
+    bfdev_xxh128_t result;
+    unsigned int index;
+    uint64_t hash;
+
+    test_prepare();
+    for (index = 0; index < BFDEV_ARRAY_SIZE(vectors); ++index) {
+        vector = &vectors[index];
+
+        hash = bfdev_xxh3(data, vector->length, vector->seed);
+        result = bfdev_xxh128(data, vector->length, vector->seed);
+
+        if (hash != vector->hash || result.low != vector->low ||
+            result.high != vector->high) {
+            bfdev_log_err("length %zu seed %#llx mismatch\n", vector->length,
+                          (unsigned long long)vector->seed);
+            return -BFDEV_EFAULT;
+        }
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "xxhash:vectors", NULL, NULL,
+    "xxh3 64 and 128-bit reference vectors"
+) {
+    return test_vectors();
+}
+
+static int
+test_stream(void)
+{
+    bfdev_xxh3_ctx_t ctx;
+    bfdev_xxh128_t result, expect;
+    size_t length, offset, chunk;
+    unsigned int loop;
+    uint64_t seed;
+
+    test_prepare();
+    for (loop = 0; loop < TEST_LOOP; ++loop) {
+        length = loop < 20 ? loop * 37 : (size_t)rand() % TEST_SIZE;
+        seed = loop % 2 ? (uint64_t)rand() << 32 | rand() : 0;
+
+        bfdev_xxh3_init(&ctx, seed);
+        for (offset = 0; offset < length; offset += chunk) {
+            chunk = loop % 3 ? rand() % TEST_CHUNK : 64;
+            chunk = bfdev_min(chunk, length - offset);
+            bfdev_xxh3_update(&ctx, data + offset, chunk);
+        }
+
+        result = bfdev_xxh128_finish(&ctx);
+        expect = bfdev_xxh128(data, length, seed);
+
+        if (bfdev_xxh3_finish(&ctx) != bfdev_xxh3(data, length, seed) ||
+            result.low != expect.low || result.high != expect.high) {
+            bfdev_log_err("stream length %zu mismatch\n", length);
+            return -BFDEV_EFAULT;
+        }
+    }
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "xxhash:stream", NULL, NULL,
+    "xxh3 streaming matches one-shot"
+) {
+    return test_stream();
+}
+
+static int
+test_adapter(void)
+{
+    static const char key[] = "bfdev-xxhash";
+
+    if (bfdev_xxh3_key(key, NULL) !=
+        bfdev_xxh3_key(key, BFDEV_XXH3_KEY_LENGTH(sizeof(key) - 1)))
+        return -BFDEV_EFAULT;
+
+    if (bfdev_xxh3_bloom(0, key, NULL) ==
+        bfdev_xxh3_bloom(1, key, NULL))
+        return -BFDEV_EFAULT;
+
+    return -BFDEV_ENOERR;
+}
+
+TESTSUITE(
+    "xxhash:adapter", NULL, NULL,
+    "xxh3 hashmap and bloom adapters"
+) {
+    return test_adapter();
+}